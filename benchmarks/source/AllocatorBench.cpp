@@ -0,0 +1,87 @@
+#include <malloc.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "tree.hpp"
+
+// Нагрузка со всплесками вставок и удалений для сравнения аллокаторов записей дерева.
+// Аллокатор выбирается при сборке: -DBINARY_TREE_ALLOCATOR=heap|pool, поэтому для сравнения
+// бенчмарк запускается из двух каталогов сборки.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kDirs = 1000;
+constexpr int kLeavesPerDir = 1000;
+constexpr size_t kEntries = static_cast<size_t>(kDirs) * kLeavesPerDir;
+
+size_t heap_in_use() { return mallinfo2().uordblks; }
+
+void report(const char *phase, Clock::time_point start, size_t ops) {
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    std::printf("  %-24s %10.1f ns/op %12.1f MB heap\n", phase, ns / static_cast<double>(ops),
+                static_cast<double>(heap_in_use()) / (1024 * 1024));
+}
+
+std::string leaf_path(int dir, int leaf) {
+    return "/dir" + std::to_string(dir) + "/session_" + std::to_string(leaf);
+}
+
+}  // namespace
+
+int main() {
+    std::printf("allocator: %s\n", kTreeAllocatorName);
+
+    auto root = create_root_node();
+    for (int d = 0; d < kDirs; ++d) {
+        create_node_by_path(root, "/dir" + std::to_string(d));
+    }
+
+    // Пути готовим заранее, чтобы в замер попадали только операции дерева.
+    std::vector<std::string> paths;
+    paths.reserve(kEntries);
+    for (int d = 0; d < kDirs; ++d) {
+        for (int l = 0; l < kLeavesPerDir; ++l) {
+            paths.push_back(leaf_path(d, l));
+        }
+    }
+    const std::string value = "value payload of a typical session record";
+
+    auto start = Clock::now();
+    for (const auto &path : paths) {
+        create_leaf_by_path(root, path, value);
+    }
+    report("insert burst", start, kEntries);
+
+    start = Clock::now();
+    for (size_t i = 0; i < kEntries; i += 2) {
+        delete_leaf_by_path_linear(root, paths[i]);
+    }
+    report("delete half", start, kEntries / 2);
+
+    start = Clock::now();
+    for (size_t i = 0; i < kEntries; i += 2) {
+        create_leaf_by_path(root, paths[i], value);
+    }
+    report("re-insert half", start, kEntries / 2);
+
+    start = Clock::now();
+    for (int d = 0; d < kDirs; ++d) {
+        delete_node_by_path_linear(root, "/dir" + std::to_string(d));
+    }
+    report("delete all dirs", start, kEntries);
+
+    start = Clock::now();
+    for (int d = 0; d < kDirs; ++d) {
+        create_node_by_path(root, "/dir" + std::to_string(d));
+    }
+    for (const auto &path : paths) {
+        create_leaf_by_path(root, path, value);
+    }
+    report("insert after free", start, kEntries);
+    return 0;
+}
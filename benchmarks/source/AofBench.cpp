@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mutationLog.hpp"
+
+// Пропускная способность журнала изменений при каждой политике fsync: потоки, как рабочие
+// потоки сервера, добавляют запись SET_LEAF и ждут ее записи (append + sync на команду).
+// Для always сравнивается число fdatasync() с числом записей: групповая фиксация объединяет
+// одновременных писателей.
+//
+// Запуск: aof_bench [records_per_thread] [log_path]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct s_result {
+    double records_per_second;
+    uint64_t records;
+    uint64_t fsyncs;
+    uint64_t file_size;
+};
+
+using Result = struct s_result;
+
+Result measure(const std::string &path, FsyncPolicy policy, int threads, int records) {
+    std::filesystem::remove(path);
+    MutationLogOptions options;
+    options.path = path;
+    options.fsync = policy;
+    MutationLog log(options);
+    if (!log.open(create_root_node())) {
+        std::exit(1);
+    }
+
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::string leaf = "/Users/user_" + std::to_string(t) + "/session";
+            std::string value(64, 'v');
+            for (int i = 0; i < records; ++i) {
+                log.sync(log.append(TreeChangeKind::SetLeaf, leaf, value));
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    uint64_t total = static_cast<uint64_t>(threads) * records;
+    return {total / seconds, total, log.fsync_count(), log.file_size()};
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    int records = argc > 1 ? std::atoi(argv[1]) : 2000;
+    std::string path = argc > 2 ? argv[2] : "/tmp/aof_bench.aof";
+
+    const std::pair<const char *, FsyncPolicy> policies[] = {
+        {"always", FsyncPolicy::Always},
+        {"everysec", FsyncPolicy::EverySecond},
+        {"never", FsyncPolicy::Never},
+    };
+    std::printf("%d records per thread, 64-byte values\n", records);
+    std::printf("%-9s %7s %14s %9s %8s\n", "policy", "threads", "records/s", "fsyncs", "MiB");
+    for (const auto &[name, policy] : policies) {
+        for (int threads : {1, 8}) {
+            Result result = measure(path, policy, threads, records);
+            std::printf("%-9s %7d %14.0f %9llu %8.1f\n", name, threads, result.records_per_second,
+                        static_cast<unsigned long long>(result.fsyncs),
+                        result.file_size / (1024.0 * 1024.0));
+        }
+    }
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Запись и чтение batch листьев на работающем database_server одним соединением:
+//   single   - по одной команде SET_LEAF/GET_LEAF с ожиданием ответа;
+//   pipeline - batch команд SET_LEAF/GET_LEAF одним write(), каждая берет свою блокировку;
+//   batch    - одна команда MSET/MGET на batch элементов под одной блокировкой.
+//
+// Запуск: server_batch_bench [host] [port] [batch] [rounds]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Читает из сокета, пока не наберется lines строк. Возвращает false при ошибке.
+bool read_lines(int fd, size_t lines) {
+    char chunk[64 * 1024];
+    size_t seen = 0;
+    while (seen < lines) {
+        ssize_t bytes_read = read(fd, chunk, sizeof(chunk));
+        if (bytes_read <= 0) {
+            return false;
+        }
+        seen += std::count(chunk, chunk + bytes_read, '\n');
+    }
+    return true;
+}
+
+bool request(int fd, const std::string &commands, size_t reply_lines) {
+    return write(fd, commands.data(), commands.size()) >= 0 && read_lines(fd, reply_lines);
+}
+
+std::string key(size_t i) { return "/bench/key_" + std::to_string(i); }
+
+// Выполняет rounds раз один шаг (запросы + ожидание ответов) и возвращает элементов в секунду.
+template <typename Step>
+double measure(size_t batch, int rounds, Step step) {
+    auto start = Clock::now();
+    for (int r = 0; r < rounds; ++r) {
+        if (!step()) {
+            std::fprintf(stderr, "connection failed\n");
+            std::exit(1);
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return static_cast<double>(batch) * rounds / seconds;
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    const char *host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? std::atoi(argv[2]) : 12004;
+    size_t batch = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 1000;
+    int rounds = argc > 4 ? std::atoi(argv[4]) : 50;
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = inet_addr(host);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (const sockaddr *)&address, sizeof(address)) != 0 ||
+        !read_lines(fd, 1) || !request(fd, "CREATE_NODE /bench\n", 1)) {
+        std::fprintf(stderr, "connection failed\n");
+        return 1;
+    }
+
+    std::string set_pipeline, get_pipeline, mset = "MSET", mget = "MGET";
+    std::vector<std::string> set_single, get_single;
+    for (size_t i = 0; i < batch; ++i) {
+        std::string value = "value_" + std::to_string(i);
+        set_single.push_back("SET_LEAF " + key(i) + " " + value + "\n");
+        get_single.push_back("GET_LEAF " + key(i) + "\n");
+        set_pipeline += set_single.back();
+        get_pipeline += get_single.back();
+        mset.append(" ").append(key(i)).append(" ").append(value);
+        mget.append(" ").append(key(i));
+    }
+    mset += "\n";
+    mget += "\n";
+
+    std::printf("batch: %zu, rounds: %d\n", batch, rounds);
+    std::printf("%-10s %14s %14s\n", "mode", "set items/s", "get items/s");
+
+    auto single = [&](const std::vector<std::string> &commands) {
+        for (const auto &command : commands) {
+            if (!request(fd, command, 1)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    double set_rate = measure(batch, rounds, [&] { return single(set_single); });
+    double get_rate = measure(batch, rounds, [&] { return single(get_single); });
+    std::printf("%-10s %14.0f %14.0f\n", "single", set_rate, get_rate);
+
+    set_rate = measure(batch, rounds, [&] { return request(fd, set_pipeline, batch); });
+    get_rate = measure(batch, rounds, [&] { return request(fd, get_pipeline, batch); });
+    std::printf("%-10s %14.0f %14.0f\n", "pipeline", set_rate, get_rate);
+
+    // Ответ MGET: строка статуса и по две строки на найденное значение
+    set_rate = measure(batch, rounds, [&] { return request(fd, mset, 1); });
+    get_rate = measure(batch, rounds, [&] { return request(fd, mget, 1 + 2 * batch); });
+    std::printf("%-10s %14.0f %14.0f\n", "batch", set_rate, get_rate);
+
+    close(fd);
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tree.hpp"
+#include "treeLock.hpp"
+
+// Пропускная способность чтения и записи при 1..32 читающих потоках и одном писателе.
+// Сравниваются схемы блокировки дерева в сервере: один эксклюзивный std::mutex (как было),
+// std::shared_mutex (в glibc приоритет у читателей) и TreeRwLock (приоритет у писателя).
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kDirs = 1000;
+constexpr int kLeavesPerDir = 100;
+constexpr auto kDuration = std::chrono::milliseconds(500);
+
+struct Result {
+    double reads_per_second;
+    double writes_per_second;
+};
+
+std::string leaf_path(int dir, int leaf) {
+    return "/dir" + std::to_string(dir) + "/leaf" + std::to_string(leaf);
+}
+
+// ReadLock - тип блокировки, которую берут читатели (std::unique_lock или std::shared_lock).
+template <typename Mutex, template <typename> class ReadLock>
+Result run(const std::shared_ptr<Node> &root, const std::vector<std::string> &paths,
+           int readers) {
+    Mutex mutex;
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> reads{0};
+    std::atomic<size_t> writes{0};
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            size_t local = 0;
+            size_t i = static_cast<size_t>(r) * 7919;
+            while (!stop.load(std::memory_order_relaxed)) {
+                ReadLock<Mutex> lock(mutex);
+                find_leaf_by_path_linear(root, paths[i++ % paths.size()]);
+                ++local;
+            }
+            reads += local;
+        });
+    }
+
+    threads.emplace_back([&] {
+        size_t local = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            std::string path = "/dir0/tmp" + std::to_string(local % 64);
+            std::unique_lock<Mutex> lock(mutex);
+            if (find_leaf_by_path_linear(root, path)) {
+                delete_leaf_by_path_linear(root, path);
+            } else {
+                create_leaf_by_path(root, path, "value");
+            }
+            ++local;
+        }
+        writes += local;
+    });
+
+    std::this_thread::sleep_for(kDuration);
+    stop = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    double seconds = std::chrono::duration<double>(kDuration).count();
+    return {static_cast<double>(reads) / seconds, static_cast<double>(writes) / seconds};
+}
+
+template <typename Mutex>
+using ExclusiveLock = std::unique_lock<Mutex>;
+template <typename Mutex>
+using SharedLock = std::shared_lock<Mutex>;
+
+}  // namespace
+
+int main() {
+    auto root = create_root_node();
+    std::vector<std::string> paths;
+    for (int d = 0; d < kDirs; ++d) {
+        create_node_by_path(root, "/dir" + std::to_string(d));
+        for (int l = 0; l < kLeavesPerDir; ++l) {
+            paths.push_back(leaf_path(d, l));
+            create_leaf_by_path(root, paths.back(), "value");
+        }
+    }
+
+    std::printf("hardware threads: %u\n", std::thread::hardware_concurrency());
+    std::printf("%8s %24s %24s %24s\n", "readers", "std::mutex reads/writes",
+                "std::shared_mutex r/w", "TreeRwLock r/w");
+    for (int readers : {1, 2, 4, 8, 16, 32}) {
+        Result exclusive = run<std::mutex, ExclusiveLock>(root, paths, readers);
+        Result shared = run<std::shared_mutex, SharedLock>(root, paths, readers);
+        Result rwlock = run<TreeRwLock, SharedLock>(root, paths, readers);
+        std::printf("%8d %12.0f/%-11.0f %12.0f/%-11.0f %12.0f/%-11.0f\n", readers,
+                    exclusive.reads_per_second, exclusive.writes_per_second,
+                    shared.reads_per_second, shared.writes_per_second, rwlock.reads_per_second,
+                    rwlock.writes_per_second);
+    }
+    return 0;
+}
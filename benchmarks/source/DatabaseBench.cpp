@@ -0,0 +1,315 @@
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "tree.hpp"
+
+// Операции дерева (tree.hpp) на деревьях трех форм:
+//   wide     - 1M листьев в одном каталоге;
+//   deep     - цепочка из 1000 каталогов, по 10 листьев на каждом уровне;
+//   balanced - 10 каталогов на уровень, 3 уровня (1000 нижних каталогов по 1000 листьев).
+// Одна итерация - одна операция: время итерации - нс на операцию, items_per_second - операций
+// в секунду, счетчик allocs_per_op - вызовов operator new на операцию. Создающие бенчмарки
+// удаляют созданное после замера, удаляющие создают записи порциями вне замера.
+//
+// Запуск: database_bench [--benchmark_filter=...]
+// JSON для сравнения между коммитами (compare.py из google/benchmark):
+//   database_bench --benchmark_out=bench.json --benchmark_out_format=json
+// или цель сборки database_bench_json.
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+}  // namespace
+
+// noinline: после встраивания GCC видит malloc()/free() вместо пары new/delete и ложно
+// предупреждает -Wmismatched-new-delete.
+__attribute__((noinline)) void *operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *pointer) noexcept { std::free(pointer); }
+__attribute__((noinline)) void operator delete(void *pointer, size_t) noexcept {
+    std::free(pointer);
+}
+
+namespace {
+
+enum class Shape { Wide, Deep, Balanced };
+
+constexpr int kWideLeaves = 1000000;
+constexpr int kDeepLevels = 1000;
+constexpr int kDeepLeavesPerLevel = 10;
+constexpr int kBalancedFanout = 10;
+constexpr int kBalancedLevels = 3;
+constexpr int kBalancedLeavesPerDirectory = 1000;
+
+// Записей, которые удаляющие бенчмарки создают за одну паузу замера.
+constexpr int kDeleteBatch = 1000;
+
+struct TreeFixture {
+    Shape shape;
+    std::shared_ptr<Node> root;
+    std::vector<std::string> nodes;       // Все каталоги, кроме корня
+    std::vector<std::string> leaves;      // Все листья
+    std::vector<std::string> targets;     // Каталоги, в которых создаются новые записи
+    std::vector<uint32_t> random_leaves;  // Случайная последовательность индексов leaves
+    std::vector<uint32_t> random_nodes;
+    uint64_t created = 0;                 // Счетчик для уникальных имен новых записей
+};
+
+std::string value_of(size_t i) { return "value_" + std::to_string(i); }
+
+void add_leaves(TreeFixture &tree, const std::string &dir, int count) {
+    for (int i = 0; i < count; ++i) {
+        tree.leaves.push_back(child_path_of(dir, "leaf" + std::to_string(i)));
+        create_leaf_by_path(tree.root, tree.leaves.back(), value_of(tree.leaves.size()));
+    }
+}
+
+std::string add_node(TreeFixture &tree, const std::string &parent, const std::string &name) {
+    tree.nodes.push_back(child_path_of(parent, name));
+    create_node_by_path(tree.root, tree.nodes.back());
+    return tree.nodes.back();
+}
+
+void build_balanced(TreeFixture &tree, const std::string &dir, int level) {
+    if (level == kBalancedLevels) {
+        add_leaves(tree, dir, kBalancedLeavesPerDirectory);
+        tree.targets.push_back(dir);
+        return;
+    }
+    for (int i = 0; i < kBalancedFanout; ++i) {
+        build_balanced(tree, add_node(tree, dir, "dir" + std::to_string(i)), level + 1);
+    }
+}
+
+std::unique_ptr<TreeFixture> build(Shape shape) {
+    auto tree = std::make_unique<TreeFixture>();
+    tree->shape = shape;
+    tree->root = create_root_node();
+    if (shape == Shape::Wide) {
+        std::string dir = add_node(*tree, "/", "wide");
+        add_leaves(*tree, dir, kWideLeaves);
+        tree->targets.push_back(dir);
+    } else if (shape == Shape::Deep) {
+        std::string dir = "/";
+        for (int level = 0; level < kDeepLevels; ++level) {
+            dir = add_node(*tree, dir, "level" + std::to_string(level));
+            add_leaves(*tree, dir, kDeepLeavesPerLevel);
+        }
+        tree->targets.push_back(dir);
+    } else {
+        build_balanced(*tree, "/", 0);
+    }
+
+    std::mt19937 random(42);
+    for (int i = 0; i < 1 << 20; ++i) {
+        tree->random_leaves.push_back(static_cast<uint32_t>(random() % tree->leaves.size()));
+        tree->random_nodes.push_back(static_cast<uint32_t>(random() % tree->nodes.size()));
+    }
+    return tree;
+}
+
+// Дерево нужной формы. Хранится одно дерево: бенчмарки сгруппированы по формам, а три дерева
+// по миллиону листьев вместе заняли бы лишнюю память.
+TreeFixture &fixture_of(Shape shape) {
+    static std::unique_ptr<TreeFixture> cached;
+    if (!cached || cached->shape != shape) {
+        cached.reset();
+        cached = build(shape);
+    }
+    return *cached;
+}
+
+const std::string &target_of(TreeFixture &tree, uint64_t i) {
+    return tree.targets[i % tree.targets.size()];
+}
+
+// Путь новой записи; каталоги balanced перебираются по очереди.
+std::string new_path(TreeFixture &tree) {
+    uint64_t id = tree.created++;
+    return child_path_of(target_of(tree, id * 7919), "new" + std::to_string(id));
+}
+
+// Пути новых записей на следующую порцию замера (вне замера, как и cleanup).
+void refill(TreeFixture &tree, std::vector<std::string> &paths) {
+    for (auto &path : paths) {
+        path = new_path(tree);
+    }
+}
+
+// Удаляет записи, созданные замером.
+template <typename Delete>
+void cleanup(TreeFixture &tree, const std::vector<std::string> &paths, Delete remove) {
+    for (const auto &path : paths) {
+        remove(tree.root, path);
+    }
+}
+
+// Операций в секунду и выделений на операцию.
+void report(benchmark::State &state, size_t allocations) {
+    state.SetItemsProcessed(state.iterations());
+    state.counters["allocs_per_op"] = benchmark::Counter(static_cast<double>(allocations),
+                                                         benchmark::Counter::kAvgIterations);
+}
+
+void BM_CreateNodeByPath(benchmark::State &state, Shape shape) {
+    TreeFixture &tree = fixture_of(shape);
+    std::vector<std::string> paths;
+    for (int i = 0; i < 1 << 16; ++i) {
+        paths.push_back(new_path(tree));
+    }
+    size_t next = 0;
+    size_t allocations = g_allocations;
+    for (auto _ : state) {
+        if (next == paths.size()) {
+            state.PauseTiming();
+            size_t before = g_allocations;
+            cleanup(tree, paths, delete_node_by_path_linear);
+            refill(tree, paths);
+            allocations += g_allocations - before;
+            next = 0;
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(create_node_by_path(tree.root, paths[next++]));
+    }
+    report(state, g_allocations - allocations);
+    paths.resize(next);
+    cleanup(tree, paths, delete_node_by_path_linear);
+}
+
+void BM_CreateLeafByPath(benchmark::State &state, Shape shape) {
+    TreeFixture &tree = fixture_of(shape);
+    std::vector<std::string> paths;
+    for (int i = 0; i < 1 << 16; ++i) {
+        paths.push_back(new_path(tree));
+    }
+    size_t next = 0;
+    const std::string value = value_of(0);
+    size_t allocations = g_allocations;
+    for (auto _ : state) {
+        if (next == paths.size()) {
+            state.PauseTiming();
+            size_t before = g_allocations;
+            cleanup(tree, paths, delete_leaf_by_path_linear);
+            refill(tree, paths);
+            allocations += g_allocations - before;
+            next = 0;
+            state.ResumeTiming();
+        }
+        benchmark::DoNotOptimize(create_leaf_by_path(tree.root, paths[next++], value));
+    }
+    report(state, g_allocations - allocations);
+    paths.resize(next);
+    cleanup(tree, paths, delete_leaf_by_path_linear);
+}
+
+void BM_FindLeafByPath(benchmark::State &state, Shape shape) {
+    TreeFixture &tree = fixture_of(shape);
+    size_t i = 0;
+    size_t allocations = g_allocations;
+    for (auto _ : state) {
+        const std::string &path = tree.leaves[tree.random_leaves[i++ % tree.random_leaves.size()]];
+        benchmark::DoNotOptimize(find_leaf_by_path_linear(tree.root, path));
+    }
+    report(state, g_allocations - allocations);
+}
+
+void BM_FindNodeByPath(benchmark::State &state, Shape shape) {
+    TreeFixture &tree = fixture_of(shape);
+    size_t i = 0;
+    size_t allocations = g_allocations;
+    for (auto _ : state) {
+        const std::string &path = tree.nodes[tree.random_nodes[i++ % tree.random_nodes.size()]];
+        benchmark::DoNotOptimize(find_node_by_path_linear(tree.root, path));
+    }
+    report(state, g_allocations - allocations);
+}
+
+void BM_DeleteLeafByPath(benchmark::State &state, Shape shape) {
+    TreeFixture &tree = fixture_of(shape);
+    std::vector<std::string> batch;
+    const std::string value = value_of(0);
+    size_t allocations = 0;
+    while (state.KeepRunningBatch(kDeleteBatch)) {
+        state.PauseTiming();
+        batch.clear();
+        for (int i = 0; i < kDeleteBatch; ++i) {
+            batch.push_back(new_path(tree));
+            create_leaf_by_path(tree.root, batch.back(), value);
+        }
+        size_t before = g_allocations;
+        state.ResumeTiming();
+        for (const auto &path : batch) {
+            benchmark::DoNotOptimize(delete_leaf_by_path_linear(tree.root, path));
+        }
+        allocations += g_allocations - before;
+    }
+    report(state, allocations);
+}
+
+// Удаление пустого каталога: стоимость удаления непустого - удаление его записей.
+void BM_DeleteNodeByPath(benchmark::State &state, Shape shape) {
+    TreeFixture &tree = fixture_of(shape);
+    std::vector<std::string> batch;
+    size_t allocations = 0;
+    while (state.KeepRunningBatch(kDeleteBatch)) {
+        state.PauseTiming();
+        batch.clear();
+        for (int i = 0; i < kDeleteBatch; ++i) {
+            batch.push_back(new_path(tree));
+            create_node_by_path(tree.root, batch.back());
+        }
+        size_t before = g_allocations;
+        state.ResumeTiming();
+        for (const auto &path : batch) {
+            benchmark::DoNotOptimize(delete_node_by_path_linear(tree.root, path));
+        }
+        allocations += g_allocations - before;
+    }
+    report(state, allocations);
+}
+
+// Вывод всего дерева; bytes_per_second - длина вывода.
+void BM_PrintTreeString(benchmark::State &state, Shape shape) {
+    TreeFixture &tree = fixture_of(shape);
+    size_t bytes = 0;
+    size_t allocations = g_allocations;
+    for (auto _ : state) {
+        std::string text = print_tree_string(tree.root);
+        bytes += text.size();
+        benchmark::DoNotOptimize(text.data());
+    }
+    report(state, g_allocations - allocations);
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+
+}  // namespace
+
+// Все операции на одной форме, затем на следующей: дерево строится один раз на форму.
+#define TREE_BENCHMARKS(name, shape)                                               \
+    BENCHMARK_CAPTURE(BM_CreateNodeByPath, name, shape);                           \
+    BENCHMARK_CAPTURE(BM_CreateLeafByPath, name, shape);                           \
+    BENCHMARK_CAPTURE(BM_FindLeafByPath, name, shape);                             \
+    BENCHMARK_CAPTURE(BM_FindNodeByPath, name, shape);                             \
+    BENCHMARK_CAPTURE(BM_DeleteLeafByPath, name, shape);                           \
+    BENCHMARK_CAPTURE(BM_DeleteNodeByPath, name, shape);                           \
+    BENCHMARK_CAPTURE(BM_PrintTreeString, name, shape)->Unit(benchmark::kMillisecond)
+
+TREE_BENCHMARKS(wide, Shape::Wide);
+TREE_BENCHMARKS(deep, Shape::Deep);
+TREE_BENCHMARKS(balanced, Shape::Balanced);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "eviction.hpp"
+#include "pathLock.hpp"
+
+// Кэш поверх дерева с пределом памяти. Ключи - листья 100 каталогов со значениями по 100 байт,
+// запрос - чтение листа под S-блокировкой каталога, промах - запись листа под X (заполнение кэша
+// из источника) после make_room. 90% запросов - 200000 ключей по Zipf(0.99), 10% - однократные
+// ключи (сканирование), которые вытесняют из LRU полезные листья. Предел памяти - на 10% ключей.
+// Для каждой политики: доля попаданий, запросов в секунду, вытеснений и самое долгое make_room.
+// Отдельно - стоимость учета одного обращения (touch) для lru и lfu.
+//
+// Запуск: eviction_bench [requests]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kDirectories = 100;
+constexpr uint32_t kKeys = 200000;
+constexpr double kZipfExponent = 0.99;
+constexpr int kScanPercent = 10;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::string path_of(uint32_t key) {
+    return "/d" + std::to_string(key % kDirectories) + "/k" + std::to_string(key);
+}
+
+// Последовательность ключей: ранги Zipf перемешаны по ключам, однократные ключи - после kKeys.
+std::vector<uint32_t> make_requests(size_t count) {
+    std::vector<double> cdf(kKeys);
+    double total = 0;
+    for (uint32_t rank = 0; rank < kKeys; ++rank) {
+        total += 1.0 / std::pow(rank + 1.0, kZipfExponent);
+        cdf[rank] = total;
+    }
+    std::mt19937_64 random(42);
+    std::vector<uint32_t> key_of_rank(kKeys);
+    std::iota(key_of_rank.begin(), key_of_rank.end(), 0);
+    std::shuffle(key_of_rank.begin(), key_of_rank.end(), random);
+
+    std::uniform_real_distribution<double> uniform(0, total);
+    std::vector<uint32_t> requests;
+    requests.reserve(count);
+    uint32_t one_off = kKeys;
+    for (size_t i = 0; i < count; ++i) {
+        if (static_cast<int>(random() % 100) < kScanPercent) {
+            requests.push_back(one_off++);
+            continue;
+        }
+        size_t rank = std::lower_bound(cdf.begin(), cdf.end(), uniform(random)) - cdf.begin();
+        requests.push_back(key_of_rank[std::min<size_t>(rank, kKeys - 1)]);
+    }
+    return requests;
+}
+
+std::shared_ptr<Node> create_cache_tree() {
+    auto root = create_root_node();
+    for (int d = 0; d < kDirectories; ++d) {
+        create_node_by_path(root, "/d" + std::to_string(d));
+    }
+    return root;
+}
+
+void run(EvictionPolicy policy, const std::vector<uint32_t> &requests, size_t leaf_bytes) {
+    auto root = create_cache_tree();
+    EvictionOptions options;
+    options.policy = policy;
+    options.max_bytes = root->index->bytes + leaf_bytes * (kKeys / 10);
+    LeafEviction eviction(root, options);
+    std::string value(100, 'v');
+    double longest = 0;
+
+    auto start = Clock::now();
+    for (uint32_t key : requests) {
+        std::string path = path_of(key);
+        uint64_t now = unix_time_ms();
+        bool hit;
+        {
+            PathLock lock = PathLock::parent_of(root, path, LockMode::Shared);
+            auto leaf = find_child_leaf(lock.node(), name_of(path));
+            hit = leaf != nullptr;
+            eviction.count_read(hit);
+            if (hit) {
+                eviction.touch(*leaf, now);
+            }
+        }
+        if (!hit) {
+            auto begin = Clock::now();
+            if (!eviction.make_room(now)) {
+                std::exit(1);
+            }
+            longest = std::max(longest, seconds_since(begin));
+            PathLock lock = PathLock::parent_of(root, path, LockMode::Exclusive);
+            eviction.touch(*set_child_leaf(lock.node(), path, value), now);
+        }
+    }
+    double total = seconds_since(start);
+
+    EvictionStats stats = eviction.stats();
+    std::printf("%-10s %8.4f %10.2f %10llu %12.1f %14.3f\n",
+                std::string(eviction_policy_name(policy)).c_str(), stats.hit_rate(),
+                requests.size() / total / 1e6, static_cast<unsigned long long>(stats.evicted),
+                stats.used_bytes / 1024.0, longest * 1e3);
+}
+
+// Наносекунд на одно обращение к одному и тому же листу.
+double touch_ns(EvictionPolicy policy) {
+    auto root = create_cache_tree();
+    auto leaf = create_leaf_by_path(root, "/d0/hot", "v");
+    EvictionOptions options;
+    options.policy = policy;
+    options.max_bytes = 1 << 30;
+    LeafEviction eviction(root, options);
+    constexpr int kTouches = 10000000;
+    uint64_t now = unix_time_ms();
+    auto start = Clock::now();
+    for (int i = 0; i < kTouches; ++i) {
+        eviction.touch(*leaf, now + i / 1000);
+    }
+    return seconds_since(start) / kTouches * 1e9;
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    size_t count = argc > 1 ? static_cast<size_t>(std::atoll(argv[1])) : 2000000;
+    auto requests = make_requests(count);
+
+    auto probe = create_cache_tree();
+    size_t leaf_bytes = footprint_of(*create_leaf_by_path(probe, path_of(kKeys / 2),
+                                                          std::string(100, 'v')));
+    std::printf("%zu requests, %u keys, %d%% one-off, limit %u leaves of %zu bytes\n", count,
+                kKeys, kScanPercent, kKeys / 10, leaf_bytes);
+    std::printf("%-10s %8s %10s %10s %12s %14s\n", "policy", "hit rate", "M req/s", "evicted",
+                "used KiB", "max room ms");
+    for (EvictionPolicy policy :
+         {EvictionPolicy::Lru, EvictionPolicy::Lfu, EvictionPolicy::TtlFirst}) {
+        run(policy, requests, leaf_bytes);
+    }
+    std::printf("touch: lru %.1f ns, lfu %.1f ns\n", touch_ns(EvictionPolicy::Lru),
+                touch_ns(EvictionPolicy::Lfu));
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "expiry.hpp"
+
+// Истечение TTL у N листьев (1000 каталогов), сроки равномерно разбросаны по 10 минутам
+// модельного времени, плюс столько же листьев без TTL:
+//   - schedule - постановка таймеров (как CREATE_LEAF ... EX / EXPIRE);
+//   - sweep    - тики по 10 мс модельного времени, пока не истекут все листья.
+// Для sweep - удалений в секунду, число тиков, самый долгий тик и среднее время пустого тика:
+// стоимость тика не зависит от размера дерева, только от числа истекших в нем листьев.
+//
+// Запуск: expiry_bench [leaves]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kDirectories = 1000;
+constexpr uint64_t kStart = 1'000'000'000'000;
+constexpr uint64_t kSpreadMs = 10 * 60 * 1000;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    int leaves = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    auto root = create_root_node();
+    std::vector<std::shared_ptr<Node>> dirs;
+    for (int d = 0; d < kDirectories; ++d) {
+        dirs.push_back(create_node(root, "/tenant_" + std::to_string(d)));
+    }
+    std::mt19937_64 random(1);
+    std::vector<std::pair<const Leaf *, uint64_t>> deadlines;
+    for (int i = 0; i < leaves; ++i) {
+        const auto &dir = dirs[i % kDirectories];
+        create_leaf(dir, std::string(dir->path) + "/plain_" + std::to_string(i), "v");
+        auto leaf = create_leaf(dir, std::string(dir->path) + "/ttl_" + std::to_string(i), "v");
+        leaf->expires_at = kStart + 1 + random() % kSpreadMs;
+        deadlines.emplace_back(leaf.get(), leaf->expires_at);
+    }
+
+    ExpiryOptions options;
+    options.max_per_tick = static_cast<size_t>(leaves);
+    LeafExpiry expiry(root, options, nullptr, kStart);
+    auto start = Clock::now();
+    for (const auto &[leaf, expires_at] : deadlines) {
+        expiry.schedule(leaf->path, expires_at);
+    }
+    double schedule_s = seconds_since(start);
+    std::printf("%d TTL leaves + %d plain in %d directories\n", leaves, leaves, kDirectories);
+    std::printf("schedule %9.2f s %8.2f M/s\n", schedule_s, leaves / schedule_s / 1e6);
+
+    size_t ticks = 0;
+    size_t empty_ticks = 0;
+    double empty_s = 0;
+    start = Clock::now();
+    for (uint64_t now = kStart; now <= kStart + kSpreadMs + options.tick_ms;
+         now += options.tick_ms) {
+        auto begin = Clock::now();
+        size_t expired = expiry.sweep(now);
+        ++ticks;
+        if (expired == 0) {
+            ++empty_ticks;
+            empty_s += seconds_since(begin);
+        }
+    }
+    double sweep_s = seconds_since(start);
+    ExpiryStats stats = expiry.stats();
+    std::printf("sweep    %9.2f s %8.2f M/s  expired %llu  pending %zu\n", sweep_s,
+                stats.expired / sweep_s / 1e6, static_cast<unsigned long long>(stats.expired),
+                stats.pending);
+    std::printf("ticks %zu  max tick %.2f ms  mean tick %.1f us  mean empty tick %.1f us\n",
+                ticks, stats.sweep_us_max / 1e3,
+                stats.sweeps ? static_cast<double>(stats.sweep_us_total) / stats.sweeps : 0.0,
+                empty_ticks ? empty_s / empty_ticks * 1e6 : 0.0);
+    return stats.expired == static_cast<uint64_t>(leaves) ? 0 : 1;
+}
@@ -0,0 +1,102 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "tree.hpp"
+
+// Замер времени вставки и удаления в одном каталоге при растущем числе детей.
+// При O(1) операциях над списками каталога время на операцию не должно расти вместе с N.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ns_per_op(Clock::time_point start, Clock::time_point stop, size_t ops) {
+    return std::chrono::duration<double, std::nano>(stop - start).count() / static_cast<double>(ops);
+}
+
+std::vector<std::string> make_paths(const std::string &dir, size_t count) {
+    std::vector<std::string> paths;
+    paths.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        paths.push_back(dir + "/entry" + std::to_string(i));
+    }
+    return paths;
+}
+
+// Удаляем через один: сначала четные, потом нечетные, чтобы затрагивать середину списка.
+std::vector<size_t> interleaved_order(size_t count) {
+    std::vector<size_t> order;
+    order.reserve(count);
+    for (size_t i = 0; i < count; i += 2) {
+        order.push_back(i);
+    }
+    for (size_t i = 1; i < count; i += 2) {
+        order.push_back(i);
+    }
+    return order;
+}
+
+void bench_leaves(size_t fanout, bool report = true) {
+    auto root = create_root_node();
+    create_node_by_path(root, "/Dir");
+    auto paths = make_paths("/Dir", fanout);
+
+    auto start = Clock::now();
+    for (const auto &path : paths) {
+        create_leaf_by_path(root, path, "value");
+    }
+    auto inserted = Clock::now();
+    for (size_t i : interleaved_order(fanout)) {
+        delete_leaf_by_path_linear(root, paths[i]);
+    }
+    auto deleted = Clock::now();
+
+    if (!report) {
+        return;
+    }
+    std::printf("%-6s %10zu %14.1f %14.1f\n", "leaf", fanout, ns_per_op(start, inserted, fanout),
+                ns_per_op(inserted, deleted, fanout));
+}
+
+void bench_nodes(size_t fanout, bool report = true) {
+    auto root = create_root_node();
+    create_node_by_path(root, "/Dir");
+    auto paths = make_paths("/Dir", fanout);
+
+    auto start = Clock::now();
+    for (const auto &path : paths) {
+        create_node_by_path(root, path);
+    }
+    auto inserted = Clock::now();
+    for (size_t i : interleaved_order(fanout)) {
+        delete_node_by_path_linear(root, paths[i]);
+    }
+    auto deleted = Clock::now();
+
+    if (!report) {
+        return;
+    }
+    std::printf("%-6s %10zu %14.1f %14.1f\n", "node", fanout, ns_per_op(start, inserted, fanout),
+                ns_per_op(inserted, deleted, fanout));
+}
+
+}  // namespace
+
+int main() {
+    const std::vector<size_t> fanouts = {1000, 10000, 100000, 1000000};
+
+    std::printf("%-6s %10s %14s %14s\n", "kind", "fanout", "insert ns/op", "delete ns/op");
+    // Прогревочный прогон перед каждой серией: после освобождения большого дерева
+    // аллокатор возвращает память системе, и первые замеры получаются шумными.
+    bench_leaves(fanouts.front(), false);
+    for (size_t fanout : fanouts) {
+        bench_leaves(fanout);
+    }
+    bench_nodes(fanouts.front(), false);
+    for (size_t fanout : fanouts) {
+        bench_nodes(fanout);
+    }
+    return 0;
+}
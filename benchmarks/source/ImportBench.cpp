@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pathLock.hpp"
+#include "scan.hpp"
+#include "subtreeStream.hpp"
+
+// Перенос поддерева из N листьев (1000 каталогов, значения по 32 байта) в другое дерево:
+//   - export  - поток порциями по 10000 записей (как EXPORT), каждая под своей S-блокировкой;
+//   - import  - SubtreeImporter по частям по 64 КиБ без блокировок, затем attach_subtree
+//               под X-блокировкой родителя /target;
+//   - replay  - те же записи по одной через create_*_by_path, каждая под своей X-блокировкой,
+//               как поток команд CREATE_NODE/CREATE_LEAF.
+// Для каждого способа - записей в секунду, самая долгая блокировка и самая долгая задержка
+// чтения из другого каталога (/other), которое выполняется параллельно.
+//
+// Запуск: import_bench [leaves]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kDirectories = 1000;
+constexpr size_t kExportChunk = 10000;
+constexpr size_t kImportPiece = 64 * 1024;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::shared_ptr<Node> build_tree(int leaves) {
+    auto root = create_root_node();
+    auto source = create_node(root, "/source");
+    create_node_by_path(root, "/other");
+    create_leaf_by_path(root, "/other/key", "value");
+    std::vector<std::shared_ptr<Node>> dirs;
+    for (int d = 0; d < kDirectories; ++d) {
+        dirs.push_back(create_node(source, "/source/tenant_" + std::to_string(d)));
+    }
+    std::string value(32, 'v');
+    for (int i = 0; i < leaves; ++i) {
+        const auto &dir = dirs[i % kDirectories];
+        create_leaf(dir, std::string(dir->path) + "/leaf_" + std::to_string(i), value);
+    }
+    return root;
+}
+
+// Самая долгая задержка чтения /other/key под S на /other, пока выполняется action.
+template <typename Action>
+double max_read_latency(const std::shared_ptr<Node> &root, Action action) {
+    std::atomic<bool> stop{false};
+    double longest = 0;
+    std::thread reader([&] {
+        while (!stop.load(std::memory_order_relaxed)) {
+            auto start = Clock::now();
+            {
+                PathLock lock(root, "/other", LockMode::Shared);
+                find_leaf_by_path_linear(root, "/other/key");
+            }
+            longest = std::max(longest, seconds_since(start));
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    action();
+    stop = true;
+    reader.join();
+    return longest;
+}
+
+std::shared_ptr<Node> create_target() {
+    auto root = create_root_node();
+    create_node_by_path(root, "/target");
+    create_node_by_path(root, "/other");
+    create_leaf_by_path(root, "/other/key", "value");
+    return root;
+}
+
+void report(const char *name, size_t entries, double total_s, double longest_lock_s,
+            double longest_read_s) {
+    std::printf("%-8s %10zu %9.2f s %8.2f %12.2f %12.2f\n", name, entries, total_s,
+                entries / total_s / 1e6, longest_lock_s * 1e3, longest_read_s * 1e3);
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    int leaves = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    auto start = Clock::now();
+    auto root = build_tree(leaves);
+    std::printf("%d leaves in %d directories, built in %.2f s\n", leaves, kDirectories,
+                seconds_since(start));
+    std::printf("%-8s %10s %11s %8s %12s %12s\n", "method", "entries", "time", "M/s",
+                "max lock ms", "max read ms");
+
+    std::string stream;
+    std::string cursor(kScanStart);
+    double longest = 0;
+    double export_s = 0;
+    double export_read = max_read_latency(root, [&] {
+        auto begin_all = Clock::now();
+        do {
+            auto begin = Clock::now();
+            PathLock lock(root, "/source", LockMode::Shared);
+            std::string next;
+            if (!export_chunk(lock.node(), cursor, kExportChunk, stream, next)) {
+                std::exit(1);
+            }
+            cursor = next;
+            longest = std::max(longest, seconds_since(begin));
+        } while (cursor != kScanStart);
+        export_s = seconds_since(begin_all);
+    });
+    report("export", static_cast<size_t>(leaves) + kDirectories, export_s, longest,
+           export_read);
+    std::printf("stream %.1f MiB\n", stream.size() / (1024.0 * 1024.0));
+
+    auto target = create_target();
+    SubtreeImporter importer("/target/imported");
+    double import_s = 0;
+    double attach_s = 0;
+    double import_read = max_read_latency(target, [&] {
+        auto begin = Clock::now();
+        for (size_t i = 0; i < stream.size(); i += kImportPiece) {
+            if (!importer.feed(std::string_view(stream).substr(i, kImportPiece))) {
+                std::exit(1);
+            }
+        }
+        auto subtree = importer.finish();
+        auto attach_begin = Clock::now();
+        {
+            PathLock lock = PathLock::parent_of(target, "/target/imported", LockMode::Exclusive);
+            if (!subtree || !attach_subtree(lock.node(), subtree)) {
+                std::exit(1);
+            }
+        }
+        attach_s = seconds_since(attach_begin);
+        import_s = seconds_since(begin);
+    });
+    report("import", importer.entries(), import_s, attach_s, import_read);
+    target.reset();
+
+    // Те же записи в порядке потока: каталог, затем его листья
+    auto replayed = create_target();
+    create_node_by_path(replayed, "/target/imported");
+    size_t created = 0;
+    longest = 0;
+    double replay_s = 0;
+    double replay_read = max_read_latency(replayed, [&] {
+        auto begin_all = Clock::now();
+        for (const auto &dir : root->childs.find("source")->childs) {
+            std::string dir_path = "/target/imported/" + std::string(name_of(dir->path));
+            auto begin = Clock::now();
+            {
+                PathLock lock = PathLock::parent_of(replayed, dir_path, LockMode::Exclusive);
+                create_node_by_path(replayed, dir_path);
+            }
+            longest = std::max(longest, seconds_since(begin));
+            for (const Leaf *leaf = dir->east.get(); leaf; leaf = leaf->east.get()) {
+                std::string path = dir_path + "/" + std::string(name_of(leaf->path));
+                begin = Clock::now();
+                {
+                    PathLock lock = PathLock::parent_of(replayed, path, LockMode::Exclusive);
+                    create_leaf_by_path(replayed, path, leaf->value);
+                }
+                longest = std::max(longest, seconds_since(begin));
+                ++created;
+            }
+            ++created;
+        }
+        replay_s = seconds_since(begin_all);
+    });
+    report("replay", created, replay_s, longest, replay_read);
+    return 0;
+}
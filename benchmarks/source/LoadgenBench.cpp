@@ -0,0 +1,484 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "metrics.hpp"
+#include "protocol.hpp"
+
+// Нагрузка на работающий database_server в духе redis-benchmark: --clients соединений (по
+// потоку на каждое) отправляют команды из смеси --mix пачками по --pipeline штук одним
+// write() и ждут все ответы. Задержка команды - от отправки ее пачки до прихода ее ответа.
+// Первые --warmup секунд не учитываются, затем --duration секунд идет замер. Итог - ops/s и
+// среднее, p50, p99, p999 и максимум задержки по каждому глаголу и по всем вместе.
+//
+// Команды отправляются бинарными фреймами: ответы на них идут с префиксом длины, поэтому
+// многострочный ответ PRINT_TREE не нужно разбирать. Ключ k из [0, --keys) задает пути
+//   <prefix>/d<k % dirs>/k<k> - лист (CREATE_LEAF, DELETE_LEAF, GET_LEAF, SET_LEAF),
+//   <prefix>/d<k % dirs>/n<k> - каталог (CREATE_NODE, DELETE_NODE),
+//   <prefix>/d<k % dirs>      - поддерево для PRINT_TREE.
+// Каталоги <prefix>/d* создаются перед прогревом. Ключи и размеры значений выбираются
+// равномерно или по Зипфу (--key-dist, --value-dist); ранги Зипфа перемешиваются, чтобы горячие
+// ключи не лежали в одном каталоге. errors - ответы не 2xx: в случайной смеси это обычно
+// создание существующего или удаление отсутствующего ключа.
+//
+// Запуск: database_loadgen [--host=ADDR] [--port=N] [--clients=N] [--pipeline=N]
+//         [--warmup=SECONDS] [--duration=SECONDS] [--mix=VERB:WEIGHT,...] [--keys=N]
+//         [--key-dist=uniform|zipf] [--value-min=BYTES] [--value-max=BYTES]
+//         [--value-dist=uniform|zipf] [--zipf-s=S] [--prefix=PATH] [--dirs=N] [--csv]
+// Пример: database_loadgen --clients=16 --pipeline=32 --key-dist=zipf --mix=SET_LEAF:3,GET_LEAF:1
+
+namespace {
+
+struct MixEntry {
+    Opcode opcode;
+    unsigned weight;
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int port = 12004;
+    int clients = 8;
+    size_t pipeline = 1;
+    double warmup = 2;
+    double duration = 10;
+    std::vector<MixEntry> mix = {{Opcode::CreateLeaf, 40}, {Opcode::DeleteLeaf, 20},
+                                 {Opcode::CreateNode, 15}, {Opcode::DeleteNode, 15},
+                                 {Opcode::PrintTree, 10}};
+    uint64_t keys = 100000;
+    bool zipf_keys = false;
+    size_t value_min = 16;
+    size_t value_max = 16;
+    bool zipf_values = false;
+    double zipf_s = 0.99;
+    std::string prefix = "/loadgen";
+    uint64_t dirs = 100;
+    bool csv = false;
+};
+
+enum class Phase : int { Warmup, Measure, Stop };
+
+// Выбор из [0, n): равномерно или по Зипфу с показателем s (ранг 0 - самый частый).
+class Sampler {
+   public:
+    Sampler(uint64_t n, bool zipf, double s) : n_(n) {
+        if (!zipf) {
+            return;
+        }
+        cdf_.resize(n);
+        double sum = 0;
+        for (uint64_t rank = 0; rank < n; ++rank) {
+            sum += 1.0 / std::pow(static_cast<double>(rank + 1), s);
+            cdf_[rank] = sum;
+        }
+        for (double &value : cdf_) {
+            value /= sum;
+        }
+    }
+
+    uint64_t operator()(std::mt19937_64 &random) const {
+        if (cdf_.empty()) {
+            return random() % n_;
+        }
+        double u = std::uniform_real_distribution<double>(0.0, 1.0)(random);
+        auto rank = static_cast<uint64_t>(std::lower_bound(cdf_.begin(), cdf_.end(), u) -
+                                          cdf_.begin());
+        return std::min(rank, n_ - 1);
+    }
+
+   private:
+    uint64_t n_;
+    std::vector<double> cdf_;  // Пуст для равномерного выбора
+};
+
+// Счетчики одного соединения; гистограммы пишет только его поток.
+struct WorkerStats {
+    explicit WorkerStats(size_t verbs) : latency(verbs), errors(verbs) {}
+
+    std::vector<LatencyHistogram> latency;  // По элементам смеси
+    std::vector<uint64_t> errors;
+};
+
+bool parse_mix(const std::string &text, std::vector<MixEntry> &mix) {
+    mix.clear();
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = std::min(text.find(',', start), text.size());
+        std::string item = text.substr(start, end - start);
+        size_t colon = item.find(':');
+        Opcode opcode = opcode_of(item.substr(0, colon));
+        int weight = colon == std::string::npos ? 1 : std::atoi(item.c_str() + colon + 1);
+        switch (opcode) {
+            case Opcode::CreateNode:
+            case Opcode::CreateLeaf:
+            case Opcode::DeleteNode:
+            case Opcode::DeleteLeaf:
+            case Opcode::PrintTree:
+            case Opcode::GetLeaf:
+            case Opcode::SetLeaf:
+                break;
+            default:
+                return false;
+        }
+        if (weight <= 0) {
+            return false;
+        }
+        mix.push_back({opcode, static_cast<unsigned>(weight)});
+        start = end + 1;
+    }
+    return !mix.empty();
+}
+
+bool parse_distribution(const std::string &value, bool &zipf) {
+    if (value != "uniform" && value != "zipf") {
+        return false;
+    }
+    zipf = value == "zipf";
+    return true;
+}
+
+bool parse_options(int argc, char const *argv[], Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+
+        if (key == "--host" && !value.empty()) {
+            options.host = value;
+        } else if (key == "--port" && std::atoi(value.c_str()) > 0) {
+            options.port = std::atoi(value.c_str());
+        } else if (key == "--clients" && std::atoi(value.c_str()) > 0) {
+            options.clients = std::atoi(value.c_str());
+        } else if (key == "--pipeline" && std::atoi(value.c_str()) > 0) {
+            options.pipeline = static_cast<size_t>(std::atoi(value.c_str()));
+        } else if (key == "--warmup" && std::atof(value.c_str()) >= 0 && !value.empty()) {
+            options.warmup = std::atof(value.c_str());
+        } else if (key == "--duration" && std::atof(value.c_str()) > 0) {
+            options.duration = std::atof(value.c_str());
+        } else if (key == "--mix" && parse_mix(value, options.mix)) {
+        } else if (key == "--keys" && std::atoll(value.c_str()) > 0) {
+            options.keys = static_cast<uint64_t>(std::atoll(value.c_str()));
+        } else if (key == "--key-dist" && parse_distribution(value, options.zipf_keys)) {
+        } else if (key == "--value-min" && !value.empty() && std::atoll(value.c_str()) >= 0) {
+            options.value_min = static_cast<size_t>(std::atoll(value.c_str()));
+        } else if (key == "--value-max" && !value.empty() && std::atoll(value.c_str()) >= 0) {
+            options.value_max = static_cast<size_t>(std::atoll(value.c_str()));
+        } else if (key == "--value-dist" && parse_distribution(value, options.zipf_values)) {
+        } else if (key == "--zipf-s" && std::atof(value.c_str()) > 0) {
+            options.zipf_s = std::atof(value.c_str());
+        } else if (key == "--prefix" && value.size() > 1 && value[0] == '/') {
+            options.prefix = value;
+        } else if (key == "--dirs" && std::atoll(value.c_str()) > 0) {
+            options.dirs = static_cast<uint64_t>(std::atoll(value.c_str()));
+        } else if (key == "--csv" && value.empty()) {
+            options.csv = true;
+        } else {
+            std::fprintf(stderr,
+                         "Unknown argument '%s'. Usage: database_loadgen [--host=ADDR] [--port=N]"
+                         " [--clients=N] [--pipeline=N] [--warmup=SECONDS] [--duration=SECONDS]"
+                         " [--mix=VERB:WEIGHT,...] [--keys=N] [--key-dist=uniform|zipf]"
+                         " [--value-min=BYTES] [--value-max=BYTES]"
+                         " [--value-dist=uniform|zipf] [--zipf-s=S] [--prefix=PATH] [--dirs=N]"
+                         " [--csv]\n",
+                         arg.c_str());
+            return false;
+        }
+    }
+    if (options.value_min > options.value_max || options.value_max >= kMaxCommandLength / 2) {
+        std::fprintf(stderr, "Expected --value-min <= --value-max < %zu\n",
+                     kMaxCommandLength / 2);
+        return false;
+    }
+    return true;
+}
+
+bool write_all(int fd, const std::string &data) {
+    size_t written = 0;
+    while (written < data.size()) {
+        ssize_t bytes = send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+        if (bytes <= 0) {
+            return false;
+        }
+        written += static_cast<size_t>(bytes);
+    }
+    return true;
+}
+
+// Входные данные соединения: ответы выбираются из начала, непрочитанное остается в буфере.
+struct Reader {
+    int fd;
+    std::string input;
+    size_t start = 0;
+
+    bool fill() {
+        if (start > 0) {
+            input.erase(0, start);
+            start = 0;
+        }
+        char chunk[64 * 1024];
+        ssize_t bytes = read(fd, chunk, sizeof(chunk));
+        if (bytes <= 0) {
+            return false;
+        }
+        input.append(chunk, static_cast<size_t>(bytes));
+        return true;
+    }
+
+    // Текстовая строка (приветствие сервера) без '\n'.
+    bool line(std::string_view &result) {
+        size_t end;
+        while ((end = input.find('\n', start)) == std::string::npos) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        result = std::string_view(input).substr(start, end - start);
+        start = end + 1;
+        return true;
+    }
+
+    // Ответ на бинарный запрос: u32 little-endian длина и текст.
+    bool reply(std::string_view &result) {
+        while (input.size() - start < 4) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        auto byte = [&](size_t i) { return static_cast<uint32_t>(
+                                        static_cast<unsigned char>(input[start + i])); };
+        size_t length = byte(0) | byte(1) << 8 | byte(2) << 16 | byte(3) << 24;
+        while (input.size() - start < 4 + length) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        result = std::string_view(input).substr(start + 4, length);
+        start += 4 + length;
+        return true;
+    }
+};
+
+// Соединение после приветствия сервера; -1 при ошибке.
+int connect_to(const sockaddr_in &address, Reader &reader) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    reader.fd = fd;
+    std::string_view greeting;
+    if (connect(fd, (const sockaddr *)&address, sizeof(address)) != 0 || !reader.line(greeting) ||
+        greeting.substr(0, 3) != "100") {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::string dir_of(const Options &options, uint64_t key) {
+    return options.prefix + "/d" + std::to_string(key % options.dirs);
+}
+
+std::string path_of(const Options &options, Opcode opcode, uint64_t key) {
+    switch (opcode) {
+        case Opcode::CreateNode:
+        case Opcode::DeleteNode:
+            return dir_of(options, key) + "/n" + std::to_string(key);
+        case Opcode::PrintTree:
+            return dir_of(options, key);
+        default:
+            return dir_of(options, key) + "/k" + std::to_string(key);
+    }
+}
+
+// Создает <prefix> и каталоги <prefix>/d*; уже существующие не мешают.
+bool create_directories(const sockaddr_in &address, const Options &options) {
+    Reader reader;
+    int fd = connect_to(address, reader);
+    if (fd < 0) {
+        return false;
+    }
+    std::string batch = encode_request(Opcode::CreateNode, options.prefix, "");
+    for (uint64_t dir = 0; dir < options.dirs; ++dir) {
+        batch += encode_request(Opcode::CreateNode, dir_of(options, dir), "");
+    }
+    bool ok = write_all(fd, batch);
+    std::string_view reply;
+    for (uint64_t i = 0; ok && i <= options.dirs; ++i) {
+        ok = reader.reply(reply);
+    }
+    close(fd);
+    return ok;
+}
+
+struct Shared {
+    const Options &options;
+    sockaddr_in address;
+    Sampler keys;
+    Sampler values;
+    std::atomic<Phase> phase{Phase::Warmup};
+    std::atomic<int> failed{0};
+};
+
+void run_client(Shared &shared, WorkerStats &stats, uint64_t seed) {
+    const Options &options = shared.options;
+    Reader reader;
+    int fd = connect_to(shared.address, reader);
+    if (fd < 0) {
+        shared.failed.fetch_add(1);
+        return;
+    }
+
+    unsigned total_weight = 0;
+    for (const auto &entry : options.mix) {
+        total_weight += entry.weight;
+    }
+    std::mt19937_64 random(seed);
+    const std::string filler(options.value_max, 'x');
+    std::string batch;
+    std::vector<size_t> sent;  // Элемент смеси каждой команды пачки
+    std::string_view reply;
+
+    while (shared.phase.load(std::memory_order_relaxed) != Phase::Stop) {
+        batch.clear();
+        sent.clear();
+        for (size_t i = 0; i < options.pipeline; ++i) {
+            unsigned pick = static_cast<unsigned>(random() % total_weight);
+            size_t entry = 0;
+            while (pick >= options.mix[entry].weight) {
+                pick -= options.mix[entry++].weight;
+            }
+            Opcode opcode = options.mix[entry].opcode;
+            // Перестановка рангов: 2654435761 - простое, взаимно простое с числом ключей
+            uint64_t key = shared.keys(random) * 2654435761u % options.keys;
+            std::string_view value;
+            if (opcode == Opcode::CreateLeaf || opcode == Opcode::SetLeaf) {
+                value = std::string_view(filler).substr(0,
+                                                        options.value_min + shared.values(random));
+            }
+            batch += encode_request(opcode, path_of(options, opcode, key), value);
+            sent.push_back(entry);
+        }
+
+        bool measured = shared.phase.load(std::memory_order_relaxed) == Phase::Measure;
+        uint64_t start = monotonic_ns();
+        if (!write_all(fd, batch)) {
+            shared.failed.fetch_add(1);
+            break;
+        }
+        for (size_t entry : sent) {
+            if (!reader.reply(reply)) {
+                shared.failed.fetch_add(1);
+                close(fd);
+                return;
+            }
+            if (measured) {
+                stats.latency[entry].record(monotonic_ns() - start);
+                stats.errors[entry] += reply.empty() || reply[0] != '2';
+            }
+        }
+    }
+    close(fd);
+}
+
+void print_row(const Options &options, std::string_view verb, const HistogramSnapshot &latency,
+               uint64_t errors, double seconds) {
+    auto usec = [](double ns) { return ns / 1e3; };
+    const char *format = options.csv
+                             ? "%s,%llu,%llu,%.0f,%.1f,%.1f,%.1f,%.1f,%.1f\n"
+                             : "%-12s %10llu %8llu %12.0f %9.1f %9.1f %9.1f %9.1f %9.1f\n";
+    std::printf(format, std::string(verb).c_str(), static_cast<unsigned long long>(latency.count),
+                static_cast<unsigned long long>(errors), latency.count / seconds,
+                usec(latency.mean()), usec(latency.percentile(0.5)),
+                usec(latency.percentile(0.99)), usec(latency.percentile(0.999)),
+                usec(latency.max));
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        return 1;
+    }
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.port);
+    if (inet_pton(AF_INET, options.host.c_str(), &address.sin_addr) != 1) {
+        std::fprintf(stderr, "Invalid address %s\n", options.host.c_str());
+        return 1;
+    }
+    if (!create_directories(address, options)) {
+        std::fprintf(stderr, "Failed to connect to %s:%d\n", options.host.c_str(), options.port);
+        return 1;
+    }
+
+    Shared shared{options, address,
+                  Sampler(options.keys, options.zipf_keys, options.zipf_s),
+                  Sampler(options.value_max - options.value_min + 1, options.zipf_values,
+                          options.zipf_s)};
+    std::vector<std::unique_ptr<WorkerStats>> stats;
+    std::vector<std::thread> threads;
+    for (int c = 0; c < options.clients; ++c) {
+        stats.push_back(std::make_unique<WorkerStats>(options.mix.size()));
+        threads.emplace_back(run_client, std::ref(shared), std::ref(*stats.back()), c + 1);
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.warmup));
+    uint64_t start = monotonic_ns();
+    shared.phase = Phase::Measure;
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+    shared.phase = Phase::Stop;
+    double seconds = (monotonic_ns() - start) / 1e9;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    if (shared.failed > 0) {
+        std::fprintf(stderr, "%d connections failed or were closed by the server\n",
+                     shared.failed.load());
+    }
+
+    if (!options.csv) {
+        std::printf("clients %d, pipeline %zu, keys %llu (%s), values %zu..%zu bytes (%s)\n",
+                    options.clients, options.pipeline,
+                    static_cast<unsigned long long>(options.keys),
+                    options.zipf_keys ? "zipf" : "uniform", options.value_min, options.value_max,
+                    options.zipf_values ? "zipf" : "uniform");
+        std::printf("warm-up %.1f s, measured %.1f s, latency in usec\n\n", options.warmup,
+                    seconds);
+        std::printf("%-12s %10s %8s %12s %9s %9s %9s %9s %9s\n", "verb", "requests", "errors",
+                    "ops/s", "avg", "p50", "p99", "p999", "max");
+    } else {
+        std::printf("verb,requests,errors,ops_per_sec,avg_us,p50_us,p99_us,p999_us,max_us\n");
+    }
+
+    HistogramSnapshot total;
+    uint64_t total_errors = 0;
+    for (size_t entry = 0; entry < options.mix.size(); ++entry) {
+        HistogramSnapshot latency;
+        uint64_t errors = 0;
+        for (const auto &worker : stats) {
+            latency.merge(worker->latency[entry]);
+            total.merge(worker->latency[entry]);
+            errors += worker->errors[entry];
+        }
+        total_errors += errors;
+        print_row(options, verb_of(options.mix[entry].opcode), latency, errors, seconds);
+    }
+    print_row(options, "total", total, total_errors, seconds);
+    return shared.failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,85 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "logger.hpp"
+
+// Стоимость строки журнала на одну команду сервера в рабочем потоке:
+//   cout    - прежний способ: std::cout << ... << std::endl (запись и сброс на каждую строку);
+//   off     - LOG_DEBUG при уровне info: только проверка уровня;
+//   async   - LOG_INFO: форматирование в кольцевой буфер потока, запись - в фоновом потоке.
+// Вывод журнала и std::cout перенаправляются в файл, как у сервера в эксплуатации.
+//
+// Запуск: logging_bench [threads] [log_path]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kLines = 128 * 1000;
+
+// Наносекунд на строку при одновременной записи из threads потоков. Строки пишутся пачками по
+// kBurst с паузой между ними, как команды конвейера; паузы в результат не входят.
+constexpr int kBurst = 128;
+
+template <typename Write>
+double measure(int threads, Write write) {
+    std::vector<std::thread> workers;
+    std::vector<double> busy_ns(threads, 0.0);
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::string path = "/Users/user_42/session";
+            for (int i = 0; i < kLines; i += kBurst) {
+                auto start = Clock::now();
+                for (int j = i; j < i + kBurst; ++j) {
+                    write(path, j);
+                }
+                auto busy = Clock::now() - start;
+                busy_ns[t] += std::chrono::duration<double, std::nano>(busy).count();
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    double total = 0;
+    for (double ns : busy_ns) {
+        total += ns;
+    }
+    return total / threads / kLines;
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    int threads = argc > 1 ? std::atoi(argv[1]) : 4;
+    const char *log_path = argc > 2 ? argv[2] : "/tmp/logging_bench.log";
+    if (!std::freopen(log_path, "w", stdout) || !log_init(LogLevel::Info, log_path)) {
+        std::fprintf(stderr, "cannot open %s\n", log_path);
+        return 1;
+    }
+
+    double cout_ns = measure(threads, [](const std::string &path, int i) {
+        std::cout << "  Command: 'SET_LEAF', Path: '" << path << "', Value: '" << i << "'"
+                  << std::endl;
+    });
+    double off_ns = measure(threads, [](const std::string &path, int i) {
+        LOG_DEBUG("Command: 'SET_LEAF', Path: '", path, "', Value: '", i, "'");
+    });
+    double async_ns = measure(threads, [](const std::string &path, int i) {
+        LOG_INFO("Command: 'SET_LEAF', Path: '", path, "', Value: '", i, "'");
+    });
+    log_shutdown();
+
+    std::fprintf(stderr, "threads: %d, %d lines each\n", threads, kLines);
+    std::fprintf(stderr, "%-8s %10s\n", "mode", "ns/line");
+    std::fprintf(stderr, "%-8s %10.1f\n", "cout", cout_ns);
+    std::fprintf(stderr, "%-8s %10.1f\n", "off", off_ns);
+    std::fprintf(stderr, "%-8s %10.1f\n", "async", async_ns);
+    return 0;
+}
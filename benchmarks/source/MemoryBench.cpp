@@ -0,0 +1,103 @@
+#include <malloc.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "compactTree.hpp"
+#include "segmentTree.hpp"
+#include "tree.hpp"
+
+// Сравнение потребления памяти на запись: полные пути в каждой записи (tree.hpp),
+// посегментное хранение с интернированием и сжатием цепочек (segmentTree.hpp)
+// и таблицы слотов с 32-битными связями (compactTree.hpp).
+//
+// Синтетическое глубокое дерево:
+//   /tenantI/region/eu/users/userJ/sessions/active/sessionK
+// 100 арендаторов * 100 пользователей * 100 листьев = 1M листьев.
+
+namespace {
+
+constexpr int kTenants = 100;
+constexpr int kUsers = 100;
+constexpr int kLeaves = 100;
+
+size_t heap_in_use() { return mallinfo2().uordblks; }
+
+// Обходит синтетическое дерево в порядке создания и вызывает on_node/on_leaf для каждого пути.
+template <typename OnNode, typename OnLeaf>
+void build(OnNode on_node, OnLeaf on_leaf) {
+    for (int t = 0; t < kTenants; ++t) {
+        std::string tenant = "/tenant" + std::to_string(t);
+        on_node(tenant);
+        on_node(tenant + "/region");
+        on_node(tenant + "/region/eu");
+        on_node(tenant + "/region/eu/users");
+        for (int u = 0; u < kUsers; ++u) {
+            std::string user = tenant + "/region/eu/users/user" + std::to_string(u);
+            on_node(user);
+            on_node(user + "/sessions");
+            on_node(user + "/sessions/active");
+            for (int l = 0; l < kLeaves; ++l) {
+                on_leaf(user + "/sessions/active/session" + std::to_string(l), "v");
+            }
+        }
+    }
+}
+
+void report(const char *name, size_t bytes, size_t entries, double seconds) {
+    std::printf("%-14s %12zu %10zu %14.1f %10.2f\n", name, bytes, entries,
+                static_cast<double>(bytes) / static_cast<double>(entries), seconds);
+}
+
+}  // namespace
+
+int main() {
+    std::printf("%-14s %12s %10s %14s %10s\n", "storage", "heap bytes", "entries",
+                "bytes/entry", "build s");
+
+    {
+        size_t before = heap_in_use();
+        auto start = std::chrono::steady_clock::now();
+        auto root = create_root_node();
+        size_t entries = 0;
+        build(
+            [&](const std::string &path) {
+                create_node_by_path(root, path);
+                ++entries;
+            },
+            [&](const std::string &path, const char *value) {
+                create_leaf_by_path(root, path, value);
+                ++entries;
+            });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        report("full paths", heap_in_use() - before, entries, elapsed.count());
+    }
+
+    {
+        size_t before = heap_in_use();
+        auto start = std::chrono::steady_clock::now();
+        SegmentTree tree;
+        build([&](const std::string &path) { tree.create_node(path); },
+              [&](const std::string &path, const char *value) { tree.create_leaf(path, value); });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        report("segments", heap_in_use() - before, tree.node_count() + tree.leaf_count(),
+               elapsed.count());
+        std::printf("  unique segments: %zu, radix nodes: %zu for %zu directories\n",
+                    tree.segments().size(), tree.compressed_node_count(), tree.node_count());
+    }
+
+    {
+        size_t before = heap_in_use();
+        auto start = std::chrono::steady_clock::now();
+        CompactTree tree;
+        build([&](const std::string &path) { create_node_by_path(tree, path); },
+              [&](const std::string &path, const char *value) {
+                  create_leaf_by_path(tree, path, value);
+              });
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        report("compact", heap_in_use() - before, tree.node_count() + tree.leaf_count(),
+               elapsed.count());
+    }
+    return 0;
+}
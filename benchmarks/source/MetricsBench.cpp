@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.hpp"
+#include "pathLock.hpp"
+
+// Цена метрик на пути команды:
+//   - record   - запись длительности в гистограмму потока (record_command);
+//   - clock    - одно чтение monotonic_ns (на команду их два);
+//   - command  - полный учет команды: два чтения часов и record;
+//   - record из 1, 4 и 8 потоков одновременно: блоки потоков не делят строк кэша, поэтому
+//     общая стоимость вызова не растет с числом потоков (пока хватает ядер);
+//   - PathLock S на каталоге глубины 3 вместе с учетом захвата и удержания;
+//   - collect  - сводка по всем потокам для INFO.
+//
+// Запуск: metrics_bench [iterations]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ns_per(Clock::time_point start, long iterations) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    long iterations = argc > 1 ? std::atol(argv[1]) : 20000000;
+
+    auto start = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        record_command(Opcode::GetLeaf, static_cast<uint64_t>(i & 0xFFFF));
+    }
+    std::printf("record   %6.2f ns\n", ns_per(start, iterations));
+
+    uint64_t sink = 0;
+    start = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        sink += monotonic_ns();
+    }
+    std::printf("clock    %6.2f ns\n", ns_per(start, iterations));
+
+    start = Clock::now();
+    for (long i = 0; i < iterations; ++i) {
+        uint64_t begin = monotonic_ns();
+        record_command(Opcode::SetLeaf, monotonic_ns() - begin);
+    }
+    std::printf("command  %6.2f ns\n", ns_per(start, iterations));
+
+    for (int threads : {1, 4, 8}) {
+        std::vector<std::thread> workers;
+        start = Clock::now();
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([iterations] {
+                for (long i = 0; i < iterations; ++i) {
+                    record_command(Opcode::MGet, static_cast<uint64_t>(i & 0xFFFF));
+                }
+            });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        std::printf("record, %d threads  %6.2f ns per call overall\n", threads,
+                    ns_per(start, iterations * threads));
+    }
+
+    auto root = create_root_node();
+    create_node_by_path(root, "/a");
+    create_node_by_path(root, "/a/b");
+    create_node_by_path(root, "/a/b/c");
+    long locks = iterations / 10;
+    start = Clock::now();
+    for (long i = 0; i < locks; ++i) {
+        PathLock lock(root, "/a/b/c", LockMode::Shared);
+    }
+    std::printf("PathLock S depth 3  %6.2f ns\n", ns_per(start, locks));
+
+    start = Clock::now();
+    MetricsSnapshot metrics = collect_metrics();
+    std::printf("collect  %6.2f us  (%llu commands recorded)\n", ns_per(start, 1) / 1e3,
+                static_cast<unsigned long long>(
+                    metrics.commands[static_cast<size_t>(Opcode::MGet)].count));
+    return sink == 0 ? 1 : 0;
+}
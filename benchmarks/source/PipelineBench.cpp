@@ -0,0 +1,101 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Пропускная способность работающего database_server на мелких командах при разной глубине
+// конвейера: клиент отправляет depth команд "hello" одним write() и ждет depth ответов.
+//
+// Запуск: server_pipeline_bench [host] [port] [connections] [duration_ms]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Читает из сокета, пока не наберется lines строк. Возвращает false при ошибке.
+bool read_lines(int fd, size_t lines) {
+    char chunk[64 * 1024];
+    size_t seen = 0;
+    while (seen < lines) {
+        ssize_t bytes_read = read(fd, chunk, sizeof(chunk));
+        if (bytes_read <= 0) {
+            return false;
+        }
+        seen += std::count(chunk, chunk + bytes_read, '\n');
+    }
+    return true;
+}
+
+double run(const sockaddr_in &address, int connections, size_t depth,
+           std::chrono::milliseconds duration) {
+    std::string batch;
+    for (size_t i = 0; i < depth; ++i) {
+        batch += "hello\n";
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> ops{0};
+    std::vector<std::thread> threads;
+    for (int c = 0; c < connections; ++c) {
+        threads.emplace_back([&] {
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            if (fd < 0 || connect(fd, (const sockaddr *)&address, sizeof(address)) != 0 ||
+                !read_lines(fd, 1)) {
+                std::fprintf(stderr, "connection failed\n");
+                close(fd);
+                return;
+            }
+            size_t local = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (write(fd, batch.data(), batch.size()) < 0 || !read_lines(fd, depth)) {
+                    break;
+                }
+                local += depth;
+            }
+            ops += local;
+            close(fd);
+        });
+    }
+
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return static_cast<double>(ops) / std::chrono::duration<double>(duration).count();
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    const char *host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? std::atoi(argv[2]) : 12004;
+    int connections = argc > 3 ? std::atoi(argv[3]) : 4;
+    auto duration = std::chrono::milliseconds(argc > 4 ? std::atoi(argv[4]) : 2000);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = inet_addr(host);
+
+    std::printf("connections: %d\n", connections);
+    std::printf("%8s %14s\n", "depth", "ops/s");
+    double baseline = 0;
+    for (size_t depth : {1, 16, 128}) {
+        double rate = run(address, connections, depth, duration);
+        if (depth == 1) {
+            baseline = rate;
+        }
+        std::printf("%8zu %14.0f  (x%.1f)\n", depth, rate, baseline > 0 ? rate / baseline : 0.0);
+    }
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "protocol.hpp"
+
+// Стоимость разбора и выбора команды на сервере, без сети и без работы с деревом:
+//   legacy - прежний путь: std::stringstream на каждую строку, линейный поиск по таблице строк
+//            и обработчик, принимающий std::string по значению;
+//   text   - parse_request + идеальный хеш глагола, аргументы std::string_view;
+//   binary - parse_request по бинарным фреймам, опкод - индекс в таблице.
+// Выделения памяти считаются подменой глобального operator new.
+
+namespace {
+
+std::atomic<size_t> g_allocations{0};
+
+}  // namespace
+
+void *operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *pointer = std::malloc(size)) {
+        return pointer;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, size_t) noexcept { std::free(pointer); }
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kCommands = 1000000;
+constexpr int kRuns = 5;
+
+size_t g_sink = 0;
+
+using LegacyCallback = int (*)(std::string path, std::string value);
+using ViewCallback = int (*)(std::string_view path, std::string_view value);
+
+int legacy_handler(std::string path, std::string value) {
+    g_sink += path.size() + value.size();
+    return 0;
+}
+
+int view_handler(std::string_view path, std::string_view value) {
+    g_sink += path.size() + value.size();
+    return 0;
+}
+
+struct LegacyHandler {
+    std::string command;
+    LegacyCallback callback;
+};
+
+const std::vector<LegacyHandler> kLegacyHandlers = {
+    {"hello", legacy_handler},       {"CREATE_NODE", legacy_handler},
+    {"CREATE_LEAF", legacy_handler}, {"DELETE_NODE", legacy_handler},
+    {"DELETE_LEAF", legacy_handler}, {"PRINT_TREE", legacy_handler}};
+
+// Смесь команд: в основном листья, как в нагрузке кеша.
+Opcode opcode_for(int i) {
+    switch (i % 8) {
+        case 0:
+            return Opcode::PrintTree;
+        case 1:
+        case 2:
+            return Opcode::DeleteLeaf;
+        default:
+            return Opcode::CreateLeaf;
+    }
+}
+
+std::string path_for(int i) { return "/Users/user_" + std::to_string(i % 1000) + "/session"; }
+
+void run_legacy(const std::string &input) {
+    // Как раньше: строка -> stringstream -> std::string command/path/value
+    size_t begin = 0;
+    size_t end;
+    while ((end = input.find('\n', begin)) != std::string::npos) {
+        std::stringstream ss(input.substr(begin, end - begin));
+        std::string command, path, value;
+        ss >> command >> path;
+        std::getline(ss, value);
+        if (!value.empty() && value.front() == ' ') {
+            value.erase(0, 1);
+        }
+        for (const auto &handler : kLegacyHandlers) {
+            if (handler.command == command) {
+                handler.callback(path, value);
+                break;
+            }
+        }
+        begin = end + 1;
+    }
+}
+
+void run_parser(const std::string &input) {
+    static const std::array<ViewCallback, 256> table = [] {
+        std::array<ViewCallback, 256> callbacks{};
+        for (const auto &spec : kCommandSpecs) {
+            callbacks[static_cast<uint8_t>(spec.opcode)] = view_handler;
+        }
+        return callbacks;
+    }();
+
+    std::string_view rest = input;
+    Request request;
+    size_t consumed = 0;
+    while (parse_request(rest, request, consumed) == ParseStatus::Complete) {
+        if (ViewCallback callback = table[static_cast<uint8_t>(request.opcode)]) {
+            callback(request.path, request.value);
+        }
+        rest.remove_prefix(consumed);
+    }
+}
+
+template <typename Run>
+void measure(const char *name, const std::string &input, Run run) {
+    double best = 1e18;
+    size_t allocations = 0;
+    for (int r = 0; r < kRuns; ++r) {
+        size_t before = g_allocations.load();
+        auto start = Clock::now();
+        run(input);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        allocations = g_allocations.load() - before;
+        best = std::min(best, ns);
+    }
+    std::printf("%-8s %10.1f %14.2f %12.1f\n", name, best / kCommands,
+                static_cast<double>(allocations) / kCommands,
+                input.size() / (best / 1e9) / (1024.0 * 1024.0));
+}
+
+}  // namespace
+
+int main() {
+    std::string text;
+    std::string binary;
+    for (int i = 0; i < kCommands; ++i) {
+        Opcode opcode = opcode_for(i);
+        std::string path = path_for(i);
+        std::string value =
+            opcode == Opcode::CreateLeaf ? "value of leaf number " + std::to_string(i) : "";
+        text.append(verb_of(opcode)).append(" ").append(path);
+        if (!value.empty()) {
+            text.append(" ").append(value);
+        }
+        text.append("\n");
+        binary += encode_request(opcode, path, value);
+    }
+
+    std::printf("%d commands\n", kCommands);
+    std::printf("%-8s %10s %14s %12s\n", "path", "ns/cmd", "allocs/cmd", "MB/s");
+    measure("legacy", text, run_legacy);
+    measure("text", text, run_parser);
+    measure("binary", binary, run_parser);
+    std::printf("(checksum %zu)\n", g_sink);
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Шторм переподключений к работающему database_server: clients потоков в цикле открывают
+// соединение, дожидаются приветствия "100 Connected" и закрывают сокет. Задержка соединения -
+// время от connect() до получения приветствия, то есть включая ожидание в очереди accept.
+//
+// Запуск: server_reconnect_bench [host] [port] [clients] [duration_ms]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Возвращает задержку в микросекундах или -1, если соединение не удалось.
+long connect_once(const sockaddr_in &address) {
+    auto start = Clock::now();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    // Соединение, которое сервер так и не принял, считается неудачным
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    bool ok = connect(fd, (const sockaddr *)&address, sizeof(address)) == 0;
+    char greeting[64];
+    ok = ok && read(fd, greeting, sizeof(greeting)) > 0;
+    close(fd);
+    if (!ok) {
+        return -1;
+    }
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    const char *host = argc > 1 ? argv[1] : "127.0.0.1";
+    int port = argc > 2 ? std::atoi(argv[2]) : 12004;
+    int clients = argc > 3 ? std::atoi(argv[3]) : 64;
+    auto duration = std::chrono::milliseconds(argc > 4 ? std::atoi(argv[4]) : 3000);
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = inet_addr(host);
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> failures{0};
+    std::vector<std::vector<long>> latencies(clients);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                long latency = connect_once(address);
+                if (latency < 0) {
+                    ++failures;
+                } else {
+                    latencies[c].push_back(latency);
+                }
+            }
+        });
+    }
+
+    std::this_thread::sleep_for(duration);
+    stop = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    std::vector<long> all;
+    for (const auto &local : latencies) {
+        all.insert(all.end(), local.begin(), local.end());
+    }
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) {
+        return all.empty() ? 0L : all[std::min(all.size() - 1, size_t(p * all.size()))];
+    };
+
+    double seconds = std::chrono::duration<double>(duration).count();
+    std::printf("clients: %d, duration: %.1f s\n", clients, seconds);
+    std::printf("accepted: %zu (%.0f conn/s), failed: %zu\n", all.size(), all.size() / seconds,
+                failures.load());
+    std::printf("connect latency us: p50 %ld, p99 %ld, max %ld\n", percentile(0.50),
+                percentile(0.99), all.empty() ? 0L : all.back());
+    return 0;
+}
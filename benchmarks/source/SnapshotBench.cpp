@@ -0,0 +1,189 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "binaryFile.hpp"
+#include "mutationLog.hpp"
+#include "pathLock.hpp"
+#include "snapshot.hpp"
+
+// Образ дерева из N листьев (1000 каталогов, значения по 32 байта):
+//   - задержка записи SET_LEAF (X на каталоге) в другом потоке, пока образ пишется:
+//     fork    - fork_snapshot(), как команда SNAPSHOT;
+//     locked  - write_snapshot() под S на корне, то есть с остановкой всех писателей;
+//   - время загрузки: load_snapshot() против проигрывания журнала с CreateNode/CreateLeaf.
+//
+// Запуск: snapshot_bench [leaves] [dir]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kDirectories = 1000;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+std::shared_ptr<Node> build_tree(int leaves) {
+    auto root = create_root_node();
+    std::vector<std::shared_ptr<Node>> dirs;
+    for (int d = 0; d < kDirectories; ++d) {
+        dirs.push_back(create_node(root, "/tenant_" + std::to_string(d)));
+    }
+    std::string value(32, 'v');
+    for (int i = 0; i < leaves; ++i) {
+        const auto &dir = dirs[i % kDirectories];
+        create_leaf(dir, std::string(dir->path) + "/leaf_" + std::to_string(i), value);
+    }
+    return root;
+}
+
+struct s_latency {
+    double p50_us;
+    double p99_us;
+    double max_us;
+    size_t writes;
+};
+
+using Latency = struct s_latency;
+
+// Пишет в /tenant_0 с паузой 100 мкс, как клиент, пока выполняется action.
+template <typename Action>
+Latency measure_writes(const std::shared_ptr<Node> &root, Action action) {
+    std::atomic<bool> stop{false};
+    std::vector<double> samples;
+    std::thread writer([&] {
+        std::string path = "/tenant_0/leaf_0";
+        for (int i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+            auto start = Clock::now();
+            {
+                PathLock lock(root, "/tenant_0", LockMode::Exclusive);
+                set_leaf_by_path(root, path, std::to_string(i));
+            }
+            samples.push_back(seconds_since(start) * 1e6);
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    action();
+    stop = true;
+    writer.join();
+
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return samples[static_cast<size_t>(q * (samples.size() - 1))]; };
+    return {at(0.5), at(0.99), samples.back(), samples.size()};
+}
+
+// Журнал, который дал бы то же дерево: каталог, затем его листья.
+void write_replay_log(const std::shared_ptr<Node> &root, const std::string &path) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    std::string out(kMutationLogMagic);
+    for (const auto &dir : root->childs) {
+        encode_log_record(out, TreeChangeKind::CreateNode, dir->path, {});
+        for (const Leaf *leaf = dir->east.get(); leaf; leaf = leaf->east.get()) {
+            encode_log_record(out, TreeChangeKind::CreateLeaf, leaf->path, leaf->value);
+        }
+        if (out.size() > (1 << 20)) {
+            write_all(fd, out);
+            out.clear();
+        }
+    }
+    write_all(fd, out);
+    close(fd);
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    int leaves = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    std::string dir = argc > 2 ? argv[2] : "/tmp";
+    std::string image = dir + "/snapshot_bench.mcdb";
+    std::string log = dir + "/snapshot_bench.aof";
+
+    auto start = Clock::now();
+    auto root = build_tree(leaves);
+    std::printf("%d leaves in %d directories, built in %.2f s\n", leaves, kDirectories,
+                seconds_since(start));
+
+    std::printf("%-8s %10s %8s %9s %9s %9s\n", "writes", "snapshot", "count", "p50 us",
+                "p99 us", "max us");
+    auto report = [](const char *name, double snapshot_s, const Latency &latency) {
+        std::printf("%-8s %8.2f s %8zu %9.1f %9.1f %9.1f\n", name, snapshot_s, latency.writes,
+                    latency.p50_us, latency.p99_us, latency.max_us);
+    };
+
+    double idle_s = 0;
+    Latency idle = measure_writes(root, [&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    });
+    report("idle", idle_s, idle);
+
+    double fork_s = 0;
+    Latency forked = measure_writes(root, [&] {
+        auto begin = Clock::now();
+        pid_t pid = fork_snapshot(root, image);
+        if (pid < 0 || !wait_snapshot(pid)) {
+            std::exit(1);
+        }
+        fork_s = seconds_since(begin);
+    });
+    report("fork", fork_s, forked);
+
+    double locked_s = 0;
+    Latency locked = measure_writes(root, [&] {
+        auto begin = Clock::now();
+        PathLock lock(root, "/", LockMode::Shared);
+        if (!write_snapshot(root, image)) {
+            std::exit(1);
+        }
+        locked_s = seconds_since(begin);
+    });
+    report("locked", locked_s, locked);
+
+    write_replay_log(root, log);
+    std::printf("image %.1f MiB, equivalent mutation log %.1f MiB\n",
+                std::filesystem::file_size(image) / (1024.0 * 1024.0),
+                std::filesystem::file_size(log) / (1024.0 * 1024.0));
+    root.reset();
+
+    start = Clock::now();
+    auto loaded = create_root_node();
+    size_t entries = 0;
+    if (!load_snapshot(loaded, image, &entries)) {
+        return 1;
+    }
+    double load_s = seconds_since(start);
+    std::printf("load_snapshot: %zu entries in %.2f s (%.2f M entries/s)\n", entries, load_s,
+                entries / load_s / 1e6);
+    loaded.reset();
+
+    start = Clock::now();
+    auto replayed_root = create_root_node();
+    size_t replayed = 0;
+    {
+        MutationLogOptions options;
+        options.path = log;
+        options.fsync = FsyncPolicy::Never;
+        MutationLog replay(options);
+        if (!replay.open(replayed_root, &replayed)) {
+            return 1;
+        }
+    }
+    double replay_s = seconds_since(start);
+    std::printf("log replay:    %zu entries in %.2f s (%.2f M entries/s)\n", replayed, replay_s,
+                replayed / replay_s / 1e6);
+
+    std::filesystem::remove(image);
+    std::filesystem::remove(log);
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pathLock.hpp"
+#include "tree.hpp"
+
+// Цена итогов поддерева (subtree_stats_of):
+//   - запись - SET_LEAF нового листа и его удаление в каталоге глубины 1, 4 и 16: счетчики
+//     обновляются у каждого предка, поэтому стоимость растет с глубиной;
+//   - то же из нескольких потоков в соседних каталогах: все писатели меняют счетчики корня;
+//   - чтение - итоги поддерева из N листьев за O(1) против подсчета обходом.
+//
+// Запуск: subtree_stats_bench [leaves]
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Цепочка каталогов заданной глубины под prefix; возвращает путь самого глубокого.
+std::string create_chain(const std::shared_ptr<Node> &root, const std::string &prefix,
+                         int depth) {
+    std::string path;
+    for (int level = 0; level < depth; ++level) {
+        path += (level == 0 ? prefix : "/d" + std::to_string(level));
+        create_node_by_path(root, path);
+    }
+    return path;
+}
+
+// Наносекунд на пару "создать лист, удалить лист" под X-блокировкой каталога.
+double write_ns(const std::shared_ptr<Node> &root, const std::string &dir, int leaves) {
+    std::string value(16, 'v');
+    auto start = Clock::now();
+    for (int i = 0; i < leaves; ++i) {
+        std::string path = dir + "/k" + std::to_string(i);
+        PathLock lock = PathLock::parent_of(root, path, LockMode::Exclusive);
+        auto leaf = set_child_leaf(lock.node(), path, value);
+        delete_leaf(root, leaf);
+    }
+    return seconds_since(start) / leaves * 1e9;
+}
+
+uint64_t count_by_walk(const Node &node) {
+    uint64_t leaves = 0;
+    for (const Leaf *leaf = node.east.get(); leaf; leaf = leaf->east.get()) {
+        ++leaves;
+    }
+    for (const auto &child : node.childs) {
+        leaves += count_by_walk(*child);
+    }
+    return leaves;
+}
+
+}  // namespace
+
+int main(int argc, char const *argv[]) {
+    int leaves = argc > 1 ? std::atoi(argv[1]) : 1000000;
+    auto root = create_root_node();
+
+    std::printf("write: set + delete of one leaf, %d times\n", leaves);
+    for (int depth : {1, 4, 16}) {
+        std::string dir = create_chain(root, "/depth" + std::to_string(depth), depth);
+        std::printf("  depth %2d  %8.1f ns\n", depth, write_ns(root, dir, leaves));
+    }
+
+    for (int threads : {1, 4, 8}) {
+        std::vector<std::string> dirs;
+        for (int t = 0; t < threads; ++t) {
+            dirs.push_back(create_chain(root, "/mt" + std::to_string(threads) + "_" +
+                                                  std::to_string(t), 4));
+        }
+        std::vector<std::thread> workers;
+        std::vector<double> ns(threads);
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] { ns[t] = write_ns(root, dirs[t], leaves / threads); });
+        }
+        for (auto &worker : workers) {
+            worker.join();
+        }
+        double total = 0;
+        for (double value : ns) {
+            total += value;
+        }
+        std::printf("  %d threads, depth 4: %8.1f ns per write in each thread\n", threads,
+                    total / threads);
+    }
+
+    std::string dir = create_chain(root, "/read", 2);
+    auto node = find_node_by_path_linear(root, dir);
+    for (int i = 0; i < leaves; ++i) {
+        create_leaf(node, dir + "/k" + std::to_string(i), "v");
+    }
+    auto top = find_node_by_path_linear(root, "/read");
+    constexpr int kReads = 1000000;
+    uint64_t sum = 0;
+    auto start = Clock::now();
+    for (int i = 0; i < kReads; ++i) {
+        sum += subtree_stats_of(*top).leaves;
+    }
+    double stats_ns = seconds_since(start) / kReads * 1e9;
+    start = Clock::now();
+    uint64_t walked = count_by_walk(*top);
+    double walk_ms = seconds_since(start) * 1e3;
+    std::printf("read: %d leaves  subtree_stats_of %.1f ns  walk %.2f ms\n", leaves, stats_ns,
+                walk_ms);
+    return sum == walked * kReads ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+Общие примитивы двоичных файлов: журнала изменений (mutationLog.hpp) и образа дерева
+(snapshot.hpp). Числа пишутся в little-endian, длины - в LEB128.
+*/
+
+// CRC-32 (IEEE). Для потока данных: crc = crc32_update(crc, part), начиная с 0.
+uint32_t crc32_update(uint32_t crc, std::string_view data);
+
+inline uint32_t crc32(std::string_view data) { return crc32_update(0, data); }
+
+void append_varint(std::string &out, uint64_t value);
+
+// Читает LEB128 с позиции position и сдвигает ее. false, если число оборвано.
+bool read_varint(std::string_view data, size_t &position, uint64_t &value);
+
+void append_u32(std::string &out, uint32_t value);
+
+uint32_t read_u32(const char *data);
+
+// write() всего буфера с повтором после EINTR и частичной записи.
+bool write_all(int fd, std::string_view data);
+
+// Дочитывает файл от текущей позиции до конца.
+bool read_all(int fd, std::string &data);
+
+// rename() становится долговечным только после fsync каталога, в котором лежит файл.
+void sync_parent_directory(const std::string &path);
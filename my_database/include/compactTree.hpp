@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "segmentTree.hpp"
+
+/*
+Компактное представление дерева без shared_ptr/weak_ptr. Узлы и листья лежат в двух таблицах
+(std::vector), связи между ними - 32-битные индексы слотов. Снаружи записи адресуются
+дескрипторами {index, generation}: при освобождении слота его поколение увеличивается, поэтому
+дескриптор удаленной записи перестает быть валидным, даже если слот уже переиспользован.
+
+Имена хранятся как интернированные сегменты (SegmentTable из segmentTree.hpp), поиск ребенка по
+имени - одна хеш-таблица на все дерево с ключом (индекс родителя, сегмент). Обход дерева
+не владеет записями и не трогает атомарные счетчики ссылок.
+
+В конце файла - тонкий слой совместимости: функции с теми же именами, что и в tree.hpp,
+принимающие CompactTree вместо корневого std::shared_ptr<Node>.
+*/
+
+inline constexpr uint32_t kNilIndex = UINT32_MAX;
+
+// Дескриптор записи: индекс слота в таблице и поколение слота на момент выдачи.
+template <typename Tag>
+struct CompactHandle {
+    uint32_t index = kNilIndex;
+    uint32_t generation = 0;
+
+    explicit operator bool() const { return index != kNilIndex; }
+    bool operator==(const CompactHandle &) const = default;
+};
+
+struct s_compact_node_tag;
+struct s_compact_leaf_tag;
+using NodeHandle = CompactHandle<s_compact_node_tag>;
+using LeafHandle = CompactHandle<s_compact_leaf_tag>;
+
+struct s_compact_node {
+    uint32_t generation = 0;
+    bool live = false;
+    SegmentId name = kNoSegment;
+    uint32_t parent = kNilIndex;
+    uint32_t first_child = kNilIndex;
+    uint32_t last_child = kNilIndex;
+    uint32_t prev_sibling = kNilIndex;
+    uint32_t next_sibling = kNilIndex;  // Для свободного слота - следующий свободный
+    uint32_t first_leaf = kNilIndex;
+    uint32_t last_leaf = kNilIndex;
+};
+
+struct s_compact_leaf {
+    uint32_t generation = 0;
+    bool live = false;
+    SegmentId name = kNoSegment;
+    uint32_t parent = kNilIndex;
+    uint32_t west = kNilIndex;
+    uint32_t east = kNilIndex;  // Для свободного слота - следующий свободный
+    std::string value;
+};
+
+using CompactNode = struct s_compact_node;
+using CompactLeaf = struct s_compact_leaf;
+
+/**
+ * @brief Дерево каталогов и листьев на таблицах слотов с дескрипторами поколений.
+ *
+ * Порядок детей и листьев - порядок вставки, как в tree.hpp. Все операции, кроме удаления
+ * поддерева и построения строк, выполняются за O(1) или O(глубина пути).
+ */
+class CompactTree {
+   public:
+    CompactTree();
+
+    NodeHandle root() const { return {0, nodes_[0].generation}; }
+
+    bool valid(NodeHandle node) const;
+    bool valid(LeafHandle leaf) const;
+
+    /**
+     * @brief Создает дочерний каталог с именем name. Возвращает пустой дескриптор, если
+     * родитель невалиден или имя занято.
+     */
+    NodeHandle create_node(NodeHandle parent, std::string_view name);
+
+    /**
+     * @brief Создает лист в конце списка листьев каталога. Возвращает пустой дескриптор, если
+     * родитель невалиден или имя занято.
+     */
+    LeafHandle create_leaf(NodeHandle parent, std::string_view name, std::string_view value);
+
+    NodeHandle find_child_node(NodeHandle parent, std::string_view name) const;
+    LeafHandle find_child_leaf(NodeHandle parent, std::string_view name) const;
+
+    // Поиск по полному пути за O(глубина пути).
+    NodeHandle find_node(std::string_view path) const;
+    LeafHandle find_leaf(std::string_view path) const;
+
+    // Удаляет каталог со всем поддеревом (итеративно). Корень удалить нельзя.
+    bool delete_node(NodeHandle node);
+    bool delete_leaf(LeafHandle leaf);
+
+    NodeHandle parent_of(NodeHandle node) const;
+    NodeHandle parent_of(LeafHandle leaf) const;
+    std::string_view name_of(NodeHandle node) const;
+    std::string_view name_of(LeafHandle leaf) const;
+    const std::string &value_of(LeafHandle leaf) const { return leaves_[leaf.index].value; }
+    void set_value(LeafHandle leaf, std::string_view value);
+
+    // Собирает полный путь записи из сегментов.
+    std::string path_of(NodeHandle node) const;
+    std::string path_of(LeafHandle leaf) const;
+
+    // Невладеющий обход прямых потомков в порядке вставки.
+    template <typename Visit>
+    void for_each_child(NodeHandle parent, Visit visit) const {
+        for (uint32_t i = nodes_[parent.index].first_child; i != kNilIndex;
+             i = nodes_[i].next_sibling) {
+            visit(NodeHandle{i, nodes_[i].generation});
+        }
+    }
+
+    template <typename Visit>
+    void for_each_leaf(NodeHandle parent, Visit visit) const {
+        for (uint32_t i = nodes_[parent.index].first_leaf; i != kNilIndex; i = leaves_[i].east) {
+            visit(LeafHandle{i, leaves_[i].generation});
+        }
+    }
+
+    // Строковое представление поддерева в формате print_tree_string из tree.hpp.
+    std::string print_tree_string(NodeHandle node) const;
+
+    size_t node_count() const { return node_count_; }  // Без учета корня
+    size_t leaf_count() const { return leaf_count_; }
+
+   private:
+    static constexpr uint32_t kLeafBit = 0x80000000u;
+
+    static uint64_t child_key(uint32_t parent, SegmentId name) {
+        return (static_cast<uint64_t>(parent) << 32) | name;
+    }
+
+    // Ищет запись (узел или лист с kLeafBit) по родителю и имени; kNilIndex, если нет.
+    uint32_t find_child(uint32_t parent, std::string_view name) const;
+    // Возвращает индекс каталога по пути или kNilIndex.
+    uint32_t resolve_node(std::string_view path) const;
+
+    uint32_t allocate_node();
+    uint32_t allocate_leaf();
+    void free_node(uint32_t index);
+    void free_leaf(uint32_t index);
+    void unlink_leaf(uint32_t index);
+
+    std::vector<CompactNode> nodes_;
+    std::vector<CompactLeaf> leaves_;
+    uint32_t free_nodes_ = kNilIndex;
+    uint32_t free_leaves_ = kNilIndex;
+    std::unordered_map<uint64_t, uint32_t> children_;  // (родитель, имя) -> запись
+    SegmentTable segments_;
+    size_t node_count_ = 0;
+    size_t leaf_count_ = 0;
+};
+
+/*--------------------------------------COMPATIBILITY_LAYER----------------------------------------------------*/
+
+// Аналоги функций tree.hpp для CompactTree. Вместо nullptr возвращается пустой дескриптор.
+
+// Делит полный путь на родительский каталог и имя. Возвращает false для некорректного пути.
+inline bool split_compact_path(std::string_view path, std::string_view &parent,
+                               std::string_view &name) {
+    size_t last_slash_pos = path.rfind('/');
+    if (path.empty() || path == "/" || last_slash_pos == std::string_view::npos ||
+        path.back() == '/') {
+        return false;
+    }
+    parent = (last_slash_pos == 0) ? std::string_view("/") : path.substr(0, last_slash_pos);
+    name = path.substr(last_slash_pos + 1);
+    return true;
+}
+
+inline NodeHandle create_node_by_path(CompactTree &tree, const std::string &path) {
+    std::string_view parent, name;
+    if (!split_compact_path(path, parent, name)) {
+        return {};
+    }
+    return tree.create_node(tree.find_node(parent), name);
+}
+
+inline LeafHandle create_leaf_by_path(CompactTree &tree, const std::string &path,
+                                      const std::string &value) {
+    std::string_view parent, name;
+    if (!split_compact_path(path, parent, name)) {
+        return {};
+    }
+    return tree.create_leaf(tree.find_node(parent), name, value);
+}
+
+inline NodeHandle find_node_by_path_linear(const CompactTree &tree, const std::string &path) {
+    return tree.find_node(path);
+}
+
+inline LeafHandle find_leaf_by_path_linear(const CompactTree &tree, const std::string &path) {
+    return tree.find_leaf(path);
+}
+
+inline bool delete_node_by_path_linear(CompactTree &tree, const std::string &path) {
+    return tree.delete_node(tree.find_node(path));
+}
+
+inline bool delete_leaf_by_path_linear(CompactTree &tree, const std::string &path) {
+    return tree.delete_leaf(tree.find_leaf(path));
+}
+
+inline std::string print_tree_string(const CompactTree &tree, NodeHandle node) {
+    return tree.print_tree_string(node);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "server.hpp"
+
+/**
+ * @brief Ограниченный пул потоков для потокового режима сервера.
+ *
+ * Вместо нового потока на каждое соединение принятые клиенты ставятся в очередь, а фиксированное
+ * число потоков по очереди обслуживает их через handle_connection. Поток занят клиентом до
+ * закрытия соединения, поэтому число потоков - жесткий предел одновременно обслуживаемых
+ * соединений. Если все потоки заняты, клиент ждет в очереди, но не дольше queue_timeout: потом
+ * он получает 503 и соединение закрывается (иначе клиент keep-alive ждал бы приветствия, пока
+ * не отключится кто-то другой). Если заполнена и очередь, 503 отправляется сразу, а не копятся
+ * потоки и память без ограничения.
+ */
+class ConnectionPool {
+   public:
+    ConnectionPool(size_t threads, size_t max_queued, std::chrono::milliseconds queue_timeout);
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool &) = delete;
+    ConnectionPool &operator=(const ConnectionPool &) = delete;
+
+    /**
+     * @brief Передает соединение пулу.
+     * @return false, если очередь заполнена и клиент отклонен.
+     */
+    bool submit(std::shared_ptr<Client> client);
+
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Queued {
+        std::shared_ptr<Client> client;
+        Clock::time_point deadline;
+    };
+
+    void worker();
+
+    // Отклоняет клиентов, простоявших в очереди дольше queue_timeout_.
+    void expire_queued();
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable queued_;  // Будит expire_queued при появлении клиента в очереди
+    std::deque<Queued> queue_;        // Сроки растут от начала к концу
+    size_t max_queued_;
+    std::chrono::milliseconds queue_timeout_;
+    bool stopping_ = false;
+    std::vector<std::thread> threads_;
+};
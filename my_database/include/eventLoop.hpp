@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "server.hpp"
+
+/*
+Режим сервера на epoll: все соединения обслуживаются небольшим фиксированным числом потоков
+цикла событий вместо отдельного потока на каждого клиента.
+
+    listen_fd 0 (SO_REUSEPORT) -> accept4() -> EventLoop 0: epoll_fd, {fd -> Client}
+    listen_fd 1 (SO_REUSEPORT) -> accept4() -> EventLoop 1: epoll_fd, {fd -> Client}
+    ...
+
+Каждый цикл владеет своим слушающим сокетом (ядро распределяет соединения между сокетами),
+сам принимает соединения и обслуживает их до закрытия, поэтому таблица клиентов цикла не
+требует блокировок. Сокеты клиентов неблокирующие и
+зарегистрированы в режиме edge-triggered: на каждое событие цикл читает и пишет до EAGAIN, но
+не больше kMaxReadsPerEvent чтений подряд - остальное после других готовых клиентов цикла.
+Ответы обработчиков копятся в выходном буфере Client и отправляются, когда сокет готов к записи;
+пока их больше Client::kOutputHighWater, сокет клиента не читается и его команды не выполняются.
+
+Журнал изменений: ответы на изменения нельзя отправлять до их записи в журнал, но fdatasync
+(--fsync=always) в потоке цикла остановил бы всех его клиентов. Поэтому клиент с незаписанными
+изменениями откладывается (parked_): его ответы остаются в буфере, сокет не читается. Поток
+синхронизации цикла ждет записи наибольшего нужного LSN (одна групповая фиксация на всех
+отложенных) и будит цикл через eventfd, после чего ответы отправляются и чтение продолжается.
+*/
+
+/**
+ * @brief Однопоточный цикл событий epoll.
+ */
+class EventLoop {
+   public:
+    explicit EventLoop(int listen_fd) : listen_fd_(listen_fd) {}
+    ~EventLoop();
+
+    EventLoop(const EventLoop &) = delete;
+    EventLoop &operator=(const EventLoop &) = delete;
+
+    /**
+     * @brief Создает epoll и регистрирует в нем слушающий сокет.
+     * @return true в случае успеха, иначе false.
+     */
+    bool init();
+
+    // Обрабатывает события до ошибки epoll_wait. Вызывается в собственном потоке цикла.
+    void run();
+
+   private:
+    void accept_clients();
+    void handle_readable(const std::shared_ptr<Client> &client);
+    void handle_writable(const std::shared_ptr<Client> &client);
+    void close_client(int fd);
+
+    // process_input без ожидания журнала; клиент с незаписанными изменениями откладывается.
+    bool process(const std::shared_ptr<Client> &client);
+    // Продолжает отложенных клиентов, изменения которых уже записаны в журнал.
+    void resume_synced();
+    // Поток синхронизации: ждет записи sync_target_ и сообщает о ней через wake_fd_.
+    void sync_loop();
+
+    int listen_fd_;
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;  // eventfd: поток синхронизации записал журнал
+    std::unordered_map<int, std::shared_ptr<Client>> clients_;
+    std::vector<int> deferred_;                 // Чтение прервано на kMaxReadsPerEvent
+    std::unordered_map<int, uint64_t> parked_;  // Клиент -> LSN, которого ждут его ответы
+
+    std::thread syncer_;  // Запускается при первом отложенном клиенте
+    std::mutex sync_mutex_;  // Поля ниже
+    std::condition_variable sync_wanted_;
+    uint64_t sync_target_ = 0;  // Наибольший LSN, который ждут отложенные клиенты
+    uint64_t synced_ = 0;       // LSN, до которого журнал записан
+    bool sync_failed_ = false;  // Журнал недоступен: отложенные клиенты закрываются
+    bool stopping_ = false;
+};
+
+/**
+ * @brief Запускает по циклу событий на каждый слушающий сокет и ждет их завершения.
+ * @details Переводит сокеты в неблокирующий режим. Первый цикл выполняется в вызывающем
+ * потоке, остальные - в отдельных потоках.
+ * @return -1 при ошибке; в штатном режиме циклы не завершаются.
+ */
+int run_event_loops(const std::vector<int> &listen_fds);
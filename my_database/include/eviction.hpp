@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "expiry.hpp"
+#include "tree.hpp"
+
+/*
+Предел памяти дерева и вытеснение листьев. Память считается оценкой footprint_of по всем
+записям дерева (s_path_index::bytes), а не размером процесса. Когда команда, которая может
+увеличить дерево, застает оценку выше предела, перед ее выполнением вытесняются листья:
+
+    lru - дольше всех не использовавшиеся (часы с шагом kLruClockMs);
+    lfu - реже всех используемые: логарифмический 8-битный счетчик, который уменьшается на 1 за
+          каждые lfu_decay_ms без обращений;
+    ttl - сначала листья с TTL, раньше всех истекающие, затем остальные по lru;
+    noeviction - ничего не вытесняется, команда получает отказ.
+
+Учет обращений - одно атомарное слово s_leaf::access: чтение под S-блокировкой каталога
+обновляет его без дополнительных блокировок и выделений памяти. Вытеснение приблизительное, как
+в Redis: листья выбираются случайно из корзин индекса путей (samples на одно вытеснение), а
+лучшие кандидаты копятся в небольшом пуле между вытеснениями. Кандидат удаляется под
+X-блокировкой родителя через delete_leaf, который перешивает соседей west/east.
+
+Листья, созданные без обращения (загрузка образа, журнала, IMPORT), считаются самыми старыми и
+редкими, пока их не прочитают.
+*/
+
+enum class EvictionPolicy : unsigned char {
+    NoEviction,
+    Lru,
+    Lfu,
+    TtlFirst,
+};
+
+// Разбирает имя политики: noeviction, lru, lfu или ttl.
+bool parse_eviction_policy(std::string_view name, EvictionPolicy &policy);
+
+std::string_view eviction_policy_name(EvictionPolicy policy);
+
+// Шаг часов LRU: 32-битные часы переполняются через 13 лет.
+inline constexpr uint64_t kLruClockMs = 100;
+
+// Начальное значение счетчика LFU: новый лист не вытесняется раньше, чем его успели прочитать.
+inline constexpr uint32_t kLfuInitialCounter = 5;
+
+struct s_eviction_options {
+    size_t max_bytes = 0;  // Предел оценки памяти дерева; 0 - без предела
+    EvictionPolicy policy = EvictionPolicy::Lru;
+    size_t samples = 5;                 // Листьев в выборке на одно вытеснение
+    unsigned lfu_log_factor = 10;       // Чем больше, тем медленнее растет счетчик LFU
+    uint64_t lfu_decay_ms = 60 * 1000;  // Период уменьшения счетчика LFU на 1
+};
+
+using EvictionOptions = struct s_eviction_options;
+
+struct s_eviction_stats {
+    size_t used_bytes = 0;
+    size_t max_bytes = 0;
+    uint64_t evicted = 0;        // Вытеснено листьев
+    uint64_t evicted_bytes = 0;  // Их оценка памяти
+    uint64_t rejected = 0;       // Команд, для которых не удалось освободить память
+    uint64_t hits = 0;           // Чтений листа, нашедших лист
+    uint64_t misses = 0;         // Чтений листа, не нашедших его
+
+    double hit_rate() const {
+        return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+    }
+};
+
+using EvictionStats = struct s_eviction_stats;
+
+// Вызывается под X-блокировкой родителя после вытеснения листа (журнал сервера).
+using EvictedCallback = void (*)(std::string_view path);
+
+class LeafEviction {
+   public:
+    LeafEviction(std::shared_ptr<Node> root, EvictionOptions options,
+                 EvictedCallback on_evicted = nullptr);
+
+    LeafEviction(const LeafEviction &) = delete;
+    LeafEviction &operator=(const LeafEviction &) = delete;
+
+    const EvictionOptions &options() const { return options_; }
+
+    // Отмечает обращение к листу (чтение или запись). Вызывается под любой блокировкой каталога.
+    // Без предела памяти обращения не учитываются.
+    void touch(Leaf &leaf, uint64_t now_ms = unix_time_ms());
+
+    void count_read(bool hit) {
+        (hit ? hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Вытесняет листья, пока оценка памяти дерева выше предела.
+     * @details Без предела или ниже него - одно атомарное чтение. Вызывается без PathLock:
+     * вытеснение берет X-блокировки родителей вытесняемых листьев.
+     * @return false, если память освободить не удалось (noeviction или нечего вытеснять).
+     */
+    bool make_room(uint64_t now_ms = unix_time_ms());
+
+    size_t used_bytes() const;
+
+    EvictionStats stats() const;
+
+   private:
+    struct Candidate {
+        std::string path;
+        uint64_t score;  // Чем больше, тем раньше лист вытесняется
+    };
+
+    static constexpr size_t kPoolSize = 16;
+
+    uint64_t score_of(const Leaf &leaf, uint64_t now_ms) const;
+    void sample(uint64_t now_ms);
+    void offer(const Leaf &leaf, uint64_t score);
+    bool evict_best();
+
+    std::shared_ptr<Node> root_;
+    EvictionOptions options_;
+    EvictedCallback on_evicted_;
+
+    std::mutex mutex_;             // Одно вытеснение за раз: pool_ и random_
+    std::vector<Candidate> pool_;  // Лучшие кандидаты по возрастанию score
+    std::mt19937_64 random_;
+
+    std::atomic<uint64_t> evicted_{0};
+    std::atomic<uint64_t> evicted_bytes_{0};
+    std::atomic<uint64_t> rejected_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+};
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "tree.hpp"
+
+/*
+Истечение TTL листьев. Время истечения хранится в самом листе (s_leaf::expires_at, мс
+Unix-времени), а удаляет истекшие листья иерархическое колесо таймеров:
+
+    уровень 0: 64 слота по 1 тику        (тик 10 мс - 0.64 с)
+    уровень 1: 64 слота по 64 тика       (41 с)
+    уровень 2: 64 слота по 64^2 тиков    (44 мин)
+    уровень 3: 64 слота по 64^3 тиков    (46 ч; более дальние сроки ждут в последнем слоте)
+
+Таймер попадает на уровень, покрывающий его срок. Когда младший уровень совершает оборот, слот
+старшего уровня перекладывается на младшие уровни, так что каждый таймер перекладывается не
+больше четырех раз, а продвижение на тик стоит O(таймеров в слоте). Тики, на которых пусты все
+младшие уровни, пропускаются разом до оборота следующего уровня. Стоимость истечения -
+O(истекших листьев), а не O(размера дерева).
+
+Срабатывание таймера только проверяет лист: если лист удален, перезаписан или его TTL продлен,
+таймер просто отбрасывается (продление ставит новый таймер). Удаление выполняется под
+X-блокировкой родителя, не больше max_per_tick листьев за тик; остальные ждут следующего тика.
+До удаления чтения не видят истекший лист (см. leaf_expired).
+*/
+
+// Текущее Unix-время в миллисекундах.
+uint64_t unix_time_ms();
+
+// Истек ли TTL листа к моменту now_ms. Читается под блокировкой каталога листа.
+inline bool leaf_expired(const Leaf &leaf, uint64_t now_ms) {
+    return leaf.expires_at != 0 && leaf.expires_at <= now_ms;
+}
+
+struct s_expiry_timer {
+    std::string path;
+    uint64_t expires_at;  // Срок листа на момент постановки таймера
+};
+
+using ExpiryTimer = struct s_expiry_timer;
+
+class TimingWheel {
+   public:
+    static constexpr unsigned kLevels = 4;
+    static constexpr unsigned kSlotBits = 6;
+    static constexpr size_t kSlots = size_t{1} << kSlotBits;
+
+    TimingWheel(uint64_t now_ms, uint64_t tick_ms);
+
+    // Ставит таймер; срок в прошлом выдается следующим advance().
+    void schedule(ExpiryTimer timer);
+
+    // Продвигает колесо до now_ms и дописывает сработавшие таймеры в due.
+    void advance(uint64_t now_ms, std::vector<ExpiryTimer> &due);
+
+    size_t size() const { return size_; }
+
+   private:
+    void place(ExpiryTimer timer);
+    void cascade(unsigned level);
+
+    uint64_t tick_ms_;
+    uint64_t current_;  // Последний обработанный тик
+    std::array<std::array<std::vector<ExpiryTimer>, kSlots>, kLevels> slots_;
+    std::array<size_t, kLevels> counts_{};  // Таймеров на каждом уровне
+    std::vector<ExpiryTimer> overdue_;      // Сроки, уже прошедшие при постановке
+    size_t size_ = 0;
+};
+
+struct s_expiry_options {
+    uint64_t tick_ms = 10;
+    size_t max_per_tick = 1000;  // Предел удалений за один тик
+};
+
+using ExpiryOptions = struct s_expiry_options;
+
+struct s_expiry_stats {
+    uint64_t scheduled = 0;        // Поставлено таймеров
+    uint64_t expired = 0;          // Листьев удалено по истечении TTL
+    uint64_t skipped = 0;          // Таймеров отброшено: лист удален, перезаписан или продлен
+    uint64_t hidden_on_read = 0;   // Чтений, не увидевших истекший, но еще не удаленный лист
+    uint64_t sweeps = 0;           // Тиков, в которых что-то удалено или отброшено
+    uint64_t sweep_us_total = 0;   // Суммарное время таких тиков
+    uint64_t sweep_us_max = 0;
+    size_t pending = 0;            // Таймеров в колесе и в очереди на удаление
+};
+
+using ExpiryStats = struct s_expiry_stats;
+
+// Вызывается под X-блокировкой родителя после удаления истекшего листа (журнал сервера).
+using ExpiredCallback = void (*)(std::string_view path);
+
+class LeafExpiry {
+   public:
+    LeafExpiry(std::shared_ptr<Node> root, ExpiryOptions options,
+               ExpiredCallback on_expired = nullptr, uint64_t now_ms = unix_time_ms());
+    ~LeafExpiry();
+
+    LeafExpiry(const LeafExpiry &) = delete;
+    LeafExpiry &operator=(const LeafExpiry &) = delete;
+
+    // Запускает фоновый поток, который вызывает sweep() раз в тик.
+    void start();
+
+    // Ставит таймер для листа path со сроком expires_at.
+    void schedule(std::string_view path, uint64_t expires_at);
+
+    // Ставит таймеры всем листьям дерева с TTL (после загрузки образа или журнала).
+    void schedule_tree();
+
+    // Один тик: удаляет до max_per_tick истекших к now_ms листьев. Возвращает число удаленных.
+    size_t sweep(uint64_t now_ms);
+
+    void count_hidden_read() { hidden_on_read_.fetch_add(1, std::memory_order_relaxed); }
+
+    ExpiryStats stats() const;
+
+   private:
+    void background_loop();
+
+    std::shared_ptr<Node> root_;
+    ExpiryOptions options_;
+    ExpiredCallback on_expired_;
+
+    mutable std::mutex mutex_;  // wheel_, backlog_ и статистика тиков
+    TimingWheel wheel_;
+    std::deque<ExpiryTimer> backlog_;  // Сработавшие, но еще не обработанные таймеры
+    std::vector<ExpiryTimer> due_;
+    ExpiryStats stats_;
+    std::atomic<uint64_t> hidden_on_read_{0};
+
+    std::mutex stop_mutex_;
+    std::condition_variable stop_signal_;
+    bool stop_ = false;
+    std::thread background_;
+};
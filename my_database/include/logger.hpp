@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*
+Асинхронный журнал с уровнями.
+
+Рабочий поток не пишет в поток вывода сам: запись форматируется прямо в слот кольцевого буфера
+своего потока (один производитель, один потребитель, без блокировок и выделений памяти), а
+фоновый поток раз в kLogDrainInterval забирает записи из всех буферов и пишет их одним fwrite()
+в файл или stderr. Если буфер потока заполнен, запись отбрасывается, а число потерь выводится
+следующим сбросом: рабочий поток никогда не ждет журнал. Заполненный наполовину буфер будит
+фоновый поток раньше срока.
+
+Отключенный уровень стоит одной relaxed-загрузки атомарной переменной: макросы LOG_* проверяют
+уровень до вычисления аргументов.
+
+Пока журнал не запущен (log_init не вызывался: тесты, бенчмарки, разбор аргументов сервера),
+записи пишутся в stderr синхронно.
+
+    LOG_INFO("New connection from ", ip, ":", port);
+*/
+
+enum class LogLevel : unsigned char {
+    Debug,
+    Info,
+    Warning,
+    Error,
+    Off,
+};
+
+inline constexpr size_t kLogLineSize = 240;     // Длиннее - обрезается
+inline constexpr size_t kLogRingSize = 1024;    // Записей в буфере одного потока, степень двойки
+inline constexpr auto kLogDrainInterval = std::chrono::milliseconds(10);
+
+extern std::atomic<LogLevel> g_log_level;
+
+inline bool log_enabled(LogLevel level) {
+    return level >= g_log_level.load(std::memory_order_relaxed);
+}
+
+struct s_log_record {
+    int64_t time_ns;  // system_clock
+    LogLevel level;
+    uint16_t length;
+    char text[kLogLineSize];
+};
+
+using LogRecord = struct s_log_record;
+
+/**
+ * @brief Кольцевой буфер записей одного потока: пишет только его владелец, читает только
+ * фоновый поток журнала.
+ */
+class LogRing {
+   public:
+    // Свободный слот для записи или nullptr, если буфер полон (потеря учитывается).
+    LogRecord *try_reserve() {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == kLogRingSize) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        return &records_[head & (kLogRingSize - 1)];
+    }
+
+    // Публикует слот, полученный try_reserve. Возвращает число записей, ждущих сброса.
+    size_t commit() {
+        uint64_t head = head_.load(std::memory_order_relaxed) + 1;
+        head_.store(head, std::memory_order_release);
+        return head - tail_.load(std::memory_order_relaxed);
+    }
+
+    // Передает visit все опубликованные записи и освобождает их слоты. Только для потребителя.
+    template <typename Visit>
+    size_t drain(Visit visit) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (uint64_t i = tail; i != head; ++i) {
+            visit(records_[i & (kLogRingSize - 1)]);
+        }
+        tail_.store(head, std::memory_order_release);
+        return head - tail;
+    }
+
+    uint64_t take_dropped() { return dropped_.exchange(0, std::memory_order_relaxed); }
+
+    std::atomic<bool> retired{false};  // Поток-владелец завершился
+
+   private:
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+    std::atomic<uint64_t> dropped_{0};
+    std::array<LogRecord, kLogRingSize> records_;
+};
+
+// Форматирует части сообщения в запись без выделений памяти.
+class LogFormatter {
+   public:
+    explicit LogFormatter(LogRecord &record) : record_(record) { record_.length = 0; }
+
+    void put(std::string_view text) {
+        size_t length = std::min(text.size(), kLogLineSize - record_.length);
+        text.copy(record_.text + record_.length, length);
+        record_.length += static_cast<uint16_t>(length);
+    }
+
+    void put(char c) { put(std::string_view(&c, 1)); }
+
+    template <std::integral T>
+    void put(T value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        put(std::string_view(digits, result.ptr - digits));
+    }
+
+   private:
+    LogRecord &record_;
+};
+
+// Буфер записей текущего потока или nullptr, если журнал не запущен.
+LogRing *this_thread_log_ring();
+
+// Синхронная запись в stderr (журнал не запущен).
+void write_log_record(const LogRecord &record);
+
+// Будит фоновый поток, не дожидаясь kLogDrainInterval.
+void wake_log_drainer();
+
+template <typename... Parts>
+void log_message(LogLevel level, const Parts &...parts) {
+    LogRing *ring = this_thread_log_ring();
+    LogRecord local;
+    LogRecord *record = ring ? ring->try_reserve() : &local;
+    if (!record) {
+        return;
+    }
+    record->level = level;
+    record->time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::system_clock::now().time_since_epoch())
+                          .count();
+    LogFormatter formatter(*record);
+    (formatter.put(parts), ...);
+    if (ring) {
+        // Буфер заполнен наполовину: сбросить раньше срока, чтобы не терять записи
+        if (ring->commit() == kLogRingSize / 2) {
+            wake_log_drainer();
+        }
+    } else {
+        write_log_record(local);
+    }
+}
+
+/**
+ * @brief Запускает фоновый поток журнала.
+ * @param level Минимальный выводимый уровень.
+ * @param path Файл журнала (дописывается) или пустая строка для stderr.
+ * @return false, если файл не удалось открыть.
+ */
+bool log_init(LogLevel level, std::string_view path = {});
+
+// Выводит оставшиеся записи и останавливает фоновый поток.
+void log_shutdown();
+
+void log_set_level(LogLevel level);
+
+// "debug", "info", "warning", "error", "off" -> уровень. false для неизвестного имени.
+bool parse_log_level(std::string_view name, LogLevel &level);
+
+#define LOG_AT(level, ...)                      \
+    do {                                        \
+        if (log_enabled(level)) {               \
+            log_message((level), __VA_ARGS__);  \
+        }                                       \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LogLevel::Debug, __VA_ARGS__)
+#define LOG_INFO(...) LOG_AT(LogLevel::Info, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_AT(LogLevel::Warning, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LogLevel::Error, __VA_ARGS__)
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "protocol.hpp"
+#include "treeLock.hpp"
+
+/*
+Метрики сервера: вызовы и задержки команд по глаголам, ожидание и удержание PathLock, байты
+сети и соединения. Запись не берет общих блокировок и не выполняет атомарных
+read-modify-write: у каждого потока свой блок счетчиков (ThreadMetrics), который меняет только
+он сам обычной парой load/store. Читатель (INFO, выгрузка для Prometheus) суммирует блоки всех
+потоков; значения одного блока читаются по отдельности, поэтому сводка не снимок на один момент.
+
+Задержки копятся в гистограммах с логарифмическими корзинами, как в HdrHistogram: каждая
+степень двойки делится на kSubBuckets равных корзин, так что ширина корзины - не больше 1/8
+значения при любом масштабе. Запись - одно сложение в корзину, без сортировки и выделений.
+
+Блок потока, завершившегося до чтения, не теряется: он возвращается в общий список и достается
+следующему новому потоку, поэтому счетчики только растут, а память не зависит от того,
+сколько потоков создавалось за время работы.
+*/
+
+// Время монотонных часов в наносекундах.
+uint64_t monotonic_ns();
+
+// Счетчик, который меняет только поток-владелец: сложение без lock-префикса, а читатели из
+// других потоков видят значение целиком.
+class OwnedCounter {
+   public:
+    void add(uint64_t delta) {
+        value_.store(value_.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    void raise_to(uint64_t value) {
+        if (value > value_.load(std::memory_order_relaxed)) {
+            value_.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t load() const { return value_.load(std::memory_order_relaxed); }
+
+   private:
+    std::atomic<uint64_t> value_{0};
+};
+
+/**
+ * @brief Гистограмма задержек потока-владельца в наносекундах.
+ * @details Значения не меньше 2^kMaxValueBits (около 68 с) попадают в последнюю корзину;
+ * максимум хранится точно.
+ */
+class LatencyHistogram {
+   public:
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets = size_t{1} << kSubBucketBits;
+    static constexpr unsigned kMaxValueBits = 36;
+    static constexpr size_t kBuckets = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+    // Корзины [0, 2 * kSubBuckets) - по одному значению, дальше по kSubBuckets на степень двойки.
+    static constexpr size_t bucket_of(uint64_t value) {
+        value = value < (uint64_t{1} << kMaxValueBits) ? value
+                                                       : (uint64_t{1} << kMaxValueBits) - 1;
+        unsigned width = static_cast<unsigned>(std::bit_width(value));
+        unsigned shift = width > kSubBucketBits + 1 ? width - kSubBucketBits - 1 : 0;
+        return (size_t{shift} << kSubBucketBits) + static_cast<size_t>(value >> shift);
+    }
+
+    // Наименьшее значение корзины.
+    static constexpr uint64_t lowest_of(size_t bucket) {
+        if (bucket < 2 * kSubBuckets) {
+            return bucket;
+        }
+        size_t shift = (bucket >> kSubBucketBits) - 1;
+        return static_cast<uint64_t>(bucket - (shift << kSubBucketBits)) << shift;
+    }
+
+    // Наибольшее значение корзины.
+    static constexpr uint64_t highest_of(size_t bucket) { return lowest_of(bucket + 1) - 1; }
+
+    void record(uint64_t value) {
+        buckets_[bucket_of(value)].add(1);
+        count_.add(1);
+        sum_.add(value);
+        max_.raise_to(value);
+    }
+
+   private:
+    friend struct s_histogram_snapshot;
+
+    std::array<OwnedCounter, kBuckets> buckets_;
+    OwnedCounter count_;
+    OwnedCounter sum_;
+    OwnedCounter max_;
+};
+
+// Сумма гистограмм нескольких потоков.
+struct s_histogram_snapshot {
+    std::vector<uint64_t> buckets = std::vector<uint64_t>(LatencyHistogram::kBuckets);
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+
+    void merge(const LatencyHistogram &histogram);
+
+    // Значение, не меньше которого доля q записей (0 < q <= 1): верхняя граница корзины, как
+    // highest equivalent value в HdrHistogram, но не больше максимума.
+    uint64_t percentile(double q) const;
+
+    double mean() const { return count == 0 ? 0.0 : static_cast<double>(sum) / count; }
+
+    // Записей в корзинах, целиком не больших value (для границ le в Prometheus).
+    uint64_t count_at_most(uint64_t value) const;
+};
+
+using HistogramSnapshot = struct s_histogram_snapshot;
+
+// Индекс метрик команды - значение Opcode; 0 - неизвестные команды.
+inline constexpr size_t kMetricCommands = kCommandSpecs.size() + 1;
+
+// Метрики PathLock ведутся отдельно для S и X (намеренные режимы - часть их захвата).
+inline constexpr size_t kMetricLockModes = 2;
+
+inline constexpr size_t lock_metric_of(LockMode mode) { return mode == LockMode::Shared ? 0 : 1; }
+
+struct s_thread_metrics {
+    std::array<LatencyHistogram, kMetricCommands> commands;  // Длительность команд
+    std::array<OwnedCounter, kMetricLockModes> lock_acquired;
+    std::array<LatencyHistogram, kMetricLockModes> lock_wait;  // Только захваты с ожиданием
+    std::array<LatencyHistogram, kMetricLockModes> lock_hold;
+    OwnedCounter bytes_in;
+    OwnedCounter bytes_out;
+};
+
+using ThreadMetrics = struct s_thread_metrics;
+
+// Блок счетчиков текущего потока; выделяется при первом обращении.
+ThreadMetrics &thread_metrics();
+
+inline void record_command(Opcode opcode, uint64_t ns) {
+    auto index = static_cast<size_t>(opcode);
+    thread_metrics().commands[index < kMetricCommands ? index : 0].record(ns);
+}
+
+// Соединения меняются редко, поэтому это общие атомарные счетчики.
+void count_connection_opened();
+void count_connection_closed();
+
+struct s_metrics_snapshot {
+    std::vector<HistogramSnapshot> commands = std::vector<HistogramSnapshot>(kMetricCommands);
+    std::array<uint64_t, kMetricLockModes> lock_acquired{};
+    std::array<HistogramSnapshot, kMetricLockModes> lock_wait;
+    std::array<HistogramSnapshot, kMetricLockModes> lock_hold;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t connected_clients = 0;
+    uint64_t total_connections = 0;
+};
+
+using MetricsSnapshot = struct s_metrics_snapshot;
+
+// Суммирует блоки всех потоков.
+MetricsSnapshot collect_metrics();
+
+// Глагол команды для индекса метрик; "unknown" для 0.
+std::string_view metric_verb_of(size_t index);
+
+/**
+ * @brief Дописывает метрики в текстовом формате Prometheus (exposition format 0.0.4).
+ * @details Задержки - гистограммы в секундах с границами le от 1 мкс до 10 с (1-2.5-5 на
+ * декаду), посчитанными по корзинам LatencyHistogram; команды без вызовов пропускаются.
+ */
+void append_prometheus(std::string &out, const MetricsSnapshot &metrics);
+
+// Одна метрика типа gauge без меток.
+void append_prometheus_gauge(std::string &out, std::string_view name, std::string_view help,
+                             uint64_t value);
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "transaction.hpp"
+#include "tree.hpp"
+
+/*
+Журнал изменений дерева (append-only): каждое успешное изменение дописывается в файл, при
+запуске файл проигрывается заново и восстанавливает дерево.
+
+Формат файла: заголовок kMutationLogMagic, затем записи
+
+    +------+----------+-----------+------+-------+-------+
+    | kind | path_len | value_len | path | value | crc32 |
+    |  u8  |  varint  |  varint   |      |       |  u32  |
+    +------+----------+-----------+------+-------+-------+
+
+kind - TreeChangeKind, длины - LEB128, crc32 (little-endian) считается по всем предыдущим байтам
+записи. Запись, оборванная сбоем посреди write(), отбрасывается при проигрывании, и файл
+обрезается до последней целой записи.
+
+Групповая фиксация: append() только добавляет запись в буфер и выдает ей номер (LSN). sync(lsn)
+ждет, пока запись окажется в файле: первый ожидающий поток становится лидером, забирает все
+накопленные записи, пишет их одним write() и (для FsyncPolicy::Always) одним fdatasync(), а
+остальные ждут результата. Так N одновременных писателей платят за один fsync.
+
+Переписывание: когда файл вырастает в rewrite_growth_percent раз от размера после предыдущего
+переписывания (и не меньше rewrite_min_size), фоновый поток делает fork() под S-блокировкой
+корня, как SNAPSHOT (snapshot.hpp). Дочерний процесс порциями пишет образ своей копии дерева во
+временный файл, а сервер тем временем принимает изменения и копит их отдельно. Затем они
+дописываются в файл, и журнал атомарно подменяется через rename().
+*/
+
+inline constexpr std::string_view kMutationLogMagic = "MCDBLOG1";
+
+enum class FsyncPolicy : unsigned char {
+    Always,       // sync() возвращается после fdatasync()
+    EverySecond,  // fdatasync() раз в секунду в фоновом потоке
+    Never,        // Только write(), сброс на диск - на усмотрение ОС
+};
+
+struct s_mutation_log_options {
+    std::string path;
+    FsyncPolicy fsync = FsyncPolicy::EverySecond;
+    uint64_t rewrite_min_size = 64 * 1024 * 1024;  // Меньшие файлы не переписываются
+    unsigned rewrite_growth_percent = 100;         // Рост относительно последнего переписывания
+};
+
+using MutationLogOptions = struct s_mutation_log_options;
+
+// "always", "everysec", "never" -> политика. false для неизвестного имени.
+bool parse_fsync_policy(std::string_view name, FsyncPolicy &policy);
+
+// Значение записи TreeChangeKind::ExpireLeaf: срок TTL (мс Unix-времени) в LEB128.
+std::string encode_expiry(uint64_t expires_at);
+
+// Дописывает запись журнала в out (для тестов и бенчмарков).
+void encode_log_record(std::string &out, TreeChangeKind kind, std::string_view path,
+                       std::string_view value);
+
+class MutationLog {
+   public:
+    explicit MutationLog(MutationLogOptions options);
+    ~MutationLog();
+
+    MutationLog(const MutationLog &) = delete;
+    MutationLog &operator=(const MutationLog &) = delete;
+
+    /**
+     * @brief Открывает (или создает) файл журнала и проигрывает его записи в дерево.
+     * @details Вызывается до того, как сервер начнет принимать клиентов. После успешного
+     * открытия запускается фоновый поток (fsync раз в секунду и переписывание).
+     * @param root Корень дерева, в которое применяются записи.
+     * @param replayed Если не nullptr, сюда записывается число примененных записей.
+     * @return false при ошибке ввода-вывода или если файл - не журнал.
+     */
+    bool open(const std::shared_ptr<Node> &root, size_t *replayed = nullptr);
+
+    /**
+     * @brief Ставит изменение в очередь записи.
+     * @details Вызывается под блокировкой дерева, покрывающей изменение: тогда порядок записей
+     * в журнале совпадает с порядком применения конфликтующих изменений.
+     * @return LSN записи для sync().
+     */
+    uint64_t append(TreeChangeKind kind, std::string_view path, std::string_view value = {});
+
+    /**
+     * @brief Ждет, пока все записи до lsn включительно будут записаны в файл (для
+     * FsyncPolicy::Always - и сброшены на диск). Вызывается без блокировок дерева.
+     * @return false при ошибке записи.
+     */
+    bool sync(uint64_t lsn);
+
+    /**
+     * @brief Переписывает журнал по текущему состоянию дерева.
+     * @return false при ошибке ввода-вывода; прежний журнал в этом случае остается.
+     */
+    bool rewrite();
+
+    uint64_t file_size() const;
+    uint64_t fsync_count() const { return fsyncs_.load(std::memory_order_relaxed); }
+    uint64_t rewrite_count() const { return rewrites_.load(std::memory_order_relaxed); }
+
+   private:
+    bool write_and_sync(int fd, const std::string &data, bool sync_data);
+    bool rewrite_locked();
+    void background_loop();
+
+    MutationLogOptions options_;
+    std::shared_ptr<Node> root_;
+    int fd_ = -1;
+
+    mutable std::mutex mutex_;        // Все поля ниже
+    std::condition_variable flushed_;
+    std::string buffer_;              // Добавленные, но еще не записанные записи
+    uint64_t appended_ = 0;           // LSN последней добавленной записи (байты с открытия)
+    uint64_t written_ = 0;            // LSN, до которого все записано
+    bool flushing_ = false;           // Лидер пишет в файл без mutex_
+    bool failed_ = false;             // Ошибка записи: журнал больше не принимает записи
+    bool dirty_ = false;              // Есть записанные, но не сброшенные на диск данные
+    bool rewriting_ = false;          // Новые записи копируются в rewrite_tail_
+    std::string rewrite_tail_;
+    uint64_t file_size_ = 0;
+    uint64_t base_size_ = 0;          // Размер после открытия или последнего переписывания
+
+    std::mutex rewrite_mutex_;        // Одно переписывание за раз; fd_ не закрывается под fsync
+    std::atomic<uint64_t> fsyncs_{0};
+    std::atomic<uint64_t> rewrites_{0};
+
+    std::mutex stop_mutex_;
+    std::condition_variable stop_signal_;
+    bool stop_ = false;
+    std::thread background_;
+};
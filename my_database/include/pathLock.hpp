@@ -0,0 +1,61 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "tree.hpp"
+
+/**
+ * @brief RAII-блокировка каталога по пути с намеренными блокировками на всех предках.
+ *
+ * Спускается от корня по дочерним спискам каталогов (hand-over-hand, сверху вниз): на каждом
+ * предке берется IS (для S) или IX (для X) и только после этого читается его список детей.
+ * На самом каталоге берется запрошенный режим. Все блокировки держатся до разрушения объекта.
+ *
+ * Правила для операций над деревом:
+ *   - создание/удаление записи в каталоге D  -> X на D (родителе записи);
+ *   - чтение каталога или листа в D          -> S на D;
+ * Поэтому писатели в непересекающихся поддеревьях работают параллельно, а DELETE_NODE и
+ * PRINT_TREE видят согласованное поддерево.
+ *
+ * Поток не должен держать два PathLock одновременно: вторая блокировка может ждать
+ * писателя, который сам ждет первую.
+ *
+ * Каждый захват учитывается в метриках потока (metrics.hpp) по запрошенному режиму: время
+ * ожидания - только если хотя бы одна блокировка пути была занята, время удержания - от
+ * захвата каталога до разрушения объекта.
+ */
+class PathLock {
+   public:
+    /**
+     * @param root Корень дерева.
+     * @param dir_path Полный путь каталога, который нужно заблокировать.
+     * @param mode LockMode::Shared или LockMode::Exclusive.
+     */
+    PathLock(const std::shared_ptr<Node> &root, std::string_view dir_path, LockMode mode);
+    ~PathLock();
+
+    PathLock(const PathLock &) = delete;
+    PathLock &operator=(const PathLock &) = delete;
+
+    // Блокирует родительский каталог записи path. Для некорректного пути node() == nullptr.
+    static PathLock parent_of(const std::shared_ptr<Node> &root, std::string_view path,
+                              LockMode mode);
+
+    // Заблокированный каталог или nullptr, если каталог (или один из предков) не найден.
+    const std::shared_ptr<Node> &node() const { return node_; }
+
+   private:
+    PathLock() = default;
+    PathLock(PathLock &&other) noexcept;
+
+    void acquire(const std::shared_ptr<Node> &root, std::string_view dir_path, LockMode mode);
+    void lock_one(const std::shared_ptr<Node> &node, LockMode mode);
+
+    std::vector<std::pair<std::shared_ptr<Node>, LockMode>> held_;
+    std::shared_ptr<Node> node_;
+    uint64_t wait_start_ns_ = 0;  // Начало первого ожидания; 0 - блокировки брались сразу
+    uint64_t acquired_ns_ = 0;    // Момент захвата каталога
+};
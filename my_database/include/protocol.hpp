@@ -0,0 +1,231 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+Формат запросов к серверу. В одном соединении можно смешивать два формата:
+
+Текстовый - строка "VERB path value\n" (допускается "\r\n"), value может содержать пробелы.
+
+Бинарный - фрейм с фиксированным заголовком, все числа little-endian:
+
+    +------+--------+----------+-----------+------+-------+
+    | 0xB1 | opcode | path_len | value_len | path | value |
+    |  u8  |   u8   |   u32    |    u32    |      |       |
+    +------+--------+----------+-----------+------+-------+
+
+Байт 0xB1 не встречается в начале текстовой команды, по нему форматы и различаются. Ответ на
+бинарный запрос - тот же текст, что и в текстовом режиме, с префиксом длины u32.
+
+Пакетные команды (MGET, MSET, MDEL) принимают список элементов: пути, а для MSET - пары
+путь/значение. В текстовом виде элементы разделяются пробелами ("MSET /a 1 /b 2"), в бинарном
+path пуст, а value - последовательность элементов [u32 длина][байты].
+
+Разбор ничего не копирует: path и value - std::string_view во входной буфер соединения,
+действительные до его следующего изменения. Команда выбирается по опкоду - индексу в таблице
+обработчиков; текстовый глагол переводится в опкод идеальным хешем, построенным при компиляции.
+*/
+
+inline constexpr unsigned char kBinaryMagic = 0xB1;
+inline constexpr size_t kBinaryHeaderSize = 10;
+
+// Предельная длина текстовой строки команды или path + value бинарного фрейма.
+inline constexpr size_t kMaxCommandLength = 1024 * 1024;
+
+enum class Opcode : uint8_t {
+    Unknown = 0,
+    Hello,
+    CreateNode,
+    CreateLeaf,
+    DeleteNode,
+    DeleteLeaf,
+    PrintTree,
+    GetLeaf,
+    SetLeaf,
+    MGet,
+    MSet,
+    MDel,
+    Multi,
+    Exec,
+    Discard,
+    Snapshot,
+    Scan,
+    Export,
+    Import,
+    Expire,
+    Info,
+    Count,
+    Memory,
+    CreateLeafEx,
+};
+
+struct s_command_spec {
+    Opcode opcode;
+    std::string_view verb;
+};
+
+using CommandSpec = struct s_command_spec;
+
+// Все команды протокола; порядок совпадает со значениями Opcode, начиная с 1.
+inline constexpr std::array<CommandSpec, 23> kCommandSpecs = {{
+    {Opcode::Hello, "hello"},
+    {Opcode::CreateNode, "CREATE_NODE"},
+    {Opcode::CreateLeaf, "CREATE_LEAF"},
+    {Opcode::DeleteNode, "DELETE_NODE"},
+    {Opcode::DeleteLeaf, "DELETE_LEAF"},
+    {Opcode::PrintTree, "PRINT_TREE"},
+    {Opcode::GetLeaf, "GET_LEAF"},
+    {Opcode::SetLeaf, "SET_LEAF"},
+    {Opcode::MGet, "MGET"},
+    {Opcode::MSet, "MSET"},
+    {Opcode::MDel, "MDEL"},
+    {Opcode::Multi, "MULTI"},
+    {Opcode::Exec, "EXEC"},
+    {Opcode::Discard, "DISCARD"},
+    {Opcode::Snapshot, "SNAPSHOT"},
+    {Opcode::Scan, "SCAN"},
+    {Opcode::Export, "EXPORT"},
+    {Opcode::Import, "IMPORT"},
+    {Opcode::Expire, "EXPIRE"},
+    {Opcode::Info, "INFO"},
+    {Opcode::Count, "COUNT"},
+    {Opcode::Memory, "MEMORY"},
+    {Opcode::CreateLeafEx, "CREATE_LEAF_EX"},
+}};
+
+constexpr std::string_view verb_of(Opcode opcode) {
+    size_t index = static_cast<size_t>(opcode);
+    return (index == 0 || index > kCommandSpecs.size()) ? std::string_view()
+                                                        : kCommandSpecs[index - 1].verb;
+}
+
+/*---------------------------------------------VERB_PERFECT_HASH-----------------------------------------------*/
+
+// Таблица глагол -> опкод без коллизий. Зерно хеша подбирается при компиляции, поэтому при
+// добавлении команды в kCommandSpecs ничего настраивать вручную не нужно.
+namespace verb_hash {
+
+inline constexpr size_t kTableSize = 64;
+
+constexpr uint32_t hash(std::string_view verb, uint32_t seed) {
+    uint32_t value = 2166136261u ^ seed;  // FNV-1a
+    for (char c : verb) {
+        value = (value ^ static_cast<unsigned char>(c)) * 16777619u;
+    }
+    // Младшие биты FNV-1a зависят только от младших бит зерна: без свертки старших бит перебор
+    // зерна дает не больше kTableSize разных раскладок
+    return value ^ (value >> 16);
+}
+
+constexpr bool collision_free(uint32_t seed) {
+    std::array<bool, kTableSize> used{};
+    for (const auto &spec : kCommandSpecs) {
+        size_t slot = hash(spec.verb, seed) % kTableSize;
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t find_seed() {
+    uint32_t seed = 0;
+    while (!collision_free(seed)) {
+        ++seed;
+    }
+    return seed;
+}
+
+inline constexpr uint32_t kSeed = find_seed();
+
+constexpr std::array<Opcode, kTableSize> build_table() {
+    std::array<Opcode, kTableSize> table{};
+    for (const auto &spec : kCommandSpecs) {
+        table[hash(spec.verb, kSeed) % kTableSize] = spec.opcode;
+    }
+    return table;
+}
+
+inline constexpr std::array<Opcode, kTableSize> kTable = build_table();
+
+}  // namespace verb_hash
+
+// Опкод текстового глагола: один хеш и одно сравнение строк.
+constexpr Opcode opcode_of(std::string_view verb) {
+    Opcode opcode = verb_hash::kTable[verb_hash::hash(verb, verb_hash::kSeed) %
+                                      verb_hash::kTableSize];
+    return verb_of(opcode) == verb ? opcode : Opcode::Unknown;
+}
+
+/*--------------------------------------------------PARSER-----------------------------------------------------*/
+
+struct s_request {
+    Opcode opcode = Opcode::Unknown;
+    uint8_t raw_opcode = 0;  // Опкод бинарного фрейма как есть, для сообщения об ошибке
+    bool binary = false;
+    std::string_view verb;  // Текстовый глагол (пустой для бинарного фрейма)
+    std::string_view path;
+    std::string_view value;
+};
+
+using Request = struct s_request;
+
+enum class ParseStatus : unsigned char {
+    Complete,    // Запрос разобран, consumed - его длина во входе
+    Incomplete,  // Нужны еще данные
+    Error,       // Фрейм длиннее kMaxCommandLength, соединение нужно закрыть
+};
+
+/**
+ * @brief Разбирает первый запрос из начала input.
+ * @param input Непрочитанная часть входного буфера соединения.
+ * @param request Результат; строки ссылаются на input.
+ * @param consumed Число байт, занятых запросом (только для ParseStatus::Complete).
+ */
+ParseStatus parse_request(std::string_view input, Request &request, size_t &consumed);
+
+// Кодирует бинарный фрейм запроса (для клиентов и тестов).
+std::string encode_request(Opcode opcode, std::string_view path, std::string_view value);
+
+/**
+ * @brief Извлекает элементы пакетной команды из полей path и value запроса.
+ * @param binary Запрос пришел бинарным фреймом.
+ * @param items Результат (очищается перед заполнением); элементы ссылаются на path и value.
+ * @return false, если бинарный список элементов поврежден.
+ */
+bool split_batch_items(bool binary, std::string_view path, std::string_view value,
+                       std::vector<std::string_view> &items);
+
+// Кодирует элементы пакетной команды в поле value бинарного фрейма.
+std::string encode_batch_items(const std::vector<std::string_view> &items);
+
+// Префикс длины ответа на бинарный запрос.
+std::array<char, 4> encode_reply_length(uint32_t length);
+
+// Предельный TTL в секундах: срок в миллисекундах не должен переполняться.
+inline constexpr uint64_t kMaxTtlSeconds = 100ULL * 365 * 24 * 3600;
+
+// Разбирает число секунд TTL (1..kMaxTtlSeconds), как в EXPIRE path seconds.
+bool parse_ttl_seconds(std::string_view text, uint64_t &seconds);
+
+/**
+ * @brief Разделяет поле value команды CREATE_LEAF_EX на TTL и значение листа.
+ * @details Поле имеет вид "seconds value": значение - все байты после первого пробела, без
+ * разбора, поэтому может быть любым (в том числе пустым или похожим на " EX 10").
+ * @return false, если число секунд некорректно.
+ */
+bool split_ttl_value(std::string_view argument, uint64_t &seconds, std::string_view &value);
+
+/**
+ * @brief Проверяет аргументы команды, не заглядывая в дерево.
+ * @details Команды MULTI проверяются при постановке в очередь: ошибка, найденная только при
+ * EXEC, оставила бы изменения предыдущих команд примененными.
+ * @return false, если аргументы value некорректны (сейчас - TTL в CREATE_LEAF_EX).
+ */
+bool arguments_valid(Opcode opcode, std::string_view value);
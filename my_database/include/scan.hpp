@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tree.hpp"
+
+/*
+Постраничный обход поддерева (SCAN). Записи выдаются в прямом порядке: листья каталога, затем
+каждый подкаталог и его содержимое. Обход без рекурсии и без стека: из законченного каталога
+обход поднимается по parent к следующему соседу, поэтому память не зависит от размера и
+глубины поддерева.
+
+Курсор - позиция после последней выданной записи: ее вид, путь и номера создания (seq) всех
+каталогов на пути от корня обхода и самой записи. Между страницами дерево может меняться:
+  - запись курсора на месте - обход продолжается за ней, поиск по имени за O(1);
+  - запись или ее каталог удалены (или пересозданы с тем же именем) - обход продолжается с
+    первой записи этого каталога с большим seq. Новые записи дописываются в конец списков
+    каталога, поэтому все записи с меньшим seq уже были выданы.
+Каждая запись, существовавшая на протяжении всего обхода, выдается ровно один раз; созданные
+во время обхода могут быть выданы или пропущены.
+
+Вызывающий держит S-блокировку корня обхода на время одной страницы.
+*/
+
+// Курсор начала обхода и признак его окончания.
+inline constexpr std::string_view kScanStart = "0";
+
+struct s_scan_entry {
+    const Node *node;  // Каталог или nullptr
+    const Leaf *leaf;  // Лист или nullptr
+};
+
+using ScanEntry = struct s_scan_entry;
+
+/**
+ * @brief Выдает до count записей поддерева dir, начиная с позиции cursor.
+ *
+ * @param dir Корень обхода.
+ * @param cursor kScanStart или курсор, полученный предыдущим вызовом для того же каталога.
+ * @param count Максимальное число записей страницы.
+ * @param page Записи страницы; указатели действительны, пока держится блокировка.
+ * @param next Курсор следующей страницы или kScanStart, если обход закончен.
+ * @return false, если курсор поврежден или получен для другого каталога.
+ */
+bool scan_subtree(const std::shared_ptr<Node> &dir, std::string_view cursor, size_t count,
+                  std::vector<ScanEntry> &page, std::string &next);
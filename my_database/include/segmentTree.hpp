@@ -0,0 +1,153 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+Компактный режим хранения дерева: каждая запись хранит только свой сегмент пути, а не полный
+путь. Одинаковые сегменты ("Users", "sessions", "session_0") интернируются в общей таблице и
+хранятся один раз, в записи остается только 32-битный идентификатор.
+
+Цепочки каталогов, в которых у каталога ровно один дочерний каталог и нет листьев, сжимаются в
+один узел в стиле radix/ART-дерева: метка узла - это последовательность сегментов.
+
+                / (root)
+                ├── [Users, Login]          <- сжатая цепочка /Users -> /Users/Login
+                │   ├── bob (лист)
+                │   └── kate (лист)
+                └── [Shops]
+
+Полные пути собираются только по требованию, например для print_tree_string.
+*/
+
+// Идентификатор интернированного сегмента пути.
+using SegmentId = uint32_t;
+
+inline constexpr SegmentId kNoSegment = UINT32_MAX;
+
+/**
+ * @brief Таблица интернированных сегментов пути со счетчиком ссылок.
+ *
+ * Каждая уникальная строка хранится один раз. Когда на сегмент не остается ссылок,
+ * его слот освобождается и переиспользуется.
+ */
+class SegmentTable {
+   public:
+    // Возвращает идентификатор сегмента, добавляя его при необходимости, и увеличивает счетчик.
+    SegmentId intern(std::string_view segment);
+
+    // Возвращает идентификатор существующего сегмента или kNoSegment. Счетчик не меняется.
+    SegmentId find(std::string_view segment) const;
+
+    // Уменьшает счетчик ссылок и освобождает слот, если ссылок больше нет.
+    void release(SegmentId id);
+
+    std::string_view view(SegmentId id) const { return slots_[id].text; }
+
+    // Количество уникальных сегментов, хранящихся в таблице.
+    size_t size() const { return ids_.size(); }
+
+   private:
+    struct Slot {
+        std::string text;
+        uint32_t refs = 0;
+    };
+
+    std::deque<Slot> slots_;  // deque не перемещает элементы, ключи ids_ остаются валидными
+    std::vector<SegmentId> free_slots_;
+    std::unordered_map<std::string_view, SegmentId> ids_;  // Ключи ссылаются на Slot::text
+};
+
+struct s_segment_node;
+using SegmentNode = struct s_segment_node;
+
+struct s_segment_node {
+    s_segment_node *parent = nullptr;
+    std::vector<SegmentId> label;  // Сжатая цепочка каталогов, у корня пустая
+    std::unordered_map<SegmentId, std::unique_ptr<s_segment_node>> children;  // По label[0]
+    std::unordered_map<SegmentId, std::string> leaves;  // Имя листа -> значение
+};
+
+/**
+ * @brief Дерево каталогов и листьев с посегментным хранением путей.
+ *
+ * Предоставляет те же операции, что и функции из tree.hpp, но принимает полные пути
+ * и не хранит их в записях. Листья и дочерние каталоги могут быть только у последнего
+ * каталога сжатой цепочки; промежуточные каталоги цепочки пусты по построению.
+ */
+class SegmentTree {
+   public:
+    SegmentTree();
+
+    /**
+     * @brief Создает каталог по полному пути. Родительский каталог должен существовать.
+     * @return true, если каталог создан, иначе false (неверный путь, нет родителя, путь занят).
+     */
+    bool create_node(std::string_view path);
+
+    /**
+     * @brief Создает лист по полному пути. Родительский каталог должен существовать.
+     * @return true, если лист создан, иначе false.
+     */
+    bool create_leaf(std::string_view path, std::string_view value);
+
+    /**
+     * @brief Удаляет каталог вместе со всем поддеревом. Корень удалить нельзя.
+     * @return true, если каталог был найден и удален.
+     */
+    bool delete_node(std::string_view path);
+
+    /**
+     * @brief Удаляет лист по полному пути.
+     * @return true, если лист был найден и удален.
+     */
+    bool delete_leaf(std::string_view path);
+
+    bool node_exists(std::string_view path) const;
+
+    /**
+     * @brief Находит значение листа по полному пути.
+     * @return Указатель на значение или nullptr, если лист не найден.
+     */
+    const std::string *find_leaf(std::string_view path) const;
+
+    /**
+     * @brief Формирует строковое представление поддерева в формате print_tree_string из
+     * tree.hpp. Полные пути собираются из сегментов на лету. Дочерние каталоги и листья
+     * выводятся в порядке имен.
+     * @return Строка с деревом или пустая строка, если каталог не найден.
+     */
+    std::string print_tree_string(std::string_view path = "/") const;
+
+    size_t node_count() const { return node_count_; }  // Без учета корня
+    size_t leaf_count() const { return leaf_count_; }
+    // Количество узлов radix-дерева после сжатия цепочек (без учета корня).
+    size_t compressed_node_count() const { return compressed_node_count_; }
+    const SegmentTable &segments() const { return segments_; }
+
+   private:
+    // Позиция каталога: узел и номер сегмента в его метке. У корня depth не используется.
+    struct Position {
+        SegmentNode *node = nullptr;
+        size_t depth = 0;
+    };
+
+    bool resolve(std::string_view path, Position &position) const;
+    bool is_tail(const Position &position) const;
+    // Есть ли в каталоге запись с именем id (внутри сжатой цепочки - следующий сегмент метки).
+    bool has_entry(const Position &position, SegmentId id) const;
+    void split(SegmentNode *node, size_t depth);
+    void merge_with_only_child(SegmentNode *node);
+    void release_subtree(SegmentNode *node, size_t from_depth);
+
+    SegmentTable segments_;
+    std::unique_ptr<SegmentNode> root_;
+    size_t node_count_ = 0;
+    size_t leaf_count_ = 0;
+    size_t compressed_node_count_ = 0;
+};
@@ -2,9 +2,13 @@
 
 #include <arpa/inet.h>  // For inet_addr()
 #include <netinet/in.h>
+#include <netinet/tcp.h>  // For TCP_NODELAY
 #include <sys/socket.h>
+#include <sys/uio.h>  // For writev()
 #include <unistd.h>  // For close()
 
+#include <cerrno>
+#include <cstdlib>  // For atoi
 #include <cstring>  // For memset
 #include <iostream>
 #include <memory>
@@ -13,23 +17,53 @@
 #include <thread>   // For std::thread
 #include <vector>
 
+#include "eviction.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "mutationLog.hpp"
+#include "protocol.hpp"
+#include "subtreeStream.hpp"
 #include "tree.hpp"
 
 #define PORT 12004
 // #define HOST "127.0.0.1"
 #define HOST "192.168.31.28"
 
+// A command queued between MULTI and EXEC. Path and value are copied: the input buffer they
+// were parsed from is reused by the next read.
+struct s_queued_command {
+    Opcode opcode;
+    std::string path;
+    std::string value;
+};
+
+using QueuedCommand = struct s_queued_command;
+
+struct s_transaction {
+    bool active = false;   // MULTI received, commands are queued instead of executed
+    bool aborted = false;  // A command could not be queued, EXEC will discard the transaction
+    std::vector<QueuedCommand> commands;
+};
+
+using Transaction = struct s_transaction;
+
 // A wrapper class for a client connection to ensure the socket is always closed.
 class Client {
    public:
     // Takes ownership of the file descriptor.
-    Client(int fd, std::string ip, int port) : fd_(fd), ip_(std::move(ip)), port_(port) {}
+    // Replies are already batched by flush(), so Nagle's algorithm only adds delayed-ACK stalls.
+    Client(int fd, std::string ip, int port) : fd_(fd), ip_(std::move(ip)), port_(port) {
+        int enable = 1;
+        setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        count_connection_opened();
+    }
 
     // Destructor ensures the socket is closed when the Client object goes out of scope.
     ~Client() {
         if (fd_ >= 0) {
             close(fd_);
         }
+        count_connection_closed();
     }
 
     // Disable copying to prevent double-closing the socket.
@@ -41,47 +75,208 @@ class Client {
     int get_port() const { return port_; }
 
     // Sends a string message to the client. Returns false on error.
-    bool send(const std::string& message) const {
-        if (write(fd_, message.c_str(), message.length()) < 0) {
-            std::cerr << "Error writing to socket " << fd_ << ": " << strerror(errno) << std::endl;
+    // In buffered mode the reply is queued and sent later by flush() together with the
+    // other replies produced from the same read.
+    bool send(const std::string& message) { return send(std::string(message)); }
+
+    bool send(std::string&& message) {
+        if (buffered_) {
+            if (binary_replies_) {
+                auto length = encode_reply_length(static_cast<uint32_t>(message.size()));
+                output_.emplace_back(length.data(), length.size());
+                output_bytes_ += length.size();
+            }
+            output_bytes_ += message.size();
+            output_.push_back(std::move(message));
+            return true;
+        }
+        ssize_t written = write(fd_, message.c_str(), message.length());
+        if (written < 0) {
+            LOG_WARNING("Error writing to socket ", fd_, ": ", strerror(errno));
             return false;
         }
+        thread_metrics().bytes_out.add(static_cast<uint64_t>(written));
+        return true;
+    }
+
+    void set_buffered(bool buffered) { buffered_ = buffered; }
+
+    // Replies to binary requests carry a u32 length prefix (buffered mode only).
+    void set_binary_replies(bool binary) { binary_replies_ = binary; }
+    bool binary_replies() const { return binary_replies_; }
+
+    // MULTI/EXEC state of this connection.
+    Transaction& transaction() { return transaction_; }
+
+    // Subtree being received by IMPORT chunks, nullptr between imports.
+    std::unique_ptr<SubtreeImporter>& importer() { return importer_; }
+
+    // Bytes received but not yet parsed into commands (buffered mode only).
+    std::string& input() { return input_; }
+
+    // Appends up to kReadChunk bytes from the socket to input(). Returns the read() result.
+    ssize_t read_some() {
+        size_t used = input_.size();
+        input_.resize(used + kReadChunk);
+        ssize_t bytes_read = read(fd_, input_.data() + used, kReadChunk);
+        input_.resize(used + (bytes_read > 0 ? static_cast<size_t>(bytes_read) : 0));
+        if (bytes_read > 0) {
+            thread_metrics().bytes_in.add(static_cast<uint64_t>(bytes_read));
+        }
+        return bytes_read;
+    }
+
+    bool has_pending_output() const { return output_index_ < output_.size(); }
+
+    // Queued reply bytes not yet written (buffered mode only).
+    size_t pending_output_bytes() const { return output_bytes_; }
+
+    // The client is not reading its replies fast enough: stop executing its commands (and, in
+    // epoll mode, reading its socket) until flush() brings the output below kOutputHighWater.
+    bool output_full() const { return output_bytes_ >= kOutputHighWater; }
+
+    // Writes queued replies with writev() until they are drained or the socket would block.
+    // Returns false if the connection is broken.
+    bool flush() {
+        while (has_pending_output()) {
+            iovec chunks[kMaxChunks];
+            int count = 0;
+            for (size_t i = output_index_; i < output_.size() && count < kMaxChunks; ++i) {
+                size_t skip = (i == output_index_) ? output_offset_ : 0;
+                chunks[count].iov_base = output_[i].data() + skip;
+                chunks[count].iov_len = output_[i].size() - skip;
+                ++count;
+            }
+
+            ssize_t written = writev(fd_, chunks, count);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+
+            thread_metrics().bytes_out.add(static_cast<uint64_t>(written));
+            output_bytes_ -= static_cast<size_t>(written);
+            size_t left = static_cast<size_t>(written);
+            while (left > 0) {
+                size_t rest = output_[output_index_].size() - output_offset_;
+                if (left < rest) {
+                    output_offset_ += left;
+                    break;
+                }
+                left -= rest;
+                ++output_index_;
+                output_offset_ = 0;
+            }
+        }
+        output_.clear();
+        output_index_ = 0;
+        output_offset_ = 0;
         return true;
     }
 
+    // Output high-water mark: one pipelined batch may overshoot it by its last reply.
+    static constexpr size_t kOutputHighWater = 1024 * 1024;
+
    private:
+    static constexpr int kMaxChunks = 256;  // iovec per writev() call, below IOV_MAX
+    static constexpr size_t kReadChunk = 16 * 1024;
+
     int fd_;
     std::string ip_;
     int port_;
+
+    bool buffered_ = false;
+    bool binary_replies_ = false;
+    Transaction transaction_;
+    std::unique_ptr<SubtreeImporter> importer_;
+    std::string input_;
+    std::vector<std::string> output_;  // Queued replies
+    size_t output_index_ = 0;          // First reply not fully written
+    size_t output_offset_ = 0;         // Written prefix of output_[output_index_]
+    size_t output_bytes_ = 0;          // Sum of the unwritten parts of output_
 };
 
-using Callback = int (*)(std::shared_ptr<Client> client, std::string path, std::string value);
+// Аргументы - std::string_view во входной буфер клиента, действительные только во время вызова.
+using Callback = int (*)(const std::shared_ptr<Client> &client, std::string_view path,
+                         std::string_view value);
 
 struct s_command_handler {
-    std::string command;
+    Opcode opcode;
     Callback callback;
 };
 
 using CommandHandler = struct s_command_handler;
 
+// Модель обслуживания соединений.
+enum class ServerMode : unsigned char {
+    Thread,  // Отдельный поток на каждого клиента, блокирующий read()
+    Epoll,   // Несколько циклов событий epoll на все соединения, см. eventLoop.hpp
+};
+
+/*
+Каждый из workers воркеров владеет своим слушающим сокетом на одном и том же адресе
+(SO_REUSEPORT), ядро распределяет входящие соединения между ними. В потоковом режиме воркер -
+это поток accept(), передающий клиентов в общий ограниченный пул (connectionPool.hpp), в режиме
+epoll - цикл событий, который сам обслуживает принятые им соединения.
+*/
+struct s_server_options {
+    std::string host = HOST;
+    int port = PORT;
+    ServerMode mode = ServerMode::Thread;
+    size_t workers = 4;          // Число слушающих сокетов и принимающих потоков
+    int backlog = SOMAXCONN;     // Очередь установленных, но еще не принятых соединений
+    size_t pool_threads = 256;   // Потоки пула: предел одновременных соединений потокового режима
+    size_t pool_queue = 4096;    // Клиенты, ждущие свободного потока пула
+    int pool_queue_timeout = 5;  // Ожидание потока в очереди, с; потом клиент получает 503
+    LogLevel log_level = LogLevel::Info;  // Команды клиентов пишутся на уровне debug
+    std::string log_file;                 // Пусто - stderr
+    MutationLogOptions aof;               // Журнал изменений; пустой путь - без журнала
+    std::string snapshot_path;            // Файл образа SNAPSHOT; пусто - команда отключена
+    EvictionOptions eviction;             // Предел памяти дерева и политика вытеснения
+    std::string metrics_file;             // Выгрузка метрик для Prometheus; пусто - без нее
+    int metrics_interval = 15;            // Период выгрузки, с
+};
+
+using ServerOptions = struct s_server_options;
+
+/**
+ * @brief Разбирает аргументы командной строки сервера.
+ * @details Поддерживаются --host=ADDR, --port=N, --mode=thread|epoll, --workers=N,
+ * --backlog=N, --pool=N, --queue=N, --queue-timeout=SECONDS,
+ * --log-level=debug|info|warning|error|off,
+ * --log-file=PATH, --aof=PATH, --fsync=always|everysec|never, --aof-rewrite-min=BYTES,
+ * --snapshot=PATH, --maxmemory=BYTES, --maxmemory-policy=noeviction|lru|lfu|ttl,
+ * --maxmemory-samples=N, --metrics-file=PATH, --metrics-interval=SECONDS.
+ * В потоковом режиме поток пула занят соединением до его закрытия, поэтому --pool - жесткий
+ * предел одновременно обслуживаемых соединений: остальные ждут в очереди не дольше
+ * --queue-timeout и получают 503.
+ * @return true, если все аргументы распознаны, иначе false (сообщение уже выведено в cerr).
+ */
+bool parse_server_options(int argc, char const *argv[], ServerOptions &options);
+
 /**
  * @brief Инициализирует и настраивает TCP-сервер.
  *
- * @details Создает сокет, привязывает его к адресу (HOST) и порту (PORT),
- * а затем переводит в режим прослушивания входящих соединений.
+ * @details Создает сокет с SO_REUSEADDR и SO_REUSEPORT, привязывает его к адресу и порту из
+ * options и переводит в режим прослушивания с очередью options.backlog. Вызывается по разу на
+ * каждого воркера: все сокеты слушают один адрес.
  * @return Файловый дескриптор слушающего сокета в случае успеха, иначе -1.
  */
-int init_server();
+int init_server(const ServerOptions &options);
+
+class ConnectionPool;
 
 /**
- * @brief Принимает новое соединение и создает новый поток для его обработки.
+ * @brief Принимает новое соединение и передает его пулу потоков.
  * @details Блокируется до тех пор, пока не появится новое клиентское соединение.
- * После принятия создает новый поток с помощью std::thread и отсоединяет его .detach() для
- * обработки клиента, в то время как основной поток продолжает слушать новые соединения и не ожидает
- * окончания работы клиентского потока.
+ * После принятия ставит клиента в очередь пула, где его обслужит один из потоков пула,
+ * в то время как воркер продолжает принимать новые соединения.
  * @param sock_fd Файловый дескриптор слушающего сокета.
+ * @param pool Пул потоков, обслуживающих клиентов.
  */
-void accept_connection(int sock_fd);
+void accept_connection(int sock_fd, ConnectionPool &pool);
 
 /**
  * @brief Основной цикл обработки команд от одного клиента.
@@ -91,11 +286,162 @@ void accept_connection(int sock_fd);
  */
 void handle_connection(std::shared_ptr<Client> client);
 
-int handle_hello(std::shared_ptr<Client> client, std::string path, std::string value);
-int handle_create_node(std::shared_ptr<Client> client, std::string path, std::string value);
-int handle_create_leaf(std::shared_ptr<Client> client, std::string path, std::string value);
-int handle_delete_node(std::shared_ptr<Client> client, std::string path, std::string value);
-int handle_delete_leaf(std::shared_ptr<Client> client, std::string path, std::string value);
-int handle_print_tree(std::shared_ptr<Client> client, std::string path, std::string value);
+/**
+ * @brief Вызывает обработчик разобранного запроса через таблицу опкодов.
+ * @details Общая часть потокового режима и режима epoll. Ответ отправляется через client->send.
+ * @param client Клиент, от которого пришел запрос.
+ * @param request Запрос; строки ссылаются на входной буфер клиента.
+ */
+void dispatch_request(const std::shared_ptr<Client> &client, const Request &request);
+
+/**
+ * @brief Выполняет все полные запросы из входного буфера клиента.
+ * @details Запросы в текстовом и бинарном формате (см. protocol.hpp) разбираются без копирования.
+ * Неполный последний запрос остается в буфере до следующего чтения, поэтому команда может
+ * прийти несколькими пакетами, а один пакет может содержать сотни команд. Ответы копятся в
+ * выходном буфере клиента; перед возвратом изменения этих команд записываются в журнал
+ * (mutationLog.hpp), так что клиент не получит ответ о еще не записанном изменении.
+ * Если ответов накопилось на Client::kOutputHighWater байт, разбор останавливается: остальные
+ * запросы ждут в буфере, пока вызывающий не отправит ответы (Client::output_full()).
+ * @param log_lsn Если не nullptr, запись в журнал не ожидается: сюда записывается LSN, который
+ * нужно дождаться через wait_mutation_log до отправки ответов (0 - ждать нечего). Так цикл
+ * событий не блокируется на fdatasync.
+ * @return false, если запрос длиннее kMaxCommandLength или журнал недоступен и соединение
+ * нужно закрыть.
+ */
+bool process_input(const std::shared_ptr<Client> &client, uint64_t *log_lsn = nullptr);
+
+/**
+ * @brief Ждет записи в журнал изменений всех записей до lsn включительно (групповая фиксация).
+ * @return false, если журнал недоступен.
+ */
+bool wait_mutation_log(uint64_t lsn);
+
+int handle_hello(const std::shared_ptr<Client> &client, std::string_view path,
+                 std::string_view value);
+int handle_create_node(const std::shared_ptr<Client> &client, std::string_view path,
+                       std::string_view value);
+int handle_create_leaf(const std::shared_ptr<Client> &client, std::string_view path,
+                       std::string_view value);
+int handle_delete_node(const std::shared_ptr<Client> &client, std::string_view path,
+                       std::string_view value);
+int handle_delete_leaf(const std::shared_ptr<Client> &client, std::string_view path,
+                       std::string_view value);
+int handle_print_tree(const std::shared_ptr<Client> &client, std::string_view path,
+                      std::string_view value);
+int handle_get_leaf(const std::shared_ptr<Client> &client, std::string_view path,
+                    std::string_view value);
+int handle_set_leaf(const std::shared_ptr<Client> &client, std::string_view path,
+                    std::string_view value);
+
+/*
+Пакетные команды: все элементы выполняются под одной блокировкой общего каталога-предка
+(S для MGET, X для MSET/MDEL), ответ - одна строка со статусом каждого элемента:
+    MSET /a 1 /b 2  -> "200 OK: cu"      c - создан, u - перезаписан, '-' - ошибка
+    MDEL /a /b      -> "200 OK: +-"      + - удален, '-' - не найден
+    MGET /a /b      -> "200 OK: +-" и для каждого найденного значения строка "$<длина>",
+                       за которой следуют само значение и '\n'
+*/
+int handle_mget(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value);
+int handle_mset(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value);
+int handle_mdel(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value);
+
+/*
+Транзакции: после MULTI команды соединения не выполняются, а копируются в очередь (ответ
+"200 OK: QUEUED"). EXEC выполняет очередь под одной блокировкой каталога, общего для всех путей
+транзакции (X, если есть изменения, иначе S). Сначала вся очередь проверяется на наложении поверх
+дерева (transaction.hpp); если какое-то изменение неприменимо, дерево не меняется и EXEC отвечает
+"409 Conflict". Иначе команды применяются по порядку, и все их ответы уходят одним сообщением
+после строки "200 OK: EXEC <n>". DISCARD очищает очередь. Пакетные команды и вложенный MULTI в
+транзакции не допускаются: такая команда отклоняется, а EXEC отбросит всю транзакцию.
+*/
+int handle_multi(const std::shared_ptr<Client> &client, std::string_view path,
+                 std::string_view value);
+int handle_exec(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value);
+int handle_discard(const std::shared_ptr<Client> &client, std::string_view path,
+                   std::string_view value);
+
+/*
+SNAPSHOT запускает запись образа дерева в файл --snapshot=PATH в дочернем процессе
+(snapshot.hpp) и сразу отвечает "200 OK"; окончание записи выводится в журнал сервера. Пока
+образ пишется, повторный SNAPSHOT отвечает "409 Conflict".
+*/
+int handle_snapshot(const std::shared_ptr<Client> &client, std::string_view path,
+                    std::string_view value);
+
+/*
+SCAN path cursor count - страница из не более count записей поддерева path (scan.hpp) под
+S-блокировкой каталога только на время страницы. Первый вызов - с курсором 0, следующие - с
+курсором из ответа, пока он не станет 0:
+    SCAN /Users 0 2  -> "200 OK: SCAN <курсор> 2", затем записи:
+                        "D <путь>" для каталога, "L <путь>" и "$<длина>\n<значение>" для листа
+*/
+inline constexpr size_t kMaxScanCount = 10000;
+
+int handle_scan(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value);
+
+/*
+Перенос поддерева в потоковом двоичном формате (subtreeStream.hpp).
+
+EXPORT path cursor count - очередная порция потока поддерева path, до count записей, постранично
+как SCAN (S-блокировка только на время порции, поэтому поток - не снимок на один момент):
+    EXPORT /Users 0 1000  -> "200 OK: EXPORT <курсор> <байт>", затем сами байты порции
+Склеенные порции от курсора 0 до курсора 0 - поток, который принимает IMPORT.
+
+IMPORT path chunk - только бинарным фреймом, chunk - очередная часть потока в любых границах.
+Поддерево строится отдельно от дерева без блокировок; ответ на часть - "200 OK: IMPORT <записей>".
+Пустой chunk завершает импорт: под X-блокировкой родителя поддерево присоединяется по пути path,
+заменяя существующий каталог, и записывается в журнал. Ошибка сбрасывает начатый импорт.
+*/
+int handle_export(const std::shared_ptr<Client> &client, std::string_view path,
+                  std::string_view value);
+int handle_import(const std::shared_ptr<Client> &client, std::string_view path,
+                  std::string_view value);
+
+/*
+TTL листьев (expiry.hpp): CREATE_LEAF_EX path seconds value создает лист со сроком жизни
+(значение - все байты после пробела за seconds, CREATE_LEAF значение не разбирает вовсе),
+EXPIRE path seconds назначает срок существующему листу ("200 OK: Leaf <путь> expires in N s.").
+SET_LEAF и MSET снимают TTL. Истекший лист не виден чтениям (GET_LEAF, MGET) и удаляется
+фоновым колесом таймеров; удаление записывается в журнал как DELETE_LEAF.
+*/
+int handle_create_leaf_ex(const std::shared_ptr<Client> &client, std::string_view path,
+                          std::string_view value);
+int handle_expire(const std::shared_ptr<Client> &client, std::string_view path,
+                  std::string_view value);
+
+/*
+Предел памяти (--maxmemory, eviction.hpp): перед командой, которая может увеличить дерево
+(CREATE_NODE, CREATE_LEAF, CREATE_LEAF_EX, SET_LEAF, MSET, EXEC, завершение IMPORT), листья
+вытесняются по политике --maxmemory-policy, пока оценка памяти дерева выше предела. Вытеснение
+записывается в журнал как DELETE_LEAF. Если освободить память нельзя (noeviction или в дереве
+нет листьев), команда не выполняется: "507 Insufficient Storage: Memory limit reached.".
+
+INFO - счетчики сервера строками "имя:значение", сгруппированными по разделам "# Раздел":
+    INFO  -> "200 OK: INFO <байт>", затем сам текст
+Кроме памяти, чтений и TTL это метрики metrics.hpp: соединения и байты сети, вызовы и задержки
+команд по глаголам (cmdstat_*, latency_percentiles_usec_*), захваты PathLock с ожиданием и
+удержанием. INFO prometheus отвечает теми же метриками в текстовом формате Prometheus; с
+--metrics-file=PATH сервер раз в --metrics-interval секунд записывает этот текст в PATH (через
+временный файл и rename) для textfile-сборщика node_exporter.
+*/
+int handle_info(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value);
+
+/*
+Итоги поддерева каталога за O(1) (subtree_stats_of в tree.hpp), без блокировок и обхода:
+    COUNT /Users   -> "200 OK: COUNT <каталогов> <листьев>"
+    MEMORY /Users  -> "200 OK: MEMORY <байт>" - длины полных путей и значений записей поддерева
+Сам каталог в итоги не входит; истекшие, но еще не удаленные листья входят.
+*/
+int handle_count(const std::shared_ptr<Client> &client, std::string_view path,
+                 std::string_view value);
+int handle_memory(const std::shared_ptr<Client> &client, std::string_view path,
+                  std::string_view value);
 
 extern std::vector<CommandHandler> commands_handlers;
\ No newline at end of file
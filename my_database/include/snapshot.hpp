@@ -0,0 +1,58 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "tree.hpp"
+
+/*
+Образ дерева на момент времени (SNAPSHOT).
+
+Формат файла: заголовок kSnapshotMagic, число каталогов и листьев (varint), затем блоки
+каталогов в прямом порядке обхода, начиная с корня, и crc32 (u32) всех байтов после заголовка:
+
+    каталог := число_листьев { имя значение срок } число_подкаталогов { имя каталог }
+
+Имена и значения - varint-длина и байты, срок - s_leaf::expires_at (varint, 0 - без TTL). В
+образе хранятся имена, а не полные пути, поэтому он компактнее журнала изменений, а загрузчик
+создает записи прямо в известном родителе, без поиска каталога по пути и проверок на каждую
+запись, как при проигрывании журнала.
+
+Запись в фоне: fork_snapshot() делает fork() под S-блокировкой корня, то есть в момент, когда ни
+одно изменение не выполняется наполовину, и сразу отпускает ее. Дочерний процесс пишет свою
+копию дерева (страницы памяти копируются ядром только при изменении родителем), а сервер
+продолжает принимать изменения: писатели ждут только сам fork().
+*/
+
+inline constexpr std::string_view kSnapshotMagic = "MCDBSNP2";
+
+/**
+ * @brief Записывает образ дерева в path (через временный файл path.tmp и rename()).
+ * @details Блокировок не берет: вызывающий отвечает за то, что дерево не меняется (копия в
+ * дочернем процессе или S-блокировка корня).
+ * @return false при ошибке ввода-вывода; прежний файл path в этом случае остается.
+ */
+bool write_snapshot(const std::shared_ptr<Node> &root, const std::string &path);
+
+/**
+ * @brief Загружает образ в пустое дерево root.
+ * @param entries Если не nullptr, сюда записывается число загруженных каталогов и листьев.
+ * @return false, если файл не прочитан, поврежден или не является образом; дерево в этом
+ * случае может быть заполнено частично.
+ */
+bool load_snapshot(const std::shared_ptr<Node> &root, const std::string &path,
+                   size_t *entries = nullptr);
+
+/**
+ * @brief Запускает запись образа в дочернем процессе.
+ * @return pid дочернего процесса или -1, если fork() не удался.
+ */
+pid_t fork_snapshot(const std::shared_ptr<Node> &root, const std::string &path);
+
+// Ждет завершения процесса, запущенного fork_snapshot() (или переписыванием журнала изменений).
+// true, если образ записан.
+bool wait_snapshot(pid_t pid);
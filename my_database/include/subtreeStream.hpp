@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tree.hpp"
+
+/*
+Потоковый формат поддерева (EXPORT/IMPORT): заголовок kSubtreeStreamMagic, затем записи в
+прямом порядке обхода (scan.hpp):
+
+    +------+-------+------+-------+---------------------+
+    | kind | depth | name_len | name | value_len | value |   value - только у листа
+    |  u8  | varint| varint   |      | varint    |       |
+    +------+-------+------+-------+---------------------+
+
+kind - 'D' (каталог) или 'L' (лист), depth - глубина записи относительно корня поддерева
+(дети корня - 1). Родитель записи - последний каталог глубины depth - 1, поэтому импорт
+не ищет каталоги по пути и не разбирает пути.
+
+Экспорт выдается порциями (export_chunk): каждая порция строится под S-блокировкой только на
+время ее построения, поэтому поддерево никогда не собирается в памяти целиком. Склеенные порции
+образуют поток. Изменения, сделанные между порциями, попадают в поток так же, как в SCAN.
+
+Импорт (SubtreeImporter) разбирает поток по частям и строит поддерево отдельно от дерева, без
+блокировок; готовое поддерево присоединяется attach_subtree под X-блокировкой родителя.
+*/
+
+inline constexpr std::string_view kSubtreeStreamMagic = "MCDBSUB1";
+
+/**
+ * @brief Кодирует следующую порцию потока поддерева dir: до count записей после cursor.
+ *
+ * @param dir Корень экспортируемого поддерева.
+ * @param cursor kScanStart для первой порции (она начинается с заголовка) или курсор из
+ * предыдущего вызова.
+ * @param count Максимальное число записей порции.
+ * @param out Сюда дописывается порция.
+ * @param next Курсор следующей порции или kScanStart, если поток закончен.
+ * @return false, если курсор поврежден.
+ */
+bool export_chunk(const std::shared_ptr<Node> &dir, std::string_view cursor, size_t count,
+                  std::string &out, std::string &next);
+
+class SubtreeImporter {
+   public:
+    // path - полный путь, по которому поддерево будет присоединено.
+    explicit SubtreeImporter(std::string path);
+    ~SubtreeImporter();
+
+    SubtreeImporter(const SubtreeImporter &) = delete;
+    SubtreeImporter &operator=(const SubtreeImporter &) = delete;
+
+    const std::string &path() const { return path_; }
+
+    // Разбирает очередную часть потока; запись может быть разрезана между частями.
+    // false, если поток поврежден: дальнейшие вызовы тоже вернут false.
+    bool feed(std::string_view bytes);
+
+    // Число записей, построенных на данный момент.
+    size_t entries() const { return entries_; }
+
+    // Готовое поддерево для attach_subtree или nullptr, если поток оборван или поврежден.
+    // Неприсоединенное поддерево освобождается discard_detached_subtree.
+    std::shared_ptr<Node> finish();
+
+   private:
+    // Разбирает одну запись с начала data. 0 - запись неполная, npos - поток поврежден.
+    size_t parse_record(std::string_view data);
+
+    std::string path_;
+    std::shared_ptr<Node> root_;
+    std::vector<std::shared_ptr<Node>> stack_;  // Последний каталог каждой глубины
+    std::string pending_;                       // Неполная запись с конца предыдущей части
+    bool header_ = false;
+    bool failed_ = false;
+    size_t entries_ = 0;
+};
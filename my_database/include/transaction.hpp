@@ -0,0 +1,42 @@
+#pragma once
+
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "tree.hpp"
+
+/*
+Проверка транзакции (MULTI/EXEC) перед применением. Изменения транзакции проигрываются на
+наложении поверх дерева: путь -> состояние после уже проверенных изменений. Само дерево не
+меняется, поэтому при первой неприменимой команде откатывать нечего.
+
+Проверка и применение должны выполняться под одной блокировкой каталога, покрывающего все пути
+транзакции: тогда применение повторяет проверку и не может завершиться ошибкой.
+*/
+
+enum class TreeChangeKind : unsigned char {
+    CreateNode,  // Как create_node_by_path: записи нет, родитель - каталог
+    CreateLeaf,  // Как create_leaf_by_path
+    SetLeaf,     // Как set_leaf_by_path: родитель - каталог, путь не занят каталогом
+    DeleteNode,  // Как delete_node_by_path_linear: каталог существует и не корень
+    DeleteLeaf,  // Как delete_leaf_by_path_linear: лист существует
+    ExpireLeaf,  // Срок TTL листа (expiry.hpp): лист существует
+};
+
+struct s_tree_change {
+    TreeChangeKind kind;
+    std::string_view path;  // Должен оставаться действительным до конца проверки
+};
+
+using TreeChange = struct s_tree_change;
+
+/**
+ * @brief Находит первое изменение, которое не удастся применить после предыдущих.
+ *
+ * @param root Корень дерева.
+ * @param changes Изменения в порядке применения.
+ * @return Индекс первого неприменимого изменения или changes.size(), если применимы все.
+ */
+size_t find_failing_change(const std::shared_ptr<Node> &root,
+                           const std::vector<TreeChange> &changes);
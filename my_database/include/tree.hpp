@@ -1,14 +1,24 @@
 #pragma once
 
 #include <algorithm>  // For std::remove
+#include <atomic>
 #include <cassert>
 #include <iostream>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
 #include <sstream>  // For std::stringstream
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <variant>
 #include <vector>
 
+#include "treeAllocator.hpp"
+#include "treeLock.hpp"
+
 enum class Tag : unsigned char {
     Root = 1, /* 00 01*/
     Node = 2, /* 00 10*/
@@ -35,27 +45,147 @@ The common view tree stracture is this:
 // Forward declarations to resolve circular dependency between Node and Leaf
 struct s_node;
 struct s_leaf;
+struct s_path_index;
 using Node = struct s_node;
 using Leaf = struct s_leaf;
+using PathIndex = struct s_path_index;
+
+// Возвращает имя записи - последний сегмент полного пути ("/Users/bob" -> "bob").
+inline std::string_view name_of(std::string_view path) {
+    return path.substr(path.rfind('/') + 1);
+}
+
+// Возвращает путь родительского каталога для полного пути ("/Users/bob" -> "/Users").
+// Путь должен начинаться с '/'.
+inline std::string_view parent_path_of(std::string_view path) {
+    size_t last_slash_pos = path.rfind('/');
+    return (last_slash_pos == 0) ? std::string_view("/") : path.substr(0, last_slash_pos);
+}
+
+// Возвращает полный путь записи name каталога parent ("/Users", "bob" -> "/Users/bob").
+inline std::string child_path_of(std::string_view parent, std::string_view name) {
+    std::string path;
+    path.reserve(parent.size() + 1 + name.size());
+    if (parent != "/") {
+        path.append(parent);
+    }
+    path.push_back('/');
+    path.append(name);
+    return path;
+}
+
+/*
+Список дочерних узлов каталога. Сохраняет порядок вставки (для стабильного вывода дерева),
+а добавление, поиск и удаление по имени выполняются за O(1) за счет хеш-таблицы
+"имя -> позиция в списке". Ключи - std::string_view на path самих дочерних узлов.
+*/
+class NodeChildren {
+   public:
+    using List = std::list<std::shared_ptr<s_node>, TreeAllocator<std::shared_ptr<s_node>>>;
+    using const_iterator = List::const_iterator;
+
+    size_t size() const { return list_.size(); }
+    bool empty() const { return list_.empty(); }
+    const_iterator begin() const { return list_.begin(); }
+    const_iterator end() const { return list_.end(); }
+    const std::shared_ptr<s_node> &front() const { return list_.front(); }
+    const std::shared_ptr<s_node> &back() const { return list_.back(); }
+
+    // Позиция дочернего узла с указанным именем в списке или end().
+    const_iterator position_of(std::string_view name) const;
+
+    // Добавляет узел в конец списка. Имя узла должно быть уникальным среди детей.
+    void push_back(std::shared_ptr<s_node> node);
+
+    // Возвращает дочерний узел с указанным именем или nullptr.
+    std::shared_ptr<s_node> find(std::string_view name) const;
+
+    // Удаляет дочерний узел с указанным именем. Возвращает false, если такого узла нет.
+    bool erase(std::string_view name);
+
+   private:
+    List list_;
+    tree_map<std::string_view, List::iterator> by_name_;
+};
 
 struct s_node {
     Tag tag;
+    uint64_t seq = 0;  // Номер создания: в списках каталога записи идут по возрастанию seq
     std::weak_ptr<s_node> parent;  // To prevent cycles of owning
-    std::vector<std::shared_ptr<s_node>> childs;
+    s_node *parent_raw = nullptr;  // Тот же родитель без счетчика ссылок, для обхода предков
+    NodeChildren childs;
     std::shared_ptr<s_leaf> east;
-    std::string path;
+    s_leaf *last_leaf = nullptr;  // Хвост списка листьев, не владеет им
+    tree_map<std::string_view, s_leaf *> leaf_by_name;  // Листья каталога по имени
+    tree_string path;
+
+    std::shared_ptr<s_path_index> index;  // Общий индекс путей всего дерева
+    IntentionLock lock;                   // Иерархическая блокировка каталога, см. pathLock.hpp
+
+    // Итоги поддерева без самого каталога, см. subtree_stats_of. Меняются писателями соседних
+    // поддеревьев под IX-блокировками предков, поэтому атомарны
+    std::atomic<uint64_t> total_nodes{0};
+    std::atomic<uint64_t> total_leaves{0};
+    std::atomic<uint64_t> total_bytes{0};
 };
 
 struct s_leaf {
     Tag tag;
+    uint64_t seq = 0;         // Номер создания, см. s_node::seq
+    // Истечение TTL, мс Unix-времени; 0 - без TTL, см. expiry.hpp. Меняется под X-блокировкой
+    // каталога; атомарно, потому что выборка вытеснения читает его без блокировок каталогов
+    std::atomic<uint64_t> expires_at{0};
+    std::atomic<uint32_t> access{0};  // Часы LRU или счетчик LFU, см. eviction.hpp
     std::variant<std::weak_ptr<s_node>, std::weak_ptr<s_leaf>> parent;
     std::shared_ptr<s_leaf> west;
     std::shared_ptr<s_leaf> east;
-    std::string path;
+    tree_string path;
+
+    tree_string value;
+};
 
-    std::string value;
+/*
+Индекс путей: хеш-таблица "полный путь -> узел или лист", общая для всего дерева.
+Ключи - это std::string_view на поле path самой записи, поэтому пути не дублируются.
+Индекс хранит слабые ссылки, чтобы не образовывать цикл владения node -> index -> node.
+Корневой узел в индекс не входит: путь "/" обрабатывается отдельно.
+Индекс общий для писателей из разных поддеревьев, поэтому защищен собственной блокировкой.
+*/
+using IndexEntry = std::variant<std::weak_ptr<s_node>, std::weak_ptr<s_leaf>>;
+
+struct s_path_index {
+    tree_map<std::string_view, IndexEntry> entries;
+    mutable TreeRwLock lock;
+    std::atomic<uint64_t> next_seq{1};  // Следующий номер создания записи дерева
+    std::atomic<size_t> bytes{0};       // Оценка памяти записей дерева, см. footprint_of
 };
 
+/**
+ * @brief Оценка памяти, которую занимает запись дерева.
+ * @details Сама запись вместе с блоком управления shared_ptr, буферы path и value вне объекта
+ * строки и элементы хеш-таблиц, в которые входит запись (индекс путей и таблица имен каталога).
+ * Сумма по всем записям дерева хранится в s_path_index::bytes.
+ */
+size_t footprint_of(const Leaf &leaf);
+size_t footprint_of(const Node &node);
+
+struct s_subtree_stats {
+    uint64_t nodes = 0;   // Каталогов-потомков
+    uint64_t leaves = 0;  // Листьев-потомков
+    uint64_t bytes = 0;   // Длины полных путей потомков и значений листьев
+};
+
+using SubtreeStats = struct s_subtree_stats;
+
+/**
+ * @brief Итоги поддерева каталога за O(1), без обхода.
+ * @details Счетчики каталога обновляются вдоль цепочки предков при каждом создании, удалении и
+ * перезаписи записи, а также при присоединении поддерева. Чтение не требует блокировок; три
+ * счетчика читаются по отдельности, поэтому во время записи в поддерево они могут
+ * соответствовать разным моментам.
+ */
+SubtreeStats subtree_stats_of(const Node &node);
+
 /**
  * @brief Создает корневой узел для дерева.
  *
@@ -83,7 +213,7 @@ std::shared_ptr<Node> create_node(const std::shared_ptr<Node> &parent, std::stri
 
 /**
  * @brief Находит последний лист в двухсвязанном списке, начинающемся с
- * parent->east.
+ * parent->east. Выполняется за O(1): узел хранит указатель на хвост списка.
  * @param parent Родительский узел, чьи листья нужно проверить.
  * @return std::shared_ptr<Leaf> на последний лист или nullptr, если листьев
  * нет.
@@ -91,7 +221,7 @@ std::shared_ptr<Node> create_node(const std::shared_ptr<Node> &parent, std::stri
 std::shared_ptr<Leaf> find_last_linear(const std::shared_ptr<Node> &parent);
 
 /**
- * @brief Создает новый лист (файл) и присоединяет его к родительскому узлу.
+ * @brief Создает новый лист (файл) и присоединяет его к концу списка листьев родителя.
  *
  * @param parent Родительский узел (каталог), к которому добавляется лист.
  * @param path Имя листа (файла).
@@ -101,6 +231,24 @@ std::shared_ptr<Leaf> find_last_linear(const std::shared_ptr<Node> &parent);
 std::shared_ptr<Leaf> create_leaf(const std::shared_ptr<Node> &parent, std::string path,
                                   std::string value);
 
+/**
+ * @brief Находит дочерний узел каталога по имени за O(1).
+ *
+ * @param parent Каталог, в котором выполняется поиск.
+ * @param name Имя узла без пути (например, "Login").
+ * @return std::shared_ptr<Node> на найденный узел или nullptr.
+ */
+std::shared_ptr<Node> find_child_node(const std::shared_ptr<Node> &parent, std::string_view name);
+
+/**
+ * @brief Находит лист каталога по имени за O(1).
+ *
+ * @param parent Каталог, в котором выполняется поиск.
+ * @param name Имя листа без пути (например, "bob").
+ * @return std::shared_ptr<Leaf> на найденный лист или nullptr.
+ */
+std::shared_ptr<Leaf> find_child_leaf(const std::shared_ptr<Node> &parent, std::string_view name);
+
 /**
  * @brief Выводит дерево в консоль.
  *
@@ -109,31 +257,43 @@ void print_tree(const std::shared_ptr<Node> &root);
 
 std::string print_tree_string(const std::shared_ptr<Node> &root);
 
+/**
+ * @brief Находит узел в поддереве root по его полному пути.
+ *
+ * Поиск выполняется за O(1) через общий индекс путей дерева, без обхода узлов.
+ *
+ * @param root Корень поддерева, в котором ищется узел.
+ * @param path Полный путь к узлу (например, "/Users/Login").
+ * @return std::shared_ptr<Node> на найденный узел или nullptr, если узел не найден.
+ */
 std::shared_ptr<Node> find_node_by_path_linear(const std::shared_ptr<Node> &root,
-                                               const std::string &path);
+                                               std::string_view path);
 
 /**
  * @brief Удаляет узел из дерева по его полному пути.
  *
  * Эта функция находит узел по его пути и удаляет его из списка
- * дочерних элементов родителя. Узел и все его поддерево будут автоматически
- * освобождены благодаря умным указателям, если на них не будет внешних ссылок.
+ * дочерних элементов родителя. Узел и все его потомки удаляются из индекса путей,
+ * а само поддерево будет автоматически освобождено благодаря умным указателям,
+ * если на него не будет внешних ссылок.
  *
  * @param root Корневой узел дерева.
  * @param path Полный путь удаляемого узла (например, "/Users/Login").
  * @return true, если узел был найден и удален, иначе false.
  */
-bool delete_node_by_path_linear(const std::shared_ptr<Node> &root, const std::string &path);
+bool delete_node_by_path_linear(const std::shared_ptr<Node> &root, std::string_view path);
 
 /**
  * @brief Находит лист в дереве по его полному пути.
  *
+ * Поиск выполняется за O(1) через общий индекс путей дерева.
+ *
  * @param root Корневой узел дерева для начала поиска.
  * @param path Полный путь к листу (например, "/Users/Login/bob").
  * @return std::shared_ptr<Leaf> на найденный лист или nullptr, если лист не найден.
  */
 std::shared_ptr<Leaf> find_leaf_by_path_linear(const std::shared_ptr<Node> &root,
-                                               const std::string &path);
+                                               std::string_view path);
 
 /**
  * @brief Удаляет лист из дерева по его полному пути.
@@ -142,7 +302,16 @@ std::shared_ptr<Leaf> find_leaf_by_path_linear(const std::shared_ptr<Node> &root
  * @param path Полный путь удаляемого листа (например, "/Users/Login/bob").
  * @return true, если лист был найден и удален, иначе false.
  */
-bool delete_leaf_by_path_linear(const std::shared_ptr<Node> &root, const std::string &path);
+bool delete_leaf_by_path_linear(const std::shared_ptr<Node> &root, std::string_view path);
+
+/**
+ * @brief Удаляет уже найденный лист: отвязывает его от соседей и родителя и убирает из индекса.
+ *
+ * @param root Корневой узел дерева (владелец индекса).
+ * @param leaf Удаляемый лист.
+ * @return true, если лист был удален, иначе false.
+ */
+bool delete_leaf(const std::shared_ptr<Node> &root, const std::shared_ptr<Leaf> &leaf);
 
 /**
  * @brief Создает узел по полному пути, если это возможно.
@@ -157,7 +326,7 @@ bool delete_leaf_by_path_linear(const std::shared_ptr<Node> &root, const std::st
  * @return std::shared_ptr<Node> на созданный узел или nullptr в случае ошибки.
  */
 std::shared_ptr<Node> create_node_by_path(const std::shared_ptr<Node> &root,
-                                          const std::string &path);
+                                          std::string_view path);
 
 /**
  * @brief Создает лист по полному пути, если это возможно.
@@ -170,4 +339,63 @@ std::shared_ptr<Node> create_node_by_path(const std::shared_ptr<Node> &root,
  * @return std::shared_ptr<Leaf> на созданный лист или nullptr в случае ошибки.
  */
 std::shared_ptr<Leaf> create_leaf_by_path(const std::shared_ptr<Node> &root,
-                                          const std::string &path, const std::string &value);
+                                          std::string_view path, std::string_view value);
+
+/**
+ * @brief Записывает значение листа по полному пути (upsert).
+ *
+ * Если лист существует, его значение перезаписывается на месте: запись s_leaf, ее положение в
+ * списке листьев и буфер значения (если хватает емкости) переиспользуются, а TTL листа
+ * снимается. Иначе лист создается, как в create_leaf_by_path.
+ *
+ * @param root Корневой узел дерева.
+ * @param path Полный путь листа (например, "/Users/Login/bob").
+ * @param value Новое значение листа.
+ * @param created Если не nullptr, сюда записывается true, когда лист был создан.
+ * @return std::shared_ptr<Leaf> на лист или nullptr, если нет родителя или путь занят каталогом.
+ */
+std::shared_ptr<Leaf> set_leaf_by_path(const std::shared_ptr<Node> &root, std::string_view path,
+                                       std::string_view value, bool *created = nullptr);
+
+/**
+ * @brief Upsert листа в уже найденном каталоге, без поиска родителя по индексу.
+ *
+ * Используется пакетными командами, которые находят общий каталог один раз на много листьев.
+ *
+ * @param parent Каталог, которому принадлежит лист.
+ * @param path Полный путь листа; его родительский путь должен совпадать с путем parent.
+ * @param value Новое значение листа.
+ * @param created Если не nullptr, сюда записывается true, когда лист был создан.
+ * @return std::shared_ptr<Leaf> на лист или nullptr, если имя занято каталогом.
+ */
+std::shared_ptr<Leaf> set_child_leaf(const std::shared_ptr<Node> &parent, std::string_view path,
+                                     std::string_view value, bool *created = nullptr);
+
+/**
+ * @brief Создает отдельный каталог с собственным индексом путей - корень поддерева, которое
+ * строится вне дерева (create_node/create_leaf) и затем присоединяется attach_subtree.
+ *
+ * @param path Полный путь, по которому поддерево будет присоединено.
+ * @return std::shared_ptr<Node> на корень нового поддерева.
+ */
+std::shared_ptr<Node> create_detached_node(std::string path);
+
+/**
+ * @brief Присоединяет поддерево, построенное от create_detached_node, к каталогу parent.
+ *
+ * Поддерево становится видимым одной вставкой в список детей parent; его записи переносятся в
+ * общий индекс путей дерева порциями, без копирования. Каталог с тем же именем заменяется
+ * вместе с содержимым. Вызывается под X-блокировкой parent.
+ *
+ * @param parent Каталог, в который присоединяется поддерево.
+ * @param subtree Корень поддерева; его родительский путь должен совпадать с путем parent.
+ * @return true, если поддерево присоединено; false, если путь не дочерний для parent или
+ * имя занято листом.
+ */
+bool attach_subtree(const std::shared_ptr<Node> &parent, const std::shared_ptr<Node> &subtree);
+
+/**
+ * @brief Освобождает поддерево от create_detached_node, которое не будет присоединено.
+ * @details Разрывает связи между листьями, иначе пары west/east держат друг друга.
+ */
+void discard_detached_subtree(const std::shared_ptr<Node> &subtree);
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+Пуловое выделение памяти для записей дерева. Выбирается при сборке опцией CMake
+BINARY_TREE_ALLOCATOR (heap | pool), которая определяет макрос TREE_POOL_ALLOCATOR.
+
+    SlabPool      - блоки одного размера нарезаются из больших слэбов; освобожденные блоки
+                    попадают в список свободных и переиспользуются следующими вставками.
+                    Используется для s_node, s_leaf (вместе с блоком управления shared_ptr)
+                    и для элементов хеш-таблиц и списков дерева.
+    StringArena   - bump-арена для содержимого строк path и value. Память нарезается
+                    классами размеров (16, 32, ... 2048 байт), освобожденные куски
+                    возвращаются в список своего класса. Более длинные строки идут в кучу.
+
+Память пулов не возвращается системе: слэбы и куски арены живут до конца процесса. Пулы
+намеренно не разрушаются, чтобы shared_ptr в статических объектах можно было освободить
+и после завершения main.
+*/
+
+// Простая спин-блокировка: критические секции пулов - несколько инструкций.
+class SpinLock {
+   public:
+    void lock() {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+    void unlock() { flag_.clear(std::memory_order_release); }
+
+   private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+/**
+ * @brief Пул блоков фиксированного размера.
+ */
+class SlabPool {
+   public:
+    SlabPool(size_t block_size, size_t alignment);
+
+    SlabPool(const SlabPool &) = delete;
+    SlabPool &operator=(const SlabPool &) = delete;
+
+    void *allocate();
+    void deallocate(void *block);
+
+    size_t blocks_in_use() const { return blocks_in_use_.load(std::memory_order_relaxed); }
+
+   private:
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    static constexpr size_t kSlabSize = 64 * 1024;
+
+    size_t block_size_;
+    size_t alignment_;
+    FreeBlock *free_list_ = nullptr;
+    std::byte *bump_ = nullptr;  // Еще не выданная часть текущего слэба
+    std::byte *bump_end_ = nullptr;
+    std::vector<std::byte *> slabs_;
+    std::atomic<size_t> blocks_in_use_{0};
+    SpinLock lock_;
+};
+
+// Пул для блоков заданного размера и выравнивания. Один пул на каждую пару параметров.
+template <size_t Size, size_t Alignment>
+SlabPool &slab_pool() {
+    static SlabPool *pool = new SlabPool(Size, Alignment);
+    return *pool;
+}
+
+/**
+ * @brief Арена для содержимого строк с переиспользованием освобожденных кусков.
+ */
+class StringArena {
+   public:
+    static StringArena &instance();
+
+    void *allocate(size_t bytes);
+    void deallocate(void *pointer, size_t bytes);
+
+    size_t bytes_in_use() const { return bytes_in_use_.load(std::memory_order_relaxed); }
+
+   private:
+    StringArena() = default;
+
+    struct FreeChunk {
+        FreeChunk *next;
+    };
+
+    static constexpr size_t kMinClassSize = 16;
+    static constexpr size_t kClassCount = 8;  // 16 ... 2048 байт
+    static constexpr size_t kMaxClassSize = kMinClassSize << (kClassCount - 1);
+    static constexpr size_t kChunkSize = 256 * 1024;
+
+    static size_t class_of(size_t bytes);
+
+    FreeChunk *free_lists_[kClassCount] = {};
+    std::byte *bump_ = nullptr;
+    std::byte *bump_end_ = nullptr;
+    std::atomic<size_t> bytes_in_use_{0};
+    SpinLock lock_;
+};
+
+// Аллокатор в стиле std::allocator: одиночные объекты берутся из SlabPool своего размера,
+// массивы (например, таблицы корзин unordered_map) - из обычной кучи.
+template <typename T>
+struct PoolAllocator {
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) {
+        if (n == 1) {
+            return static_cast<T *>(slab_pool<sizeof(T), alignof(T)>().allocate());
+        }
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    void deallocate(T *pointer, size_t n) noexcept {
+        if (n == 1) {
+            slab_pool<sizeof(T), alignof(T)>().deallocate(pointer);
+            return;
+        }
+        ::operator delete(pointer, std::align_val_t(alignof(T)));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U> &) const noexcept {
+        return true;
+    }
+};
+
+// Аллокатор символов строк поверх общей StringArena.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &) noexcept {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(StringArena::instance().allocate(n * sizeof(T)));
+    }
+    void deallocate(T *pointer, size_t n) noexcept {
+        StringArena::instance().deallocate(pointer, n * sizeof(T));
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &) const noexcept {
+        return true;
+    }
+};
+
+#ifdef TREE_POOL_ALLOCATOR
+template <typename T>
+using TreeAllocator = PoolAllocator<T>;
+using tree_string = std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+inline constexpr const char *kTreeAllocatorName = "pool";
+#else
+template <typename T>
+using TreeAllocator = std::allocator<T>;
+using tree_string = std::string;
+inline constexpr const char *kTreeAllocatorName = "heap";
+#endif
+
+// Хеш-таблица, элементы которой выделяются через аллокатор дерева.
+template <typename Key, typename Value>
+using tree_map = std::unordered_map<Key, Value, std::hash<Key>, std::equal_to<Key>,
+                                    TreeAllocator<std::pair<const Key, Value>>>;
+
+// Переносит строку в хранилище дерева; без копирования, если tree_string - это std::string.
+inline void assign_tree_string(tree_string &target, std::string &&source) {
+#ifdef TREE_POOL_ALLOCATOR
+    target.assign(source.data(), source.size());
+#else
+    target = std::move(source);
+#endif
+}
+
+// Создает запись дерева через выбранный аллокатор (объект и блок управления - одним блоком).
+template <typename T>
+std::shared_ptr<T> make_tree_shared() {
+    return std::allocate_shared<T>(TreeAllocator<T>());
+}
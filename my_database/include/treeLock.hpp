@@ -0,0 +1,92 @@
+#pragma once
+
+#include <pthread.h>
+
+#include <atomic>
+#include <cstdint>
+
+/*
+Блокировки для доступа к дереву из нескольких потоков.
+*/
+
+/**
+ * @brief Блокировка читатель/писатель с приоритетом писателя.
+ *
+ * Читатели выполняются параллельно друг с другом. В отличие от std::shared_mutex (в glibc
+ * он отдает приоритет читателям), ожидающий писатель не пропускает вперед новых читателей,
+ * поэтому при потоке чтений >90% изменения не голодают.
+ * Совместима с std::unique_lock и std::shared_lock.
+ */
+class TreeRwLock {
+   public:
+    TreeRwLock() {
+        pthread_rwlockattr_t attr;
+        pthread_rwlockattr_init(&attr);
+        pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+        pthread_rwlock_init(&lock_, &attr);
+        pthread_rwlockattr_destroy(&attr);
+    }
+    ~TreeRwLock() { pthread_rwlock_destroy(&lock_); }
+
+    TreeRwLock(const TreeRwLock &) = delete;
+    TreeRwLock &operator=(const TreeRwLock &) = delete;
+
+    void lock() { pthread_rwlock_wrlock(&lock_); }
+    bool try_lock() { return pthread_rwlock_trywrlock(&lock_) == 0; }
+    void unlock() { pthread_rwlock_unlock(&lock_); }
+
+    void lock_shared() { pthread_rwlock_rdlock(&lock_); }
+    bool try_lock_shared() { return pthread_rwlock_tryrdlock(&lock_) == 0; }
+    void unlock_shared() { pthread_rwlock_unlock(&lock_); }
+
+   private:
+    pthread_rwlock_t lock_;
+};
+
+// Режимы иерархической блокировки каталога.
+enum class LockMode : unsigned char {
+    IntentionShared,     // IS: ниже по дереву будет взята S
+    IntentionExclusive,  // IX: ниже по дереву будет взята X
+    Shared,              // S: чтение всего поддерева
+    Exclusive,           // X: изменение каталога и всего поддерева
+};
+
+/**
+ * @brief Блокировка каталога с намеренными режимами (multiple granularity locking).
+ *
+ * Совместимость режимов:
+ *
+ *          IS   IX   S    X
+ *     IS   +    +    +    -
+ *     IX   +    +    -    -
+ *     S    +    -    +    -
+ *     X    -    -    -    -
+ *
+ * Писатели в разных поддеревьях держат IX на общих предках и не мешают друг другу, а S или X
+ * на каталоге дожидается всех, кто работает внутри его поддерева. Ожидающий X не пропускает
+ * вперед новые запросы других режимов, чтобы DELETE_NODE не голодал.
+ *
+ * Все состояние - одно 64-битное слово, ожидание через std::atomic::wait, поэтому блокировка
+ * занимает 8 байт в каждом узле. Блокировки должны браться сверху вниз по дереву.
+ */
+class IntentionLock {
+   public:
+    void lock(LockMode mode);
+    bool try_lock(LockMode mode);
+    void unlock(LockMode mode);
+
+   private:
+    // Раскладка слова состояния: по 16 бит на счетчики IS, IX, S, 1 бит X
+    // и 15 бит на число ожидающих X.
+    static constexpr uint64_t kIntentionShared = 1ull;
+    static constexpr uint64_t kIntentionExclusive = 1ull << 16;
+    static constexpr uint64_t kShared = 1ull << 32;
+    static constexpr uint64_t kExclusive = 1ull << 48;
+    static constexpr uint64_t kExclusiveWaiter = 1ull << 49;
+    static constexpr uint64_t kCounterMask = 0xFFFFull;
+
+    static uint64_t delta_of(LockMode mode);
+    static bool compatible(uint64_t state, LockMode mode, bool own_waiter);
+
+    std::atomic<uint64_t> state_{0};
+};
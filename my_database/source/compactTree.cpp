@@ -0,0 +1,368 @@
+#include "compactTree.hpp"
+
+#include <sstream>
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+CompactTree::CompactTree() {
+    // Слот 0 - корень. Он не имеет имени и никогда не освобождается.
+    nodes_.emplace_back();
+    nodes_[0].live = true;
+}
+
+bool CompactTree::valid(NodeHandle node) const {
+    return node.index < nodes_.size() && nodes_[node.index].live &&
+           nodes_[node.index].generation == node.generation;
+}
+
+bool CompactTree::valid(LeafHandle leaf) const {
+    return leaf.index < leaves_.size() && leaves_[leaf.index].live &&
+           leaves_[leaf.index].generation == leaf.generation;
+}
+
+uint32_t CompactTree::allocate_node() {
+    if (free_nodes_ != kNilIndex) {
+        uint32_t index = free_nodes_;
+        free_nodes_ = nodes_[index].next_sibling;
+        return index;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+uint32_t CompactTree::allocate_leaf() {
+    if (free_leaves_ != kNilIndex) {
+        uint32_t index = free_leaves_;
+        free_leaves_ = leaves_[index].east;
+        return index;
+    }
+    leaves_.emplace_back();
+    return static_cast<uint32_t>(leaves_.size() - 1);
+}
+
+void CompactTree::free_node(uint32_t index) {
+    CompactNode &node = nodes_[index];
+    segments_.release(node.name);
+
+    uint32_t generation = node.generation + 1;  // Все выданные дескрипторы слота устаревают
+    node = CompactNode{};
+    node.generation = generation;
+    node.next_sibling = free_nodes_;
+    free_nodes_ = index;
+    --node_count_;
+}
+
+void CompactTree::free_leaf(uint32_t index) {
+    CompactLeaf &leaf = leaves_[index];
+    segments_.release(leaf.name);
+
+    uint32_t generation = leaf.generation + 1;
+    leaf = CompactLeaf{};
+    leaf.generation = generation;
+    leaf.east = free_leaves_;
+    free_leaves_ = index;
+    --leaf_count_;
+}
+
+uint32_t CompactTree::find_child(uint32_t parent, std::string_view name) const {
+    SegmentId id = segments_.find(name);
+    if (id == kNoSegment) {
+        return kNilIndex;
+    }
+    auto it = children_.find(child_key(parent, id));
+    return it == children_.end() ? kNilIndex : it->second;
+}
+
+uint32_t CompactTree::resolve_node(std::string_view path) const {
+    if (path.empty() || path.front() != '/') {
+        return kNilIndex;
+    }
+
+    uint32_t current = 0;
+    if (path == "/") {
+        return current;
+    }
+
+    size_t begin = 1;
+    while (begin <= path.size()) {
+        size_t end = path.find('/', begin);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        uint32_t child = find_child(current, path.substr(begin, end - begin));
+        if (child == kNilIndex || (child & kLeafBit)) {
+            return kNilIndex;
+        }
+        current = child;
+        begin = end + 1;
+    }
+    return current;
+}
+
+NodeHandle CompactTree::create_node(NodeHandle parent, std::string_view name) {
+    if (!valid(parent) || name.empty() || name.find('/') != std::string_view::npos ||
+        find_child(parent.index, name) != kNilIndex) {
+        return {};
+    }
+
+    uint32_t index = allocate_node();  // Может перераспределить nodes_, ссылки берем после
+    CompactNode &node = nodes_[index];
+    node.live = true;
+    node.name = segments_.intern(name);
+    node.parent = parent.index;
+
+    CompactNode &parent_node = nodes_[parent.index];
+    node.prev_sibling = parent_node.last_child;
+    if (parent_node.last_child != kNilIndex) {
+        nodes_[parent_node.last_child].next_sibling = index;
+    } else {
+        parent_node.first_child = index;
+    }
+    parent_node.last_child = index;
+
+    children_.emplace(child_key(parent.index, node.name), index);
+    ++node_count_;
+    return {index, node.generation};
+}
+
+LeafHandle CompactTree::create_leaf(NodeHandle parent, std::string_view name,
+                                    std::string_view value) {
+    if (!valid(parent) || name.empty() || name.find('/') != std::string_view::npos ||
+        find_child(parent.index, name) != kNilIndex) {
+        return {};
+    }
+
+    uint32_t index = allocate_leaf();
+    CompactLeaf &leaf = leaves_[index];
+    leaf.live = true;
+    leaf.name = segments_.intern(name);
+    leaf.parent = parent.index;
+    leaf.value.assign(value);
+
+    CompactNode &parent_node = nodes_[parent.index];
+    leaf.west = parent_node.last_leaf;
+    if (parent_node.last_leaf != kNilIndex) {
+        leaves_[parent_node.last_leaf].east = index;
+    } else {
+        parent_node.first_leaf = index;
+    }
+    parent_node.last_leaf = index;
+
+    children_.emplace(child_key(parent.index, leaf.name), index | kLeafBit);
+    ++leaf_count_;
+    return {index, leaf.generation};
+}
+
+NodeHandle CompactTree::find_child_node(NodeHandle parent, std::string_view name) const {
+    if (!valid(parent)) {
+        return {};
+    }
+    uint32_t child = find_child(parent.index, name);
+    if (child == kNilIndex || (child & kLeafBit)) {
+        return {};
+    }
+    return {child, nodes_[child].generation};
+}
+
+LeafHandle CompactTree::find_child_leaf(NodeHandle parent, std::string_view name) const {
+    if (!valid(parent)) {
+        return {};
+    }
+    uint32_t child = find_child(parent.index, name);
+    if (child == kNilIndex || !(child & kLeafBit)) {
+        return {};
+    }
+    child &= ~kLeafBit;
+    return {child, leaves_[child].generation};
+}
+
+NodeHandle CompactTree::find_node(std::string_view path) const {
+    uint32_t index = resolve_node(path);
+    if (index == kNilIndex) {
+        return {};
+    }
+    return {index, nodes_[index].generation};
+}
+
+LeafHandle CompactTree::find_leaf(std::string_view path) const {
+    std::string_view parent_path, name;
+    if (!split_compact_path(path, parent_path, name)) {
+        return {};
+    }
+    uint32_t parent = resolve_node(parent_path);
+    if (parent == kNilIndex) {
+        return {};
+    }
+    return find_child_leaf({parent, nodes_[parent].generation}, name);
+}
+
+void CompactTree::unlink_leaf(uint32_t index) {
+    CompactLeaf &leaf = leaves_[index];
+    CompactNode &parent = nodes_[leaf.parent];
+
+    if (leaf.west != kNilIndex) {
+        leaves_[leaf.west].east = leaf.east;
+    } else {
+        parent.first_leaf = leaf.east;
+    }
+    if (leaf.east != kNilIndex) {
+        leaves_[leaf.east].west = leaf.west;
+    } else {
+        parent.last_leaf = leaf.west;
+    }
+    children_.erase(child_key(leaf.parent, leaf.name));
+}
+
+bool CompactTree::delete_leaf(LeafHandle leaf) {
+    if (!valid(leaf)) {
+        return false;
+    }
+    unlink_leaf(leaf.index);
+    free_leaf(leaf.index);
+    return true;
+}
+
+bool CompactTree::delete_node(NodeHandle node) {
+    if (!valid(node) || node.index == 0) {
+        return false;
+    }
+
+    // Отвязываем вершину поддерева от списка детей родителя.
+    CompactNode &top = nodes_[node.index];
+    CompactNode &parent = nodes_[top.parent];
+    if (top.prev_sibling != kNilIndex) {
+        nodes_[top.prev_sibling].next_sibling = top.next_sibling;
+    } else {
+        parent.first_child = top.next_sibling;
+    }
+    if (top.next_sibling != kNilIndex) {
+        nodes_[top.next_sibling].prev_sibling = top.prev_sibling;
+    } else {
+        parent.last_child = top.prev_sibling;
+    }
+
+    // Освобождаем поддерево обходом с явным стеком, без рекурсии.
+    std::vector<uint32_t> pending = {node.index};
+    while (!pending.empty()) {
+        uint32_t current = pending.back();
+        pending.pop_back();
+
+        for (uint32_t child = nodes_[current].first_child; child != kNilIndex;
+             child = nodes_[child].next_sibling) {
+            pending.push_back(child);
+        }
+        for (uint32_t leaf = nodes_[current].first_leaf; leaf != kNilIndex;) {
+            uint32_t next = leaves_[leaf].east;
+            children_.erase(child_key(current, leaves_[leaf].name));
+            free_leaf(leaf);
+            leaf = next;
+        }
+
+        children_.erase(child_key(nodes_[current].parent, nodes_[current].name));
+        free_node(current);
+    }
+    return true;
+}
+
+NodeHandle CompactTree::parent_of(NodeHandle node) const {
+    if (!valid(node) || node.index == 0) {
+        return {};
+    }
+    uint32_t parent = nodes_[node.index].parent;
+    return {parent, nodes_[parent].generation};
+}
+
+NodeHandle CompactTree::parent_of(LeafHandle leaf) const {
+    if (!valid(leaf)) {
+        return {};
+    }
+    uint32_t parent = leaves_[leaf.index].parent;
+    return {parent, nodes_[parent].generation};
+}
+
+std::string_view CompactTree::name_of(NodeHandle node) const {
+    if (node.index == 0) {
+        return "";
+    }
+    return segments_.view(nodes_[node.index].name);
+}
+
+std::string_view CompactTree::name_of(LeafHandle leaf) const {
+    return segments_.view(leaves_[leaf.index].name);
+}
+
+void CompactTree::set_value(LeafHandle leaf, std::string_view value) {
+    leaves_[leaf.index].value.assign(value);
+}
+
+std::string CompactTree::path_of(NodeHandle node) const {
+    if (node.index == 0) {
+        return "/";
+    }
+
+    std::vector<std::string_view> names;
+    for (uint32_t i = node.index; i != 0; i = nodes_[i].parent) {
+        names.push_back(segments_.view(nodes_[i].name));
+    }
+
+    std::string path;
+    for (auto it = names.rbegin(); it != names.rend(); ++it) {
+        path += '/';
+        path += *it;
+    }
+    return path;
+}
+
+std::string CompactTree::path_of(LeafHandle leaf) const {
+    uint32_t parent = leaves_[leaf.index].parent;
+    std::string path = (parent == 0) ? "" : path_of(NodeHandle{parent, nodes_[parent].generation});
+    path += '/';
+    path += segments_.view(leaves_[leaf.index].name);
+    return path;
+}
+
+std::string CompactTree::print_tree_string(NodeHandle node) const {
+    if (!valid(node)) {
+        return "";
+    }
+
+    // Кадр обхода: каталог, его полный путь, отступ и следующий еще не выведенный ребенок.
+    struct Frame {
+        uint32_t node;
+        std::string path;
+        int indent;
+        uint32_t next_child;
+    };
+
+    std::stringstream ss;
+    std::vector<Frame> frames;
+    frames.push_back({node.index, path_of(node), 0, nodes_[node.index].first_child});
+    ss << "📁 " << frames.back().path << "\n";
+
+    while (!frames.empty()) {
+        Frame &frame = frames.back();
+        std::string_view prefix = (frame.node == 0) ? std::string_view() : frame.path;
+
+        if (frame.next_child != kNilIndex) {
+            uint32_t child = frame.next_child;
+            frame.next_child = nodes_[child].next_sibling;
+
+            std::string child_path(prefix);
+            child_path += '/';
+            child_path += segments_.view(nodes_[child].name);
+            ss << std::string((frame.indent + 1) * 2, ' ') << "📁 " << child_path << "\n";
+            frames.push_back({child, std::move(child_path), frame.indent + 1,
+                              nodes_[child].first_child});
+            continue;
+        }
+
+        for (uint32_t leaf = nodes_[frame.node].first_leaf; leaf != kNilIndex;
+             leaf = leaves_[leaf].east) {
+            ss << std::string((frame.indent + 1) * 2, ' ') << "🍃 " << prefix << "/"
+               << segments_.view(leaves_[leaf].name) << " (value: '" << leaves_[leaf].value
+               << "')\n";
+        }
+        frames.pop_back();
+    }
+    return ss.str();
+}
@@ -0,0 +1,82 @@
+#include "connectionPool.hpp"
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+ConnectionPool::ConnectionPool(size_t threads, size_t max_queued,
+                               std::chrono::milliseconds queue_timeout)
+    : max_queued_(max_queued), queue_timeout_(queue_timeout) {
+    threads_.reserve(threads + 1);
+    for (size_t i = 0; i < threads; ++i) {
+        threads_.emplace_back(&ConnectionPool::worker, this);
+    }
+    threads_.emplace_back(&ConnectionPool::expire_queued, this);
+}
+
+ConnectionPool::~ConnectionPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    ready_.notify_all();
+    queued_.notify_all();
+    for (auto &thread : threads_) {
+        thread.join();
+    }
+}
+
+bool ConnectionPool::submit(std::shared_ptr<Client> client) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.size() < max_queued_) {
+            queue_.push_back({std::move(client), Clock::now() + queue_timeout_});
+            ready_.notify_one();
+            queued_.notify_one();
+            return true;
+        }
+    }
+    client->send("503 Service Unavailable: Too many connections.\n");
+    return false;
+}
+
+void ConnectionPool::worker() {
+    while (true) {
+        std::shared_ptr<Client> client;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+            if (stopping_ && queue_.empty()) {
+                return;
+            }
+            client = std::move(queue_.front().client);
+            queue_.pop_front();
+        }
+        handle_connection(std::move(client));
+    }
+}
+
+void ConnectionPool::expire_queued() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        if (queue_.empty()) {
+            queued_.wait(lock);
+            continue;
+        }
+        if (queued_.wait_until(lock, queue_.front().deadline) != std::cv_status::timeout) {
+            continue;  // Очередь изменилась: первым мог стать другой клиент
+        }
+        std::vector<std::shared_ptr<Client>> expired;
+        auto now = Clock::now();
+        while (!queue_.empty() && queue_.front().deadline <= now) {
+            expired.push_back(std::move(queue_.front().client));
+            queue_.pop_front();
+        }
+        lock.unlock();
+        for (auto &client : expired) {
+            LOG_WARNING("No free worker for ", client->get_ip(), ":", client->get_port(),
+                        ", closing.");
+            client->send("503 Service Unavailable: All workers are busy.\n");
+        }
+        expired.clear();  // Сокеты закрываются без блокировки
+        lock.lock();
+    }
+}
@@ -0,0 +1,359 @@
+#include "eventLoop.hpp"
+
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "logger.hpp"
+
+/*-----------------------------------------STATIC_VARiABLES----------------------------------------------------*/
+
+static constexpr int kMaxEvents = 256;
+
+// Чтений одного клиента за событие: быстрый отправитель не должен занимать цикл целиком.
+static constexpr int kMaxReadsPerEvent = 16;
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+static bool set_non_blocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+EventLoop::~EventLoop() {
+    {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        stopping_ = true;
+    }
+    sync_wanted_.notify_one();
+    if (syncer_.joinable()) {
+        syncer_.join();
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool EventLoop::init() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        LOG_ERROR("epoll_create1 failed: ", strerror(errno));
+        return false;
+    }
+
+    struct epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.fd = listen_fd_;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &event) != 0) {
+        LOG_ERROR("Failed to watch listening socket: ", strerror(errno));
+        return false;
+    }
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    event.data.fd = wake_fd_;
+    if (wake_fd_ < 0 || epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) != 0) {
+        LOG_ERROR("Failed to create mutation log wakeup: ", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::run() {
+    struct epoll_event events[kMaxEvents];
+
+    while (true) {
+        // Клиенты с недочитанными данными: не ждать событий, которых для них не будет
+        int ready = epoll_wait(epoll_fd_, events, kMaxEvents, deferred_.empty() ? -1 : 0);
+        if (ready < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("epoll_wait failed: ", strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == listen_fd_) {
+                accept_clients();
+                continue;
+            }
+            if (fd == wake_fd_) {
+                resume_synced();
+                continue;
+            }
+
+            auto it = clients_.find(fd);
+            if (it == clients_.end()) {
+                continue;
+            }
+            std::shared_ptr<Client> client = it->second;
+
+            uint32_t mask = events[i].events;
+            if (mask & (EPOLLERR | EPOLLHUP)) {
+                close_client(fd);
+                continue;
+            }
+            if (mask & (EPOLLIN | EPOLLRDHUP)) {
+                handle_readable(client);
+            }
+            if ((mask & EPOLLOUT) && clients_.count(fd)) {
+                handle_writable(client);
+            }
+        }
+
+        // Продолжение клиентов, исчерпавших kMaxReadsPerEvent, после всех готовых событий
+        std::vector<int> deferred;
+        deferred.swap(deferred_);
+        for (int fd : deferred) {
+            auto it = clients_.find(fd);
+            if (it != clients_.end()) {
+                std::shared_ptr<Client> client = it->second;
+                handle_readable(client);
+            }
+        }
+    }
+}
+
+void EventLoop::accept_clients() {
+    while (true) {
+        struct sockaddr_in address;
+        socklen_t len = sizeof(address);
+        int client_fd = accept4(listen_fd_, (struct sockaddr *)&address, &len,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client_fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            // EAGAIN - очередь принятых соединений пуста
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("accept failed: ", strerror(errno));
+            }
+            return;
+        }
+
+        char ip[16];
+        inet_ntop(AF_INET, &address.sin_addr, ip, sizeof(ip));
+        auto client = std::make_shared<Client>(client_fd, ip, ntohs(address.sin_port));
+        client->set_buffered(true);
+
+        struct epoll_event event {};
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.fd = client_fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &event) != 0) {
+            LOG_ERROR("Failed to watch socket ", client_fd, ": ", strerror(errno));
+            continue;  // Client закроет сокет
+        }
+
+        LOG_INFO("New connection from ", ip, ":", client->get_port());
+        client->send("100 Connected to server\n");
+        clients_.emplace(client_fd, std::move(client));
+    }
+}
+
+void EventLoop::handle_readable(const std::shared_ptr<Client> &client) {
+    if (parked_.count(client->get_fd())) {
+        return;  // Продолжит resume_synced после записи журнала
+    }
+    // Edge-triggered: следующего события не будет, пока сокет не опустеет, поэтому клиент,
+    // на котором чтение прервано до EAGAIN, продолжается из deferred_ или handle_writable.
+    // Команды выполняются после каждого чтения, чтобы входной буфер не рос без предела.
+    // Запросы, оставленные process_input при переполнении вывода, выполняются до нового чтения:
+    // клиент может ждать ответов на них и больше ничего не прислать
+    bool peer_closed = !client->input().empty() && !process(client);
+    for (int reads = 0; !peer_closed && !parked_.count(client->get_fd()); ++reads) {
+        if (client->output_full()) {
+            // Клиент не забирает ответы: не читать и не выполнять команды, пока они не уйдут
+            if (!client->flush()) {
+                close_client(client->get_fd());
+                return;
+            }
+            if (client->output_full()) {
+                return;  // Продолжит handle_writable, когда сокет примет ответы
+            }
+            peer_closed = !process(client);
+            continue;
+        }
+        if (reads >= kMaxReadsPerEvent) {
+            deferred_.push_back(client->get_fd());
+            break;
+        }
+
+        ssize_t bytes_read = client->read_some();
+        if (bytes_read > 0) {
+            if (!process(client)) {
+                peer_closed = true;
+                break;
+            }
+            continue;
+        }
+        if (bytes_read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        peer_closed = true;  // 0 - клиент закрыл соединение, иначе ошибка сокета
+        break;
+    }
+
+    if (parked_.count(client->get_fd())) {
+        if (peer_closed) {
+            close_client(client->get_fd());  // Ответы о незаписанных изменениях не отправляются
+        }
+        return;
+    }
+    if (!client->flush() || peer_closed) {
+        close_client(client->get_fd());
+    }
+}
+
+void EventLoop::handle_writable(const std::shared_ptr<Client> &client) {
+    if (parked_.count(client->get_fd())) {
+        return;
+    }
+    bool paused = client->output_full();
+    if (!client->flush()) {
+        close_client(client->get_fd());
+    } else if (paused && !client->output_full()) {
+        handle_readable(client);  // Чтение было остановлено до этого момента
+    }
+}
+
+void EventLoop::close_client(int fd) {
+    auto it = clients_.find(fd);
+    if (it == clients_.end()) {
+        return;
+    }
+    LOG_INFO("Client ", it->second->get_ip(), ":", it->second->get_port(), " disconnected.");
+    // Сокет закроет деструктор Client; из epoll он удалится при закрытии, но убираем явно,
+    // так как обработчик мог сохранить ссылку на клиента
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    clients_.erase(it);
+    parked_.erase(fd);
+}
+
+bool EventLoop::process(const std::shared_ptr<Client> &client) {
+    uint64_t lsn = 0;
+    if (!process_input(client, &lsn)) {
+        return false;
+    }
+    if (lsn == 0) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        if (sync_failed_) {
+            LOG_ERROR("Mutation log is unavailable, closing ", client->get_ip(), ":",
+                      client->get_port());
+            return false;
+        }
+        sync_target_ = std::max(sync_target_, lsn);
+    }
+    if (!syncer_.joinable()) {
+        syncer_ = std::thread(&EventLoop::sync_loop, this);
+    }
+    sync_wanted_.notify_one();
+    parked_[client->get_fd()] = lsn;
+    return true;
+}
+
+void EventLoop::resume_synced() {
+    uint64_t count;
+    while (read(wake_fd_, &count, sizeof(count)) < 0 && errno == EINTR) {
+    }
+    uint64_t synced;
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(sync_mutex_);
+        synced = synced_;
+        failed = sync_failed_;
+    }
+
+    std::vector<int> ready;
+    for (const auto &[fd, lsn] : parked_) {
+        if (failed || lsn <= synced) {
+            ready.push_back(fd);
+        }
+    }
+    for (int fd : ready) {
+        parked_.erase(fd);
+        auto it = clients_.find(fd);
+        if (it == clients_.end()) {
+            continue;
+        }
+        std::shared_ptr<Client> client = it->second;
+        if (failed) {
+            LOG_ERROR("Mutation log is unavailable, closing ", client->get_ip(), ":",
+                      client->get_port());
+            close_client(fd);
+            continue;
+        }
+        // Сначала ответы, затем оставшиеся запросы и новые данные сокета. Если сокет не принял
+        // все ответы, чтение продолжит handle_writable
+        if (!client->flush()) {
+            close_client(fd);
+        } else if (!client->output_full()) {
+            handle_readable(client);
+        }
+    }
+}
+
+void EventLoop::sync_loop() {
+    std::unique_lock<std::mutex> lock(sync_mutex_);
+    while (true) {
+        sync_wanted_.wait(lock, [this] {
+            return stopping_ || (!sync_failed_ && sync_target_ > synced_);
+        });
+        if (stopping_) {
+            return;
+        }
+        uint64_t target = sync_target_;
+        lock.unlock();
+        bool ok = wait_mutation_log(target);
+        lock.lock();
+        if (ok) {
+            synced_ = std::max(synced_, target);
+        } else {
+            sync_failed_ = true;
+        }
+        uint64_t one = 1;
+        if (write(wake_fd_, &one, sizeof(one)) < 0) {
+            LOG_ERROR("Mutation log wakeup failed: ", strerror(errno));
+        }
+    }
+}
+
+int run_event_loops(const std::vector<int> &listen_fds) {
+    std::vector<std::unique_ptr<EventLoop>> loops;
+    for (int listen_fd : listen_fds) {
+        if (!set_non_blocking(listen_fd)) {
+            LOG_ERROR("Failed to make listening socket non-blocking: ", strerror(errno));
+            return -1;
+        }
+        loops.push_back(std::make_unique<EventLoop>(listen_fd));
+        if (!loops.back()->init()) {
+            return -1;
+        }
+    }
+    if (loops.empty()) {
+        return -1;
+    }
+
+    LOG_INFO("Serving connections with ", loops.size(), " epoll event loop(s)");
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < loops.size(); ++i) {
+        threads.emplace_back(&EventLoop::run, loops[i].get());
+    }
+    loops[0]->run();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    return -1;  // run() возвращается только при ошибке epoll_wait
+}
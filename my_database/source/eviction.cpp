@@ -0,0 +1,228 @@
+#include "eviction.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <shared_mutex>
+
+#include "pathLock.hpp"
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+// Слово LFU: старшие 24 бита - период последнего обращения, младшие 8 - счетчик.
+constexpr uint32_t kLfuCounterMax = 255;
+constexpr uint32_t kLfuCounterBits = 8;
+constexpr uint32_t kLfuPeriodMask = (uint32_t{1} << 24) - 1;
+
+// Проб корзин индекса на один лист выборки: корзины бывают пустыми или заняты каталогами.
+constexpr size_t kProbesPerSample = 8;
+
+// Повторные выборки, если все кандидаты пула удалены, пока их выбирали.
+constexpr int kEvictAttempts = 4;
+
+// Листья с TTL при политике ttl: выше любого значения LRU.
+constexpr uint64_t kTtlBand = uint64_t{1} << 63;
+
+// Часы LRU; 0 зарезервирован за листом без обращений.
+uint32_t lru_clock(uint64_t now_ms) {
+    auto clock = static_cast<uint32_t>(now_ms / kLruClockMs);
+    return clock == 0 ? 1 : clock;
+}
+
+uint32_t lfu_period(uint64_t now_ms, uint64_t decay_ms) {
+    return static_cast<uint32_t>(now_ms / std::max<uint64_t>(decay_ms, 1)) & kLfuPeriodMask;
+}
+
+// Счетчик LFU за вычетом периодов без обращений.
+uint32_t lfu_counter(uint32_t word, uint32_t period) {
+    uint32_t counter = word & kLfuCounterMax;
+    uint32_t idle = (period - (word >> kLfuCounterBits)) & kLfuPeriodMask;
+    return counter > idle ? counter - idle : 0;
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+bool parse_eviction_policy(std::string_view name, EvictionPolicy &policy) {
+    if (name == "noeviction") {
+        policy = EvictionPolicy::NoEviction;
+    } else if (name == "lru") {
+        policy = EvictionPolicy::Lru;
+    } else if (name == "lfu") {
+        policy = EvictionPolicy::Lfu;
+    } else if (name == "ttl") {
+        policy = EvictionPolicy::TtlFirst;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string_view eviction_policy_name(EvictionPolicy policy) {
+    switch (policy) {
+        case EvictionPolicy::NoEviction:
+            return "noeviction";
+        case EvictionPolicy::Lru:
+            return "lru";
+        case EvictionPolicy::Lfu:
+            return "lfu";
+        case EvictionPolicy::TtlFirst:
+            return "ttl";
+    }
+    return "";
+}
+
+LeafEviction::LeafEviction(std::shared_ptr<Node> root, EvictionOptions options,
+                           EvictedCallback on_evicted)
+    : root_(std::move(root)), options_(options), on_evicted_(on_evicted), random_(1) {
+    options_.samples = std::max<size_t>(options_.samples, 1);
+}
+
+void LeafEviction::touch(Leaf &leaf, uint64_t now_ms) {
+    if (options_.policy == EvictionPolicy::NoEviction || options_.max_bytes == 0) {
+        return;
+    }
+    uint32_t word = leaf.access.load(std::memory_order_relaxed);
+    uint32_t updated;
+    if (options_.policy == EvictionPolicy::Lfu) {
+        // Логарифмический рост: вероятность увеличения 1 / ((counter - initial) * factor + 1)
+        uint32_t period = lfu_period(now_ms, options_.lfu_decay_ms);
+        uint32_t counter = word == 0 ? kLfuInitialCounter : lfu_counter(word, period);
+        if (word != 0 && counter < kLfuCounterMax) {
+            thread_local std::minstd_rand random(std::random_device{}());
+            uint32_t base = counter > kLfuInitialCounter ? counter - kLfuInitialCounter : 0;
+            if (random() <= std::minstd_rand::max() / (base * options_.lfu_log_factor + 1)) {
+                ++counter;
+            }
+        }
+        updated = period << kLfuCounterBits | counter;
+    } else {
+        updated = lru_clock(now_ms);
+    }
+    // Горячий лист читают многие потоки: строка кэша не пишется, если слово не изменилось
+    if (updated != word) {
+        leaf.access.store(updated, std::memory_order_relaxed);
+    }
+}
+
+bool LeafEviction::make_room(uint64_t now_ms) {
+    if (options_.max_bytes == 0 || used_bytes() <= options_.max_bytes) {
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (used_bytes() > options_.max_bytes) {
+        bool evicted = false;
+        if (options_.policy != EvictionPolicy::NoEviction) {
+            for (int attempt = 0; !evicted && attempt < kEvictAttempts; ++attempt) {
+                sample(now_ms);
+                evicted = evict_best();
+            }
+        }
+        if (!evicted) {
+            rejected_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t LeafEviction::used_bytes() const {
+    return root_->index ? root_->index->bytes.load(std::memory_order_relaxed) : 0;
+}
+
+EvictionStats LeafEviction::stats() const {
+    EvictionStats stats;
+    stats.used_bytes = used_bytes();
+    stats.max_bytes = options_.max_bytes;
+    stats.evicted = evicted_.load(std::memory_order_relaxed);
+    stats.evicted_bytes = evicted_bytes_.load(std::memory_order_relaxed);
+    stats.rejected = rejected_.load(std::memory_order_relaxed);
+    stats.hits = hits_.load(std::memory_order_relaxed);
+    stats.misses = misses_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+uint64_t LeafEviction::score_of(const Leaf &leaf, uint64_t now_ms) const {
+    uint32_t word = leaf.access.load(std::memory_order_relaxed);
+    if (options_.policy == EvictionPolicy::Lfu) {
+        return kLfuCounterMax - lfu_counter(word, lfu_period(now_ms, options_.lfu_decay_ms));
+    }
+    if (options_.policy == EvictionPolicy::TtlFirst) {
+        // Чем раньше срок, тем больше оценка
+        uint64_t expires_at = leaf.expires_at.load(std::memory_order_relaxed);
+        if (expires_at != 0) {
+            return kTtlBand + (kTtlBand - 1 - std::min(expires_at, kTtlBand - 1));
+        }
+    }
+    // Время без обращений в шагах часов; лист без обращений - самый старый
+    uint64_t never = uint64_t{std::numeric_limits<uint32_t>::max()} + 1;
+    return word == 0 ? never : static_cast<uint32_t>(lru_clock(now_ms) - word);
+}
+
+void LeafEviction::sample(uint64_t now_ms) {
+    if (!root_->index) {
+        return;
+    }
+    const PathIndex &index = *root_->index;
+    std::shared_lock<TreeRwLock> lock(index.lock);
+    if (index.entries.empty()) {
+        return;
+    }
+    // Случайные корзины индекса: выбор не зависит от размера дерева
+    size_t buckets = index.entries.bucket_count();
+    size_t seen = 0;
+    for (size_t probe = 0; seen < options_.samples && probe < options_.samples * kProbesPerSample;
+         ++probe) {
+        size_t bucket = random_() % buckets;
+        for (auto it = index.entries.begin(bucket); it != index.entries.end(bucket); ++it) {
+            const auto *entry = std::get_if<std::weak_ptr<Leaf>>(&it->second);
+            if (auto leaf = entry ? entry->lock() : nullptr) {
+                offer(*leaf, score_of(*leaf, now_ms));
+                ++seen;
+            }
+        }
+    }
+}
+
+void LeafEviction::offer(const Leaf &leaf, uint64_t score) {
+    std::string_view path = leaf.path;
+    auto same = std::find_if(pool_.begin(), pool_.end(),
+                             [&](const Candidate &candidate) { return candidate.path == path; });
+    if (same != pool_.end()) {
+        same->score = score;
+    } else if (pool_.size() < kPoolSize) {
+        pool_.push_back({std::string(path), score});
+    } else if (score > pool_.front().score) {
+        pool_.front() = {std::string(path), score};
+    } else {
+        return;
+    }
+    std::sort(pool_.begin(), pool_.end(), [](const Candidate &a, const Candidate &b) {
+        return a.score < b.score;
+    });
+}
+
+bool LeafEviction::evict_best() {
+    while (!pool_.empty()) {
+        Candidate best = std::move(pool_.back());
+        pool_.pop_back();
+        PathLock lock = PathLock::parent_of(root_, best.path, LockMode::Exclusive);
+        auto leaf = lock.node() ? find_child_leaf(lock.node(), name_of(best.path)) : nullptr;
+        if (!leaf) {
+            continue;  // Удален, пока был в пуле
+        }
+        size_t bytes = footprint_of(*leaf);
+        if (!delete_leaf(root_, leaf)) {
+            continue;
+        }
+        evicted_.fetch_add(1, std::memory_order_relaxed);
+        evicted_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+        if (on_evicted_) {
+            on_evicted_(best.path);
+        }
+        return true;
+    }
+    return false;
+}
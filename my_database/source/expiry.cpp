@@ -0,0 +1,216 @@
+#include "expiry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include "pathLock.hpp"
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+constexpr uint64_t kSlotMask = TimingWheel::kSlots - 1;
+
+// Число тиков, которое покрывают уровни 0..level.
+constexpr uint64_t span_of(unsigned level) {
+    return uint64_t{1} << (TimingWheel::kSlotBits * (level + 1));
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+uint64_t unix_time_ms() {
+    using namespace std::chrono;
+    return static_cast<uint64_t>(
+        duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+}
+
+TimingWheel::TimingWheel(uint64_t now_ms, uint64_t tick_ms)
+    : tick_ms_(std::max<uint64_t>(tick_ms, 1)), current_(now_ms / tick_ms_) {}
+
+void TimingWheel::schedule(ExpiryTimer timer) {
+    ++size_;
+    place(std::move(timer));
+}
+
+void TimingWheel::place(ExpiryTimer timer) {
+    // Тик округляется вверх: таймер не срабатывает раньше срока листа
+    uint64_t tick = timer.expires_at / tick_ms_ + (timer.expires_at % tick_ms_ != 0);
+    if (tick <= current_) {
+        overdue_.push_back(std::move(timer));
+        return;
+    }
+    uint64_t delta = tick - current_;
+    unsigned level = 0;
+    while (level + 1 < kLevels && delta >= span_of(level)) {
+        ++level;
+    }
+    if (delta >= span_of(level)) {
+        tick = current_ + span_of(level) - 1;  // Дальше последнего уровня: ждет и перекладывается
+    }
+    slots_[level][(tick >> (kSlotBits * level)) & kSlotMask].push_back(std::move(timer));
+    ++counts_[level];
+}
+
+void TimingWheel::cascade(unsigned level) {
+    auto &slot = slots_[level][(current_ >> (kSlotBits * level)) & kSlotMask];
+    std::vector<ExpiryTimer> timers;
+    timers.swap(slot);
+    counts_[level] -= timers.size();
+    for (auto &timer : timers) {
+        place(std::move(timer));
+    }
+}
+
+void TimingWheel::advance(uint64_t now_ms, std::vector<ExpiryTimer> &due) {
+    uint64_t target = now_ms / tick_ms_;
+    while (current_ < target) {
+        // Уровни ниже empty пусты: до оборота уровня empty ни один таймер не сработает
+        unsigned empty = 0;
+        while (empty < kLevels && counts_[empty] == 0) {
+            ++empty;
+        }
+        if (empty > 0) {
+            uint64_t skip_to = target;
+            if (empty < kLevels) {
+                unsigned bits = kSlotBits * empty;
+                skip_to = std::min(target, (((current_ >> bits) + 1) << bits) - 1);
+            }
+            if (skip_to > current_) {
+                current_ = skip_to;
+                continue;
+            }
+        }
+        ++current_;
+        // Оборот младшего уровня: слот следующего уровня раскладывается по младшим
+        for (unsigned level = 1; level < kLevels && (current_ & kSlotMask) == 0; ++level) {
+            cascade(level);
+            if (((current_ >> (kSlotBits * level)) & kSlotMask) != 0) {
+                break;
+            }
+        }
+        auto &slot = slots_[0][current_ & kSlotMask];
+        size_ -= slot.size();
+        counts_[0] -= slot.size();
+        std::move(slot.begin(), slot.end(), std::back_inserter(due));
+        slot.clear();
+    }
+    size_ -= overdue_.size();
+    std::move(overdue_.begin(), overdue_.end(), std::back_inserter(due));
+    overdue_.clear();
+}
+
+LeafExpiry::LeafExpiry(std::shared_ptr<Node> root, ExpiryOptions options,
+                       ExpiredCallback on_expired, uint64_t now_ms)
+    : root_(std::move(root)),
+      options_(options),
+      on_expired_(on_expired),
+      wheel_(now_ms, options.tick_ms) {}
+
+LeafExpiry::~LeafExpiry() {
+    if (background_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(stop_mutex_);
+            stop_ = true;
+        }
+        stop_signal_.notify_one();
+        background_.join();
+    }
+}
+
+void LeafExpiry::start() { background_ = std::thread(&LeafExpiry::background_loop, this); }
+
+void LeafExpiry::schedule(std::string_view path, uint64_t expires_at) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    wheel_.schedule({std::string(path), expires_at});
+    ++stats_.scheduled;
+}
+
+void LeafExpiry::schedule_tree() {
+    PathLock lock(root_, "/", LockMode::Shared);
+    std::vector<const Node *> pending = {root_.get()};
+    while (!pending.empty()) {
+        const Node *node = pending.back();
+        pending.pop_back();
+        for (const Leaf *leaf = node->east.get(); leaf; leaf = leaf->east.get()) {
+            if (leaf->expires_at != 0) {
+                schedule(leaf->path, leaf->expires_at);
+            }
+        }
+        for (const auto &child : node->childs) {
+            pending.push_back(child.get());
+        }
+    }
+}
+
+size_t LeafExpiry::sweep(uint64_t now_ms) {
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<ExpiryTimer> batch;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wheel_.advance(now_ms, due_);
+        std::move(due_.begin(), due_.end(), std::back_inserter(backlog_));
+        due_.clear();
+        size_t count = std::min(backlog_.size(), options_.max_per_tick);
+        batch.assign(std::make_move_iterator(backlog_.begin()),
+                     std::make_move_iterator(backlog_.begin() + static_cast<ptrdiff_t>(count)));
+        backlog_.erase(backlog_.begin(), backlog_.begin() + static_cast<ptrdiff_t>(count));
+    }
+    if (batch.empty()) {
+        return 0;
+    }
+
+    size_t expired = 0;
+    for (const auto &timer : batch) {
+        PathLock lock = PathLock::parent_of(root_, timer.path, LockMode::Exclusive);
+        if (!lock.node()) {
+            continue;
+        }
+        auto it = lock.node()->leaf_by_name.find(name_of(timer.path));
+        const Leaf *leaf = it == lock.node()->leaf_by_name.end() ? nullptr : it->second;
+        // Лист удален, перезаписан или продлен после постановки таймера
+        if (!leaf || leaf->expires_at != timer.expires_at || !leaf_expired(*leaf, now_ms)) {
+            continue;
+        }
+        if (delete_leaf_by_path_linear(root_, timer.path)) {
+            ++expired;
+            if (on_expired_) {
+                on_expired_(timer.path);
+            }
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - begin)
+                       .count();
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.expired += expired;
+    stats_.skipped += batch.size() - expired;
+    ++stats_.sweeps;
+    stats_.sweep_us_total += static_cast<uint64_t>(elapsed);
+    stats_.sweep_us_max = std::max(stats_.sweep_us_max, static_cast<uint64_t>(elapsed));
+    return expired;
+}
+
+ExpiryStats LeafExpiry::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ExpiryStats stats = stats_;
+    stats.hidden_on_read = hidden_on_read_.load(std::memory_order_relaxed);
+    stats.pending = wheel_.size() + backlog_.size();
+    return stats;
+}
+
+void LeafExpiry::background_loop() {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    while (!stop_) {
+        stop_signal_.wait_for(lock, std::chrono::milliseconds(options_.tick_ms));
+        if (stop_) {
+            break;
+        }
+        lock.unlock();
+        sweep(unix_time_ms());
+        lock.lock();
+    }
+}
@@ -0,0 +1,217 @@
+#include "logger.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+std::atomic<LogLevel> g_log_level{LogLevel::Info};
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+struct Logger {
+    std::atomic<bool> running{false};
+    std::mutex mutex;  // rings, stop, out
+    std::condition_variable wake;
+    std::atomic<bool> wake_pending{false};  // Пробуждение, пришедшее во время сброса, не теряется
+    std::vector<std::shared_ptr<LogRing>> rings;
+    bool stop = false;
+    std::FILE *out = stderr;
+    std::thread drainer;
+};
+
+Logger &logger() {
+    static Logger instance;
+    return instance;
+}
+
+// Помечает буфер потока завершенным, когда поток выходит; буфер освобождает фоновый поток.
+struct ThreadRing {
+    std::shared_ptr<LogRing> ring;
+    ~ThreadRing() {
+        if (ring) {
+            ring->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRing t_ring;
+
+std::string_view level_name(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug:
+            return "DEBUG";
+        case LogLevel::Info:
+            return "INFO";
+        case LogLevel::Warning:
+            return "WARN";
+        case LogLevel::Error:
+            return "ERROR";
+        case LogLevel::Off:
+            break;
+    }
+    return "?";
+}
+
+// Дата и время с точностью до секунды: localtime_r дорогой, а записи одной секунды идут подряд.
+struct s_time_prefix {
+    time_t seconds = -1;
+    char text[24] = {};  // "2026-01-31 12:00:00"
+    size_t length = 0;
+};
+
+using TimePrefix = struct s_time_prefix;
+
+// "2026-01-31 12:00:00.123456 [INFO] text\n"
+void format_record(std::string &out, const LogRecord &record, TimePrefix &prefix) {
+    time_t seconds = static_cast<time_t>(record.time_ns / 1000000000);
+    if (seconds != prefix.seconds) {
+        tm local{};
+        localtime_r(&seconds, &local);
+        prefix.seconds = seconds;
+        prefix.length =
+            std::strftime(prefix.text, sizeof(prefix.text), "%Y-%m-%d %H:%M:%S", &local);
+    }
+    char micros[16];
+    std::snprintf(micros, sizeof(micros), ".%06d",
+                  static_cast<int>(record.time_ns % 1000000000 / 1000));
+
+    out.append(prefix.text, prefix.length).append(micros).append(" [");
+    out.append(level_name(record.level)).append("] ");
+    out.append(record.text, record.length).push_back('\n');
+}
+
+// Забирает записи всех буферов и пишет их одним вызовом. Вызывается под logger().mutex.
+void drain_rings(Logger &state, std::string &buffer, TimePrefix &prefix) {
+    buffer.clear();
+    for (auto it = state.rings.begin(); it != state.rings.end();) {
+        LogRing &ring = **it;
+        bool retired = ring.retired.load(std::memory_order_acquire);
+        ring.drain([&](const LogRecord &record) { format_record(buffer, record, prefix); });
+        if (uint64_t dropped = ring.take_dropped()) {
+            buffer.append("[WARN] logger: ").append(std::to_string(dropped));
+            buffer.append(" messages dropped, ring buffer full\n");
+        }
+        // Записи завершенного потока уже забраны: новых не будет
+        it = retired ? state.rings.erase(it) : it + 1;
+    }
+    if (!buffer.empty()) {
+        std::fwrite(buffer.data(), 1, buffer.size(), state.out);
+        std::fflush(state.out);
+    }
+}
+
+void drain_loop() {
+    Logger &state = logger();
+    std::string buffer;
+    TimePrefix prefix;
+    std::unique_lock<std::mutex> lock(state.mutex);
+    while (!state.stop) {
+        state.wake.wait_for(lock, kLogDrainInterval,
+                            [&] { return state.stop || state.wake_pending.exchange(false); });
+        drain_rings(state, buffer, prefix);
+    }
+    drain_rings(state, buffer, prefix);
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+LogRing *this_thread_log_ring() {
+    Logger &state = logger();
+    if (!state.running.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    if (!t_ring.ring) {
+        // Первая запись потока: регистрация буфера, вне горячего пути
+        t_ring.ring = std::make_shared<LogRing>();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.rings.push_back(t_ring.ring);
+    }
+    return t_ring.ring.get();
+}
+
+void write_log_record(const LogRecord &record) {
+    std::string line;
+    TimePrefix prefix;
+    format_record(line, record, prefix);
+    std::fwrite(line.data(), 1, line.size(), stderr);
+}
+
+void wake_log_drainer() {
+    Logger &state = logger();
+    state.wake_pending.store(true, std::memory_order_release);
+    state.wake.notify_one();
+}
+
+bool log_init(LogLevel level, std::string_view path) {
+    Logger &state = logger();
+    if (state.running.load()) {
+        log_shutdown();
+    }
+
+    std::FILE *out = stderr;
+    if (!path.empty()) {
+        out = std::fopen(std::string(path).c_str(), "a");
+        if (!out) {
+            LOG_ERROR("Failed to open log file '", path, "'");
+            return false;
+        }
+    }
+
+    log_set_level(level);
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.out = out;
+        state.stop = false;
+    }
+    state.drainer = std::thread(drain_loop);
+    state.running.store(true, std::memory_order_release);
+    return true;
+}
+
+void log_shutdown() {
+    Logger &state = logger();
+    if (!state.running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.stop = true;
+    }
+    state.wake.notify_one();
+    state.drainer.join();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (state.out != stderr) {
+        std::fclose(state.out);
+        state.out = stderr;
+    }
+}
+
+void log_set_level(LogLevel level) { g_log_level.store(level, std::memory_order_relaxed); }
+
+bool parse_log_level(std::string_view name, LogLevel &level) {
+    constexpr std::array<std::pair<std::string_view, LogLevel>, 5> kNames = {{
+        {"debug", LogLevel::Debug},
+        {"info", LogLevel::Info},
+        {"warning", LogLevel::Warning},
+        {"error", LogLevel::Error},
+        {"off", LogLevel::Off},
+    }};
+    for (const auto &[known, value] : kNames) {
+        if (known == name) {
+            level = value;
+            return true;
+        }
+    }
+    return false;
+}
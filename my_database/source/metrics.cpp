@@ -0,0 +1,232 @@
+#include "metrics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+// Все блоки счетчиков, выданные потокам; блоки завершившихся потоков ждут в free.
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadMetrics>> blocks;
+    std::vector<ThreadMetrics *> free;
+};
+
+// Не разрушается при выходе: отсоединенные потоки могут писать метрики до самого конца.
+Registry &registry() {
+    static auto *instance = new Registry;
+    return *instance;
+}
+
+// Возвращает блок в общий список при завершении потока.
+struct BlockOwner {
+    ThreadMetrics *block = nullptr;
+
+    ~BlockOwner() {
+        if (block) {
+            Registry &shared = registry();
+            std::lock_guard<std::mutex> lock(shared.mutex);
+            shared.free.push_back(block);
+        }
+    }
+};
+
+thread_local ThreadMetrics *t_block = nullptr;
+
+std::atomic<uint64_t> g_connected_clients{0};
+std::atomic<uint64_t> g_total_connections{0};
+
+// Границы le гистограмм Prometheus: 1-2.5-5 на декаду от 1 мкс до 10 с, в наносекундах.
+constexpr std::array<uint64_t, 22> kPrometheusBoundsNs = {
+    1'000,         2'500,         5'000,         10'000,        25'000,        50'000,
+    100'000,       250'000,       500'000,       1'000'000,     2'500'000,     5'000'000,
+    10'000'000,    25'000'000,    50'000'000,    100'000'000,   250'000'000,   500'000'000,
+    1'000'000'000, 2'500'000'000, 5'000'000'000, 10'000'000'000};
+
+void append_format(std::string &out, const char *format, double value) {
+    char buffer[64];
+    std::snprintf(buffer, sizeof(buffer), format, value);
+    out += buffer;
+}
+
+void append_family(std::string &out, std::string_view name, std::string_view type,
+                   std::string_view help) {
+    out.append("# HELP ").append(name).append(" ").append(help).push_back('\n');
+    out.append("# TYPE ").append(name).append(" ").append(type).push_back('\n');
+}
+
+// Строки одной гистограммы; labels - "verb=\"GET_LEAF\"" без фигурных скобок.
+void append_histogram(std::string &out, std::string_view name, const std::string &labels,
+                      const HistogramSnapshot &histogram) {
+    for (uint64_t bound : kPrometheusBoundsNs) {
+        out.append(name).append("_bucket{").append(labels).append(",le=\"");
+        append_format(out, "%g", bound / 1e9);
+        out.append("\"} ").append(std::to_string(histogram.count_at_most(bound)));
+        out.push_back('\n');
+    }
+    out.append(name).append("_bucket{").append(labels).append(",le=\"+Inf\"} ");
+    out.append(std::to_string(histogram.count)).push_back('\n');
+    out.append(name).append("_sum{").append(labels).append("} ");
+    append_format(out, "%.9f", histogram.sum / 1e9);
+    out.push_back('\n');
+    out.append(name).append("_count{").append(labels).append("} ");
+    out.append(std::to_string(histogram.count)).push_back('\n');
+}
+
+std::string mode_label(size_t mode) {
+    return mode == 0 ? "mode=\"shared\"" : "mode=\"exclusive\"";
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+uint64_t monotonic_ns() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+void s_histogram_snapshot::merge(const LatencyHistogram &histogram) {
+    for (size_t bucket = 0; bucket < LatencyHistogram::kBuckets; ++bucket) {
+        buckets[bucket] += histogram.buckets_[bucket].load();
+    }
+    count += histogram.count_.load();
+    sum += histogram.sum_.load();
+    max = std::max(max, histogram.max_.load());
+}
+
+uint64_t s_histogram_snapshot::percentile(double q) const {
+    if (count == 0) {
+        return 0;
+    }
+    auto target = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+    target = std::max<uint64_t>(target, 1);
+    uint64_t seen = 0;
+    for (size_t bucket = 0; bucket < LatencyHistogram::kBuckets; ++bucket) {
+        seen += buckets[bucket];
+        if (seen >= target) {
+            return std::min(LatencyHistogram::highest_of(bucket), max);
+        }
+    }
+    // Корзины и count читались не одновременно
+    return max;
+}
+
+uint64_t s_histogram_snapshot::count_at_most(uint64_t value) const {
+    uint64_t total = 0;
+    for (size_t bucket = 0;
+         bucket < LatencyHistogram::kBuckets && LatencyHistogram::highest_of(bucket) <= value;
+         ++bucket) {
+        total += buckets[bucket];
+    }
+    return total;
+}
+
+ThreadMetrics &thread_metrics() {
+    if (t_block) {
+        return *t_block;
+    }
+    thread_local BlockOwner owner;
+    Registry &shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    if (!shared.free.empty()) {
+        owner.block = shared.free.back();
+        shared.free.pop_back();
+    } else {
+        shared.blocks.push_back(std::make_unique<ThreadMetrics>());
+        owner.block = shared.blocks.back().get();
+    }
+    t_block = owner.block;
+    return *t_block;
+}
+
+void count_connection_opened() {
+    g_connected_clients.fetch_add(1, std::memory_order_relaxed);
+    g_total_connections.fetch_add(1, std::memory_order_relaxed);
+}
+
+void count_connection_closed() { g_connected_clients.fetch_sub(1, std::memory_order_relaxed); }
+
+MetricsSnapshot collect_metrics() {
+    MetricsSnapshot metrics;
+    {
+        Registry &shared = registry();
+        std::lock_guard<std::mutex> lock(shared.mutex);
+        for (const auto &block : shared.blocks) {
+            for (size_t i = 0; i < kMetricCommands; ++i) {
+                metrics.commands[i].merge(block->commands[i]);
+            }
+            for (size_t mode = 0; mode < kMetricLockModes; ++mode) {
+                metrics.lock_acquired[mode] += block->lock_acquired[mode].load();
+                metrics.lock_wait[mode].merge(block->lock_wait[mode]);
+                metrics.lock_hold[mode].merge(block->lock_hold[mode]);
+            }
+            metrics.bytes_in += block->bytes_in.load();
+            metrics.bytes_out += block->bytes_out.load();
+        }
+    }
+    metrics.connected_clients = g_connected_clients.load(std::memory_order_relaxed);
+    metrics.total_connections = g_total_connections.load(std::memory_order_relaxed);
+    return metrics;
+}
+
+std::string_view metric_verb_of(size_t index) {
+    return index == 0 ? std::string_view("unknown") : verb_of(static_cast<Opcode>(index));
+}
+
+void append_prometheus(std::string &out, const MetricsSnapshot &metrics) {
+    append_family(out, "database_command_duration_seconds", "histogram",
+                  "Time to execute a command, by verb.");
+    for (size_t i = 0; i < kMetricCommands; ++i) {
+        if (metrics.commands[i].count != 0) {
+            std::string labels = "verb=\"" + std::string(metric_verb_of(i)) + "\"";
+            append_histogram(out, "database_command_duration_seconds", labels,
+                             metrics.commands[i]);
+        }
+    }
+
+    append_family(out, "database_lock_acquisitions_total", "counter",
+                  "Directory locks taken, by mode.");
+    for (size_t mode = 0; mode < kMetricLockModes; ++mode) {
+        out.append("database_lock_acquisitions_total{").append(mode_label(mode)).append("} ");
+        out.append(std::to_string(metrics.lock_acquired[mode])).push_back('\n');
+    }
+    append_family(out, "database_lock_wait_seconds", "histogram",
+                  "Time spent waiting for a contended directory lock.");
+    for (size_t mode = 0; mode < kMetricLockModes; ++mode) {
+        append_histogram(out, "database_lock_wait_seconds", mode_label(mode),
+                         metrics.lock_wait[mode]);
+    }
+    append_family(out, "database_lock_hold_seconds", "histogram",
+                  "Time a directory lock was held.");
+    for (size_t mode = 0; mode < kMetricLockModes; ++mode) {
+        append_histogram(out, "database_lock_hold_seconds", mode_label(mode),
+                         metrics.lock_hold[mode]);
+    }
+
+    append_family(out, "database_network_bytes_total", "counter",
+                  "Bytes read from and written to client sockets.");
+    out.append("database_network_bytes_total{direction=\"in\"} ");
+    out.append(std::to_string(metrics.bytes_in)).push_back('\n');
+    out.append("database_network_bytes_total{direction=\"out\"} ");
+    out.append(std::to_string(metrics.bytes_out)).push_back('\n');
+
+    append_family(out, "database_connections_total", "counter", "Client connections accepted.");
+    out.append("database_connections_total ");
+    out.append(std::to_string(metrics.total_connections)).push_back('\n');
+    append_prometheus_gauge(out, "database_connected_clients", "Client connections open now.",
+                            metrics.connected_clients);
+}
+
+void append_prometheus_gauge(std::string &out, std::string_view name, std::string_view help,
+                             uint64_t value) {
+    append_family(out, name, "gauge", help);
+    out.append(name).append(" ").append(std::to_string(value)).push_back('\n');
+}
@@ -0,0 +1,403 @@
+#include "mutationLog.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "binaryFile.hpp"
+#include "logger.hpp"
+#include "pathLock.hpp"
+#include "snapshot.hpp"
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+// Предельная длина пути или значения в записи: защищает от мусора в поврежденном файле.
+constexpr uint64_t kMaxFieldLength = 1ULL << 30;
+
+// Порция образа при переписывании: образ пишется по частям, а не собирается в памяти целиком.
+constexpr size_t kDumpChunk = 1 << 20;
+
+struct s_log_entry {
+    TreeChangeKind kind;
+    std::string_view path;
+    std::string_view value;
+};
+
+using LogEntry = struct s_log_entry;
+
+// Разбирает запись в начале data. Возвращает ее длину или 0, если запись неполна или повреждена.
+size_t decode_record(std::string_view data, LogEntry &entry) {
+    size_t position = 1;
+    uint64_t path_length = 0;
+    uint64_t value_length = 0;
+    if (data.empty() || static_cast<unsigned char>(data[0]) >
+                            static_cast<unsigned char>(TreeChangeKind::ExpireLeaf) ||
+        !read_varint(data, position, path_length) || !read_varint(data, position, value_length) ||
+        path_length > kMaxFieldLength || value_length > kMaxFieldLength ||
+        data.size() - position < path_length + value_length + 4) {
+        return 0;
+    }
+    size_t body = position + path_length + value_length;
+    if (read_u32(data.data() + body) != crc32(data.substr(0, body))) {
+        return 0;
+    }
+    entry.kind = static_cast<TreeChangeKind>(data[0]);
+    entry.path = data.substr(position, path_length);
+    entry.value = data.substr(position + path_length, value_length);
+    return body + 4;
+}
+
+bool apply_entry(const std::shared_ptr<Node> &root, const LogEntry &entry) {
+    switch (entry.kind) {
+        case TreeChangeKind::CreateNode:
+            return create_node_by_path(root, entry.path) != nullptr;
+        case TreeChangeKind::CreateLeaf:
+            return create_leaf_by_path(root, entry.path, entry.value) != nullptr;
+        case TreeChangeKind::SetLeaf:
+            return set_leaf_by_path(root, entry.path, entry.value) != nullptr;
+        case TreeChangeKind::DeleteNode:
+            return delete_node_by_path_linear(root, entry.path);
+        case TreeChangeKind::DeleteLeaf:
+            return delete_leaf_by_path_linear(root, entry.path);
+        case TreeChangeKind::ExpireLeaf: {
+            auto leaf = find_leaf_by_path_linear(root, entry.path);
+            size_t position = 0;
+            uint64_t expires_at;
+            if (!leaf || !read_varint(entry.value, position, expires_at)) {
+                return false;
+            }
+            leaf->expires_at = expires_at;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Пишет в fd образ дерева (с заголовком журнала): каталог записывается раньше своего содержимого.
+// Обход без рекурсии, чтобы глубокие деревья не переполняли стек.
+bool dump_tree(int fd, const std::shared_ptr<Node> &root) {
+    std::string out(kMutationLogMagic);
+    auto flush_full = [&] {
+        if (out.size() < kDumpChunk) {
+            return true;
+        }
+        bool ok = write_all(fd, out);
+        out.clear();
+        return ok;
+    };
+    std::vector<const Node *> pending = {root.get()};
+    while (!pending.empty()) {
+        const Node *node = pending.back();
+        pending.pop_back();
+        for (const Leaf *leaf = node->east.get(); leaf; leaf = leaf->east.get()) {
+            encode_log_record(out, TreeChangeKind::CreateLeaf, leaf->path, leaf->value);
+            if (leaf->expires_at != 0) {
+                encode_log_record(out, TreeChangeKind::ExpireLeaf, leaf->path,
+                                  encode_expiry(leaf->expires_at));
+            }
+            if (!flush_full()) {
+                return false;
+            }
+        }
+        for (const auto &child : node->childs) {
+            encode_log_record(out, TreeChangeKind::CreateNode, child->path, {});
+            pending.push_back(child.get());
+        }
+        if (!flush_full()) {
+            return false;
+        }
+    }
+    return write_all(fd, out);
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+bool parse_fsync_policy(std::string_view name, FsyncPolicy &policy) {
+    if (name == "always") {
+        policy = FsyncPolicy::Always;
+    } else if (name == "everysec") {
+        policy = FsyncPolicy::EverySecond;
+    } else if (name == "never") {
+        policy = FsyncPolicy::Never;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string encode_expiry(uint64_t expires_at) {
+    std::string value;
+    append_varint(value, expires_at);
+    return value;
+}
+
+void encode_log_record(std::string &out, TreeChangeKind kind, std::string_view path,
+                       std::string_view value) {
+    size_t begin = out.size();
+    out.push_back(static_cast<char>(kind));
+    append_varint(out, path.size());
+    append_varint(out, value.size());
+    out.append(path);
+    out.append(value);
+    append_u32(out, crc32(std::string_view(out).substr(begin)));
+}
+
+MutationLog::MutationLog(MutationLogOptions options) : options_(std::move(options)) {}
+
+MutationLog::~MutationLog() {
+    if (background_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(stop_mutex_);
+            stop_ = true;
+        }
+        stop_signal_.notify_one();
+        background_.join();
+    }
+    if (fd_ >= 0) {
+        uint64_t last;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            last = appended_;
+        }
+        sync(last);
+        if (options_.fsync != FsyncPolicy::Never) {
+            fdatasync(fd_);
+        }
+        close(fd_);
+    }
+}
+
+bool MutationLog::open(const std::shared_ptr<Node> &root, size_t *replayed) {
+    root_ = root;
+    fd_ = ::open(options_.path.c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    std::string data;
+    if (fd_ < 0 || !read_all(fd_, data)) {
+        LOG_ERROR("Failed to open mutation log '", options_.path, "': ", strerror(errno));
+        return false;
+    }
+
+    size_t count = 0;
+    if (data.empty()) {
+        if (!write_and_sync(fd_, std::string(kMutationLogMagic), true)) {
+            return false;
+        }
+        file_size_ = kMutationLogMagic.size();
+    } else {
+        if (!std::string_view(data).starts_with(kMutationLogMagic)) {
+            LOG_ERROR("'", options_.path, "' is not a mutation log");
+            return false;
+        }
+        size_t offset = kMutationLogMagic.size();
+        LogEntry entry;
+        while (size_t length = decode_record(std::string_view(data).substr(offset), entry)) {
+            if (!apply_entry(root, entry)) {
+                LOG_WARNING("Mutation log record for '", entry.path, "' could not be applied");
+            }
+            ++count;
+            offset += length;
+        }
+        // Хвост после последней целой записи - оборванная сбоем запись
+        if (offset < data.size()) {
+            LOG_WARNING("Mutation log '", options_.path, "': dropping ", data.size() - offset,
+                        " bytes of a torn record");
+            if (ftruncate(fd_, static_cast<off_t>(offset)) != 0) {
+                LOG_ERROR("Failed to truncate mutation log: ", strerror(errno));
+                return false;
+            }
+        }
+        file_size_ = offset;
+    }
+    base_size_ = file_size_;
+    if (replayed) {
+        *replayed = count;
+    }
+
+    background_ = std::thread(&MutationLog::background_loop, this);
+    return true;
+}
+
+uint64_t MutationLog::append(TreeChangeKind kind, std::string_view path, std::string_view value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (failed_) {
+        return appended_ + 1;  // sync() для такого LSN вернет false
+    }
+    size_t before = buffer_.size();
+    encode_log_record(buffer_, kind, path, value);
+    if (rewriting_) {
+        rewrite_tail_.append(buffer_, before);
+    }
+    appended_ += buffer_.size() - before;
+    return appended_;
+}
+
+bool MutationLog::sync(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (written_ < lsn && !failed_) {
+        if (flushing_) {
+            flushed_.wait(lock);
+            continue;
+        }
+        // Лидер группы: пишет все, что накопили остальные, пока он ждал своей очереди
+        std::string batch;
+        batch.swap(buffer_);
+        uint64_t end = appended_;
+        int fd = fd_;
+        flushing_ = true;
+        lock.unlock();
+        bool ok = write_and_sync(fd, batch, options_.fsync == FsyncPolicy::Always);
+        lock.lock();
+        flushing_ = false;
+        if (ok) {
+            written_ = std::max(written_, end);
+            file_size_ += batch.size();
+            dirty_ = dirty_ || options_.fsync == FsyncPolicy::EverySecond;
+        } else {
+            failed_ = true;
+            LOG_ERROR("Mutation log write failed: ", strerror(errno));
+        }
+        flushed_.notify_all();
+    }
+    return written_ >= lsn;
+}
+
+bool MutationLog::rewrite() {
+    std::lock_guard<std::mutex> guard(rewrite_mutex_);
+    return rewrite_locked();
+}
+
+uint64_t MutationLog::file_size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_size_;
+}
+
+bool MutationLog::write_and_sync(int fd, const std::string &data, bool sync_data) {
+    if (!write_all(fd, data)) {
+        return false;
+    }
+    if (sync_data) {
+        if (fdatasync(fd) != 0) {
+            return false;
+        }
+        fsyncs_.fetch_add(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+bool MutationLog::rewrite_locked() {
+    std::string temp_path = options_.path + ".rewrite";
+    int temp_fd = ::open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC,
+                         0644);
+    bool ok = temp_fd >= 0;
+
+    // 1. Образ дерева, как в fork_snapshot(): fork() под S на корне, которая ждет всех
+    //    писателей, поэтому изменения, попавшие в образ, и изменения, попавшие в
+    //    rewrite_tail_, не пересекаются. Писатели ждут только сам fork().
+    pid_t pid = -1;
+    if (ok) {
+        PathLock lock(root_, "/", LockMode::Shared);
+        {
+            std::lock_guard<std::mutex> guard(mutex_);
+            rewriting_ = true;
+            rewrite_tail_.clear();
+        }
+        pid = fork();
+        if (pid == 0) {
+            // Как в fork_snapshot(): только этот поток, без блокировок, деструкторов и журнала
+            close_range(3, temp_fd - 1, 0);
+            close_range(temp_fd + 1, ~0U, 0);
+            _exit(dump_tree(temp_fd, root_) && fdatasync(temp_fd) == 0 ? 0 : 1);
+        }
+    }
+
+    // 2. Дочерний процесс пишет образ во временный файл, а писатели продолжают работать:
+    //    их изменения копятся в rewrite_tail_.
+    ok = pid > 0 && wait_snapshot(pid);
+    if (ok) {
+        fsyncs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // 3. Хвост изменений и подмена файла. Лидер группы мог писать в старый файл - ждем его.
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushed_.wait(lock, [&] { return !flushing_; });
+    struct stat file_stat {};
+    ok = ok && write_and_sync(temp_fd, rewrite_tail_, true) && fstat(temp_fd, &file_stat) == 0 &&
+         std::rename(temp_path.c_str(), options_.path.c_str()) == 0;
+    rewriting_ = false;
+    if (!ok) {
+        LOG_ERROR("Mutation log rewrite failed: ", strerror(errno));
+        if (temp_fd >= 0) {
+            close(temp_fd);
+        }
+        unlink(temp_path.c_str());
+        rewrite_tail_.clear();
+        return false;
+    }
+    sync_parent_directory(options_.path);
+
+    uint64_t old_size = file_size_;
+    close(fd_);
+    fd_ = temp_fd;
+    // Все добавленные записи уже в новом файле: до разреза - в образе, после - в хвосте
+    file_size_ = base_size_ = static_cast<uint64_t>(file_stat.st_size);
+    buffer_.clear();
+    written_ = appended_;
+    dirty_ = false;
+    rewrite_tail_.clear();
+    rewrite_tail_.shrink_to_fit();
+    flushed_.notify_all();
+    rewrites_.fetch_add(1, std::memory_order_relaxed);
+    LOG_INFO("Mutation log rewritten: ", old_size, " -> ", file_size_, " bytes");
+    return true;
+}
+
+void MutationLog::background_loop() {
+    std::unique_lock<std::mutex> stop_lock(stop_mutex_);
+    while (!stop_signal_.wait_for(stop_lock, std::chrono::seconds(1), [&] { return stop_; })) {
+        stop_lock.unlock();
+        {
+            std::lock_guard<std::mutex> guard(rewrite_mutex_);
+            uint64_t last;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                last = appended_;
+            }
+            sync(last);
+
+            bool sync_data;
+            int fd;
+            uint64_t size;
+            uint64_t base;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                sync_data = dirty_;
+                dirty_ = false;
+                fd = fd_;
+                size = file_size_;
+                base = base_size_;
+            }
+            if (sync_data) {
+                if (fdatasync(fd) == 0) {
+                    fsyncs_.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    LOG_ERROR("Mutation log fdatasync failed: ", strerror(errno));
+                }
+            }
+            if (size >= options_.rewrite_min_size &&
+                size * 100 >= base * (100 + options_.rewrite_growth_percent)) {
+                rewrite_locked();
+            }
+        }
+        stop_lock.lock();
+    }
+}
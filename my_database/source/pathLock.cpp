@@ -0,0 +1,88 @@
+#include "pathLock.hpp"
+
+#include "metrics.hpp"
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+PathLock::PathLock(const std::shared_ptr<Node> &root, std::string_view dir_path, LockMode mode) {
+    acquire(root, dir_path, mode);
+}
+
+PathLock::PathLock(PathLock &&other) noexcept
+    : held_(std::move(other.held_)),
+      node_(std::move(other.node_)),
+      wait_start_ns_(other.wait_start_ns_),
+      acquired_ns_(other.acquired_ns_) {
+    other.held_.clear();
+}
+
+PathLock::~PathLock() {
+    if (node_) {
+        thread_metrics().lock_hold[lock_metric_of(held_.back().second)].record(
+            monotonic_ns() - acquired_ns_);
+    }
+    // Снимаем в обратном порядке: снизу вверх.
+    for (auto it = held_.rbegin(); it != held_.rend(); ++it) {
+        it->first->lock.unlock(it->second);
+    }
+}
+
+PathLock PathLock::parent_of(const std::shared_ptr<Node> &root, std::string_view path,
+                             LockMode mode) {
+    PathLock lock;
+    if (path.empty() || path.front() != '/' || path == "/" || path.back() == '/') {
+        return lock;
+    }
+    lock.acquire(root, parent_path_of(path), mode);
+    return lock;
+}
+
+void PathLock::acquire(const std::shared_ptr<Node> &root, std::string_view dir_path,
+                       LockMode mode) {
+    if (!root || dir_path.empty() || dir_path.front() != '/') {
+        return;
+    }
+
+    LockMode intention =
+        (mode == LockMode::Shared) ? LockMode::IntentionShared : LockMode::IntentionExclusive;
+
+    std::shared_ptr<Node> current = root;
+    size_t begin = 1;
+    while (begin <= dir_path.size() && dir_path != "/") {
+        lock_one(current, intention);
+
+        size_t end = dir_path.find('/', begin);
+        if (end == std::string_view::npos) {
+            end = dir_path.size();
+        }
+        // Список детей читаем только под намеренной блокировкой текущего каталога.
+        auto child = find_child_node(current, dir_path.substr(begin, end - begin));
+        if (!child) {
+            return;
+        }
+        current = std::move(child);
+        begin = end + 1;
+    }
+
+    lock_one(current, mode);
+    node_ = std::move(current);
+
+    // Часы читаются один раз на захват, если ждать не пришлось
+    ThreadMetrics &metrics = thread_metrics();
+    size_t slot = lock_metric_of(mode);
+    acquired_ns_ = monotonic_ns();
+    metrics.lock_acquired[slot].add(1);
+    if (wait_start_ns_ != 0) {
+        metrics.lock_wait[slot].record(acquired_ns_ - wait_start_ns_);
+    }
+}
+
+void PathLock::lock_one(const std::shared_ptr<Node> &node, LockMode mode) {
+    if (!node->lock.try_lock(mode)) {
+        if (wait_start_ns_ == 0) {
+            wait_start_ns_ = monotonic_ns();
+        }
+        node->lock.lock(mode);
+    }
+    held_.emplace_back(node, mode);
+}
@@ -0,0 +1,173 @@
+#include "protocol.hpp"
+
+#include <charconv>
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+// Возвращает следующее слово строки и сдвигает position за него; пробелы перед словом пропускаются.
+static std::string_view next_token(std::string_view line, size_t &position) {
+    while (position < line.size() && is_space(line[position])) {
+        ++position;
+    }
+    size_t begin = position;
+    while (position < line.size() && !is_space(line[position])) {
+        ++position;
+    }
+    return line.substr(begin, position - begin);
+}
+
+static uint32_t read_u32(const char *data) {
+    const auto *bytes = reinterpret_cast<const unsigned char *>(data);
+    return static_cast<uint32_t>(bytes[0]) | (static_cast<uint32_t>(bytes[1]) << 8) |
+           (static_cast<uint32_t>(bytes[2]) << 16) | (static_cast<uint32_t>(bytes[3]) << 24);
+}
+
+static void append_u32(std::string &out, uint32_t value) {
+    auto bytes = encode_reply_length(value);
+    out.append(bytes.data(), bytes.size());
+}
+
+static ParseStatus parse_binary(std::string_view input, Request &request, size_t &consumed) {
+    if (input.size() < kBinaryHeaderSize) {
+        return ParseStatus::Incomplete;
+    }
+    size_t path_length = read_u32(input.data() + 2);
+    size_t value_length = read_u32(input.data() + 6);
+    if (path_length + value_length > kMaxCommandLength) {
+        return ParseStatus::Error;
+    }
+    size_t total = kBinaryHeaderSize + path_length + value_length;
+    if (input.size() < total) {
+        return ParseStatus::Incomplete;
+    }
+
+    request = Request{};
+    request.binary = true;
+    request.raw_opcode = static_cast<unsigned char>(input[1]);
+    request.opcode = verb_of(static_cast<Opcode>(request.raw_opcode)).empty()
+                         ? Opcode::Unknown
+                         : static_cast<Opcode>(request.raw_opcode);
+    request.path = input.substr(kBinaryHeaderSize, path_length);
+    request.value = input.substr(kBinaryHeaderSize + path_length, value_length);
+    consumed = total;
+    return ParseStatus::Complete;
+}
+
+static ParseStatus parse_text(std::string_view input, Request &request, size_t &consumed) {
+    size_t end = input.find('\n');
+    if (end == std::string_view::npos) {
+        return input.size() > kMaxCommandLength ? ParseStatus::Error : ParseStatus::Incomplete;
+    }
+
+    std::string_view line = input.substr(0, end);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+
+    // "VERB path value": value - остаток строки после одного пробела за path
+    request = Request{};
+    size_t position = 0;
+    request.verb = next_token(line, position);
+    request.path = next_token(line, position);
+    request.value = line.substr(position);
+    if (!request.value.empty() && request.value.front() == ' ') {
+        request.value.remove_prefix(1);
+    }
+    request.opcode = opcode_of(request.verb);
+    consumed = end + 1;
+    return ParseStatus::Complete;
+}
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+ParseStatus parse_request(std::string_view input, Request &request, size_t &consumed) {
+    if (input.empty()) {
+        return ParseStatus::Incomplete;
+    }
+    if (static_cast<unsigned char>(input.front()) == kBinaryMagic) {
+        return parse_binary(input, request, consumed);
+    }
+    return parse_text(input, request, consumed);
+}
+
+std::string encode_request(Opcode opcode, std::string_view path, std::string_view value) {
+    std::string frame;
+    frame.reserve(kBinaryHeaderSize + path.size() + value.size());
+    frame.push_back(static_cast<char>(kBinaryMagic));
+    frame.push_back(static_cast<char>(opcode));
+    append_u32(frame, static_cast<uint32_t>(path.size()));
+    append_u32(frame, static_cast<uint32_t>(value.size()));
+    frame.append(path);
+    frame.append(value);
+    return frame;
+}
+
+bool split_batch_items(bool binary, std::string_view path, std::string_view value,
+                       std::vector<std::string_view> &items) {
+    items.clear();
+    if (!binary) {
+        // Текст: первый элемент разобран как path, остальные - слова value
+        if (!path.empty()) {
+            items.push_back(path);
+        }
+        size_t position = 0;
+        std::string_view item;
+        while (!(item = next_token(value, position)).empty()) {
+            items.push_back(item);
+        }
+        return true;
+    }
+
+    if (!path.empty()) {
+        return false;
+    }
+    std::string_view rest = value;
+    while (!rest.empty()) {
+        if (rest.size() < 4) {
+            return false;
+        }
+        size_t length = read_u32(rest.data());
+        if (rest.size() - 4 < length) {
+            return false;
+        }
+        items.push_back(rest.substr(4, length));
+        rest.remove_prefix(4 + length);
+    }
+    return true;
+}
+
+std::string encode_batch_items(const std::vector<std::string_view> &items) {
+    std::string packed;
+    for (auto item : items) {
+        append_u32(packed, static_cast<uint32_t>(item.size()));
+        packed.append(item);
+    }
+    return packed;
+}
+
+std::array<char, 4> encode_reply_length(uint32_t length) {
+    return {static_cast<char>(length & 0xFF), static_cast<char>((length >> 8) & 0xFF),
+            static_cast<char>((length >> 16) & 0xFF), static_cast<char>((length >> 24) & 0xFF)};
+}
+
+bool parse_ttl_seconds(std::string_view text, uint64_t &seconds) {
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), seconds);
+    return !text.empty() && error == std::errc() && end == text.data() + text.size() &&
+           seconds != 0 && seconds <= kMaxTtlSeconds;
+}
+
+bool split_ttl_value(std::string_view argument, uint64_t &seconds, std::string_view &value) {
+    size_t space = argument.find(' ');
+    value = space == std::string_view::npos ? std::string_view() : argument.substr(space + 1);
+    return parse_ttl_seconds(argument.substr(0, space), seconds);
+}
+
+bool arguments_valid(Opcode opcode, std::string_view value) {
+    uint64_t seconds;
+    std::string_view data;
+    return opcode != Opcode::CreateLeafEx || split_ttl_value(value, seconds, data);
+}
@@ -0,0 +1,192 @@
+#include "scan.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+#include "binaryFile.hpp"
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+constexpr std::string_view kHexDigits = "0123456789abcdef";
+constexpr char kLeafCursor = 'L';
+constexpr char kNodeCursor = 'D';
+
+// Следующая выдаваемая запись: лист leaf каталога dir или, если листья кончились, подкаталог child.
+struct s_scan_position {
+    const Node *dir;
+    const Leaf *leaf;
+    NodeChildren::const_iterator child;
+};
+
+using ScanPosition = struct s_scan_position;
+
+ScanPosition start_of(const Node &dir) { return {&dir, dir.east.get(), dir.childs.begin()}; }
+
+const Node *parent_of(const Node &node) { return node.parent.lock().get(); }
+
+const Node *parent_of(const Leaf &leaf) {
+    return std::get<std::weak_ptr<s_node>>(leaf.parent).lock().get();
+}
+
+// Курсор в текстовом протоколе - одно слово, поэтому двоичная запись курсора кодируется в hex.
+std::string to_hex(std::string_view bytes) {
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (char c : bytes) {
+        auto byte = static_cast<unsigned char>(c);
+        hex.push_back(kHexDigits[byte >> 4]);
+        hex.push_back(kHexDigits[byte & 0x0F]);
+    }
+    return hex;
+}
+
+bool from_hex(std::string_view hex, std::string &bytes) {
+    if (hex.size() % 2 != 0) {
+        return false;
+    }
+    bytes.clear();
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        size_t high = kHexDigits.find(hex[i]);
+        size_t low = kHexDigits.find(hex[i + 1]);
+        if (high == std::string_view::npos || low == std::string_view::npos) {
+            return false;
+        }
+        bytes.push_back(static_cast<char>(high << 4 | low));
+    }
+    return true;
+}
+
+// Вид записи, число уровней, seq каталогов от корня обхода и самой записи, полный путь записи.
+std::string encode_cursor(const Node &root, const ScanEntry &entry) {
+    std::vector<uint64_t> seqs;
+    const Node *dir;
+    if (entry.leaf) {
+        seqs.push_back(entry.leaf->seq);
+        dir = parent_of(*entry.leaf);
+    } else {
+        seqs.push_back(entry.node->seq);
+        dir = parent_of(*entry.node);
+    }
+    for (; dir != &root; dir = parent_of(*dir)) {
+        seqs.push_back(dir->seq);
+    }
+
+    std::string bytes(1, entry.leaf ? kLeafCursor : kNodeCursor);
+    append_varint(bytes, seqs.size());
+    for (auto it = seqs.rbegin(); it != seqs.rend(); ++it) {
+        append_varint(bytes, *it);
+    }
+    bytes.append(entry.leaf ? std::string_view(entry.leaf->path)
+                            : std::string_view(entry.node->path));
+    return to_hex(bytes);
+}
+
+const Leaf *first_leaf_after(const Node &dir, uint64_t seq) {
+    const Leaf *leaf = dir.east.get();
+    while (leaf && leaf->seq <= seq) {
+        leaf = leaf->east.get();
+    }
+    return leaf;
+}
+
+NodeChildren::const_iterator first_child_after(const Node &dir, uint64_t seq) {
+    return std::find_if(dir.childs.begin(), dir.childs.end(),
+                        [seq](const auto &child) { return child->seq > seq; });
+}
+
+// Позиция сразу за записью курсора (см. scan.hpp). false, если курсор не разобран.
+bool resume(const Node &root, std::string_view cursor, ScanPosition &position) {
+    std::string bytes;
+    if (!from_hex(cursor, bytes) || bytes.empty() ||
+        (bytes[0] != kLeafCursor && bytes[0] != kNodeCursor)) {
+        return false;
+    }
+    bool leaf_cursor = bytes[0] == kLeafCursor;
+    size_t offset = 1;
+    uint64_t levels;
+    if (!read_varint(bytes, offset, levels) || levels == 0 || levels > bytes.size()) {
+        return false;
+    }
+    std::vector<uint64_t> seqs(levels);
+    for (auto &seq : seqs) {
+        if (!read_varint(bytes, offset, seq)) {
+            return false;
+        }
+    }
+
+    // Путь записи относительно корня обхода: ровно levels имен
+    std::string_view path = std::string_view(bytes).substr(offset);
+    std::string_view prefix = root.path == "/" ? std::string_view() : std::string_view(root.path);
+    if (!path.starts_with(prefix) || path.size() <= prefix.size() + 1 ||
+        path[prefix.size()] != '/') {
+        return false;
+    }
+    std::string_view rest = path.substr(prefix.size() + 1);
+    if (static_cast<uint64_t>(std::count(rest.begin(), rest.end(), '/')) + 1 != levels) {
+        return false;
+    }
+
+    const Node *dir = &root;
+    for (uint64_t level = 0; level < levels; ++level) {
+        bool last = level + 1 == levels;
+        std::string_view name = rest.substr(0, rest.find('/'));
+        rest.remove_prefix(last ? rest.size() : name.size() + 1);
+
+        if (last && leaf_cursor) {
+            auto it = dir->leaf_by_name.find(name);
+            const Leaf *leaf = it == dir->leaf_by_name.end() ? nullptr : it->second;
+            position = {dir,
+                        (leaf && leaf->seq == seqs[level]) ? leaf->east.get()
+                                                           : first_leaf_after(*dir, seqs[level]),
+                        dir->childs.begin()};
+            return true;
+        }
+
+        auto it = dir->childs.position_of(name);
+        if (it == dir->childs.end() || (*it)->seq != seqs[level]) {
+            // Каталог удален вместе с содержимым: обход продолжается со следующего соседа
+            position = {dir, nullptr, first_child_after(*dir, seqs[level])};
+            return true;
+        }
+        dir = it->get();
+    }
+    position = start_of(*dir);  // Курсор - каталог: далее его содержимое
+    return true;
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+bool scan_subtree(const std::shared_ptr<Node> &dir, std::string_view cursor, size_t count,
+                  std::vector<ScanEntry> &page, std::string &next) {
+    page.clear();
+    ScanPosition position = start_of(*dir);
+    if (cursor != kScanStart && !resume(*dir, cursor, position)) {
+        return false;
+    }
+
+    while (page.size() < count) {
+        if (position.leaf) {
+            page.push_back({nullptr, position.leaf});
+            position.leaf = position.leaf->east.get();
+        } else if (position.child != position.dir->childs.end()) {
+            const Node &child = **position.child;
+            page.push_back({&child, nullptr});
+            position = start_of(child);
+        } else if (position.dir != dir.get()) {
+            // Каталог закончен: следующий сосед в родителе
+            const Node *parent = parent_of(*position.dir);
+            auto it = parent->childs.position_of(name_of(position.dir->path));
+            position = {parent, nullptr, std::next(it)};
+        } else {
+            break;
+        }
+    }
+
+    next = page.size() < count || page.empty() ? std::string(kScanStart)
+                                               : encode_cursor(*dir, page.back());
+    return true;
+}
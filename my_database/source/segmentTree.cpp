@@ -0,0 +1,360 @@
+#include "segmentTree.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+// Проверяет синтаксис полного пути: начинается с '/', без пустых сегментов и '/' в конце.
+static bool is_valid_path(std::string_view path) {
+    if (path.empty() || path.front() != '/') {
+        return false;
+    }
+    if (path == "/") {
+        return true;
+    }
+    return path.back() != '/' && path.find("//") == std::string_view::npos;
+}
+
+// Делит путь на родительский каталог и имя: "/Users/bob" -> ("/Users", "bob").
+static void split_parent(std::string_view path, std::string_view &parent, std::string_view &name) {
+    size_t last_slash_pos = path.rfind('/');
+    parent = (last_slash_pos == 0) ? std::string_view("/") : path.substr(0, last_slash_pos);
+    name = path.substr(last_slash_pos + 1);
+}
+
+// Возвращает пары (имя, элемент) контейнера, отсортированные по имени.
+template <typename Map>
+static std::vector<std::pair<std::string_view, const typename Map::mapped_type *>> sorted_by_name(
+    const Map &map, const SegmentTable &segments) {
+    std::vector<std::pair<std::string_view, const typename Map::mapped_type *>> result;
+    result.reserve(map.size());
+    for (const auto &[id, item] : map) {
+        result.emplace_back(segments.view(id), &item);
+    }
+    std::sort(result.begin(), result.end(),
+              [](const auto &a, const auto &b) { return a.first < b.first; });
+    return result;
+}
+
+static void print_segment_node(std::stringstream &ss, const SegmentTable &segments,
+                               const SegmentNode &node, size_t from_depth, std::string path,
+                               int indent) {
+    if (node.parent == nullptr) {
+        ss << std::string(indent * 2, ' ') << "📁 /\n";
+        ++indent;
+    }
+
+    // Разворачиваем сжатую цепочку: каждый каталог метки печатается на своем уровне.
+    for (size_t depth = from_depth; depth < node.label.size(); ++depth) {
+        if (depth > from_depth) {
+            path += '/';
+            path += segments.view(node.label[depth]);
+        }
+        ss << std::string(indent * 2, ' ') << "📁 " << path << "\n";
+        ++indent;
+    }
+
+    std::string prefix = (path == "/") ? "" : path;
+    for (const auto &[name, child] : sorted_by_name(node.children, segments)) {
+        print_segment_node(ss, segments, **child, 0, prefix + "/" + std::string(name), indent);
+    }
+    for (const auto &[name, value] : sorted_by_name(node.leaves, segments)) {
+        ss << std::string(indent * 2, ' ') << "🍃 " << prefix << "/" << name << " (value: '"
+           << *value << "')\n";
+    }
+}
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+SegmentId SegmentTable::intern(std::string_view segment) {
+    auto it = ids_.find(segment);
+    if (it != ids_.end()) {
+        ++slots_[it->second].refs;
+        return it->second;
+    }
+
+    SegmentId id;
+    if (!free_slots_.empty()) {
+        id = free_slots_.back();
+        free_slots_.pop_back();
+    } else {
+        id = static_cast<SegmentId>(slots_.size());
+        slots_.emplace_back();
+    }
+
+    slots_[id].text.assign(segment);
+    slots_[id].refs = 1;
+    ids_.emplace(slots_[id].text, id);
+    return id;
+}
+
+SegmentId SegmentTable::find(std::string_view segment) const {
+    auto it = ids_.find(segment);
+    return it == ids_.end() ? kNoSegment : it->second;
+}
+
+void SegmentTable::release(SegmentId id) {
+    Slot &slot = slots_[id];
+    if (--slot.refs > 0) {
+        return;
+    }
+    ids_.erase(slot.text);
+    slot.text.clear();
+    slot.text.shrink_to_fit();
+    free_slots_.push_back(id);
+}
+
+SegmentTree::SegmentTree() : root_(std::make_unique<SegmentNode>()) {}
+
+bool SegmentTree::resolve(std::string_view path, Position &position) const {
+    if (!is_valid_path(path)) {
+        return false;
+    }
+
+    position = {root_.get(), 0};
+    if (path == "/") {
+        return true;
+    }
+
+    size_t begin = 1;
+    while (begin <= path.size()) {
+        size_t end = path.find('/', begin);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+
+        SegmentId id = segments_.find(path.substr(begin, end - begin));
+        if (id == kNoSegment) {
+            return false;
+        }
+
+        if (!is_tail(position)) {
+            // Внутри сжатой цепочки у каталога единственный потомок - следующий сегмент метки.
+            if (position.node->label[position.depth + 1] != id) {
+                return false;
+            }
+            ++position.depth;
+        } else {
+            auto it = position.node->children.find(id);
+            if (it == position.node->children.end()) {
+                return false;
+            }
+            position = {it->second.get(), 0};
+        }
+        begin = end + 1;
+    }
+    return true;
+}
+
+bool SegmentTree::is_tail(const Position &position) const {
+    return position.node == root_.get() || position.depth + 1 == position.node->label.size();
+}
+
+bool SegmentTree::has_entry(const Position &position, SegmentId id) const {
+    if (id == kNoSegment) {
+        return false;
+    }
+    if (!is_tail(position)) {
+        return position.node->label[position.depth + 1] == id;
+    }
+    return position.node->children.count(id) || position.node->leaves.count(id);
+}
+
+void SegmentTree::split(SegmentNode *node, size_t depth) {
+    auto rest = std::make_unique<SegmentNode>();
+    rest->parent = node;
+    rest->label.assign(node->label.begin() + depth + 1, node->label.end());
+    rest->children = std::move(node->children);
+    rest->leaves = std::move(node->leaves);
+    for (auto &[id, child] : rest->children) {
+        child->parent = rest.get();
+    }
+
+    node->label.resize(depth + 1);
+    node->children.clear();
+    node->leaves.clear();
+    SegmentId key = rest->label.front();
+    node->children.emplace(key, std::move(rest));
+    ++compressed_node_count_;
+}
+
+void SegmentTree::merge_with_only_child(SegmentNode *node) {
+    if (node == root_.get() || !node->leaves.empty() || node->children.size() != 1) {
+        return;
+    }
+
+    auto child = std::move(node->children.begin()->second);
+    node->children.clear();
+    node->label.insert(node->label.end(), child->label.begin(), child->label.end());
+    node->children = std::move(child->children);
+    node->leaves = std::move(child->leaves);
+    for (auto &[id, grandchild] : node->children) {
+        grandchild->parent = node;
+    }
+    --compressed_node_count_;
+}
+
+void SegmentTree::release_subtree(SegmentNode *node, size_t from_depth) {
+    for (size_t depth = from_depth; depth < node->label.size(); ++depth) {
+        segments_.release(node->label[depth]);
+    }
+    node_count_ -= node->label.size() - from_depth;
+
+    for (const auto &[id, value] : node->leaves) {
+        segments_.release(id);
+    }
+    leaf_count_ -= node->leaves.size();
+
+    for (const auto &[id, child] : node->children) {
+        release_subtree(child.get(), 0);
+        --compressed_node_count_;
+    }
+}
+
+bool SegmentTree::create_node(std::string_view path) {
+    if (path == "/" || !is_valid_path(path)) {
+        return false;
+    }
+
+    std::string_view parent_path, name;
+    split_parent(path, parent_path, name);
+
+    Position position;
+    if (!resolve(parent_path, position)) {
+        return false;
+    }
+    // Проверка до split(): иначе неудачная попытка оставила бы цепочку разбитой
+    if (has_entry(position, segments_.find(name))) {
+        return false;
+    }
+    if (!is_tail(position)) {
+        split(position.node, position.depth);
+    }
+
+    SegmentNode *parent = position.node;
+
+    SegmentId id = segments_.intern(name);
+    if (parent != root_.get() && parent->children.empty() && parent->leaves.empty()) {
+        // Пустой каталог с единственным потомком - продлеваем сжатую цепочку.
+        parent->label.push_back(id);
+    } else {
+        auto child = std::make_unique<SegmentNode>();
+        child->parent = parent;
+        child->label.push_back(id);
+        parent->children.emplace(id, std::move(child));
+        ++compressed_node_count_;
+    }
+    ++node_count_;
+    return true;
+}
+
+bool SegmentTree::create_leaf(std::string_view path, std::string_view value) {
+    if (path == "/" || !is_valid_path(path)) {
+        return false;
+    }
+
+    std::string_view parent_path, name;
+    split_parent(path, parent_path, name);
+
+    Position position;
+    if (!resolve(parent_path, position)) {
+        return false;
+    }
+    // Проверка до split(): иначе неудачная попытка оставила бы цепочку разбитой
+    if (has_entry(position, segments_.find(name))) {
+        return false;
+    }
+    if (!is_tail(position)) {
+        split(position.node, position.depth);
+    }
+
+    SegmentNode *parent = position.node;
+
+    parent->leaves.emplace(segments_.intern(name), std::string(value));
+    ++leaf_count_;
+    return true;
+}
+
+bool SegmentTree::delete_node(std::string_view path) {
+    Position position;
+    if (path == "/" || !resolve(path, position)) {
+        return false;
+    }
+
+    SegmentNode *node = position.node;
+    if (position.depth > 0) {
+        // Удаляется хвост сжатой цепочки: укорачиваем метку, узел остается пустым каталогом.
+        release_subtree(node, position.depth);
+        node->children.clear();
+        node->leaves.clear();
+        node->label.resize(position.depth);
+        return true;
+    }
+
+    SegmentNode *parent = node->parent;
+    SegmentId key = node->label.front();
+    release_subtree(node, 0);
+    --compressed_node_count_;
+    parent->children.erase(key);
+    merge_with_only_child(parent);
+    return true;
+}
+
+bool SegmentTree::delete_leaf(std::string_view path) {
+    if (path == "/" || !is_valid_path(path)) {
+        return false;
+    }
+
+    std::string_view parent_path, name;
+    split_parent(path, parent_path, name);
+
+    Position position;
+    SegmentId id = segments_.find(name);
+    if (id == kNoSegment || !resolve(parent_path, position) || !is_tail(position)) {
+        return false;
+    }
+
+    SegmentNode *parent = position.node;
+    if (parent->leaves.erase(id) == 0) {
+        return false;
+    }
+    segments_.release(id);
+    --leaf_count_;
+    merge_with_only_child(parent);
+    return true;
+}
+
+bool SegmentTree::node_exists(std::string_view path) const {
+    Position position;
+    return resolve(path, position);
+}
+
+const std::string *SegmentTree::find_leaf(std::string_view path) const {
+    if (path == "/" || !is_valid_path(path)) {
+        return nullptr;
+    }
+
+    std::string_view parent_path, name;
+    split_parent(path, parent_path, name);
+
+    Position position;
+    SegmentId id = segments_.find(name);
+    if (id == kNoSegment || !resolve(parent_path, position) || !is_tail(position)) {
+        return nullptr;
+    }
+
+    auto it = position.node->leaves.find(id);
+    return it == position.node->leaves.end() ? nullptr : &it->second;
+}
+
+std::string SegmentTree::print_tree_string(std::string_view path) const {
+    Position position;
+    if (!resolve(path, position)) {
+        return "";
+    }
+
+    std::stringstream ss;
+    print_segment_node(ss, segments_, *position.node, position.depth, std::string(path), 0);
+    return ss.str();
+}
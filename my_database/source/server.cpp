@@ -1,31 +1,593 @@
 #include "server.hpp"
 
-#include <mutex>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <unordered_map>
+#include <utility>
+
+#include "connectionPool.hpp"
+#include "eventLoop.hpp"
+#include "eviction.hpp"
+#include "expiry.hpp"
+#include "logger.hpp"
+#include "metrics.hpp"
+#include "pathLock.hpp"
+#include "scan.hpp"
+#include "snapshot.hpp"
+#include "subtreeStream.hpp"
+#include "transaction.hpp"
 /*-----------------------------------------STATIC_VARiABLES----------------------------------------------------*/
 
-// Глобальный указатель на корень дерева и мьютекс для защиты доступа к нему.
+// Глобальный указатель на корень дерева. Глобальной блокировки нет: каждая команда блокирует
+// только свой каталог (PathLock), поэтому команды в разных поддеревьях выполняются параллельно.
+// Изменяющие команды берут X на родительском каталоге записи, PRINT_TREE - S на каталоге.
 static std::shared_ptr<Node> g_root;
-static std::mutex g_tree_mutex;
+
+// Журнал изменений (nullptr, если сервер запущен без --aof). Изменение добавляется в журнал под
+// той же блокировкой, что и применяется, а ожидание записи на диск - после ее снятия.
+static std::unique_ptr<MutationLog> g_log;
+static thread_local uint64_t t_log_lsn = 0;  // Последняя запись журнала этого потока
+
+// Удаление листьев с истекшим TTL (expiry.hpp); создается до приема клиентов.
+static std::unique_ptr<LeafExpiry> g_expiry;
+
+// Предел памяти дерева и вытеснение листьев (eviction.hpp); создается до приема клиентов.
+static std::unique_ptr<LeafEviction> g_eviction;
+
+// Файл образа (--snapshot) и признак того, что образ сейчас пишет дочерний процесс.
+static std::string g_snapshot_path;
+static std::atomic<bool> g_snapshot_running{false};
 
 /*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
 
-Callback get_callback(std::string command) {
-    Callback callback = nullptr;
-    for (const auto &handler : commands_handlers) {
-        if (handler.command == command) {
-            callback = handler.callback;
-            break;
+// Таблица обработчиков, индексированная опкодом: выбор команды - одно обращение к массиву.
+Callback get_callback(Opcode opcode) {
+    static const std::array<Callback, 256> table = [] {
+        std::array<Callback, 256> callbacks{};
+        for (const auto &handler : commands_handlers) {
+            callbacks[static_cast<uint8_t>(handler.opcode)] = handler.callback;
+        }
+        return callbacks;
+    }();
+    return table[static_cast<uint8_t>(opcode)];
+}
+
+// Склеивает ответ из частей за одно выделение памяти.
+static std::string concat(std::initializer_list<std::string_view> parts) {
+    size_t length = 0;
+    for (auto part : parts) {
+        length += part.size();
+    }
+    std::string result;
+    result.reserve(length);
+    for (auto part : parts) {
+        result.append(part);
+    }
+    return result;
+}
+
+// Путь записи, с которым может работать пакетная команда: "/a/b", но не "", "/" или "/a/".
+static bool is_entry_path(std::string_view path) {
+    return path.size() > 1 && path.front() == '/' && path.back() != '/';
+}
+
+// Лежит ли каталог path внутри каталога dir (или совпадает с ним).
+static bool is_within(std::string_view dir, std::string_view path) {
+    return dir == "/" || path == dir ||
+           (path.size() > dir.size() && path.starts_with(dir) && path[dir.size()] == '/');
+}
+
+// Поднимается от каталога dir, пока он не станет предком каталога other (или самим other).
+static std::string_view widen_directory(std::string_view dir, std::string_view other) {
+    if (dir.empty()) {
+        return other;
+    }
+    while (!is_within(dir, other)) {
+        dir = parent_path_of(dir);
+    }
+    return dir;
+}
+
+// Ближайший общий каталог-предок родителей всех корректных путей пакета.
+static std::string_view common_directory(const std::vector<std::string_view> &paths) {
+    std::string_view dir;
+    for (auto path : paths) {
+        if (is_entry_path(path)) {
+            dir = widen_directory(dir, parent_path_of(path));
+        }
+    }
+    return dir;
+}
+
+// Каталоги элементов пакета: каждый родительский путь ищется в индексе один раз на пакет.
+using DirectoryCache = std::unordered_map<std::string_view, std::shared_ptr<Node>>;
+
+static std::shared_ptr<Node> parent_directory(DirectoryCache &cache, std::string_view path) {
+    std::string_view parent = parent_path_of(path);
+    auto it = cache.find(parent);
+    if (it == cache.end()) {
+        it = cache.emplace(parent, find_node_by_path_linear(g_root, parent)).first;
+    }
+    return it->second;
+}
+
+// Разбирает элементы пакета; при ошибке отвечает клиенту сам и возвращает false.
+static bool read_batch(const std::shared_ptr<Client> &client, std::string_view verb,
+                       std::string_view path, std::string_view value,
+                       std::vector<std::string_view> &items) {
+    if (!split_batch_items(client->binary_replies(), path, value, items)) {
+        client->send(concat({"400 Bad Request: Malformed item list for ", verb, ".\n"}));
+        return false;
+    }
+    if (items.empty()) {
+        client->send(concat({"400 Bad Request: At least one path is required for ", verb, ".\n"}));
+        return false;
+    }
+    return true;
+}
+
+// Разбирает "cursor count" постраничных команд; при ошибке отвечает клиенту сам.
+static bool read_page_arguments(const std::shared_ptr<Client> &client, std::string_view verb,
+                                std::string_view path, std::string_view value,
+                                std::string_view &cursor, size_t &count) {
+    size_t space = value.find(' ');
+    cursor = value.substr(0, space);
+    std::string_view count_text = space == std::string_view::npos ? "" : value.substr(space + 1);
+    auto [end, error] = std::from_chars(count_text.data(), count_text.data() + count_text.size(),
+                                        count);
+    if (path.empty() || cursor.empty() || error != std::errc() ||
+        end != count_text.data() + count_text.size() || count == 0 || count > kMaxScanCount) {
+        client->send(concat({"400 Bad Request: Usage: ", verb, " path cursor count (count 1..",
+                             std::to_string(kMaxScanCount), ").\n"}));
+        return false;
+    }
+    return true;
+}
+
+// Добавляет успешное изменение в журнал; вызывается под блокировкой, покрывающей изменение.
+static void log_change(TreeChangeKind kind, std::string_view path, std::string_view value = {}) {
+    if (g_log) {
+        t_log_lsn = g_log->append(kind, path, value);
+    }
+}
+
+// Ждет записи в журнал всех изменений этого потока. false - журнал недоступен.
+static bool sync_mutation_log() {
+    if (!g_log || t_log_lsn == 0) {
+        return true;
+    }
+    return wait_mutation_log(std::exchange(t_log_lsn, 0));
+}
+
+// Назначает листу срок TTL: журнал и таймер колеса. Вызывается под X-блокировкой родителя.
+static void set_expiry(Leaf &leaf, uint64_t expires_at) {
+    leaf.expires_at = expires_at;
+    log_change(TreeChangeKind::ExpireLeaf, leaf.path, encode_expiry(expires_at));
+    if (g_expiry) {
+        g_expiry->schedule(leaf.path, expires_at);
+    }
+}
+
+// Виден ли лист чтениям: истекший, но еще не удаленный колесом лист считается отсутствующим.
+static bool visible(const Leaf &leaf) {
+    if (leaf.expires_at == 0 || !leaf_expired(leaf, unix_time_ms())) {
+        return true;
+    }
+    if (g_expiry) {
+        g_expiry->count_hidden_read();
+    }
+    return false;
+}
+
+// Удаляет лист path, если его TTL истек. Вызывается под X-блокировкой родителя.
+static bool remove_if_expired(std::string_view path) {
+    auto leaf = find_leaf_by_path_linear(g_root, path);
+    if (!leaf || leaf->expires_at == 0 || !leaf_expired(*leaf, unix_time_ms()) ||
+        !delete_leaf_by_path_linear(g_root, path)) {
+        return false;
+    }
+    log_change(TreeChangeKind::DeleteLeaf, path);
+    return true;
+}
+
+// Удаление листа колесом TTL или вытеснением. Запись журнала не ждет fsync: если она потеряется
+// при сбое, лист восстановится и будет удален снова.
+static void log_removed_leaf(std::string_view path) {
+    log_change(TreeChangeKind::DeleteLeaf, path);
+}
+
+// Чтение листа: виден ли он, с учетом обращения для вытеснения и статистики попаданий.
+static bool read_leaf(Leaf *leaf) {
+    bool hit = leaf && visible(*leaf);
+    if (g_eviction) {
+        g_eviction->count_read(hit);
+        if (hit) {
+            g_eviction->touch(*leaf);
         }
     }
+    return hit;
+}
+
+// Запись листа - тоже обращение для вытеснения.
+static void touch_written(Leaf &leaf) {
+    if (g_eviction) {
+        g_eviction->touch(leaf);
+    }
+}
 
-    if (!callback) {
-        return nullptr;
+// Может ли команда увеличить дерево: перед ней освобождается память до предела.
+static bool grows_tree(const Request &request) {
+    switch (request.opcode) {
+        case Opcode::CreateNode:
+        case Opcode::CreateLeaf:
+        case Opcode::CreateLeafEx:
+        case Opcode::SetLeaf:
+        case Opcode::MSet:
+        case Opcode::Exec:
+            return true;
+        case Opcode::Import:
+            return request.value.empty();  // Части потока строятся вне дерева
+        default:
+            return false;
     }
-    return callback;
+}
+
+// Строка "имя:значение" ответа INFO.
+static void append_info(std::string &text, std::string_view name, std::string_view value) {
+    text.append(name).append(":").append(value).push_back('\n');
+}
+
+static void append_info(std::string &text, std::string_view name, uint64_t value) {
+    append_info(text, name, std::to_string(value));
+}
+
+// Микросекунды с двумя знаками из наносекунд.
+static std::string usec_of(double ns) {
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.2f", ns / 1e3);
+    return text;
+}
+
+// "p50=..,p99=..,p99.9=..,max=.." в микросекундах.
+static std::string percentiles_usec(const HistogramSnapshot &histogram) {
+    return concat({"p50=", usec_of(histogram.percentile(0.5)),
+                   ",p99=", usec_of(histogram.percentile(0.99)),
+                   ",p99.9=", usec_of(histogram.percentile(0.999)),
+                   ",max=", usec_of(histogram.max)});
+}
+
+// Метрики metrics.hpp разделами INFO, по образцу INFO в Redis.
+static void append_metrics_info(std::string &text, const MetricsSnapshot &metrics) {
+    text += "# Clients\n";
+    append_info(text, "connected_clients", metrics.connected_clients);
+    append_info(text, "total_connections_received", metrics.total_connections);
+
+    text += "# Stats\n";
+    append_info(text, "total_net_input_bytes", metrics.bytes_in);
+    append_info(text, "total_net_output_bytes", metrics.bytes_out);
+
+    text += "# Commandstats\n";
+    for (size_t i = 0; i < kMetricCommands; ++i) {
+        const HistogramSnapshot &command = metrics.commands[i];
+        if (command.count != 0) {
+            append_info(text, concat({"cmdstat_", metric_verb_of(i)}),
+                        concat({"calls=", std::to_string(command.count),
+                                ",usec=", std::to_string(command.sum / 1000),
+                                ",usec_per_call=", usec_of(command.mean())}));
+        }
+    }
+
+    text += "# Latencystats\n";
+    for (size_t i = 0; i < kMetricCommands; ++i) {
+        if (metrics.commands[i].count != 0) {
+            append_info(text, concat({"latency_percentiles_usec_", metric_verb_of(i)}),
+                        percentiles_usec(metrics.commands[i]));
+        }
+    }
+
+    text += "# Locks\n";
+    for (size_t mode = 0; mode < kMetricLockModes; ++mode) {
+        const HistogramSnapshot &wait = metrics.lock_wait[mode];
+        const HistogramSnapshot &hold = metrics.lock_hold[mode];
+        std::string_view name = mode == 0 ? "lock_shared" : "lock_exclusive";
+        append_info(text, name,
+                    concat({"acquired=", std::to_string(metrics.lock_acquired[mode]),
+                            ",contended=", std::to_string(wait.count),
+                            ",wait_usec=", std::to_string(wait.sum / 1000),
+                            ",hold_usec=", std::to_string(hold.sum / 1000)}));
+        append_info(text, concat({name, "_wait_usec"}), percentiles_usec(wait));
+        append_info(text, concat({name, "_hold_usec"}), percentiles_usec(hold));
+    }
+}
+
+// Метрики в формате Prometheus: metrics.hpp, размер дерева и оценка его памяти.
+static std::string prometheus_text() {
+    std::string text;
+    append_prometheus(text, collect_metrics());
+    SubtreeStats keyspace = subtree_stats_of(*g_root);
+    append_prometheus_gauge(text, "database_tree_nodes", "Directories in the tree.",
+                            keyspace.nodes);
+    append_prometheus_gauge(text, "database_tree_leaves", "Leaves in the tree.",
+                            keyspace.leaves);
+    append_prometheus_gauge(text, "database_tree_key_value_bytes",
+                            "Bytes of full paths and leaf values in the tree.", keyspace.bytes);
+    append_prometheus_gauge(text, "database_memory_used_bytes",
+                            "Estimated memory used by tree entries.",
+                            g_eviction ? g_eviction->used_bytes() : 0);
+    return text;
+}
+
+// Раз в interval_s секунд записывает prometheus_text() в path. Запись идет во временный файл,
+// который затем переименовывается, чтобы сборщик не прочитал файл наполовину.
+static void start_metrics_dump(std::string path, int interval_s) {
+    std::thread([path = std::move(path), interval_s] {
+        std::string temporary = path + ".tmp";
+        bool failing = false;
+        while (true) {
+            bool written = false;
+            {
+                std::ofstream out(temporary, std::ios::trunc);
+                out << prometheus_text();
+                out.close();
+                written = !out.fail();
+            }
+            if (!written || std::rename(temporary.c_str(), path.c_str()) != 0) {
+                if (!failing) {
+                    LOG_WARNING("Failed to write metrics to ", path, ": ", strerror(errno));
+                }
+                failing = true;
+            } else {
+                failing = false;
+            }
+            std::this_thread::sleep_for(std::chrono::seconds(interval_s));
+        }
+    }).detach();
+}
+
+/*-------------------------------------------COMMAND_BODIES----------------------------------------------------*/
+
+// Команды над одним путем без взятия блокировок: вызывающий уже держит PathLock, покрывающий
+// каталог команды (обработчик - на одну команду, EXEC - на всю транзакцию). Если каталог не
+// найден, PathLock держит намеренную блокировку на ближайшем существующем предке, поэтому
+// недостающий каталог не появится во время выполнения. Возвращают текст ответа.
+using RunCommand = std::string (*)(std::string_view path, std::string_view value);
+
+static std::string run_hello(std::string_view path, std::string_view value) {
+    (void)path;
+    (void)value;
+    return "Hello from server!\n";
+}
+
+static std::string run_create_node(std::string_view path, std::string_view value) {
+    (void)value;
+    // Место может занимать истекший лист, который колесо TTL еще не удалило
+    if (create_node_by_path(g_root, path) ||
+        (remove_if_expired(path) && create_node_by_path(g_root, path))) {
+        log_change(TreeChangeKind::CreateNode, path);
+        return concat({"200 OK: Node ", path, " created.\n"});
+    }
+    return concat({"500 Internal Server Error: Failed to create node ", path, ".\n"});
+}
+
+// Создает лист; ttl_seconds == 0 - без срока жизни.
+static std::string create_leaf_with_ttl(std::string_view path, std::string_view value,
+                                        uint64_t ttl_seconds) {
+    auto leaf = create_leaf_by_path(g_root, path, value);
+    if (!leaf && remove_if_expired(path)) {
+        leaf = create_leaf_by_path(g_root, path, value);
+    }
+    if (leaf) {
+        touch_written(*leaf);
+        log_change(TreeChangeKind::CreateLeaf, path, value);
+        if (ttl_seconds != 0) {
+            set_expiry(*leaf, unix_time_ms() + ttl_seconds * 1000);
+        }
+        return concat({"200 OK: Leaf ", path, " created.\n"});
+    }
+    return concat({"500 Internal Server Error: Failed to create leaf ", path, ".\n"});
+}
+
+static std::string run_create_leaf(std::string_view path, std::string_view value) {
+    return create_leaf_with_ttl(path, value, 0);
+}
+
+static std::string ttl_usage(std::string_view usage) {
+    return concat({"400 Bad Request: Usage: ", usage, " (1..", std::to_string(kMaxTtlSeconds),
+                   ").\n"});
+}
+
+// value - "seconds value": срок передается отдельно от байтов значения, которые не разбираются.
+static std::string run_create_leaf_ex(std::string_view path, std::string_view value) {
+    uint64_t ttl_seconds;
+    std::string_view data;
+    if (!split_ttl_value(value, ttl_seconds, data)) {
+        return ttl_usage("CREATE_LEAF_EX path seconds value, seconds");
+    }
+    return create_leaf_with_ttl(path, data, ttl_seconds);
+}
+
+static std::string run_delete_node(std::string_view path, std::string_view value) {
+    (void)value;
+    if (path != "/" && delete_node_by_path_linear(g_root, path)) {
+        log_change(TreeChangeKind::DeleteNode, path);
+        return concat({"200 OK: Node ", path, " deleted.\n"});
+    }
+    return concat({"404 Not Found: Failed to delete node ", path, ".\n"});
+}
+
+static std::string run_delete_leaf(std::string_view path, std::string_view value) {
+    (void)value;
+    if (delete_leaf_by_path_linear(g_root, path)) {
+        log_change(TreeChangeKind::DeleteLeaf, path);
+        return concat({"200 OK: Leaf ", path, " deleted.\n"});
+    }
+    return concat({"404 Not Found: Failed to delete leaf ", path, ".\n"});
+}
+
+static std::string run_print_tree(std::string_view path, std::string_view value) {
+    (void)value;
+    if (auto node = find_node_by_path_linear(g_root, path)) {
+        return "200 OK\n" + print_tree_string(node);
+    }
+    return concat({"404 Not Found: Node ", path, " not found.\n"});
+}
+
+static std::string run_get_leaf(std::string_view path, std::string_view value) {
+    (void)value;
+    // Ответ собирается только из значения листа, без обхода каталога
+    auto leaf = find_leaf_by_path_linear(g_root, path);
+    if (read_leaf(leaf.get())) {
+        return concat({"200 OK: ", leaf->value, "\n"});
+    }
+    return concat({"404 Not Found: Leaf ", path, " not found.\n"});
+}
+
+static std::string run_set_leaf(std::string_view path, std::string_view value) {
+    // Один поиск: существующий лист перезаписывается на месте
+    bool created = false;
+    if (auto leaf = set_leaf_by_path(g_root, path, value, &created)) {
+        touch_written(*leaf);
+        log_change(TreeChangeKind::SetLeaf, path, value);
+        return concat({"200 OK: Leaf ", path, created ? " created.\n" : " updated.\n"});
+    }
+    return concat({"500 Internal Server Error: Failed to set leaf ", path, ".\n"});
+}
+
+// Команды, которые можно поставить в очередь транзакции; nullptr - нельзя.
+static RunCommand get_run_command(Opcode opcode) {
+    switch (opcode) {
+        case Opcode::Hello:
+            return run_hello;
+        case Opcode::CreateNode:
+            return run_create_node;
+        case Opcode::CreateLeaf:
+            return run_create_leaf;
+        case Opcode::CreateLeafEx:
+            return run_create_leaf_ex;
+        case Opcode::DeleteNode:
+            return run_delete_node;
+        case Opcode::DeleteLeaf:
+            return run_delete_leaf;
+        case Opcode::PrintTree:
+            return run_print_tree;
+        case Opcode::GetLeaf:
+            return run_get_leaf;
+        case Opcode::SetLeaf:
+            return run_set_leaf;
+        default:
+            return nullptr;
+    }
+}
+
+// Изменение дерева, которое вносит команда транзакции; false для команд только на чтение.
+static bool tree_change_of(const QueuedCommand &command, TreeChange &change) {
+    switch (command.opcode) {
+        case Opcode::CreateNode:
+            change.kind = TreeChangeKind::CreateNode;
+            break;
+        case Opcode::CreateLeaf:
+        case Opcode::CreateLeafEx:
+            change.kind = TreeChangeKind::CreateLeaf;
+            break;
+        case Opcode::DeleteNode:
+            change.kind = TreeChangeKind::DeleteNode;
+            break;
+        case Opcode::DeleteLeaf:
+            change.kind = TreeChangeKind::DeleteLeaf;
+            break;
+        case Opcode::SetLeaf:
+            change.kind = TreeChangeKind::SetLeaf;
+            break;
+        default:
+            return false;
+    }
+    change.path = command.path;
+    return true;
+}
+
+// Каталог, который блокирует команда транзакции ("" - команда не работает с деревом).
+static std::string_view locked_directory(const QueuedCommand &command) {
+    if (command.opcode == Opcode::Hello) {
+        return {};
+    }
+    if (command.opcode == Opcode::PrintTree) {
+        return command.path.starts_with('/') ? std::string_view(command.path) : std::string_view();
+    }
+    return is_entry_path(command.path) ? parent_path_of(command.path) : std::string_view();
 }
 
 /*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
-int init_server() {
+bool parse_server_options(int argc, char const *argv[], ServerOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        std::string key = arg.substr(0, eq);
+        std::string value = (eq == std::string::npos) ? "" : arg.substr(eq + 1);
+        LogLevel level;
+        FsyncPolicy policy;
+        EvictionPolicy eviction;
+
+        if (key == "--host" && !value.empty()) {
+            options.host = value;
+        } else if (key == "--port" && !value.empty()) {
+            options.port = std::atoi(value.c_str());
+        } else if (key == "--mode" && (value == "thread" || value == "epoll")) {
+            options.mode = (value == "epoll") ? ServerMode::Epoll : ServerMode::Thread;
+        } else if (key == "--workers" && std::atoi(value.c_str()) > 0) {
+            options.workers = static_cast<size_t>(std::atoi(value.c_str()));
+        } else if (key == "--backlog" && std::atoi(value.c_str()) > 0) {
+            options.backlog = std::atoi(value.c_str());
+        } else if (key == "--pool" && std::atoi(value.c_str()) > 0) {
+            options.pool_threads = static_cast<size_t>(std::atoi(value.c_str()));
+        } else if (key == "--queue" && std::atoi(value.c_str()) > 0) {
+            options.pool_queue = static_cast<size_t>(std::atoi(value.c_str()));
+        } else if (key == "--queue-timeout" && std::atoi(value.c_str()) > 0) {
+            options.pool_queue_timeout = std::atoi(value.c_str());
+        } else if (key == "--log-level" && parse_log_level(value, level)) {
+            options.log_level = level;
+        } else if (key == "--log-file" && !value.empty()) {
+            options.log_file = value;
+        } else if (key == "--aof" && !value.empty()) {
+            options.aof.path = value;
+        } else if (key == "--fsync" && parse_fsync_policy(value, policy)) {
+            options.aof.fsync = policy;
+        } else if (key == "--aof-rewrite-min" && std::atoll(value.c_str()) > 0) {
+            options.aof.rewrite_min_size = static_cast<uint64_t>(std::atoll(value.c_str()));
+        } else if (key == "--snapshot" && !value.empty()) {
+            options.snapshot_path = value;
+        } else if (key == "--maxmemory" && std::atoll(value.c_str()) > 0) {
+            options.eviction.max_bytes = static_cast<size_t>(std::atoll(value.c_str()));
+        } else if (key == "--maxmemory-policy" && parse_eviction_policy(value, eviction)) {
+            options.eviction.policy = eviction;
+        } else if (key == "--maxmemory-samples" && std::atoi(value.c_str()) > 0) {
+            options.eviction.samples = static_cast<size_t>(std::atoi(value.c_str()));
+        } else if (key == "--metrics-file" && !value.empty()) {
+            options.metrics_file = value;
+        } else if (key == "--metrics-interval" && std::atoi(value.c_str()) > 0) {
+            options.metrics_interval = std::atoi(value.c_str());
+        } else {
+            LOG_ERROR("Unknown argument '", arg, "'. Usage: database_server",
+                      " [--host=ADDR] [--port=N] [--mode=thread|epoll] [--workers=N]",
+                      " [--backlog=N] [--pool=N (max concurrent connections in thread mode)]",
+                      " [--queue=N] [--queue-timeout=SECONDS]",
+                      " [--log-level=debug|info|warning|error|off] [--log-file=PATH]",
+                      " [--aof=PATH] [--fsync=always|everysec|never] [--aof-rewrite-min=BYTES]",
+                      " [--snapshot=PATH] [--maxmemory=BYTES]",
+                      " [--maxmemory-policy=noeviction|lru|lfu|ttl] [--maxmemory-samples=N]",
+                      " [--metrics-file=PATH] [--metrics-interval=SECONDS]");
+            return false;
+        }
+    }
+    return true;
+}
+
+int init_server(const ServerOptions &options) {
     struct sockaddr_in sock;
     int sock_fd;
 
@@ -34,33 +596,45 @@ int init_server() {
      To conver in proper network byte order (little-endian vs. big-endian) use htons() and
      inet_addr() func
     */
-    sock.sin_port = htons(PORT);
-    sock.sin_addr.s_addr = inet_addr(HOST);
+    sock.sin_port = htons(options.port);
+    sock.sin_addr.s_addr = inet_addr(options.host.c_str());
 
     sock_fd = socket(AF_INET, SOCK_STREAM, 0);  // SOCK_STREAM - use TCP
 
     if (sock_fd < 0) {
-        std::cerr << "Error: Socket creation failed: " << strerror(errno) << std::endl;
+        LOG_ERROR("Socket creation failed: ", strerror(errno));
+        return -1;
+    }
+
+    // SO_REUSEPORT: каждый воркер открывает свой сокет на том же адресе, ядро балансирует
+    // соединения между ними. SO_REUSEADDR - быстрый перезапуск после деплоя.
+    int enable = 1;
+    if (setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) != 0 ||
+        setsockopt(sock_fd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) != 0) {
+        LOG_ERROR("Failed to set socket options: ", strerror(errno));
+        close(sock_fd);
         return -1;
     }
 
     if (bind(sock_fd, (struct sockaddr *)&sock, sizeof(sock)) != 0) {
-        std::cerr << "Error: Bind failed for " << HOST << ":" << PORT << ": " << strerror(errno)
-                  << std::endl;
+        LOG_ERROR("Bind failed for ", options.host, ":", options.port, ": ", strerror(errno));
+        close(sock_fd);
         return -1;
     }
 
-    if (listen(sock_fd, 20) != 0) {  // How many connections at a time
-        std::cerr << "Error: Failed to listen on socket: " << strerror(errno) << std::endl;
+    // Ядро ограничивает очередь значением net.core.somaxconn
+    if (listen(sock_fd, options.backlog) != 0) {
+        LOG_ERROR("Failed to listen on socket: ", strerror(errno));
+        close(sock_fd);
         return -1;
     }
 
-    std::cout << "Server started listening on " << HOST << ":" << PORT << std::endl;
+    LOG_INFO("Server started listening on ", options.host, ":", options.port);
 
     return sock_fd;
 }
 
-void accept_connection(int sock_fd) {
+void accept_connection(int sock_fd, ConnectionPool &pool) {
     struct sockaddr_in client;
     int client_fd;
 
@@ -78,165 +652,829 @@ void accept_connection(int sock_fd) {
     inet_ntop(AF_INET, &client.sin_addr, ip, sizeof(ip));
     auto new_client = std::make_shared<Client>(client_fd, ip, port);
 
-    std::cout << "New connection from " << ip << ":" << port << std::endl;
+    LOG_INFO("New connection from ", ip, ":", port);
 
-    std::thread(handle_connection, std::move(new_client)).detach();
+    pool.submit(std::move(new_client));
 }
 
 void handle_connection(std::shared_ptr<Client> client) {
-    char buffer[256];
+    // Ответы на все команды из одного чтения уходят одним writev()
+    client->set_buffered(true);
     client->send("100 Connected to server\n");
-    while (true) {
-        memset(buffer, 0, sizeof(buffer));
-        ssize_t bytes_read = read(client->get_fd(), buffer, sizeof(buffer) - 1);
-
+    while (client->flush()) {
+        ssize_t bytes_read = client->read_some();
+        if (bytes_read < 0 && errno == EINTR) {
+            continue;
+        }
         if (bytes_read <= 0) {
-            std::cout << "Client " << client->get_ip() << ":" << client->get_port()
-                      << " disconnected." << std::endl;
             break;
         }
+        bool ok = process_input(client);
+        // Запросы, оставленные из-за переполнения вывода, выполняются после отправки ответов
+        while (ok && client->output_full()) {
+            ok = client->flush() && process_input(client);
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    LOG_INFO("Client ", client->get_ip(), ":", client->get_port(), " disconnected.");
+}
 
-        buffer[strcspn(buffer, "\r\n")] = 0;
-
-        std::stringstream ss(buffer);
-        std::string command, path, value;
-
-        ss >> command >> path;
+bool wait_mutation_log(uint64_t lsn) { return !g_log || lsn == 0 || g_log->sync(lsn); }
 
-        std::getline(ss, value);
+bool process_input(const std::shared_ptr<Client> &client, uint64_t *log_lsn) {
+    std::string &input = client->input();
+    std::string_view rest = input;
+    Request request;
+    size_t consumed = 0;
+    ParseStatus status = ParseStatus::Complete;
+    while (!client->output_full() &&
+           (status = parse_request(rest, request, consumed)) == ParseStatus::Complete) {
+        dispatch_request(client, request);
+        rest.remove_prefix(consumed);
+    }
+    input.erase(0, input.size() - rest.size());
 
-        if (!value.empty() && value.front() == ' ') {
-            value.erase(0, 1);
-        }
+    // Ответы уходят клиенту только после записи изменений в журнал: одна групповая фиксация
+    // на все команды этого чтения. С log_lsn записи ждет вызывающий
+    if (log_lsn) {
+        *log_lsn = std::exchange(t_log_lsn, 0);
+    } else if (!sync_mutation_log()) {
+        LOG_ERROR("Mutation log is unavailable, closing ", client->get_ip(), ":",
+                  client->get_port());
+        return false;
+    }
+    if (status == ParseStatus::Error) {
+        LOG_WARNING("Command from ", client->get_ip(), ":", client->get_port(), " exceeds ",
+                    kMaxCommandLength, " bytes, closing.");
+        return false;
+    }
+    return true;
+}
 
-        std::cout << "  Command: '" << command << "', Path: '" << path << "', Value: '" << value
-                  << "'" << std::endl;
+void dispatch_request(const std::shared_ptr<Client> &client, const Request &request) {
+    client->set_binary_replies(request.binary);
 
-        // dprintf(client->client_fd, "\n cmd:\t%s\n path:\t%s\n value:\t%s\n", command.c_str(),
-        //         path.c_str(), value.c_str());
+    std::string_view verb = request.binary ? verb_of(request.opcode) : request.verb;
+    LOG_DEBUG("Command: '", verb, "', Path: '", request.path, "', Value: '", request.value, "'");
 
-        Callback callback = get_callback(command);
-        if (callback) {
-            callback(client, path, value);
+    Transaction &transaction = client->transaction();
+    if (transaction.active && request.opcode != Opcode::Exec &&
+        request.opcode != Opcode::Discard && request.opcode != Opcode::Multi) {
+        if (!get_run_command(request.opcode)) {
+            transaction.aborted = true;
+            client->send(concat({"400 Bad Request: Command '", verb,
+                                 "' is not allowed in MULTI, transaction will be discarded.\n"}));
+        } else if (!arguments_valid(request.opcode, request.value)) {
+            // Ошибка в аргументах обнаружилась бы только при EXEC, после части изменений
+            transaction.aborted = true;
+            client->send(concat({"400 Bad Request: Invalid arguments for '", verb,
+                                 "', transaction will be discarded.\n"}));
         } else {
-            client->send("400 Bad Request: Unknown command '" + command + "'\n");
+            transaction.commands.push_back(
+                {request.opcode, std::string(request.path), std::string(request.value)});
+            client->send("200 OK: QUEUED\n");
         }
+        return;
+    }
+
+    if (grows_tree(request) && g_eviction && !g_eviction->make_room()) {
+        client->send("507 Insufficient Storage: Memory limit reached.\n");
+        return;
+    }
+
+    uint64_t start = monotonic_ns();
+    if (Callback callback = get_callback(request.opcode)) {
+        callback(client, request.path, request.value);
+    } else if (request.binary) {
+        client->send(concat({"400 Bad Request: Unknown opcode ",
+                             std::to_string(request.raw_opcode), "\n"}));
+    } else {
+        client->send(concat({"400 Bad Request: Unknown command '", request.verb, "'\n"}));
     }
+    record_command(request.opcode, monotonic_ns() - start);
 }
 
-int handle_hello(std::shared_ptr<Client> client, std::string path, std::string value) {
-    client->send("Hello from server!\n");
+int handle_hello(const std::shared_ptr<Client> &client, std::string_view path,
+                 std::string_view value) {
+    client->send(run_hello(path, value));
     return 0;
 }
 
-int handle_create_node(std::shared_ptr<Client> client, std::string path, std::string value) {
+int handle_create_node(const std::shared_ptr<Client> &client, std::string_view path,
+                       std::string_view value) {
     if (path.empty()) {
         client->send("400 Bad Request: Path is required for CREATE_NODE.\n");
         return -1;
     }
 
-    std::lock_guard<std::mutex> lock(g_tree_mutex);  // RAII Mutex
-    if (auto new_node = create_node_by_path(g_root, path)) {
-        client->send("200 OK: Node " + path + " created.\n");
-    } else {
-        client->send("500 Internal Server Error: Failed to create node " + path + ".\n");
-    }
+    PathLock lock = PathLock::parent_of(g_root, path, LockMode::Exclusive);
+    client->send(run_create_node(path, value));
     return 0;
 }
 
-int handle_create_leaf(std::shared_ptr<Client> client, std::string path, std::string value) {
+int handle_create_leaf(const std::shared_ptr<Client> &client, std::string_view path,
+                       std::string_view value) {
     if (path.empty()) {
         client->send("400 Bad Request: Path is required for CREATE_LEAF.\n");
         return -1;
     }
 
-    std::lock_guard<std::mutex> lock(g_tree_mutex);
-    if (auto new_leaf = create_leaf_by_path(g_root, path, value)) {
-        client->send("200 OK: Leaf " + path + " created.\n");
-    } else {
-        client->send("500 Internal Server Error: Failed to create leaf " + path + ".\n");
+    PathLock lock = PathLock::parent_of(g_root, path, LockMode::Exclusive);
+    client->send(run_create_leaf(path, value));
+    return 0;
+}
+
+int handle_create_leaf_ex(const std::shared_ptr<Client> &client, std::string_view path,
+                          std::string_view value) {
+    uint64_t ttl_seconds;
+    std::string_view data;
+    if (path.empty() || !split_ttl_value(value, ttl_seconds, data)) {
+        client->send(ttl_usage("CREATE_LEAF_EX path seconds value, seconds"));
+        return -1;
     }
+
+    PathLock lock = PathLock::parent_of(g_root, path, LockMode::Exclusive);
+    client->send(create_leaf_with_ttl(path, data, ttl_seconds));
     return 0;
 }
 
-int handle_delete_node(std::shared_ptr<Client> client, std::string path, std::string value) {
-    (void)value;
+int handle_delete_node(const std::shared_ptr<Client> &client, std::string_view path,
+                       std::string_view value) {
     if (path.empty() || path == "/") {
         client->send("400 Bad Request: Path is required and cannot be root for DELETE_NODE.\n");
         return -1;
     }
 
-    std::lock_guard<std::mutex> lock(g_tree_mutex);
-    if (delete_node_by_path_linear(g_root, path)) {
-        client->send("200 OK: Node " + path + " deleted.\n");
-    } else {
-        client->send("404 Not Found: Failed to delete node " + path + ".\n");
-    }
+    // X на родителе ждет всех, кто работает внутри удаляемого поддерева
+    PathLock lock = PathLock::parent_of(g_root, path, LockMode::Exclusive);
+    client->send(run_delete_node(path, value));
     return 0;
 }
 
-int handle_delete_leaf(std::shared_ptr<Client> client, std::string path, std::string value) {
-    (void)value;
+int handle_delete_leaf(const std::shared_ptr<Client> &client, std::string_view path,
+                       std::string_view value) {
     if (path.empty()) {
         client->send("400 Bad Request: Path is required for DELETE_LEAF.\n");
         return -1;
     }
 
-    std::lock_guard<std::mutex> lock(g_tree_mutex);
-    if (delete_leaf_by_path_linear(g_root, path)) {
-        client->send("200 OK: Leaf " + path + " deleted.\n");
-    } else {
-        client->send("404 Not Found: Failed to delete leaf " + path + ".\n");
+    PathLock lock = PathLock::parent_of(g_root, path, LockMode::Exclusive);
+    client->send(run_delete_leaf(path, value));
+    return 0;
+}
+
+int handle_print_tree(const std::shared_ptr<Client> &client, std::string_view path,
+                      std::string_view value) {
+    if (path.empty()) {
+        client->send("400 Bad Request: Path is required for PRINT_TREE.\n");
+        return -1;
+    }
+
+    // S на каталоге: изменения внутри поддерева ждут, пока мы строим вывод,
+    // остальная часть дерева доступна другим командам
+    PathLock lock(g_root, path, LockMode::Shared);
+    client->send(run_print_tree(path, value));
+    return 0;
+}
+
+int handle_get_leaf(const std::shared_ptr<Client> &client, std::string_view path,
+                    std::string_view value) {
+    if (path.empty()) {
+        client->send("400 Bad Request: Path is required for GET_LEAF.\n");
+        return -1;
+    }
+
+    PathLock lock = PathLock::parent_of(g_root, path, LockMode::Shared);
+    client->send(run_get_leaf(path, value));
+    return 0;
+}
+
+int handle_set_leaf(const std::shared_ptr<Client> &client, std::string_view path,
+                    std::string_view value) {
+    if (path.empty()) {
+        client->send("400 Bad Request: Path is required for SET_LEAF.\n");
+        return -1;
+    }
+
+    PathLock lock = PathLock::parent_of(g_root, path, LockMode::Exclusive);
+    client->send(run_set_leaf(path, value));
+    return 0;
+}
+
+int handle_mget(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value) {
+    std::vector<std::string_view> paths;
+    if (!read_batch(client, "MGET", path, value, paths)) {
+        return -1;
+    }
+
+    std::string status(paths.size(), '-');
+    std::string values;
+    {
+        // Одна S-блокировка на весь пакет: значения согласованы между собой
+        PathLock lock(g_root, common_directory(paths), LockMode::Shared);
+        DirectoryCache directories;
+        for (size_t i = 0; lock.node() && i < paths.size(); ++i) {
+            if (!is_entry_path(paths[i])) {
+                continue;
+            }
+            auto parent = parent_directory(directories, paths[i]);
+            auto leaf = parent ? find_child_leaf(parent, name_of(paths[i])) : nullptr;
+            if (read_leaf(leaf.get())) {
+                status[i] = '+';
+                values.append("$").append(std::to_string(leaf->value.size())).append("\n");
+                values.append(leaf->value).append("\n");
+            }
+        }
+    }
+    client->send(concat({"200 OK: ", status, "\n", values}));
+    return 0;
+}
+
+int handle_mset(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value) {
+    std::vector<std::string_view> items;
+    if (!read_batch(client, "MSET", path, value, items)) {
+        return -1;
+    }
+    if (items.size() % 2 != 0) {
+        client->send("400 Bad Request: MSET expects path/value pairs.\n");
+        return -1;
+    }
+
+    std::vector<std::string_view> paths;
+    paths.reserve(items.size() / 2);
+    for (size_t i = 0; i < items.size(); i += 2) {
+        paths.push_back(items[i]);
+    }
+
+    std::string status(paths.size(), '-');
+    {
+        PathLock lock(g_root, common_directory(paths), LockMode::Exclusive);
+        DirectoryCache directories;
+        for (size_t i = 0; lock.node() && i < paths.size(); ++i) {
+            if (!is_entry_path(paths[i])) {
+                continue;
+            }
+            bool created = false;
+            auto parent = parent_directory(directories, paths[i]);
+            auto leaf = parent ? set_child_leaf(parent, paths[i], items[2 * i + 1], &created)
+                               : nullptr;
+            if (leaf) {
+                touch_written(*leaf);
+                log_change(TreeChangeKind::SetLeaf, paths[i], items[2 * i + 1]);
+                status[i] = created ? 'c' : 'u';
+            }
+        }
+    }
+    client->send(concat({"200 OK: ", status, "\n"}));
+    return 0;
+}
+
+int handle_mdel(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value) {
+    std::vector<std::string_view> paths;
+    if (!read_batch(client, "MDEL", path, value, paths)) {
+        return -1;
+    }
+
+    std::string status(paths.size(), '-');
+    {
+        PathLock lock(g_root, common_directory(paths), LockMode::Exclusive);
+        DirectoryCache directories;
+        for (size_t i = 0; lock.node() && i < paths.size(); ++i) {
+            if (!is_entry_path(paths[i])) {
+                continue;
+            }
+            auto parent = parent_directory(directories, paths[i]);
+            auto leaf = parent ? find_child_leaf(parent, name_of(paths[i])) : nullptr;
+            if (leaf && delete_leaf(g_root, leaf)) {
+                log_change(TreeChangeKind::DeleteLeaf, paths[i]);
+                status[i] = '+';
+            }
+        }
+    }
+    client->send(concat({"200 OK: ", status, "\n"}));
+    return 0;
+}
+
+int handle_multi(const std::shared_ptr<Client> &client, std::string_view path,
+                 std::string_view value) {
+    (void)path;
+    (void)value;
+    Transaction &transaction = client->transaction();
+    if (transaction.active) {
+        client->send("400 Bad Request: MULTI calls can not be nested.\n");
+        return -1;
+    }
+    transaction = Transaction{};
+    transaction.active = true;
+    client->send("200 OK\n");
+    return 0;
+}
+
+int handle_exec(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value) {
+    (void)path;
+    (void)value;
+    Transaction &transaction = client->transaction();
+    if (!transaction.active) {
+        client->send("400 Bad Request: EXEC without MULTI.\n");
+        return -1;
+    }
+    Transaction queued = std::move(transaction);
+    transaction = Transaction{};
+    if (queued.aborted) {
+        client->send("400 Bad Request: Transaction discarded because of previous errors.\n");
+        return -1;
+    }
+
+    // Каталог, покрывающий все команды, и изменения дерева для проверки
+    std::string_view scope;
+    std::vector<TreeChange> changes;
+    std::vector<size_t> change_command;  // Номер команды для каждого изменения
+    for (size_t i = 0; i < queued.commands.size(); ++i) {
+        std::string_view dir = locked_directory(queued.commands[i]);
+        if (!dir.empty()) {
+            scope = widen_directory(scope, dir);
+        }
+        TreeChange change;
+        if (tree_change_of(queued.commands[i], change)) {
+            changes.push_back(change);
+            change_command.push_back(i);
+        }
+    }
+
+    std::string replies;
+    {
+        PathLock lock(g_root, scope, changes.empty() ? LockMode::Shared : LockMode::Exclusive);
+        size_t failed = find_failing_change(g_root, changes);
+        if (failed < changes.size()) {
+            const QueuedCommand &command = queued.commands[change_command[failed]];
+            client->send(concat({"409 Conflict: Transaction aborted at command ",
+                                 std::to_string(change_command[failed] + 1), " (",
+                                 verb_of(command.opcode), " ", command.path,
+                                 "), nothing applied.\n"}));
+            return -1;
+        }
+
+        replies = concat({"200 OK: EXEC ", std::to_string(queued.commands.size()), "\n"});
+        for (const auto &command : queued.commands) {
+            replies += get_run_command(command.opcode)(command.path, command.value);
+        }
+    }
+    // Все ответы транзакции - одним сообщением
+    client->send(std::move(replies));
+    return 0;
+}
+
+int handle_discard(const std::shared_ptr<Client> &client, std::string_view path,
+                   std::string_view value) {
+    (void)path;
+    (void)value;
+    Transaction &transaction = client->transaction();
+    if (!transaction.active) {
+        client->send("400 Bad Request: DISCARD without MULTI.\n");
+        return -1;
+    }
+    transaction = Transaction{};
+    client->send("200 OK\n");
+    return 0;
+}
+
+int handle_snapshot(const std::shared_ptr<Client> &client, std::string_view path,
+                    std::string_view value) {
+    (void)path;
+    (void)value;
+    if (g_snapshot_path.empty()) {
+        client->send("400 Bad Request: Snapshots are disabled (no --snapshot=PATH).\n");
+        return -1;
+    }
+    if (g_snapshot_running.exchange(true)) {
+        client->send("409 Conflict: Snapshot already in progress.\n");
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid = fork_snapshot(g_root, g_snapshot_path);
+    if (pid < 0) {
+        g_snapshot_running = false;
+        client->send("500 Internal Server Error: Failed to start snapshot.\n");
+        return -1;
+    }
+    // Дочерний процесс дожидается отдельный поток: обработчик не ждет записи образа
+    std::thread([pid, start] {
+        bool ok = wait_snapshot(pid);
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        if (ok) {
+            LOG_INFO("Snapshot saved to ", g_snapshot_path, " in ", elapsed.count(), " ms");
+        } else {
+            LOG_ERROR("Snapshot to ", g_snapshot_path, " failed");
+        }
+        g_snapshot_running = false;
+    }).detach();
+    client->send("200 OK: Snapshot started.\n");
+    return 0;
+}
+
+int handle_scan(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value) {
+    std::string_view cursor;
+    size_t count = 0;
+    if (!read_page_arguments(client, "SCAN", path, value, cursor, count)) {
+        return -1;
+    }
+
+    std::vector<ScanEntry> page;
+    std::string next;
+    std::string reply;
+    {
+        PathLock lock(g_root, path, LockMode::Shared);
+        if (!lock.node()) {
+            client->send(concat({"404 Not Found: Node ", path, " not found.\n"}));
+            return -1;
+        }
+        if (!scan_subtree(lock.node(), cursor, count, page, next)) {
+            client->send("400 Bad Request: Invalid SCAN cursor.\n");
+            return -1;
+        }
+        reply = concat({"200 OK: SCAN ", next, " ", std::to_string(page.size()), "\n"});
+        for (const auto &entry : page) {
+            if (entry.node) {
+                reply.append("D ").append(entry.node->path).push_back('\n');
+            } else {
+                reply.append("L ").append(entry.leaf->path).append("\n$");
+                reply.append(std::to_string(entry.leaf->value.size())).push_back('\n');
+                reply.append(entry.leaf->value).push_back('\n');
+            }
+        }
+    }
+    client->send(std::move(reply));
+    return 0;
+}
+
+int handle_export(const std::shared_ptr<Client> &client, std::string_view path,
+                  std::string_view value) {
+    std::string_view cursor;
+    size_t count = 0;
+    if (!read_page_arguments(client, "EXPORT", path, value, cursor, count)) {
+        return -1;
+    }
+
+    std::string chunk;
+    std::string next;
+    {
+        PathLock lock(g_root, path, LockMode::Shared);
+        if (!lock.node()) {
+            client->send(concat({"404 Not Found: Node ", path, " not found.\n"}));
+            return -1;
+        }
+        if (!export_chunk(lock.node(), cursor, count, chunk, next)) {
+            client->send("400 Bad Request: Invalid EXPORT cursor.\n");
+            return -1;
+        }
     }
+    std::string reply = concat({"200 OK: EXPORT ", next, " ", std::to_string(chunk.size()), "\n"});
+    reply.append(chunk);
+    client->send(std::move(reply));
     return 0;
 }
 
-int handle_print_tree(std::shared_ptr<Client> client, std::string path, std::string value) {
+// Пишет присоединенное поддерево в журнал как создание всех его записей в прямом порядке.
+static void log_subtree(const Node &subtree) {
+    struct Frame {
+        NodeChildren::const_iterator next;
+        NodeChildren::const_iterator end;
+    };
+    auto log_directory = [](const Node &node) {
+        log_change(TreeChangeKind::CreateNode, node.path);
+        for (const Leaf *leaf = node.east.get(); leaf; leaf = leaf->east.get()) {
+            log_change(TreeChangeKind::CreateLeaf, leaf->path, leaf->value);
+        }
+    };
+    if (!g_log) {
+        return;
+    }
+    log_directory(subtree);
+    std::vector<Frame> stack = {{subtree.childs.begin(), subtree.childs.end()}};
+    while (!stack.empty()) {
+        Frame &top = stack.back();
+        if (top.next == top.end) {
+            stack.pop_back();
+            continue;
+        }
+        const Node &child = **top.next++;
+        log_directory(child);
+        stack.push_back({child.childs.begin(), child.childs.end()});
+    }
+}
+
+int handle_import(const std::shared_ptr<Client> &client, std::string_view path,
+                  std::string_view value) {
+    auto &importer = client->importer();
+    if (!client->binary_replies()) {
+        client->send("400 Bad Request: IMPORT requires the binary protocol.\n");
+        return -1;
+    }
+    if (!is_entry_path(path) || (importer && importer->path() != path)) {
+        importer.reset();
+        client->send(concat({"400 Bad Request: Invalid IMPORT path ", path, ".\n"}));
+        return -1;
+    }
+    if (!value.empty()) {
+        if (!importer) {
+            importer = std::make_unique<SubtreeImporter>(std::string(path));
+        }
+        if (!importer->feed(value)) {
+            importer.reset();
+            client->send("400 Bad Request: Malformed IMPORT stream.\n");
+            return -1;
+        }
+        client->send(concat({"200 OK: IMPORT ", std::to_string(importer->entries()), "\n"}));
+        return 0;
+    }
+
+    // Пустая часть - конец потока: поддерево готово и присоединяется
+    std::unique_ptr<SubtreeImporter> finished = std::move(importer);
+    std::shared_ptr<Node> subtree = finished ? finished->finish() : nullptr;
+    if (!subtree) {
+        client->send("400 Bad Request: Incomplete IMPORT stream.\n");
+        return -1;
+    }
+    size_t entries = finished->entries();
+    bool found = false;
+    bool attached = false;
+    {
+        PathLock lock = PathLock::parent_of(g_root, path, LockMode::Exclusive);
+        if (lock.node()) {
+            found = true;
+            bool replaced = lock.node()->childs.find(name_of(path)) != nullptr;
+            attached = attach_subtree(lock.node(), subtree);
+            if (attached && replaced) {
+                log_change(TreeChangeKind::DeleteNode, path);
+            }
+            if (attached) {
+                log_subtree(*subtree);
+            }
+        }
+    }
+    if (!attached) {
+        discard_detached_subtree(subtree);
+        client->send(found ? concat({"409 Conflict: ", path, " is a leaf.\n"})
+                           : concat({"404 Not Found: Parent of ", path, " not found.\n"}));
+        return -1;
+    }
+    client->send(concat({"200 OK: Imported ", std::to_string(entries), " entries into ", path,
+                         ".\n"}));
+    return 0;
+}
+
+int handle_expire(const std::shared_ptr<Client> &client, std::string_view path,
+                  std::string_view value) {
+    uint64_t ttl_seconds;
+    if (path.empty() || !parse_ttl_seconds(value, ttl_seconds)) {
+        client->send(ttl_usage("EXPIRE path seconds"));
+        return -1;
+    }
+
+    std::string reply;
+    {
+        PathLock lock = PathLock::parent_of(g_root, path, LockMode::Exclusive);
+        remove_if_expired(path);
+        if (auto leaf = find_leaf_by_path_linear(g_root, path)) {
+            set_expiry(*leaf, unix_time_ms() + ttl_seconds * 1000);
+            reply = concat({"200 OK: Leaf ", path, " expires in ", value, " s.\n"});
+        } else {
+            reply = concat({"404 Not Found: Leaf ", path, " not found.\n"});
+        }
+    }
+    client->send(std::move(reply));
+    return 0;
+}
+
+int handle_info(const std::shared_ptr<Client> &client, std::string_view path,
+                std::string_view value) {
     (void)value;
+    if (path == "prometheus") {
+        std::string text = prometheus_text();
+        client->send(concat({"200 OK: INFO ", std::to_string(text.size()), "\n", text}));
+        return 0;
+    }
+    if (!path.empty()) {
+        client->send("400 Bad Request: Usage: INFO [prometheus].\n");
+        return -1;
+    }
+
+    std::string text = "# Memory\n";
+    EvictionStats eviction = g_eviction ? g_eviction->stats() : EvictionStats{};
+    append_info(text, "used_bytes", eviction.used_bytes);
+    append_info(text, "max_bytes", eviction.max_bytes);
+    append_info(text, "eviction_policy",
+                g_eviction ? eviction_policy_name(g_eviction->options().policy) : "");
+    append_info(text, "evicted_leaves", eviction.evicted);
+    append_info(text, "evicted_bytes", eviction.evicted_bytes);
+    append_info(text, "rejected_commands", eviction.rejected);
+
+    SubtreeStats keyspace = subtree_stats_of(*g_root);
+    append_info(text, "tree_nodes", keyspace.nodes);
+    append_info(text, "tree_leaves", keyspace.leaves);
+    append_info(text, "tree_key_value_bytes", keyspace.bytes);
+
+    text += "# Reads\n";
+    char hit_rate[32];
+    std::snprintf(hit_rate, sizeof(hit_rate), "%.4f", eviction.hit_rate());
+    append_info(text, "leaf_hits", eviction.hits);
+    append_info(text, "leaf_misses", eviction.misses);
+    append_info(text, "hit_rate", hit_rate);
+
+    text += "# Expiry\n";
+    ExpiryStats expiry = g_expiry ? g_expiry->stats() : ExpiryStats{};
+    append_info(text, "expiry_scheduled", expiry.scheduled);
+    append_info(text, "expiry_expired", expiry.expired);
+    append_info(text, "expiry_skipped", expiry.skipped);
+    append_info(text, "expiry_hidden_reads", expiry.hidden_on_read);
+    append_info(text, "expiry_pending", expiry.pending);
+    append_info(text, "expiry_sweeps", expiry.sweeps);
+    append_info(text, "expiry_sweep_us_total", expiry.sweep_us_total);
+    append_info(text, "expiry_sweep_us_max", expiry.sweep_us_max);
+
+    append_metrics_info(text, collect_metrics());
+
+    client->send(concat({"200 OK: INFO ", std::to_string(text.size()), "\n", text}));
+    return 0;
+}
+
+// Итоги каталога path для COUNT и MEMORY; при ошибке отвечает клиенту сам.
+static bool read_subtree_stats(const std::shared_ptr<Client> &client, std::string_view verb,
+                               std::string_view path, SubtreeStats &stats) {
     if (path.empty()) {
-        client->send("400 Bad Request: Path is required for PRINT_TREE.\n");
+        client->send(concat({"400 Bad Request: Usage: ", verb, " path.\n"}));
+        return false;
+    }
+    // Итоги атомарны, а узел держит shared_ptr: блокировка каталога не нужна
+    auto node = find_node_by_path_linear(g_root, path);
+    if (!node) {
+        client->send(concat({"404 Not Found: Node ", path, " not found.\n"}));
+        return false;
+    }
+    stats = subtree_stats_of(*node);
+    return true;
+}
+
+int handle_count(const std::shared_ptr<Client> &client, std::string_view path,
+                 std::string_view value) {
+    (void)value;
+    SubtreeStats stats;
+    if (!read_subtree_stats(client, "COUNT", path, stats)) {
         return -1;
     }
+    client->send(concat({"200 OK: COUNT ", std::to_string(stats.nodes), " ",
+                         std::to_string(stats.leaves), "\n"}));
+    return 0;
+}
 
-    // Блокируем мьютекс на время чтения из дерева для потокобезопасности
-    std::lock_guard<std::mutex> lock(g_tree_mutex);
-    if (auto node = find_node_by_path_linear(g_root, path)) {
-        client->send("200 OK\n" + print_tree_string(node));
-    } else {
-        client->send("404 Not Found: Node " + path + " not found.\n");
+int handle_memory(const std::shared_ptr<Client> &client, std::string_view path,
+                  std::string_view value) {
+    (void)value;
+    SubtreeStats stats;
+    if (!read_subtree_stats(client, "MEMORY", path, stats)) {
+        return -1;
     }
+    client->send(concat({"200 OK: MEMORY ", std::to_string(stats.bytes), "\n"}));
     return 0;
 }
 
-std::vector<CommandHandler> commands_handlers = {{"hello", handle_hello},
-                                                 {"CREATE_NODE", handle_create_node},
-                                                 {"CREATE_LEAF", handle_create_leaf},
-                                                 {"DELETE_NODE", handle_delete_node},
-                                                 {"DELETE_LEAF", handle_delete_leaf},
-                                                 {"PRINT_TREE", handle_print_tree}};
+std::vector<CommandHandler> commands_handlers = {{Opcode::Hello, handle_hello},
+                                                 {Opcode::CreateNode, handle_create_node},
+                                                 {Opcode::CreateLeaf, handle_create_leaf},
+                                                 {Opcode::DeleteNode, handle_delete_node},
+                                                 {Opcode::DeleteLeaf, handle_delete_leaf},
+                                                 {Opcode::PrintTree, handle_print_tree},
+                                                 {Opcode::GetLeaf, handle_get_leaf},
+                                                 {Opcode::SetLeaf, handle_set_leaf},
+                                                 {Opcode::MGet, handle_mget},
+                                                 {Opcode::MSet, handle_mset},
+                                                 {Opcode::MDel, handle_mdel},
+                                                 {Opcode::Multi, handle_multi},
+                                                 {Opcode::Exec, handle_exec},
+                                                 {Opcode::Discard, handle_discard},
+                                                 {Opcode::Snapshot, handle_snapshot},
+                                                 {Opcode::Scan, handle_scan},
+                                                 {Opcode::Export, handle_export},
+                                                 {Opcode::Import, handle_import},
+                                                 {Opcode::Expire, handle_expire},
+                                                 {Opcode::Info, handle_info},
+                                                 {Opcode::Count, handle_count},
+                                                 {Opcode::Memory, handle_memory},
+                                                 {Opcode::CreateLeafEx, handle_create_leaf_ex}};
 
 int main(int argc, char const *argv[]) {
-    (void)argc;
-    (void)argv;
+    ServerOptions options;
+    if (!parse_server_options(argc, argv, options)) {
+        return -1;
+    }
+    if (!log_init(options.log_level, options.log_file)) {
+        return -1;
+    }
 
     g_root = create_root_node();
-    std::cout << "Data tree initialized." << std::endl;
+    LOG_INFO("Data tree initialized.");
+
+    // Дерево восстанавливается из журнала до того, как сервер начнет принимать клиентов
+    size_t replayed = 0;
+    if (!options.aof.path.empty()) {
+        g_log = std::make_unique<MutationLog>(options.aof);
+        if (!g_log->open(g_root, &replayed)) {
+            log_shutdown();
+            return -1;
+        }
+        LOG_INFO("Replayed ", replayed, " records from ", options.aof.path);
+    }
 
-    // Демонстрационное наполнение дерева
-    create_node_by_path(g_root, "/Users");
-    create_leaf_by_path(g_root, "/Users/readme", "This is a user directory.");
+    // Без журнала (или с пустым журналом) дерево загружается из последнего образа
+    size_t loaded = 0;
+    g_snapshot_path = options.snapshot_path;
+    if (replayed == 0 && !g_snapshot_path.empty() && std::filesystem::exists(g_snapshot_path)) {
+        auto start = std::chrono::steady_clock::now();
+        if (!load_snapshot(g_root, g_snapshot_path, &loaded)) {
+            log_shutdown();
+            return -1;
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        LOG_INFO("Loaded ", loaded, " entries from ", g_snapshot_path, " in ", elapsed.count(),
+                 " ms");
+        // Журнал должен начинаться с загруженного состояния, иначе следующий запуск его потеряет
+        if (g_log && loaded > 0 && !g_log->rewrite()) {
+            log_shutdown();
+            return -1;
+        }
+    }
 
-    int sock_fd = init_server();
-    if (sock_fd < 0) {
-        std::cerr << "Failed to init server" << std::endl;
-        return -1;
+    // Таймеры TTL для листьев из журнала или образа; истекшие за время простоя удалятся на
+    // первом тике
+    g_expiry = std::make_unique<LeafExpiry>(g_root, ExpiryOptions{}, log_removed_leaf);
+    g_eviction = std::make_unique<LeafEviction>(g_root, options.eviction, log_removed_leaf);
+    if (options.eviction.max_bytes != 0) {
+        LOG_INFO("Memory limit ", options.eviction.max_bytes, " bytes, policy ",
+                 eviction_policy_name(options.eviction.policy), ", tree uses ",
+                 g_eviction->used_bytes(), " bytes");
     }
-    while (true) {
-        accept_connection(sock_fd);
+    g_expiry->schedule_tree();
+    g_expiry->start();
+    if (!options.metrics_file.empty()) {
+        start_metrics_dump(options.metrics_file, options.metrics_interval);
+        LOG_INFO("Writing metrics to ", options.metrics_file, " every ",
+                 options.metrics_interval, " s");
     }
 
-    std::cout << "Server stopped" << std::endl;
-    close(sock_fd);
+    // Демонстрационное наполнение нового дерева (попадает в журнал, как обычные команды)
+    if (replayed == 0 && loaded == 0) {
+        run_create_node("/Users", "");
+        run_create_leaf("/Users/readme", "This is a user directory.");
+        sync_mutation_log();
+    }
+
+    std::vector<int> listen_fds;
+    for (size_t i = 0; i < options.workers; ++i) {
+        int sock_fd = init_server(options);
+        if (sock_fd < 0) {
+            LOG_ERROR("Failed to init server");
+            log_shutdown();
+            return -1;
+        }
+        listen_fds.push_back(sock_fd);
+    }
+
+    if (options.mode == ServerMode::Epoll) {
+        run_event_loops(listen_fds);
+    } else {
+        ConnectionPool pool(options.pool_threads, options.pool_queue,
+                            std::chrono::seconds(options.pool_queue_timeout));
+        std::vector<std::thread> acceptors;
+        for (size_t i = 1; i < listen_fds.size(); ++i) {
+            acceptors.emplace_back([fd = listen_fds[i], &pool] {
+                while (true) {
+                    accept_connection(fd, pool);
+                }
+            });
+        }
+        while (true) {
+            accept_connection(listen_fds[0], pool);
+        }
+    }
+
+    LOG_INFO("Server stopped");
+    for (int sock_fd : listen_fds) {
+        close(sock_fd);
+    }
+    g_expiry.reset();  // Удаления по TTL и вытеснения пишутся в журнал, поэтому до него
+    g_eviction.reset();
+    g_log.reset();  // Дописывает буфер журнала изменений
+    log_shutdown();
     return 0;
 }
 
@@ -0,0 +1,261 @@
+#include "snapshot.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "binaryFile.hpp"
+#include "logger.hpp"
+#include "pathLock.hpp"
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+constexpr size_t kWriteChunk = 1024 * 1024;
+
+// Буферизованная запись тела образа с подсчетом crc32.
+struct s_snapshot_output {
+    int fd;
+    std::string buffer;
+    uint32_t crc = 0;
+    bool ok = true;
+
+    void flush() {
+        crc = crc32_update(crc, buffer);
+        ok = ok && write_all(fd, buffer);
+        buffer.clear();
+    }
+
+    void put_count(uint64_t value) { append_varint(buffer, value); }
+
+    void put_string(std::string_view text) {
+        append_varint(buffer, text.size());
+        buffer.append(text);
+        if (buffer.size() >= kWriteChunk) {
+            flush();
+        }
+    }
+};
+
+using SnapshotOutput = struct s_snapshot_output;
+
+// Листья каталога и число его подкаталогов; сами подкаталоги пишет вызывающий.
+void put_directory(SnapshotOutput &out, const Node &node) {
+    out.put_count(node.leaf_by_name.size());
+    for (const Leaf *leaf = node.east.get(); leaf; leaf = leaf->east.get()) {
+        out.put_string(name_of(leaf->path));
+        out.put_string(leaf->value);
+        out.put_count(leaf->expires_at);
+    }
+    out.put_count(node.childs.size());
+}
+
+// Обход без рекурсии, чтобы глубокие деревья не переполняли стек.
+void put_tree(SnapshotOutput &out, const Node &root) {
+    struct Frame {
+        NodeChildren::const_iterator next;
+        NodeChildren::const_iterator end;
+    };
+    put_directory(out, root);
+    std::vector<Frame> stack = {{root.childs.begin(), root.childs.end()}};
+    while (!stack.empty()) {
+        Frame &top = stack.back();
+        if (top.next == top.end) {
+            stack.pop_back();
+            continue;
+        }
+        const Node &child = **top.next++;
+        out.put_string(name_of(child.path));
+        put_directory(out, child);
+        stack.push_back({child.childs.begin(), child.childs.end()});
+    }
+}
+
+struct s_snapshot_input {
+    std::string_view data;
+    size_t position = 0;
+
+    bool get_count(uint64_t &value) { return read_varint(data, position, value); }
+
+    bool get_string(std::string_view &text) {
+        uint64_t length;
+        if (!get_count(length) || data.size() - position < length) {
+            return false;
+        }
+        text = data.substr(position, length);
+        position += length;
+        return true;
+    }
+};
+
+using SnapshotInput = struct s_snapshot_input;
+
+// Читает листья каталога node и число его подкаталогов.
+bool get_directory(SnapshotInput &in, const std::shared_ptr<Node> &node, uint64_t &children,
+                   size_t &entries) {
+    uint64_t leaves;
+    if (!in.get_count(leaves) || leaves > in.data.size()) {
+        return false;
+    }
+    node->leaf_by_name.reserve(leaves);
+    for (uint64_t i = 0; i < leaves; ++i) {
+        std::string_view name;
+        std::string_view value;
+        uint64_t expires_at;
+        if (!in.get_string(name) || !in.get_string(value) || !in.get_count(expires_at) ||
+            name.empty()) {
+            return false;
+        }
+        auto leaf = create_leaf(node, child_path_of(node->path, name), std::string(value));
+        if (!leaf) {
+            return false;
+        }
+        leaf->expires_at = expires_at;
+    }
+    entries += leaves;
+    return in.get_count(children);
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+bool write_snapshot(const std::shared_ptr<Node> &root, const std::string &path) {
+    std::string temp_path = path + ".tmp";
+    int fd = open(temp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+
+    SnapshotOutput out;
+    out.fd = fd;
+    out.buffer.reserve(kWriteChunk + 64 * 1024);
+    bool ok = write_all(fd, kSnapshotMagic);
+    out.put_count(root->index ? root->index->entries.size() : 0);  // Для reserve() индекса
+    put_tree(out, *root);
+    out.flush();
+
+    std::string trailer;
+    append_u32(trailer, out.crc);
+    ok = ok && out.ok && write_all(fd, trailer) && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok && std::rename(temp_path.c_str(), path.c_str()) == 0;
+    if (!ok) {
+        unlink(temp_path.c_str());
+        return false;
+    }
+    sync_parent_directory(path);
+    return true;
+}
+
+bool load_snapshot(const std::shared_ptr<Node> &root, const std::string &path, size_t *entries) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    std::string data;
+    struct stat info;
+    if (fd >= 0 && fstat(fd, &info) == 0) {
+        data.reserve(static_cast<size_t>(info.st_size));
+    }
+    bool read_ok = fd >= 0 && read_all(fd, data);
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (!read_ok) {
+        LOG_ERROR("Failed to read snapshot '", path, "': ", strerror(errno));
+        return false;
+    }
+
+    size_t header = kSnapshotMagic.size();
+    if (data.size() < header + 4 || !std::string_view(data).starts_with(kSnapshotMagic)) {
+        LOG_ERROR("'", path, "' is not a snapshot");
+        return false;
+    }
+    std::string_view body = std::string_view(data).substr(header, data.size() - header - 4);
+    if (crc32(body) != read_u32(data.data() + data.size() - 4)) {
+        LOG_ERROR("Snapshot '", path, "' is corrupted: checksum mismatch");
+        return false;
+    }
+
+    struct Frame {
+        std::shared_ptr<Node> node;
+        uint64_t children;  // Еще не прочитанные подкаталоги
+    };
+    SnapshotInput in{body};
+    uint64_t hint;
+    uint64_t children;
+    size_t count = 0;
+    if (!in.get_count(hint)) {
+        LOG_ERROR("Snapshot '", path, "' is corrupted");
+        return false;
+    }
+    if (root->index && hint <= body.size()) {
+        root->index->entries.reserve(hint);
+    }
+    if (!get_directory(in, root, children, count)) {
+        LOG_ERROR("Snapshot '", path, "' is corrupted");
+        return false;
+    }
+
+    std::vector<Frame> stack = {{root, children}};
+    while (!stack.empty()) {
+        if (stack.back().children == 0) {
+            stack.pop_back();
+            continue;
+        }
+        --stack.back().children;
+        const std::shared_ptr<Node> &parent = stack.back().node;
+        std::string_view name;
+        if (!in.get_string(name) || name.empty()) {
+            LOG_ERROR("Snapshot '", path, "' is corrupted");
+            return false;
+        }
+        auto node = create_node(parent, child_path_of(parent->path, name));
+        ++count;
+        if (!get_directory(in, node, children, count)) {
+            LOG_ERROR("Snapshot '", path, "' is corrupted");
+            return false;
+        }
+        stack.push_back({std::move(node), children});
+    }
+    if (in.position != body.size()) {
+        LOG_ERROR("Snapshot '", path, "' has trailing data");
+        return false;
+    }
+    if (entries) {
+        *entries = count;
+    }
+    return true;
+}
+
+pid_t fork_snapshot(const std::shared_ptr<Node> &root, const std::string &path) {
+    // S на корне ждет завершения начатых изменений: копия дерева в дочернем процессе целостна
+    PathLock lock(root, "/", LockMode::Shared);
+    pid_t pid = fork();
+    if (pid == 0) {
+        // В дочернем процессе только этот поток: блокировки дерева не нужны, а снимать их нельзя
+        // (их мьютексы могли быть захвачены другими потоками в момент fork), поэтому _exit()
+        // без деструкторов. Сокеты клиентов закрываются, чтобы отключение клиента не ждало конца
+        // записи образа. Журнал сервера в дочернем процессе не выводится.
+        close_range(3, ~0U, 0);
+        _exit(write_snapshot(root, path) ? 0 : 1);
+    }
+    if (pid < 0) {
+        LOG_ERROR("fork() for snapshot failed: ", strerror(errno));
+    }
+    return pid;
+}
+
+bool wait_snapshot(pid_t pid) {
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0) {
+        if (errno != EINTR) {
+            return false;
+        }
+    }
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
@@ -0,0 +1,176 @@
+#include "subtreeStream.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "binaryFile.hpp"
+#include "scan.hpp"
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+constexpr char kNodeRecord = 'D';
+constexpr char kLeafRecord = 'L';
+constexpr size_t kMaxVarintBytes = 10;
+
+// Глубина записи path относительно корня поддерева root_path (дети корня - 1).
+uint64_t depth_of(std::string_view root_path, std::string_view path) {
+    size_t prefix = root_path == "/" ? 0 : root_path.size();
+    std::string_view rest = path.substr(prefix + 1);
+    return static_cast<uint64_t>(std::count(rest.begin(), rest.end(), '/')) + 1;
+}
+
+void put_string(std::string &out, std::string_view text) {
+    append_varint(out, text.size());
+    out.append(text);
+}
+
+// Результат разбора поля: данные кончились раньше поля или поле некорректно.
+enum class Field { Ok, Incomplete, Corrupt };
+
+Field get_count(std::string_view data, size_t &position, uint64_t &value) {
+    size_t start = position;
+    if (read_varint(data, position, value)) {
+        return Field::Ok;
+    }
+    return data.size() - start < kMaxVarintBytes ? Field::Incomplete : Field::Corrupt;
+}
+
+Field get_string(std::string_view data, size_t &position, std::string_view &text) {
+    uint64_t length;
+    Field field = get_count(data, position, length);
+    if (field != Field::Ok) {
+        return field;
+    }
+    if (data.size() - position < length) {
+        return Field::Incomplete;
+    }
+    text = data.substr(position, length);
+    position += length;
+    return Field::Ok;
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+bool export_chunk(const std::shared_ptr<Node> &dir, std::string_view cursor, size_t count,
+                  std::string &out, std::string &next) {
+    std::vector<ScanEntry> page;
+    if (!scan_subtree(dir, cursor, count, page, next)) {
+        return false;
+    }
+    if (cursor == kScanStart) {
+        out.append(kSubtreeStreamMagic);
+    }
+    for (const auto &entry : page) {
+        std::string_view path = entry.leaf ? std::string_view(entry.leaf->path)
+                                           : std::string_view(entry.node->path);
+        out.push_back(entry.leaf ? kLeafRecord : kNodeRecord);
+        append_varint(out, depth_of(dir->path, path));
+        put_string(out, name_of(path));
+        if (entry.leaf) {
+            put_string(out, entry.leaf->value);
+        }
+    }
+    return true;
+}
+
+SubtreeImporter::SubtreeImporter(std::string path) : path_(std::move(path)) {}
+
+SubtreeImporter::~SubtreeImporter() { discard_detached_subtree(root_); }
+
+bool SubtreeImporter::feed(std::string_view bytes) {
+    if (failed_) {
+        return false;
+    }
+    // Неполная запись прошлой части склеивается с новой, остальное разбирается без копирования
+    std::string_view data = bytes;
+    if (!pending_.empty()) {
+        pending_.append(bytes);
+        data = pending_;
+    }
+
+    size_t position = 0;
+    if (!header_) {
+        size_t available = std::min(data.size(), kSubtreeStreamMagic.size());
+        if (data.substr(0, available) != kSubtreeStreamMagic.substr(0, available)) {
+            failed_ = true;
+            return false;
+        }
+        if (available == kSubtreeStreamMagic.size()) {
+            header_ = true;
+            position = available;
+            root_ = create_detached_node(path_);
+            stack_ = {root_};
+        }
+    }
+    while (header_ && position < data.size()) {
+        size_t used = parse_record(data.substr(position));
+        if (used == std::string_view::npos) {
+            failed_ = true;
+            pending_.clear();
+            stack_.clear();
+            discard_detached_subtree(std::exchange(root_, nullptr));
+            return false;
+        }
+        if (used == 0) {
+            break;
+        }
+        position += used;
+    }
+
+    std::string rest(data.substr(position));
+    pending_ = std::move(rest);
+    return true;
+}
+
+size_t SubtreeImporter::parse_record(std::string_view data) {
+    constexpr size_t kCorrupt = std::string_view::npos;
+    char kind = data[0];
+    if (kind != kNodeRecord && kind != kLeafRecord) {
+        return kCorrupt;
+    }
+    size_t position = 1;
+    uint64_t depth;
+    std::string_view name;
+    std::string_view value;
+    Field field = get_count(data, position, depth);
+    if (field == Field::Ok) {
+        field = get_string(data, position, name);
+    }
+    if (field == Field::Ok && kind == kLeafRecord) {
+        field = get_string(data, position, value);
+    }
+    if (field != Field::Ok) {
+        return field == Field::Incomplete ? 0 : kCorrupt;
+    }
+
+    // Родитель - последний каталог глубины depth - 1; имя не должно повторяться в каталоге
+    if (depth == 0 || depth > stack_.size() || name.empty() ||
+        name.find('/') != std::string_view::npos) {
+        return kCorrupt;
+    }
+    const std::shared_ptr<Node> &parent = stack_[depth - 1];
+    if (parent->leaf_by_name.count(name) || parent->childs.find(name)) {
+        return kCorrupt;
+    }
+    if (kind == kLeafRecord) {
+        create_leaf(parent, child_path_of(parent->path, name), std::string(value));
+    } else {
+        auto node = create_node(parent, child_path_of(parent->path, name));
+        stack_.resize(depth);
+        stack_.push_back(std::move(node));
+    }
+    ++entries_;
+    return position;
+}
+
+std::shared_ptr<Node> SubtreeImporter::finish() {
+    if (failed_ || !header_ || !pending_.empty()) {
+        return nullptr;
+    }
+    stack_.clear();
+    return std::move(root_);
+}
@@ -0,0 +1,117 @@
+#include "transaction.hpp"
+
+#include <map>
+
+#include "expiry.hpp"
+
+/*-------------------------------------------HELPER_FUNCTION---------------------------------------------------*/
+
+namespace {
+
+enum class EntryState : unsigned char { Absent, Node, Leaf };
+
+// Дерево с изменениями, проверенными в этой транзакции.
+class ChangeOverlay {
+   public:
+    explicit ChangeOverlay(const std::shared_ptr<Node> &root) : root_(root) {}
+
+    EntryState state(std::string_view path) const {
+        if (path == "/") {
+            return EntryState::Node;
+        }
+        if (auto it = changed_.find(path); it != changed_.end()) {
+            return it->second;
+        }
+        // Предок уже создан или удален транзакцией: прежнего содержимого под ним нет
+        for (auto dir = parent_path_of(path); dir != "/"; dir = parent_path_of(dir)) {
+            if (changed_.count(dir)) {
+                return EntryState::Absent;
+            }
+        }
+        if (find_node_by_path_linear(root_, path)) {
+            return EntryState::Node;
+        }
+        // Истекший лист, еще не удаленный колесом TTL, команды удаляют перед созданием записи
+        auto leaf = find_leaf_by_path_linear(root_, path);
+        return leaf && !leaf_expired(*leaf, now_ms_) ? EntryState::Leaf : EntryState::Absent;
+    }
+
+    void set(std::string_view path, EntryState state) { changed_[path] = state; }
+
+    // Удаляет каталог вместе с изменениями внутри него.
+    void remove_subtree(std::string_view path) {
+        auto it = changed_.upper_bound(path);
+        while (it != changed_.end() && it->first.starts_with(path)) {
+            if (it->first[path.size()] == '/') {
+                it = changed_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        changed_[path] = EntryState::Absent;
+    }
+
+   private:
+    const std::shared_ptr<Node> &root_;
+    uint64_t now_ms_ = unix_time_ms();
+    std::map<std::string_view, EntryState> changed_;
+};
+
+bool is_entry_path(std::string_view path) {
+    return path.size() > 1 && path.front() == '/' && path.back() != '/';
+}
+
+bool apply_change(ChangeOverlay &overlay, const TreeChange &change) {
+    if (!is_entry_path(change.path)) {
+        return false;
+    }
+    EntryState current = overlay.state(change.path);
+    switch (change.kind) {
+        case TreeChangeKind::CreateNode:
+        case TreeChangeKind::CreateLeaf:
+            if (current != EntryState::Absent ||
+                overlay.state(parent_path_of(change.path)) != EntryState::Node) {
+                return false;
+            }
+            overlay.set(change.path, change.kind == TreeChangeKind::CreateNode ? EntryState::Node
+                                                                                : EntryState::Leaf);
+            return true;
+        case TreeChangeKind::SetLeaf:
+            if (current == EntryState::Node ||
+                overlay.state(parent_path_of(change.path)) != EntryState::Node) {
+                return false;
+            }
+            overlay.set(change.path, EntryState::Leaf);
+            return true;
+        case TreeChangeKind::DeleteNode:
+            if (current != EntryState::Node) {
+                return false;
+            }
+            overlay.remove_subtree(change.path);
+            return true;
+        case TreeChangeKind::DeleteLeaf:
+            if (current != EntryState::Leaf) {
+                return false;
+            }
+            overlay.set(change.path, EntryState::Absent);
+            return true;
+        case TreeChangeKind::ExpireLeaf:
+            return current == EntryState::Leaf;
+    }
+    return false;
+}
+
+}  // namespace
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+size_t find_failing_change(const std::shared_ptr<Node> &root,
+                           const std::vector<TreeChange> &changes) {
+    ChangeOverlay overlay(root);
+    for (size_t i = 0; i < changes.size(); ++i) {
+        if (!apply_change(overlay, changes[i])) {
+            return i;
+        }
+    }
+    return changes.size();
+}
@@ -1,5 +1,7 @@
 #include "tree.hpp"
 
+#include "logger.hpp"
+
 void print_tree_helper(const std::shared_ptr<Node> &node, int indent) {
     if (!node) {
         return;
@@ -12,18 +14,19 @@ void print_tree_helper(const std::shared_ptr<Node> &node, int indent) {
 
     // Рекурсивно вызываем для дочерних узлов и листьев, увеличивая отступ
 
-    for (auto child : node->childs) {
+    // Обход не владеет записями: ссылки и сырые указатели не трогают счетчики shared_ptr.
+    for (const auto &child : node->childs) {
         print_tree_helper(child, indent + 1);
     }
 
-    auto current_leaf = node->east;
+    const Leaf *current_leaf = node->east.get();
     while (current_leaf) {
         for (int i = 0; i < indent + 1; ++i) {
             std::cout << "  ";
         }
         std::cout << "🍃 " << current_leaf->path << " (value: '" << current_leaf->value << "')"
                   << std::endl;
-        current_leaf = current_leaf->east;
+        current_leaf = current_leaf->east.get();
     }
 }
 
@@ -43,45 +46,230 @@ static void print_tree_recursive(std::stringstream &ss, const std::shared_ptr<No
     }
 
     // Итерируемся по листьям текущего узла
-    auto current_leaf = node->east;
+    const Leaf *current_leaf = node->east.get();
     while (current_leaf) {
         ss << std::string((indent + 1) * 2, ' ') << "🍃 " << current_leaf->path << " (value: '"
            << current_leaf->value << "')\n";
-        current_leaf = current_leaf->east;
+        current_leaf = current_leaf->east.get();
     }
 }
 
-// Рекурсивная вспомогательная функция для поиска узла по полному пути.
-static std::shared_ptr<Node> find_node_recursive(const std::shared_ptr<Node> &current_node,
-                                                 const std::string &path) {
-    if (!current_node) {
+// Проверяет, что путь лежит внутри поддерева с корнем в узле root (или совпадает с ним).
+static bool is_in_subtree(const std::shared_ptr<Node> &root, std::string_view path) {
+    std::string_view prefix = root->path;
+    if (prefix == "/") {
+        return true;
+    }
+    if (path.size() < prefix.size() || path.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    return path.size() == prefix.size() || path[prefix.size()] == '/';
+}
+
+// Поиск записи в индексе путей дерева. Запись копируется под разделяемой блокировкой индекса,
+// потому что параллельные писатели в других поддеревьях могут менять таблицу.
+static std::optional<IndexEntry> find_index_entry(const std::shared_ptr<Node> &root,
+                                                  std::string_view path) {
+    if (!root->index) {
+        return std::nullopt;
+    }
+    std::shared_lock<TreeRwLock> lock(root->index->lock);
+    auto it = root->index->entries.find(path);
+    if (it == root->index->entries.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+// Поиск узла по полному пути внутри поддерева root за O(1) через индекс путей.
+static std::shared_ptr<Node> find_node_in_index(const std::shared_ptr<Node> &root,
+                                                std::string_view path) {
+    if (path == root->path) {
+        return root;
+    }
+    if (!is_in_subtree(root, path)) {
         return nullptr;
     }
 
-    // 1. Проверяем, является ли текущий узел искомым.
-    if (current_node->path == path) {
-        return current_node;
+    auto entry = find_index_entry(root, path);
+    if (!entry || !std::holds_alternative<std::weak_ptr<Node>>(*entry)) {
+        return nullptr;
     }
+    return std::get<std::weak_ptr<Node>>(*entry).lock();
+}
 
-    // 2. Если нет, рекурсивно ищем во всех дочерних узлах.
-    for (const auto &child : current_node->childs) {
-        auto found = find_node_recursive(child, path);
-        if (found) {
-            // Если нашли в дочернем поддереве, возвращаем результат.
-            return found;
-        }
+// Записей, переносимых attach_subtree в общий индекс за одно взятие его блокировки.
+static constexpr size_t kAttachIndexBatch = 4096;
+
+// Возвращает владеющий указатель на лист: его хранит либо предыдущий лист, либо сам каталог.
+static const std::shared_ptr<Leaf> &owning_ptr_of(const Node &parent, const Leaf *leaf) {
+    return leaf->west ? leaf->west->east : parent.east;
+}
+
+// Номер создания новой записи каталога parent. Записи одного каталога создаются под его
+// X-блокировкой, поэтому в списках каталога номера возрастают.
+static uint64_t next_entry_seq(const Node &parent) {
+    return parent.index ? parent.index->next_seq.fetch_add(1, std::memory_order_relaxed) : 0;
+}
+
+// Блок управления allocate_shared: два счетчика ссылок и указатель на таблицу виртуальных функций.
+static constexpr size_t kSharedControlBytes = 2 * sizeof(long) + sizeof(void *);
+
+// Элемент хеш-таблицы сверх пары ключ-значение: указатель на следующий, хеш и доля корзины.
+static constexpr size_t kMapNodeBytes = 3 * sizeof(void *);
+
+// Буфер строки вне самого объекта; короткая строка хранится внутри объекта.
+static size_t heap_bytes_of(const tree_string &text) {
+    static const size_t inline_capacity = tree_string().capacity();
+    return text.capacity() > inline_capacity ? text.capacity() + 1 : 0;
+}
+
+static void add_bytes(PathIndex *index, size_t bytes) {
+    if (index) {
+        index->bytes.fetch_add(bytes, std::memory_order_relaxed);
     }
+}
+
+static void remove_bytes(PathIndex *index, size_t bytes) {
+    if (index) {
+        index->bytes.fetch_sub(bytes, std::memory_order_relaxed);
+    }
+}
+
+// Прибавляет к счетчику, если изменение не нулевое: у корня его меняют все писатели дерева.
+static void add_to_counter(std::atomic<uint64_t> &counter, int64_t delta) {
+    if (delta != 0) {
+        // Отрицательное изменение прибавляется в дополнительном коде
+        counter.fetch_add(static_cast<uint64_t>(delta), std::memory_order_relaxed);
+    }
+}
+
+// Прибавляет изменение итогов к каталогу parent и всем его предкам. Предки живы: их держит
+// цепочка владения от корня, а удалить их не дают IX-блокировки пишущего. Обход по parent_raw:
+// weak_ptr::lock на каждом уровне стоил бы еще двух атомарных операций.
+static void add_to_totals(const std::shared_ptr<Node> &parent, int64_t nodes, int64_t leaves,
+                          int64_t bytes) {
+    for (Node *node = parent.get(); node; node = node->parent_raw) {
+        add_to_counter(node->total_nodes, nodes);
+        add_to_counter(node->total_leaves, leaves);
+        add_to_counter(node->total_bytes, bytes);
+    }
+}
 
-    // 3. Если не нашли ни в текущем узле, ни в его поддеревьях.
-    return nullptr;
+static int64_t entry_bytes_of(const Leaf &leaf) {
+    return static_cast<int64_t>(leaf.path.size() + leaf.value.size());
+}
+
+// Прибавляет к предкам (sign = 1) или вычитает из них (sign = -1) поддерево node целиком.
+static void add_subtree_to_totals(const std::shared_ptr<Node> &parent, const Node &node,
+                                  int64_t sign) {
+    SubtreeStats stats = subtree_stats_of(node);
+    add_to_totals(parent, sign * static_cast<int64_t>(stats.nodes + 1),
+                  sign * static_cast<int64_t>(stats.leaves),
+                  sign * static_cast<int64_t>(stats.bytes + node.path.size()));
+}
+
+static std::shared_ptr<Node> parent_node_of(const Leaf &leaf) {
+    return std::holds_alternative<std::weak_ptr<Node>>(leaf.parent)
+               ? std::get<std::weak_ptr<Node>>(leaf.parent).lock()
+               : nullptr;
+}
+
+// Перезаписывает значение существующего листа на месте; TTL снимается.
+static void assign_leaf_value(const std::shared_ptr<Node> &parent, Leaf &leaf,
+                              std::string_view value) {
+    size_t before = footprint_of(leaf);
+    int64_t before_bytes = entry_bytes_of(leaf);
+    // assign не освобождает буфер, если новое значение в него помещается
+    leaf.value.assign(value.data(), value.size());
+    leaf.expires_at = 0;
+    PathIndex *index = parent ? parent->index.get() : nullptr;
+    add_bytes(index, footprint_of(leaf));
+    remove_bytes(index, before);
+    if (entry_bytes_of(leaf) != before_bytes) {
+        add_to_totals(parent, 0, 0, entry_bytes_of(leaf) - before_bytes);
+    }
+}
+
+// Рекурсивно удаляет из индекса все узлы и листья поддерева и разрывает связи между листьями,
+// иначе пары west/east держат друг друга и память не освобождается.
+static void unindex_subtree(PathIndex &index, const std::shared_ptr<Node> &node) {
+    index.entries.erase(node->path);
+    remove_bytes(&index, footprint_of(*node));
+
+    for (const auto &child : node->childs) {
+        unindex_subtree(index, child);
+    }
+
+    node->leaf_by_name.clear();
+    node->last_leaf = nullptr;
+    auto current_leaf = std::move(node->east);
+    while (current_leaf) {
+        index.entries.erase(current_leaf->path);
+        remove_bytes(&index, footprint_of(*current_leaf));
+        auto next_leaf = std::move(current_leaf->east);
+        current_leaf->west.reset();
+        current_leaf = std::move(next_leaf);
+    }
 }
 
 /*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
 
+size_t footprint_of(const Leaf &leaf) {
+    return sizeof(Leaf) + kSharedControlBytes + heap_bytes_of(leaf.path) +
+           heap_bytes_of(leaf.value) + sizeof(std::pair<const std::string_view, IndexEntry>) +
+           sizeof(std::pair<const std::string_view, Leaf *>) + 2 * kMapNodeBytes;
+}
+
+size_t footprint_of(const Node &node) {
+    // Элемент списка детей родителя - shared_ptr и два указателя, плюс таблица имен детей
+    return sizeof(Node) + kSharedControlBytes + heap_bytes_of(node.path) +
+           sizeof(std::pair<const std::string_view, IndexEntry>) + sizeof(std::shared_ptr<Node>) +
+           2 * sizeof(void *) + sizeof(std::pair<const std::string_view, void *>) +
+           2 * kMapNodeBytes;
+}
+
+SubtreeStats subtree_stats_of(const Node &node) {
+    SubtreeStats stats;
+    stats.nodes = node.total_nodes.load(std::memory_order_relaxed);
+    stats.leaves = node.total_leaves.load(std::memory_order_relaxed);
+    stats.bytes = node.total_bytes.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void NodeChildren::push_back(std::shared_ptr<s_node> node) {
+    std::string_view name = name_of(node->path);
+    list_.push_back(std::move(node));
+    by_name_.emplace(name, std::prev(list_.end()));
+}
+
+std::shared_ptr<s_node> NodeChildren::find(std::string_view name) const {
+    auto it = by_name_.find(name);
+    return it == by_name_.end() ? nullptr : *it->second;
+}
+
+NodeChildren::const_iterator NodeChildren::position_of(std::string_view name) const {
+    auto it = by_name_.find(name);
+    return it == by_name_.end() ? list_.end() : const_iterator(it->second);
+}
+
+bool NodeChildren::erase(std::string_view name) {
+    auto it = by_name_.find(name);
+    if (it == by_name_.end()) {
+        return false;
+    }
+    // Сначала убираем ключ: он ссылается на path удаляемого узла.
+    auto position = it->second;
+    by_name_.erase(it);
+    list_.erase(position);
+    return true;
+}
+
 std::shared_ptr<Node> create_root_node() {
-    auto root = std::make_shared<Node>();
+    auto root = make_tree_shared<Node>();
     root->tag = Tag::Root | Tag::Node;
-    root->path = "/";
+    root->path.assign(1, '/');
+    root->index = make_tree_shared<PathIndex>();
     // Дочерние указатели по умолчанию равны nullptr в std::shared_ptr
     return root;
 }
@@ -90,25 +278,30 @@ std::shared_ptr<Node> create_node(const std::shared_ptr<Node> &parent, std::stri
     assert(parent != nullptr && "Parent node cannot be null");
     assert(!path.empty() && "Node path cannot be empty");
 
-    auto new_node = std::make_shared<Node>();
+    auto new_node = make_tree_shared<Node>();
     new_node->tag = Tag::Node;
-    new_node->path = std::move(path);
+    new_node->seq = next_entry_seq(*parent);
+    assign_tree_string(new_node->path, std::move(path));
     new_node->parent = parent;
+    new_node->parent_raw = parent.get();
+    new_node->index = parent->index;
 
     parent->childs.push_back(new_node);
+    if (new_node->index) {
+        std::unique_lock<TreeRwLock> lock(new_node->index->lock);
+        new_node->index->entries.emplace(new_node->path, std::weak_ptr<Node>(new_node));
+    }
+    add_bytes(new_node->index.get(), footprint_of(*new_node));
+    add_to_totals(parent, 1, 0, static_cast<int64_t>(new_node->path.size()));
     return new_node;
 }
 
 std::shared_ptr<Leaf> find_last_linear(const std::shared_ptr<Node> &parent) {
     assert(parent != nullptr && "Parent node cannot be null");
-    if (!parent->east) {
+    if (!parent->last_leaf) {
         return nullptr;
     }
-    auto current_leaf = parent->east;
-    while (current_leaf->east) {
-        current_leaf = current_leaf->east;
-    }
-    return current_leaf;
+    return owning_ptr_of(*parent, parent->last_leaf);
 }
 
 std::shared_ptr<Leaf> create_leaf(const std::shared_ptr<Node> &parent, std::string path,
@@ -116,10 +309,11 @@ std::shared_ptr<Leaf> create_leaf(const std::shared_ptr<Node> &parent, std::stri
     assert(parent != nullptr && "Parent node cannot be null");
     assert(!path.empty() && "Leaf path cannot be empty");
 
-    auto new_leaf = std::make_shared<Leaf>();
+    auto new_leaf = make_tree_shared<Leaf>();
     new_leaf->tag = Tag::Leaf;
-    new_leaf->path = std::move(path);
-    new_leaf->value = std::move(value);
+    new_leaf->seq = next_entry_seq(*parent);
+    assign_tree_string(new_leaf->path, std::move(path));
+    assign_tree_string(new_leaf->value, std::move(value));
     new_leaf->parent = parent;
 
     if (auto last_leaf = find_last_linear(parent)) {
@@ -128,10 +322,32 @@ std::shared_ptr<Leaf> create_leaf(const std::shared_ptr<Node> &parent, std::stri
     } else {
         parent->east = new_leaf;
     }
+    parent->last_leaf = new_leaf.get();
+    parent->leaf_by_name.emplace(name_of(new_leaf->path), new_leaf.get());
 
+    if (parent->index) {
+        std::unique_lock<TreeRwLock> lock(parent->index->lock);
+        parent->index->entries.emplace(new_leaf->path, std::weak_ptr<Leaf>(new_leaf));
+    }
+    add_bytes(parent->index.get(), footprint_of(*new_leaf));
+    add_to_totals(parent, 0, 1, entry_bytes_of(*new_leaf));
     return new_leaf;
 }
 
+std::shared_ptr<Node> find_child_node(const std::shared_ptr<Node> &parent, std::string_view name) {
+    assert(parent != nullptr && "Parent node cannot be null");
+    return parent->childs.find(name);
+}
+
+std::shared_ptr<Leaf> find_child_leaf(const std::shared_ptr<Node> &parent, std::string_view name) {
+    assert(parent != nullptr && "Parent node cannot be null");
+    auto it = parent->leaf_by_name.find(name);
+    if (it == parent->leaf_by_name.end()) {
+        return nullptr;
+    }
+    return owning_ptr_of(*parent, it->second);
+}
+
 void print_tree(const std::shared_ptr<Node> &root) { print_tree_helper(root, 0); }
 
 std::string print_tree_string(const std::shared_ptr<Node> &root) {
@@ -144,168 +360,292 @@ std::string print_tree_string(const std::shared_ptr<Node> &root) {
 }
 
 std::shared_ptr<Node> find_node_by_path_linear(const std::shared_ptr<Node> &root,
-                                               const std::string &path) {
+                                               std::string_view path) {
     if (!root || path.empty()) {
         return nullptr;
     }
-    return find_node_recursive(root, path);
+    return find_node_in_index(root, path);
 }
 
-bool delete_node_by_path_linear(const std::shared_ptr<Node> &root, const std::string &path) {
+bool delete_node_by_path_linear(const std::shared_ptr<Node> &root, std::string_view path) {
     if (path == "/") {
-        std::cerr << "Error: Cannot delete the root node." << std::endl;
+        LOG_DEBUG("Cannot delete the root node.");
         return false;
     }
 
     auto node_to_delete = find_node_by_path_linear(root, path);
     if (!node_to_delete) {
-        std::cerr << "Error: Node '" << path << "' not found for deletion." << std::endl;
+        LOG_DEBUG("Node '", path, "' not found for deletion.");
         return false;
     }
 
     // 2. Получаем родителя этого узла.
     auto parent_node = node_to_delete->parent.lock();
+    if (!parent_node) {
+        LOG_ERROR("Consistency Error: Could not lock parent of node '", path, "'.");
+        return false;
+    }
 
-    // 3. Удаляем узел из списка дочерних элементов родителя.
-    // Используем идиому erase-remove для эффективного удаления.
-    auto &children = parent_node->childs;
-    auto it = std::remove(children.begin(), children.end(), node_to_delete);
-
-    if (it == children.end()) {
-        std::cerr << "Consistency Error: Node found but not in parent's child list." << std::endl;
+    // 3. Удаляем узел из списка дочерних элементов родителя за O(1) по имени.
+    if (!parent_node->childs.erase(name_of(node_to_delete->path))) {
+        LOG_ERROR("Consistency Error: Node found but not in parent's child list.");
         return false;
     }
 
-    children.erase(it, children.end());
+    // 4. Убираем из индекса сам узел и всех его потомков.
+    add_subtree_to_totals(parent_node, *node_to_delete, -1);
+    if (root->index) {
+        std::unique_lock<TreeRwLock> lock(root->index->lock);
+        unindex_subtree(*root->index, node_to_delete);
+    }
     return true;
 }
 
 std::shared_ptr<Leaf> find_leaf_by_path_linear(const std::shared_ptr<Node> &root,
-                                               const std::string &path) {
-    if (!root || path.empty() || path == "/" || path.find('/') == std::string::npos) {
+                                               std::string_view path) {
+    if (!root || path.empty() || path == "/" || path.find('/') == std::string_view::npos) {
         // Путь не может быть пустым, корневым или не содержать '/'
         return nullptr;
     }
 
-    // 1. Определяем путь к родительскому узлу
-    size_t last_slash_pos = path.rfind('/');
-    std::string parent_path = (last_slash_pos == 0) ? "/" : path.substr(0, last_slash_pos);
-
-    // 2. Находим родительский узел
-    auto parent_node = find_node_by_path_linear(root, parent_path);
-    if (!parent_node) {
-        // Родитель не найден, значит и листа быть не может
+    if (!is_in_subtree(root, path)) {
         return nullptr;
     }
 
-    // 3. Ищем лист в связанном списке родителя
-    auto current_leaf = parent_node->east;
-    while (current_leaf) {
-        if (current_leaf->path == path) {
-            return current_leaf;  // Нашли!
-        }
-        current_leaf = current_leaf->east;
+    auto entry = find_index_entry(root, path);
+    if (!entry || !std::holds_alternative<std::weak_ptr<Leaf>>(*entry)) {
+        return nullptr;
     }
-
-    // Лист не найден в списке родителя
-    return nullptr;
+    return std::get<std::weak_ptr<Leaf>>(*entry).lock();
 }
 
-bool delete_leaf_by_path_linear(const std::shared_ptr<Node> &root, const std::string &path) {
+bool delete_leaf_by_path_linear(const std::shared_ptr<Node> &root, std::string_view path) {
     // 1. Находим лист, который нужно удалить.
     auto leaf_to_delete = find_leaf_by_path_linear(root, path);
     if (!leaf_to_delete) {
-        std::cerr << "Error: Leaf '" << path << "' not found for deletion." << std::endl;
+        LOG_DEBUG("Leaf '", path, "' not found for deletion.");
         return false;
     }
+    return delete_leaf(root, leaf_to_delete);
+}
 
-    // 2. Получаем указатели на соседние листья.
+bool delete_leaf(const std::shared_ptr<Node> &root, const std::shared_ptr<Leaf> &leaf_to_delete) {
+    // 1. Получаем родительский каталог и соседние листья.
+    auto parent_node = parent_node_of(*leaf_to_delete);
+    if (!parent_node) {
+        LOG_ERROR("Consistency Error: Could not lock parent node of a leaf.");
+        return false;
+    }
     auto prev_leaf = leaf_to_delete->west;
     auto next_leaf = leaf_to_delete->east;
 
-    // 3. Обновляем связи в двусвязном списке.
+    // 2. Обновляем связи в двусвязном списке.
     if (prev_leaf) {
         // Если есть предыдущий лист, его 'east' теперь указывает на следующий.
         prev_leaf->east = next_leaf;
     } else {
         // Если предыдущего листа нет, значит, удаляемый лист был первым.
         // Нужно обновить указатель 'east' у родительского узла.
-        if (std::holds_alternative<std::weak_ptr<Node>>(leaf_to_delete->parent)) {
-            auto parent_node = std::get<std::weak_ptr<Node>>(leaf_to_delete->parent).lock();
-            if (parent_node) {
-                parent_node->east = next_leaf;
-            } else {
-                std::cerr << "Consistency Error: Could not lock parent node of a leaf."
-                          << std::endl;
-                return false;
-            }
-        }
+        parent_node->east = next_leaf;
     }
 
     if (next_leaf) {
         // Если есть следующий лист, его 'west' теперь указывает на предыдущий.
         next_leaf->west = prev_leaf;
+    } else {
+        // Удаляемый лист был последним: хвост списка сдвигается на предыдущий.
+        parent_node->last_leaf = prev_leaf.get();
     }
+    parent_node->leaf_by_name.erase(name_of(leaf_to_delete->path));
 
+    // 3. Убираем лист из индекса и отвязываем его от соседей.
+    if (root->index) {
+        std::unique_lock<TreeRwLock> lock(root->index->lock);
+        root->index->entries.erase(leaf_to_delete->path);
+    }
+    remove_bytes(root->index.get(), footprint_of(*leaf_to_delete));
+    add_to_totals(parent_node, 0, -1, -entry_bytes_of(*leaf_to_delete));
+    leaf_to_delete->west.reset();
+    leaf_to_delete->east.reset();
     return true;
 }
 
 std::shared_ptr<Node> create_node_by_path(const std::shared_ptr<Node> &root,
-                                          const std::string &path) {
-    if (path.empty() || path == "/" || path.find('/') == std::string::npos || path.back() == '/') {
-        std::cerr << "Error: Invalid path for new node: '" << path << "'" << std::endl;
+                                          std::string_view path) {
+    if (path.empty() || path == "/" || path.find('/') == std::string_view::npos ||
+        path.back() == '/') {
+        LOG_DEBUG("Invalid path for new node: '", path, "'");
         return nullptr;
     }
 
-    // 1. Проверяем, не существует ли уже узел или лист с таким путем
-    if (find_node_by_path_linear(root, path) || find_leaf_by_path_linear(root, path)) {
-        std::cerr << "Error: Node or leaf with path '" << path << "' already exists." << std::endl;
+    // 1. Проверяем, не существует ли уже узел или лист с таким путем (один поиск в индексе)
+    if (find_index_entry(root, path)) {
+        LOG_DEBUG("Node or leaf with path '", path, "' already exists.");
         return nullptr;
     }
 
     // 2. Определяем путь к родительскому узлу
-    size_t last_slash_pos = path.rfind('/');
-    std::string parent_path = (last_slash_pos == 0) ? "/" : path.substr(0, last_slash_pos);
+    std::string_view parent_path = parent_path_of(path);
 
     // 3. Находим родительский узел
-    auto parent_node = find_node_by_path_linear(root, parent_path);
+    auto parent_node = find_node_in_index(root, parent_path);
     if (!parent_node) {
-        std::cerr << "Error: Parent node '" << parent_path << "' not found. Cannot create node '"
-                  << path << "'." << std::endl;
+        LOG_DEBUG("Parent node '", parent_path, "' not found. Cannot create node '", path, "'.");
         return nullptr;
     }
 
     // 4. Если все проверки пройдены, создаем новый узел
-    return create_node(parent_node, path);
+    return create_node(parent_node, std::string(path));
 }
 
 std::shared_ptr<Leaf> create_leaf_by_path(const std::shared_ptr<Node> &root,
-                                          const std::string &path, const std::string &value) {
-    if (path.empty() || path == "/" || path.find('/') == std::string::npos || path.back() == '/') {
-        std::cerr << "Error: Invalid path for new leaf: '" << path << "'" << std::endl;
+                                          std::string_view path, std::string_view value) {
+    if (path.empty() || path == "/" || path.find('/') == std::string_view::npos ||
+        path.back() == '/') {
+        LOG_DEBUG("Invalid path for new leaf: '", path, "'");
         return nullptr;
     }
 
-    // 1. Проверяем, не существует ли уже узел или лист с таким путем
-    if (find_node_by_path_linear(root, path) || find_leaf_by_path_linear(root, path)) {
-        std::cerr << "Error: Node or leaf with path '" << path << "' already exists." << std::endl;
+    // 1. Проверяем, не существует ли уже узел или лист с таким путем (один поиск в индексе)
+    if (find_index_entry(root, path)) {
+        LOG_DEBUG("Node or leaf with path '", path, "' already exists.");
         return nullptr;
     }
 
     // 2. Определяем путь к родительскому узлу
-    size_t last_slash_pos = path.rfind('/');
-    std::string parent_path = (last_slash_pos == 0) ? "/" : path.substr(0, last_slash_pos);
+    std::string_view parent_path = parent_path_of(path);
 
     // 3. Находим родительский узел
-    auto parent_node = find_node_by_path_linear(root, parent_path);
+    auto parent_node = find_node_in_index(root, parent_path);
     if (!parent_node) {
-        std::cerr << "Error: Parent node '" << parent_path << "' not found. Cannot create leaf '"
-                  << path << "'." << std::endl;
+        LOG_DEBUG("Parent node '", parent_path, "' not found. Cannot create leaf '", path, "'.");
         return nullptr;
     }
 
     // 4. Если все проверки пройдены, создаем новый лист
-    return create_leaf(parent_node, path, value);
+    return create_leaf(parent_node, std::string(path), std::string(value));
+}
+
+std::shared_ptr<Leaf> set_child_leaf(const std::shared_ptr<Node> &parent, std::string_view path,
+                                     std::string_view value, bool *created) {
+    if (created) {
+        *created = false;
+    }
+
+    std::string_view name = name_of(path);
+    if (auto leaf = find_child_leaf(parent, name)) {
+        assign_leaf_value(parent, *leaf, value);
+        return leaf;
+    }
+    if (find_child_node(parent, name)) {
+        LOG_DEBUG("Node with path '", path, "' already exists.");
+        return nullptr;
+    }
+
+    auto leaf = create_leaf(parent, std::string(path), std::string(value));
+    if (leaf && created) {
+        *created = true;
+    }
+    return leaf;
+}
+
+std::shared_ptr<Leaf> set_leaf_by_path(const std::shared_ptr<Node> &root, std::string_view path,
+                                       std::string_view value, bool *created) {
+    if (created) {
+        *created = false;
+    }
+
+    if (auto leaf = find_leaf_by_path_linear(root, path)) {
+        assign_leaf_value(parent_node_of(*leaf), *leaf, value);
+        return leaf;
+    }
+
+    auto leaf = create_leaf_by_path(root, path, value);
+    if (leaf && created) {
+        *created = true;
+    }
+    return leaf;
+}
+
+std::shared_ptr<Node> create_detached_node(std::string path) {
+    auto node = make_tree_shared<Node>();
+    node->tag = Tag::Node;
+    assign_tree_string(node->path, std::move(path));
+    node->index = make_tree_shared<PathIndex>();
+    add_bytes(node->index.get(), footprint_of(*node));
+    return node;
+}
+
+bool attach_subtree(const std::shared_ptr<Node> &parent, const std::shared_ptr<Node> &subtree) {
+    assert(parent != nullptr && subtree != nullptr);
+    std::string_view name = name_of(subtree->path);
+    if (!subtree->index || subtree->path == "/" ||
+        parent_path_of(subtree->path) != parent->path || parent->leaf_by_name.count(name)) {
+        return false;
+    }
+
+    // Каталоги поддерева переходят на общий индекс (листья ссылок на индекс не хранят)
+    auto side_index = std::move(subtree->index);
+    std::vector<Node *> pending = {subtree.get()};
+    while (!pending.empty()) {
+        Node *node = pending.back();
+        pending.pop_back();
+        node->index = parent->index;
+        for (const auto &child : node->childs) {
+            pending.push_back(child.get());
+        }
+    }
+
+    auto replaced = parent->childs.find(name);
+    if (replaced) {
+        parent->childs.erase(name);
+        add_subtree_to_totals(parent, *replaced, -1);
+    }
+    subtree->parent = parent;
+    subtree->parent_raw = parent.get();
+    subtree->seq = next_entry_seq(*parent);
+    parent->childs.push_back(subtree);
+    // Итоги поддерева уже посчитаны при его построении: предкам достаточно одной прибавки
+    add_subtree_to_totals(parent, *subtree, 1);
+
+    if (!parent->index) {
+        return true;
+    }
+    PathIndex &index = *parent->index;
+
+    // Номера записей поддерева выданы его собственным счетчиком: новые записи в его каталогах
+    // должны получать большие номера
+    uint64_t side_next = side_index->next_seq.load(std::memory_order_relaxed);
+    uint64_t next = index.next_seq.load(std::memory_order_relaxed);
+    while (next < side_next && !index.next_seq.compare_exchange_weak(next, side_next)) {
+    }
+
+    {
+        std::unique_lock<TreeRwLock> lock(index.lock);
+        if (replaced) {
+            unindex_subtree(index, replaced);
+        }
+        index.entries.reserve(index.entries.size() + side_index->entries.size() + 1);
+        index.entries.emplace(subtree->path, std::weak_ptr<Node>(subtree));
+    }
+    // Узлы хеш-таблицы поддерева переставляются в общую без выделения памяти и копирования.
+    // Индекс отпускается между порциями, чтобы поиск в остальном дереве не ждал всего переноса;
+    // в само поддерево до снятия X-блокировки parent никто не войдет
+    auto &side = side_index->entries;
+    while (!side.empty()) {
+        std::unique_lock<TreeRwLock> lock(index.lock);
+        for (size_t moved = 0; moved < kAttachIndexBatch && !side.empty(); ++moved) {
+            index.entries.insert(side.extract(side.begin()));
+        }
+    }
+    add_bytes(&index, side_index->bytes.load(std::memory_order_relaxed));
+    return true;
+}
+
+void discard_detached_subtree(const std::shared_ptr<Node> &subtree) {
+    if (subtree && subtree->index) {
+        unindex_subtree(*subtree->index, subtree);
+    }
 }
 
 // int main() {
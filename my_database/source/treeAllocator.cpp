@@ -0,0 +1,113 @@
+#include "treeAllocator.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+SlabPool::SlabPool(size_t block_size, size_t alignment)
+    : block_size_(std::max({block_size, sizeof(FreeBlock), alignment})), alignment_(alignment) {
+    // Размер блока кратен выравниванию, чтобы соседние блоки в слэбе были выровнены.
+    block_size_ = (block_size_ + alignment_ - 1) / alignment_ * alignment_;
+}
+
+void *SlabPool::allocate() {
+    std::lock_guard<SpinLock> lock(lock_);
+    blocks_in_use_.fetch_add(1, std::memory_order_relaxed);
+
+    if (free_list_) {
+        FreeBlock *block = free_list_;
+        free_list_ = block->next;
+        return block;
+    }
+
+    if (bump_ == bump_end_) {
+        size_t slab_size = std::max(kSlabSize, block_size_);
+        slab_size -= slab_size % block_size_;
+        bump_ = static_cast<std::byte *>(::operator new(slab_size, std::align_val_t(alignment_)));
+        bump_end_ = bump_ + slab_size;
+        slabs_.push_back(bump_);
+    }
+
+    void *block = bump_;
+    bump_ += block_size_;
+    return block;
+}
+
+void SlabPool::deallocate(void *block) {
+    std::lock_guard<SpinLock> lock(lock_);
+    blocks_in_use_.fetch_sub(1, std::memory_order_relaxed);
+
+    auto *free_block = static_cast<FreeBlock *>(block);
+    free_block->next = free_list_;
+    free_list_ = free_block;
+}
+
+StringArena &StringArena::instance() {
+    static StringArena *arena = new StringArena();
+    return *arena;
+}
+
+size_t StringArena::class_of(size_t bytes) {
+    size_t index = 0;
+    size_t class_size = kMinClassSize;
+    while (class_size < bytes) {
+        class_size <<= 1;
+        ++index;
+    }
+    return index;
+}
+
+void *StringArena::allocate(size_t bytes) {
+    if (bytes > kMaxClassSize) {
+        return ::operator new(bytes);
+    }
+
+    size_t index = class_of(bytes);
+    size_t class_size = kMinClassSize << index;
+
+    std::lock_guard<SpinLock> lock(lock_);
+    bytes_in_use_.fetch_add(class_size, std::memory_order_relaxed);
+
+    if (FreeChunk *chunk = free_lists_[index]) {
+        free_lists_[index] = chunk->next;
+        return chunk;
+    }
+
+    if (static_cast<size_t>(bump_end_ - bump_) < class_size) {
+        // Остаток текущего куска раздаем по спискам меньших классов, чтобы он не пропал.
+        while (static_cast<size_t>(bump_end_ - bump_) >= kMinClassSize) {
+            size_t rest = static_cast<size_t>(bump_end_ - bump_);
+            size_t rest_index = class_of(rest);
+            if ((kMinClassSize << rest_index) > rest) {
+                --rest_index;
+            }
+            auto *rest_chunk = reinterpret_cast<FreeChunk *>(bump_);
+            rest_chunk->next = free_lists_[rest_index];
+            free_lists_[rest_index] = rest_chunk;
+            bump_ += kMinClassSize << rest_index;
+        }
+        bump_ = static_cast<std::byte *>(::operator new(kChunkSize));
+        bump_end_ = bump_ + kChunkSize;
+    }
+
+    void *chunk = bump_;
+    bump_ += class_size;
+    return chunk;
+}
+
+void StringArena::deallocate(void *pointer, size_t bytes) {
+    if (bytes > kMaxClassSize) {
+        ::operator delete(pointer);
+        return;
+    }
+
+    size_t index = class_of(bytes);
+
+    std::lock_guard<SpinLock> lock(lock_);
+    bytes_in_use_.fetch_sub(kMinClassSize << index, std::memory_order_relaxed);
+
+    auto *chunk = static_cast<FreeChunk *>(pointer);
+    chunk->next = free_lists_[index];
+    free_lists_[index] = chunk;
+}
@@ -0,0 +1,83 @@
+#include "treeLock.hpp"
+
+/*------------------------------------HEADER_FUNCTION_IMPLEMENTATION--------------------------------------------*/
+
+uint64_t IntentionLock::delta_of(LockMode mode) {
+    switch (mode) {
+        case LockMode::IntentionShared:
+            return kIntentionShared;
+        case LockMode::IntentionExclusive:
+            return kIntentionExclusive;
+        case LockMode::Shared:
+            return kShared;
+        case LockMode::Exclusive:
+            return kExclusive;
+    }
+    return 0;
+}
+
+bool IntentionLock::compatible(uint64_t state, LockMode mode, bool own_waiter) {
+    uint64_t intention_shared = state & kCounterMask;
+    uint64_t intention_exclusive = (state >> 16) & kCounterMask;
+    uint64_t shared = (state >> 32) & kCounterMask;
+    bool exclusive = (state & kExclusive) != 0;
+    uint64_t waiters = (state >> 49) - (own_waiter ? 1 : 0);
+
+    switch (mode) {
+        case LockMode::IntentionShared:
+            return !exclusive && waiters == 0;
+        case LockMode::IntentionExclusive:
+            return !exclusive && shared == 0 && waiters == 0;
+        case LockMode::Shared:
+            return !exclusive && intention_exclusive == 0 && waiters == 0;
+        case LockMode::Exclusive:
+            return !exclusive && intention_shared == 0 && intention_exclusive == 0 &&
+                   shared == 0;
+    }
+    return false;
+}
+
+void IntentionLock::lock(LockMode mode) {
+    uint64_t delta = delta_of(mode);
+    uint64_t current = state_.load(std::memory_order_acquire);
+    bool waiting = false;
+
+    while (true) {
+        if (compatible(current, mode, waiting)) {
+            uint64_t next = current + delta - (waiting ? kExclusiveWaiter : 0);
+            if (state_.compare_exchange_weak(current, next, std::memory_order_acquire)) {
+                return;
+            }
+            continue;
+        }
+
+        if (mode == LockMode::Exclusive && !waiting) {
+            // Регистрируемся как ожидающий X, чтобы новые читатели и писатели ждали нас.
+            if (!state_.compare_exchange_weak(current, current + kExclusiveWaiter,
+                                              std::memory_order_relaxed)) {
+                continue;
+            }
+            current += kExclusiveWaiter;
+            waiting = true;
+        }
+
+        state_.wait(current, std::memory_order_relaxed);
+        current = state_.load(std::memory_order_acquire);
+    }
+}
+
+bool IntentionLock::try_lock(LockMode mode) {
+    uint64_t current = state_.load(std::memory_order_acquire);
+    while (compatible(current, mode, false)) {
+        if (state_.compare_exchange_weak(current, current + delta_of(mode),
+                                         std::memory_order_acquire)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void IntentionLock::unlock(LockMode mode) {
+    state_.fetch_sub(delta_of(mode), std::memory_order_release);
+    state_.notify_all();
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include "compactTree.hpp"
+#include "tree.hpp"
+
+namespace database_test {
+
+class CompactTreeTest : public ::testing::Test {
+protected:
+    CompactTree tree;
+};
+
+TEST_F(CompactTreeTest, HandlesAreSmall) {
+    EXPECT_EQ(sizeof(NodeHandle), 8u);
+    EXPECT_EQ(sizeof(LeafHandle), 8u);
+}
+
+TEST_F(CompactTreeTest, CreateAndFind) {
+    auto users = create_node_by_path(tree, "/Users");
+    auto login = create_node_by_path(tree, "/Users/Login");
+    auto bob = create_leaf_by_path(tree, "/Users/Login/bob", "bob_data");
+
+    ASSERT_TRUE(users);
+    ASSERT_TRUE(login);
+    ASSERT_TRUE(bob);
+    EXPECT_EQ(find_node_by_path_linear(tree, "/"), tree.root());
+    EXPECT_EQ(find_node_by_path_linear(tree, "/Users/Login"), login);
+    EXPECT_EQ(find_leaf_by_path_linear(tree, "/Users/Login/bob"), bob);
+    EXPECT_EQ(tree.value_of(bob), "bob_data");
+    EXPECT_EQ(tree.parent_of(bob), login);
+    EXPECT_EQ(tree.parent_of(login), users);
+    EXPECT_EQ(tree.path_of(bob), "/Users/Login/bob");
+    EXPECT_EQ(tree.path_of(login), "/Users/Login");
+
+    EXPECT_FALSE(find_node_by_path_linear(tree, "/Users/Login/bob"));
+    EXPECT_FALSE(find_leaf_by_path_linear(tree, "/Users/Login"));
+    EXPECT_FALSE(create_node_by_path(tree, "/Users"));
+    EXPECT_FALSE(create_leaf_by_path(tree, "/Users/Login", "x"));
+    EXPECT_FALSE(create_leaf_by_path(tree, "/Missing/x", "x"));
+}
+
+TEST_F(CompactTreeTest, StaleHandlesAreRejected) {
+    auto users = create_node_by_path(tree, "/Users");
+    auto bob = create_leaf_by_path(tree, "/Users/bob", "bob_data");
+
+    ASSERT_TRUE(delete_leaf_by_path_linear(tree, "/Users/bob"));
+    EXPECT_FALSE(tree.valid(bob));
+    EXPECT_FALSE(tree.delete_leaf(bob));
+
+    // Слот переиспользуется, но старый дескриптор остается невалидным
+    auto kate = create_leaf_by_path(tree, "/Users/kate", "kate_data");
+    EXPECT_EQ(kate.index, bob.index);
+    EXPECT_NE(kate.generation, bob.generation);
+    EXPECT_FALSE(tree.valid(bob));
+    EXPECT_TRUE(tree.valid(kate));
+
+    ASSERT_TRUE(tree.delete_node(users));
+    EXPECT_FALSE(tree.valid(users));
+    EXPECT_FALSE(tree.valid(kate));
+    EXPECT_FALSE(tree.create_leaf(users, "x", "x"));
+}
+
+TEST_F(CompactTreeTest, DeleteNodeFreesSubtree) {
+    create_node_by_path(tree, "/a");
+    create_node_by_path(tree, "/a/b");
+    create_node_by_path(tree, "/a/b/c");
+    create_leaf_by_path(tree, "/a/b/c/leaf", "1");
+    create_leaf_by_path(tree, "/a/leaf", "2");
+    create_node_by_path(tree, "/d");
+
+    ASSERT_TRUE(delete_node_by_path_linear(tree, "/a"));
+    EXPECT_EQ(tree.node_count(), 1u);
+    EXPECT_EQ(tree.leaf_count(), 0u);
+    EXPECT_FALSE(find_node_by_path_linear(tree, "/a/b"));
+    EXPECT_FALSE(find_leaf_by_path_linear(tree, "/a/b/c/leaf"));
+    EXPECT_FALSE(tree.delete_node(tree.root()));
+
+    EXPECT_TRUE(create_node_by_path(tree, "/a"));
+    EXPECT_TRUE(create_leaf_by_path(tree, "/a/leaf", "3"));
+}
+
+TEST_F(CompactTreeTest, PrintMatchesSharedPtrTree) {
+    auto root = create_root_node();
+    for (const char *path : {"/Users", "/Users/Login", "/Shops", "/Users/Password"}) {
+        create_node_by_path(root, path);
+        create_node_by_path(tree, path);
+    }
+    for (const char *path : {"/Users/Login/bob", "/Users/Login/kate", "/Users/readme"}) {
+        create_leaf_by_path(root, path, "data");
+        create_leaf_by_path(tree, path, "data");
+    }
+    delete_node_by_path_linear(root, "/Users/Password");
+    delete_node_by_path_linear(tree, "/Users/Password");
+    delete_leaf_by_path_linear(root, "/Users/Login/bob");
+    delete_leaf_by_path_linear(tree, "/Users/Login/bob");
+
+    EXPECT_EQ(print_tree_string(tree, tree.root()), print_tree_string(root));
+    EXPECT_EQ(print_tree_string(tree, tree.find_node("/Users")),
+              print_tree_string(find_node_by_path_linear(root, "/Users")));
+}
+
+TEST_F(CompactTreeTest, TraversalKeepsInsertionOrder) {
+    auto dir = create_node_by_path(tree, "/dir");
+    create_leaf_by_path(tree, "/dir/c", "1");
+    create_leaf_by_path(tree, "/dir/a", "2");
+    create_leaf_by_path(tree, "/dir/b", "3");
+
+    std::string names;
+    tree.for_each_leaf(dir, [&](LeafHandle leaf) { names += tree.name_of(leaf); });
+    EXPECT_EQ(names, "cab");
+}
+
+}  // namespace database_test
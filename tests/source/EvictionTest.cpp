@@ -0,0 +1,206 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "eviction.hpp"
+#include "subtreeStream.hpp"
+
+namespace database_test {
+
+constexpr uint64_t kNow = 1'000'000'000'000;  // Произвольное начало отсчета, мс
+
+class EvictionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = create_root_node();
+        cache = create_node_by_path(root, "/Cache");
+        for (int i = 0; i < kLeaves; ++i) {
+            create_leaf_by_path(root, path_of(i), "v");
+        }
+        per_leaf = footprint_of(*find_leaf_by_path_linear(root, path_of(0)));
+    }
+
+    static std::string path_of(int i) { return "/Cache/k" + std::to_string(i); }
+
+    // Вытеснение с пределом, который требует вытеснить count листьев.
+    std::unique_ptr<LeafEviction> evict_later(EvictionPolicy policy, int count,
+                                              size_t samples = 10) {
+        EvictionOptions options;
+        options.policy = policy;
+        options.samples = samples;
+        options.max_bytes = root->index->bytes - count * per_leaf;
+        return std::make_unique<LeafEviction>(root, options);
+    }
+
+    void touch(LeafEviction &eviction, int i, uint64_t now_ms, int times = 1) {
+        for (int t = 0; t < times; ++t) {
+            eviction.touch(*find_leaf_by_path_linear(root, path_of(i)), now_ms);
+        }
+    }
+
+    bool exists(int i) { return find_leaf_by_path_linear(root, path_of(i)) != nullptr; }
+
+    static constexpr int kLeaves = 100;
+    std::shared_ptr<Node> root;
+    std::shared_ptr<Node> cache;
+    size_t per_leaf = 0;
+};
+
+// Оценка памяти дерева - сумма footprint_of всех записей при любых изменениях.
+TEST_F(EvictionTest, FootprintIsAccounted) {
+    auto sum = [&] {
+        size_t bytes = footprint_of(*cache);
+        for (const Leaf *leaf = cache->east.get(); leaf; leaf = leaf->east.get()) {
+            bytes += footprint_of(*leaf);
+        }
+        return bytes;
+    };
+    EXPECT_EQ(root->index->bytes, sum());
+
+    set_leaf_by_path(root, path_of(1), std::string(1000, 'x'));
+    set_child_leaf(cache, path_of(2), std::string(300, 'y'));
+    EXPECT_EQ(root->index->bytes, sum());
+    set_leaf_by_path(root, path_of(1), "short");
+    delete_leaf_by_path_linear(root, path_of(3));
+    EXPECT_EQ(root->index->bytes, sum());
+
+    auto subtree = create_detached_node("/Cache/Sub");
+    create_leaf(subtree, "/Cache/Sub/a", std::string(100, 'a'));
+    size_t before = root->index->bytes;
+    ASSERT_TRUE(attach_subtree(cache, subtree));
+    auto leaf = find_leaf_by_path_linear(root, "/Cache/Sub/a");
+    EXPECT_EQ(root->index->bytes, before + footprint_of(*subtree) + footprint_of(*leaf));
+
+    delete_node_by_path_linear(root, "/Cache");
+    EXPECT_EQ(root->index->bytes, 0u);
+}
+
+TEST_F(EvictionTest, LruEvictsLeastRecentlyUsed) {
+    auto eviction = evict_later(EvictionPolicy::Lru, 50);
+    for (int i = 0; i < kLeaves; ++i) {
+        touch(*eviction, i, kNow);
+    }
+    for (int i = 0; i < 10; ++i) {
+        touch(*eviction, i, kNow + 60'000);
+    }
+
+    ASSERT_TRUE(eviction->make_room(kNow + 120'000));
+    EXPECT_LE(eviction->used_bytes(), eviction->options().max_bytes);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(exists(i)) << "recently used leaf " << i << " evicted";
+    }
+    EvictionStats stats = eviction->stats();
+    EXPECT_EQ(stats.evicted, 50u);
+    EXPECT_EQ(stats.evicted_bytes, 50 * per_leaf);
+}
+
+TEST_F(EvictionTest, LfuKeepsFrequentlyUsedAndDecays) {
+    auto eviction = evict_later(EvictionPolicy::Lfu, 50);
+    for (int i = 0; i < kLeaves; ++i) {
+        touch(*eviction, i, kNow);
+    }
+    // Частые обращения к первым десяти листьям, затем последнее обращение ко всем остальным
+    for (int i = 0; i < 10; ++i) {
+        touch(*eviction, i, kNow, 200);
+    }
+    for (int i = 10; i < kLeaves; ++i) {
+        touch(*eviction, i, kNow + 1000);
+    }
+    ASSERT_TRUE(eviction->make_room(kNow + 2000));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_TRUE(exists(i)) << "frequently used leaf " << i << " evicted";
+    }
+
+    // Через час без обращений счетчики частых листьев уменьшились до нуля: новый лист с парой
+    // обращений остается, а бывшие частые вытесняются
+    create_leaf_by_path(root, "/Cache/fresh", "v");
+    auto fresh = find_leaf_by_path_linear(root, "/Cache/fresh");
+    eviction->touch(*fresh, kNow + 3'600'000);
+    eviction->touch(*fresh, kNow + 3'600'000);
+    for (int i = 10; i < kLeaves; ++i) {
+        if (exists(i)) {
+            touch(*eviction, i, kNow + 3'600'000);
+        }
+    }
+    EvictionOptions options = eviction->options();
+    options.max_bytes = root->index->bytes - 10 * per_leaf;
+    options.samples = 50;
+    LeafEviction later(root, options);
+    ASSERT_TRUE(later.make_room(kNow + 3'600'000));
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_FALSE(exists(i)) << "decayed leaf " << i << " kept";
+    }
+    EXPECT_NE(find_leaf_by_path_linear(root, "/Cache/fresh"), nullptr);
+}
+
+// Выборка приблизительная: вытесняются листья с TTL, первым - самый ранний из них.
+TEST_F(EvictionTest, TtlFirstEvictsSoonestExpiring) {
+    auto eviction = evict_later(EvictionPolicy::TtlFirst, 5, 50);
+    for (int i = 0; i < kLeaves; ++i) {
+        touch(*eviction, i, kNow);
+    }
+    for (int i = 50; i < 60; ++i) {
+        find_leaf_by_path_linear(root, path_of(i))->expires_at = kNow + 1000 * i;
+    }
+
+    ASSERT_TRUE(eviction->make_room(kNow));
+    int evicted_with_ttl = 0;
+    for (int i = 0; i < kLeaves; ++i) {
+        if (i < 50 || i >= 60) {
+            EXPECT_TRUE(exists(i)) << "leaf without TTL " << i << " evicted";
+        } else {
+            evicted_with_ttl += !exists(i);
+        }
+    }
+    EXPECT_EQ(evicted_with_ttl, 5);
+    EXPECT_FALSE(exists(50));
+}
+
+TEST_F(EvictionTest, NoEvictionRejects) {
+    auto eviction = evict_later(EvictionPolicy::NoEviction, 1);
+    EXPECT_FALSE(eviction->make_room(kNow));
+    EXPECT_EQ(eviction->stats().rejected, 1u);
+    EXPECT_TRUE(exists(0));
+
+    // Нечего вытеснять: в дереве остались только каталоги
+    auto lru = evict_later(EvictionPolicy::Lru, kLeaves + 1);
+    EXPECT_FALSE(lru->make_room(kNow));
+    EXPECT_EQ(cache->east, nullptr);
+    EXPECT_EQ(lru->stats().evicted, static_cast<uint64_t>(kLeaves));
+}
+
+// После вытеснений список листьев каталога цел: связи west/east, хвост и таблица имен.
+TEST_F(EvictionTest, EvictionKeepsSiblingListConsistent) {
+    auto eviction = evict_later(EvictionPolicy::Lru, 73);
+    for (int i = 0; i < kLeaves; ++i) {
+        touch(*eviction, i, kNow + 1000 * (i % 7));
+    }
+    ASSERT_TRUE(eviction->make_room(kNow + 10'000));
+
+    size_t count = 0;
+    const Leaf *previous = nullptr;
+    for (const Leaf *leaf = cache->east.get(); leaf; leaf = leaf->east.get()) {
+        EXPECT_EQ(leaf->west.get(), previous);
+        EXPECT_EQ(cache->leaf_by_name.at(name_of(leaf->path)), leaf);
+        previous = leaf;
+        ++count;
+    }
+    EXPECT_EQ(count, 27u);
+    EXPECT_EQ(cache->last_leaf, previous);
+    EXPECT_EQ(cache->leaf_by_name.size(), count);
+    EXPECT_EQ(root->index->entries.size(), count + 1);
+}
+
+TEST_F(EvictionTest, CountsHitRate) {
+    auto eviction = evict_later(EvictionPolicy::Lru, 0);
+    for (bool hit : {true, true, true, false}) {
+        eviction->count_read(hit);
+    }
+    EvictionStats stats = eviction->stats();
+    EXPECT_EQ(stats.hits, 3u);
+    EXPECT_EQ(stats.misses, 1u);
+    EXPECT_DOUBLE_EQ(stats.hit_rate(), 0.75);
+}
+
+}  // namespace database_test
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "expiry.hpp"
+#include "mutationLog.hpp"
+#include "snapshot.hpp"
+
+namespace database_test {
+
+constexpr uint64_t kStart = 1'000'000'000'000;  // Произвольное начало отсчета, мс
+constexpr uint64_t kTick = 10;
+
+// Таймеры на всех уровнях колеса срабатывают в свой тик, не раньше срока.
+TEST(TimingWheelTest, FiresEachTimerOnItsTick) {
+    TimingWheel wheel(kStart, kTick);
+    std::mt19937_64 random(7);
+    std::vector<uint64_t> deadlines = {kStart + 1, kStart + 10, kStart + 640, kStart + 641,
+                                       kStart + 41'000, kStart + 3'000'000};
+    for (int i = 0; i < 300; ++i) {
+        deadlines.push_back(kStart + random() % 5'000'000);
+    }
+    for (size_t i = 0; i < deadlines.size(); ++i) {
+        wheel.schedule({std::to_string(i), deadlines[i]});
+    }
+    EXPECT_EQ(wheel.size(), deadlines.size());
+
+    std::vector<ExpiryTimer> due;
+    size_t fired = 0;
+    for (uint64_t now = kStart; now <= kStart + 5'000'000 + kTick; now += kTick) {
+        due.clear();
+        wheel.advance(now, due);
+        for (const auto &timer : due) {
+            EXPECT_LE(timer.expires_at, now);
+            EXPECT_GT(timer.expires_at + kTick, now) << "late timer " << timer.path;
+            EXPECT_EQ(deadlines[std::stoul(timer.path)], timer.expires_at);
+        }
+        fired += due.size();
+    }
+    EXPECT_EQ(fired, deadlines.size());
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(TimingWheelTest, HandlesOverdueAndFarTimersAndJumps) {
+    TimingWheel wheel(kStart, kTick);
+    uint64_t far = kStart + 100ULL * 24 * 3600 * 1000;  // Дальше последнего уровня (46 ч)
+    wheel.schedule({"past", kStart - 5000});
+    wheel.schedule({"far", far});
+
+    std::vector<ExpiryTimer> due;
+    wheel.advance(kStart, due);
+    ASSERT_EQ(due.size(), 1u);
+    EXPECT_EQ(due[0].path, "past");
+
+    // Скачок часов вперед на сутки: дальний таймер еще не срабатывает
+    due.clear();
+    wheel.advance(kStart + 24ULL * 3600 * 1000, due);
+    EXPECT_TRUE(due.empty());
+    wheel.advance(far - 1, due);
+    EXPECT_TRUE(due.empty());
+    wheel.advance(far, due);
+    ASSERT_EQ(due.size(), 1u);
+    EXPECT_EQ(due[0].path, "far");
+}
+
+class LeafExpiryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = create_root_node();
+        create_node_by_path(root, "/Sessions");
+        expiry = std::make_unique<LeafExpiry>(root, options, nullptr, kStart);
+    }
+
+    void set_ttl(const std::string &path, uint64_t expires_at) {
+        find_leaf_by_path_linear(root, path)->expires_at = expires_at;
+        expiry->schedule(path, expires_at);
+    }
+
+    std::shared_ptr<Node> root;
+    ExpiryOptions options;
+    std::unique_ptr<LeafExpiry> expiry;
+};
+
+TEST_F(LeafExpiryTest, RemovesOnlyExpiredLeaves) {
+    for (int i = 0; i < 10; ++i) {
+        create_leaf_by_path(root, "/Sessions/s" + std::to_string(i), "v");
+        set_ttl("/Sessions/s" + std::to_string(i), kStart + 1000 * (i + 1));
+    }
+    create_leaf_by_path(root, "/Sessions/forever", "v");
+
+    EXPECT_EQ(expiry->sweep(kStart + 500), 0u);
+    EXPECT_EQ(expiry->sweep(kStart + 3000), 3u);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Sessions/s2"), nullptr);
+    EXPECT_NE(find_leaf_by_path_linear(root, "/Sessions/s3"), nullptr);
+    EXPECT_EQ(expiry->sweep(kStart + 20000), 7u);
+    EXPECT_NE(find_leaf_by_path_linear(root, "/Sessions/forever"), nullptr);
+
+    ExpiryStats stats = expiry->stats();
+    EXPECT_EQ(stats.scheduled, 10u);
+    EXPECT_EQ(stats.expired, 10u);
+    EXPECT_EQ(stats.skipped, 0u);
+    EXPECT_EQ(stats.pending, 0u);
+    EXPECT_EQ(stats.sweeps, 2u);
+}
+
+// Таймер не удаляет лист, который после постановки удален, перезаписан или продлен.
+TEST_F(LeafExpiryTest, StaleTimersAreSkipped) {
+    for (const char *name : {"deleted", "rewritten", "extended", "recreated"}) {
+        create_leaf_by_path(root, std::string("/Sessions/") + name, "v");
+        set_ttl(std::string("/Sessions/") + name, kStart + 1000);
+    }
+    delete_leaf_by_path_linear(root, "/Sessions/deleted");
+    set_leaf_by_path(root, "/Sessions/rewritten", "new");
+    set_ttl("/Sessions/extended", kStart + 5000);
+    delete_leaf_by_path_linear(root, "/Sessions/recreated");
+    create_leaf_by_path(root, "/Sessions/recreated", "v");
+
+    EXPECT_EQ(expiry->sweep(kStart + 2000), 0u);
+    EXPECT_EQ(expiry->stats().skipped, 4u);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Sessions/rewritten")->expires_at, 0u);
+    EXPECT_NE(find_leaf_by_path_linear(root, "/Sessions/extended"), nullptr);
+
+    EXPECT_EQ(expiry->sweep(kStart + 5000), 1u);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Sessions/extended"), nullptr);
+}
+
+TEST_F(LeafExpiryTest, WorkPerTickIsBounded) {
+    options.max_per_tick = 100;
+    expiry = std::make_unique<LeafExpiry>(root, options, nullptr, kStart);
+    for (int i = 0; i < 250; ++i) {
+        create_leaf_by_path(root, "/Sessions/s" + std::to_string(i), "v");
+        set_ttl("/Sessions/s" + std::to_string(i), kStart + 1000);
+    }
+    EXPECT_EQ(expiry->sweep(kStart + 1000), 100u);
+    EXPECT_EQ(expiry->sweep(kStart + 1010), 100u);
+    EXPECT_EQ(expiry->sweep(kStart + 1020), 50u);
+    EXPECT_TRUE(root->childs.find("Sessions")->leaf_by_name.empty());
+}
+
+// Срок TTL переживает проигрывание журнала (включая переписывание) и загрузку образа.
+TEST_F(LeafExpiryTest, TtlIsPersisted) {
+    std::string path = ::testing::TempDir() + "expiry_test";
+    std::filesystem::remove(path + ".aof");
+    create_leaf_by_path(root, "/Sessions/a", "1");
+    find_leaf_by_path_linear(root, "/Sessions/a")->expires_at = kStart + 1234;
+    create_leaf_by_path(root, "/Sessions/b", "2");
+
+    MutationLogOptions log_options;
+    log_options.path = path + ".aof";
+    {
+        MutationLog log(log_options);
+        ASSERT_TRUE(log.open(create_root_node()));
+        log.append(TreeChangeKind::CreateNode, "/Sessions");
+        log.append(TreeChangeKind::CreateLeaf, "/Sessions/a", "1");
+        ASSERT_TRUE(log.sync(log.append(TreeChangeKind::ExpireLeaf, "/Sessions/a",
+                                        encode_expiry(kStart + 1234))));
+    }
+    auto replayed = create_root_node();
+    {
+        MutationLog log(log_options);
+        ASSERT_TRUE(log.open(replayed));
+        ASSERT_TRUE(log.rewrite());
+    }
+    auto rewritten = create_root_node();
+    {
+        MutationLog log(log_options);
+        ASSERT_TRUE(log.open(rewritten));
+    }
+    EXPECT_EQ(find_leaf_by_path_linear(rewritten, "/Sessions/a")->expires_at, kStart + 1234);
+
+    ASSERT_TRUE(write_snapshot(root, path + ".mcdb"));
+    auto loaded = create_root_node();
+    ASSERT_TRUE(load_snapshot(loaded, path + ".mcdb"));
+    EXPECT_EQ(find_leaf_by_path_linear(loaded, "/Sessions/a")->expires_at, kStart + 1234);
+    EXPECT_EQ(find_leaf_by_path_linear(loaded, "/Sessions/b")->expires_at, 0u);
+
+    // После загрузки таймеры ставятся обходом дерева
+    LeafExpiry restored(loaded, options, nullptr, kStart);
+    restored.schedule_tree();
+    EXPECT_EQ(restored.sweep(kStart + 2000), 1u);
+    EXPECT_EQ(find_leaf_by_path_linear(loaded, "/Sessions/a"), nullptr);
+
+    std::filesystem::remove(path + ".aof");
+    std::filesystem::remove(path + ".mcdb");
+}
+
+}  // namespace database_test
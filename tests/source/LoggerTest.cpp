@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "logger.hpp"
+
+namespace database_test {
+
+TEST(LoggerTest, RingKeepsOrderAndCountsDrops) {
+    auto ring = std::make_unique<LogRing>();
+    for (size_t i = 0; i < kLogRingSize + 3; ++i) {
+        if (LogRecord *record = ring->try_reserve()) {
+            LogFormatter formatter(*record);
+            formatter.put(i);
+            ring->commit();
+        }
+    }
+    EXPECT_EQ(ring->take_dropped(), 3u);
+
+    std::vector<std::string> texts;
+    size_t drained = ring->drain([&](const LogRecord &record) {
+        texts.emplace_back(record.text, record.length);
+    });
+    EXPECT_EQ(drained, kLogRingSize);
+    EXPECT_EQ(texts.front(), "0");
+    EXPECT_EQ(texts.back(), std::to_string(kLogRingSize - 1));
+
+    // После сброса слоты снова свободны
+    EXPECT_NE(ring->try_reserve(), nullptr);
+    EXPECT_EQ(ring->take_dropped(), 0u);
+}
+
+TEST(LoggerTest, FormatterJoinsPartsAndTruncates) {
+    LogRecord record;
+    LogFormatter formatter(record);
+    formatter.put("Client ");
+    formatter.put(std::string("127.0.0.1"));
+    formatter.put(':');
+    formatter.put(-42);
+    EXPECT_EQ(std::string(record.text, record.length), "Client 127.0.0.1:-42");
+
+    formatter.put(std::string(2 * kLogLineSize, 'x'));
+    EXPECT_EQ(record.length, kLogLineSize);
+}
+
+TEST(LoggerTest, DisabledLevelSkipsArguments) {
+    LogLevel saved = g_log_level.load();
+    log_set_level(LogLevel::Warning);
+    int evaluated = 0;
+    auto argument = [&] {
+        ++evaluated;
+        return 1;
+    };
+    LOG_DEBUG("value ", argument());
+    LOG_INFO("value ", argument());
+    EXPECT_EQ(evaluated, 0);
+    EXPECT_TRUE(log_enabled(LogLevel::Error));
+
+    LogLevel level;
+    EXPECT_TRUE(parse_log_level("debug", level));
+    EXPECT_EQ(level, LogLevel::Debug);
+    EXPECT_FALSE(parse_log_level("verbose", level));
+    log_set_level(saved);
+}
+
+}  // namespace database_test
@@ -0,0 +1,149 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.hpp"
+#include "pathLock.hpp"
+
+namespace database_test {
+
+TEST(MetricsTest, BucketsCoverEveryValue) {
+    using H = LatencyHistogram;
+    EXPECT_EQ(H::lowest_of(0), 0u);
+    for (size_t bucket = 0; bucket + 1 < H::kBuckets; ++bucket) {
+        ASSERT_EQ(H::highest_of(bucket) + 1, H::lowest_of(bucket + 1)) << bucket;
+    }
+    for (uint64_t value = 1; value < (uint64_t{1} << H::kMaxValueBits); value = value * 3 + 1) {
+        for (uint64_t probe : {value - 1, value, value + 1}) {
+            size_t bucket = H::bucket_of(probe);
+            ASSERT_LE(H::lowest_of(bucket), probe);
+            ASSERT_GE(H::highest_of(bucket), probe);
+            // Ширина корзины - не больше 1/8 ее нижней границы
+            uint64_t width = H::highest_of(bucket) - H::lowest_of(bucket) + 1;
+            ASSERT_LE(width, std::max<uint64_t>(1, H::lowest_of(bucket) / H::kSubBuckets));
+        }
+    }
+    EXPECT_EQ(H::bucket_of(~uint64_t{0}), H::kBuckets - 1);
+}
+
+TEST(MetricsTest, PercentilesWithinBucketError) {
+    LatencyHistogram histogram;
+    for (uint64_t value = 1; value <= 10000; ++value) {
+        histogram.record(value);
+    }
+    HistogramSnapshot snapshot;
+    snapshot.merge(histogram);
+    EXPECT_EQ(snapshot.count, 10000u);
+    EXPECT_EQ(snapshot.max, 10000u);
+    EXPECT_DOUBLE_EQ(snapshot.mean(), 5000.5);
+    for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        double exact = q * 10000;
+        EXPECT_GE(snapshot.percentile(q), exact) << q;
+        EXPECT_LE(snapshot.percentile(q), exact * 1.125) << q;
+    }
+    EXPECT_EQ(snapshot.percentile(1.0), 10000u);
+    EXPECT_EQ(snapshot.count_at_most(15), 15u);
+    EXPECT_EQ(snapshot.count_at_most(~uint64_t{0}), 10000u);
+}
+
+// Сводка складывает блоки всех потоков, в том числе уже завершившихся.
+TEST(MetricsTest, SumsBlocksOfAllThreads) {
+    constexpr int kThreads = 4;
+    constexpr int kCalls = 1000;
+    MetricsSnapshot before = collect_metrics();
+    for (int round = 0; round < 2; ++round) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; ++t) {
+            threads.emplace_back([] {
+                for (int i = 0; i < kCalls; ++i) {
+                    record_command(Opcode::GetLeaf, 100);
+                    thread_metrics().bytes_in.add(10);
+                }
+            });
+        }
+        for (auto &thread : threads) {
+            thread.join();
+        }
+    }
+    MetricsSnapshot after = collect_metrics();
+    auto get = static_cast<size_t>(Opcode::GetLeaf);
+    EXPECT_EQ(after.commands[get].count - before.commands[get].count, 2u * kThreads * kCalls);
+    EXPECT_EQ(after.commands[get].sum - before.commands[get].sum, 200u * kThreads * kCalls);
+    EXPECT_EQ(after.bytes_in - before.bytes_in, 20u * kThreads * kCalls);
+
+    // Неизвестный опкод считается в индексе 0
+    record_command(static_cast<Opcode>(200), 5);
+    EXPECT_EQ(collect_metrics().commands[0].count, after.commands[0].count + 1);
+}
+
+TEST(MetricsTest, PathLockRecordsWaitAndHold) {
+    auto root = create_root_node();
+    create_node_by_path(root, "/a");
+    MetricsSnapshot before = collect_metrics();
+
+    std::atomic<bool> locked{false};
+    std::thread writer([&] {
+        PathLock lock(root, "/a", LockMode::Exclusive);
+        locked = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    });
+    while (!locked) {
+        std::this_thread::yield();
+    }
+    { PathLock reader(root, "/a", LockMode::Shared); }
+    writer.join();
+
+    MetricsSnapshot after = collect_metrics();
+    size_t shared = lock_metric_of(LockMode::Shared);
+    size_t exclusive = lock_metric_of(LockMode::Exclusive);
+    EXPECT_EQ(after.lock_acquired[shared] - before.lock_acquired[shared], 1u);
+    EXPECT_EQ(after.lock_acquired[exclusive] - before.lock_acquired[exclusive], 1u);
+    EXPECT_EQ(after.lock_wait[shared].count - before.lock_wait[shared].count, 1u);
+    EXPECT_GE(after.lock_wait[shared].max, 10'000'000u);
+    EXPECT_GE(after.lock_hold[exclusive].max, 30'000'000u);
+}
+
+// Границы le накопительные и заканчиваются +Inf, равным _count.
+TEST(MetricsTest, PrometheusBucketsAreCumulative) {
+    for (uint64_t ns : {500ull, 3000ull, 70000ull, 2000000ull, 20000000000ull}) {
+        record_command(Opcode::Scan, ns);
+    }
+    std::string text;
+    append_prometheus(text, collect_metrics());
+
+    std::istringstream lines(text);
+    std::string line;
+    uint64_t previous = 0;
+    uint64_t inf = 0;
+    uint64_t count = 0;
+    size_t buckets = 0;
+    const std::string bucket = "database_command_duration_seconds_bucket{verb=\"SCAN\"";
+    auto value_of = [](const std::string &line) {
+        return std::stoull(line.substr(line.rfind(' ') + 1));
+    };
+    while (std::getline(lines, line)) {
+        if (line.rfind(bucket, 0) == 0) {
+            uint64_t value = value_of(line);
+            EXPECT_GE(value, previous) << line;
+            previous = value;
+            ++buckets;
+            if (line.find("le=\"+Inf\"") != std::string::npos) {
+                inf = value;
+            }
+        } else if (line.rfind("database_command_duration_seconds_count{verb=\"SCAN\"}", 0) == 0) {
+            count = value_of(line);
+        }
+    }
+    EXPECT_EQ(buckets, 23u);
+    EXPECT_GE(count, 5u);
+    EXPECT_EQ(inf, count);
+    EXPECT_NE(text.find("database_connected_clients "), std::string::npos);
+}
+
+}  // namespace database_test
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "mutationLog.hpp"
+
+namespace database_test {
+
+class MutationLogTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // ctest запускает тесты отдельными процессами параллельно: у каждого свой файл
+        const auto *test = ::testing::UnitTest::GetInstance()->current_test_info();
+        path = ::testing::TempDir() + "mutation_log_test_" + test->name() + "_" +
+               std::to_string(getpid()) + ".aof";
+        std::filesystem::remove(path);
+        options.path = path;
+        options.fsync = FsyncPolicy::Always;
+    }
+
+    void TearDown() override { std::filesystem::remove(path); }
+
+    // Проигрывает журнал в новое дерево и возвращает его вывод.
+    std::string replay(size_t *replayed = nullptr) {
+        auto root = create_root_node();
+        MutationLog log(options);
+        EXPECT_TRUE(log.open(root, replayed));
+        return print_tree_string(root);
+    }
+
+    std::string path;
+    MutationLogOptions options;
+};
+
+TEST_F(MutationLogTest, ReplayRestoresTree) {
+    auto root = create_root_node();
+    {
+        MutationLog log(options);
+        size_t replayed = 1;
+        ASSERT_TRUE(log.open(root, &replayed));
+        EXPECT_EQ(replayed, 0u);
+
+        // Изменения применяются к дереву вызывающим, журнал только записывает их
+        create_node_by_path(root, "/Users");
+        log.append(TreeChangeKind::CreateNode, "/Users");
+        create_leaf_by_path(root, "/Users/bob", "bob_data");
+        log.append(TreeChangeKind::CreateLeaf, "/Users/bob", "bob_data");
+        create_leaf_by_path(root, "/Users/kate", "kate_data");
+        log.append(TreeChangeKind::CreateLeaf, "/Users/kate", "kate_data");
+        set_leaf_by_path(root, "/Users/bob", "new_data");
+        log.append(TreeChangeKind::SetLeaf, "/Users/bob", "new_data");
+        delete_leaf_by_path_linear(root, "/Users/kate");
+        uint64_t lsn = log.append(TreeChangeKind::DeleteLeaf, "/Users/kate");
+        EXPECT_TRUE(log.sync(lsn));
+        EXPECT_GE(log.fsync_count(), 1u);
+    }
+
+    size_t replayed = 0;
+    EXPECT_EQ(replay(&replayed), print_tree_string(root));
+    EXPECT_EQ(replayed, 5u);
+}
+
+TEST_F(MutationLogTest, TornTailIsDropped) {
+    {
+        MutationLog log(options);
+        ASSERT_TRUE(log.open(create_root_node()));
+        log.append(TreeChangeKind::CreateNode, "/Users");
+        log.sync(log.append(TreeChangeKind::CreateLeaf, "/Users/bob", "bob_data"));
+    }
+    auto intact_size = std::filesystem::file_size(path);
+
+    // Сбой посреди write(): в файле только начало следующей записи
+    std::string record;
+    encode_log_record(record, TreeChangeKind::CreateLeaf, "/Users/kate", "kate_data");
+    std::ofstream(path, std::ios::binary | std::ios::app) << record.substr(0, record.size() - 3);
+
+    size_t replayed = 0;
+    std::string tree = replay(&replayed);
+    EXPECT_EQ(replayed, 2u);
+    EXPECT_NE(tree.find("bob"), std::string::npos);
+    EXPECT_EQ(tree.find("kate"), std::string::npos);
+    EXPECT_EQ(std::filesystem::file_size(path), intact_size);
+}
+
+TEST_F(MutationLogTest, RewriteCompactsLog) {
+    auto root = create_root_node();
+    std::string expected;
+    uint64_t size_before = 0;
+    {
+        MutationLog log(options);
+        ASSERT_TRUE(log.open(root));
+        create_node_by_path(root, "/Users");
+        log.append(TreeChangeKind::CreateNode, "/Users");
+        create_node_by_path(root, "/Users/deep");
+        log.append(TreeChangeKind::CreateNode, "/Users/deep");
+        create_leaf_by_path(root, "/Users/deep/counter", "0");
+        log.append(TreeChangeKind::CreateLeaf, "/Users/deep/counter", "0");
+        uint64_t lsn = 0;
+        for (int i = 1; i <= 1000; ++i) {
+            set_leaf_by_path(root, "/Users/deep/counter", std::to_string(i));
+            lsn = log.append(TreeChangeKind::SetLeaf, "/Users/deep/counter", std::to_string(i));
+        }
+        ASSERT_TRUE(log.sync(lsn));
+        size_before = log.file_size();
+
+        ASSERT_TRUE(log.rewrite());
+        EXPECT_EQ(log.rewrite_count(), 1u);
+        EXPECT_LT(log.file_size(), size_before / 10);
+
+        // Записи после переписывания дописываются в новый файл
+        create_leaf_by_path(root, "/Users/bob", "bob_data");
+        log.sync(log.append(TreeChangeKind::CreateLeaf, "/Users/bob", "bob_data"));
+        expected = print_tree_string(root);
+    }
+
+    size_t replayed = 0;
+    EXPECT_EQ(replay(&replayed), expected);
+    EXPECT_EQ(replayed, 4u);  // Два каталога, лист из образа и лист после переписывания
+    EXPECT_LT(std::filesystem::file_size(path), size_before / 10);
+}
+
+TEST_F(MutationLogTest, RewriteWritesLargeImageInChunks) {
+    auto root = create_root_node();
+    std::string expected;
+    {
+        MutationLog log(options);
+        ASSERT_TRUE(log.open(root));
+        create_node_by_path(root, "/Users");
+        // Образ в несколько мегабайт: дочерний процесс пишет его несколькими порциями
+        const std::string value(200, 'x');
+        for (int i = 0; i < 20000; ++i) {
+            create_leaf_by_path(root, "/Users/leaf" + std::to_string(i), value);
+        }
+        ASSERT_TRUE(log.rewrite());
+        expected = print_tree_string(root);
+    }
+
+    size_t replayed = 0;
+    EXPECT_EQ(replay(&replayed), expected);
+    EXPECT_EQ(replayed, 20001u);
+}
+
+TEST_F(MutationLogTest, RejectsForeignFile) {
+    std::ofstream(path, std::ios::binary) << "not a log";
+    auto root = create_root_node();
+    MutationLog log(options);
+    EXPECT_FALSE(log.open(root));
+}
+
+}  // namespace database_test
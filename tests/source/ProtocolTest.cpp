@@ -0,0 +1,175 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "protocol.hpp"
+
+namespace database_test {
+
+TEST(ProtocolTest, VerbsMapToOpcodes) {
+    for (const auto &spec : kCommandSpecs) {
+        EXPECT_EQ(opcode_of(spec.verb), spec.opcode);
+        EXPECT_EQ(verb_of(spec.opcode), spec.verb);
+    }
+    static_assert(opcode_of("CREATE_LEAF") == Opcode::CreateLeaf);
+
+    EXPECT_EQ(opcode_of("create_leaf"), Opcode::Unknown);
+    EXPECT_EQ(opcode_of("CREATE"), Opcode::Unknown);
+    EXPECT_EQ(opcode_of(""), Opcode::Unknown);
+}
+
+TEST(ProtocolTest, ParsesTextLine) {
+    std::string input = "CREATE_LEAF  /Users/bob  hello world\r\nPRINT_TREE /\n";
+    Request request;
+    size_t consumed = 0;
+
+    ASSERT_EQ(parse_request(input, request, consumed), ParseStatus::Complete);
+    EXPECT_FALSE(request.binary);
+    EXPECT_EQ(request.opcode, Opcode::CreateLeaf);
+    EXPECT_EQ(request.path, "/Users/bob");
+    EXPECT_EQ(request.value, " hello world");  // Снимается только один пробел после пути
+    // Строки ссылаются на входной буфер, без копирования
+    EXPECT_EQ(request.path.data(), input.data() + 13);
+
+    std::string_view rest = std::string_view(input).substr(consumed);
+    ASSERT_EQ(parse_request(rest, request, consumed), ParseStatus::Complete);
+    EXPECT_EQ(request.opcode, Opcode::PrintTree);
+    EXPECT_EQ(request.path, "/");
+    EXPECT_EQ(request.value, "");
+    EXPECT_EQ(consumed, rest.size());
+}
+
+TEST(ProtocolTest, TextWithoutNewlineIsIncomplete) {
+    Request request;
+    size_t consumed = 0;
+    EXPECT_EQ(parse_request("CREATE_NODE /Users", request, consumed), ParseStatus::Incomplete);
+    EXPECT_EQ(parse_request("", request, consumed), ParseStatus::Incomplete);
+
+    std::string endless(kMaxCommandLength + 1, 'x');
+    EXPECT_EQ(parse_request(endless, request, consumed), ParseStatus::Error);
+}
+
+TEST(ProtocolTest, UnknownVerbKeepsText) {
+    Request request;
+    size_t consumed = 0;
+    ASSERT_EQ(parse_request("FLY /a\n", request, consumed), ParseStatus::Complete);
+    EXPECT_EQ(request.opcode, Opcode::Unknown);
+    EXPECT_EQ(request.verb, "FLY");
+}
+
+TEST(ProtocolTest, BinaryRoundTrip) {
+    std::string value("line1\nline2 \0 end", 17);
+    std::string frame = encode_request(Opcode::CreateLeaf, "/Users/bob", value);
+    EXPECT_EQ(frame.size(), kBinaryHeaderSize + 10 + value.size());
+
+    Request request;
+    size_t consumed = 0;
+    ASSERT_EQ(parse_request(frame, request, consumed), ParseStatus::Complete);
+    EXPECT_TRUE(request.binary);
+    EXPECT_EQ(request.opcode, Opcode::CreateLeaf);
+    EXPECT_EQ(request.path, "/Users/bob");
+    EXPECT_EQ(request.value, value);  // Перевод строки и нулевой байт допустимы
+    EXPECT_EQ(consumed, frame.size());
+
+    // Любой обрезанный префикс - неполный фрейм
+    for (size_t length = 1; length < frame.size(); ++length) {
+        EXPECT_EQ(parse_request(std::string_view(frame).substr(0, length), request, consumed),
+                  ParseStatus::Incomplete);
+    }
+}
+
+TEST(ProtocolTest, BinaryUnknownOpcodeAndOversizedFrame) {
+    Request request;
+    size_t consumed = 0;
+    std::string frame = encode_request(static_cast<Opcode>(200), "/a", "");
+    ASSERT_EQ(parse_request(frame, request, consumed), ParseStatus::Complete);
+    EXPECT_EQ(request.opcode, Opcode::Unknown);
+    EXPECT_EQ(request.raw_opcode, 200);
+
+    std::string oversized = encode_request(Opcode::CreateLeaf, "/a", "");
+    oversized[9] = 0x7F;  // value_len ~ 2 ГБ
+    EXPECT_EQ(parse_request(oversized, request, consumed), ParseStatus::Error);
+}
+
+TEST(ProtocolTest, TextAndBinaryCanBeMixed) {
+    std::string input = "hello\n" + encode_request(Opcode::DeleteNode, "/Shops", "") +
+                        "DELETE_LEAF /Users/bob\n";
+    std::string_view rest = input;
+    Request request;
+    size_t consumed = 0;
+    std::vector<Opcode> opcodes;
+    while (parse_request(rest, request, consumed) == ParseStatus::Complete) {
+        opcodes.push_back(request.opcode);
+        rest.remove_prefix(consumed);
+    }
+    EXPECT_TRUE(rest.empty());
+    EXPECT_EQ(opcodes,
+              (std::vector<Opcode>{Opcode::Hello, Opcode::DeleteNode, Opcode::DeleteLeaf}));
+}
+
+TEST(ProtocolTest, SplitsBatchItems) {
+    Request request;
+    size_t consumed = 0;
+    ASSERT_EQ(parse_request("MSET /a 1  /b\t2\n", request, consumed), ParseStatus::Complete);
+    EXPECT_EQ(request.opcode, Opcode::MSet);
+    std::vector<std::string_view> items;
+    ASSERT_TRUE(split_batch_items(false, request.path, request.value, items));
+    EXPECT_EQ(items, (std::vector<std::string_view>{"/a", "1", "/b", "2"}));
+
+    // Бинарные элементы могут содержать пробелы и переводы строк
+    std::vector<std::string_view> values = {"/a", "hello world\n", "/b", ""};
+    std::string frame = encode_request(Opcode::MSet, "", encode_batch_items(values));
+    ASSERT_EQ(parse_request(frame, request, consumed), ParseStatus::Complete);
+    ASSERT_TRUE(split_batch_items(true, request.path, request.value, items));
+    EXPECT_EQ(items, values);
+
+    std::string packed = encode_batch_items(values);
+    EXPECT_FALSE(split_batch_items(true, "", packed.substr(0, packed.size() - 3), items));
+}
+
+// Значение CREATE_LEAF не разбирается: похожий на TTL хвост - часть значения. Срок задается
+// только отдельным полем CREATE_LEAF_EX.
+TEST(ProtocolTest, TtlIsNotTakenFromValue) {
+    std::string input =
+        "CREATE_LEAF /note meet at 5 EX 5\n"
+        "CREATE_LEAF_EX /note 10 meet at 5 EX 5\n";
+    Request request;
+    size_t consumed = 0;
+    ASSERT_EQ(parse_request(input, request, consumed), ParseStatus::Complete);
+    EXPECT_EQ(request.opcode, Opcode::CreateLeaf);
+    EXPECT_EQ(request.value, "meet at 5 EX 5");
+
+    ASSERT_EQ(parse_request(std::string_view(input).substr(consumed), request, consumed),
+              ParseStatus::Complete);
+    EXPECT_EQ(request.opcode, Opcode::CreateLeafEx);
+    uint64_t seconds = 0;
+    std::string_view value;
+    ASSERT_TRUE(split_ttl_value(request.value, seconds, value));
+    EXPECT_EQ(seconds, 10u);
+    EXPECT_EQ(value, "meet at 5 EX 5");
+
+    // Бинарный фрейм: значение может содержать пробелы, переводы строк и нули
+    std::string data("a b\n\0 EX 7", 11);
+    std::string frame = encode_request(Opcode::CreateLeafEx, "/bin", "3 " + data);
+    ASSERT_EQ(parse_request(frame, request, consumed), ParseStatus::Complete);
+    ASSERT_TRUE(split_ttl_value(request.value, seconds, value));
+    EXPECT_EQ(seconds, 3u);
+    EXPECT_EQ(value, data);
+
+    EXPECT_TRUE(split_ttl_value("5", seconds, value));
+    EXPECT_EQ(value, "");
+    EXPECT_FALSE(split_ttl_value("", seconds, value));
+    EXPECT_FALSE(split_ttl_value("0 x", seconds, value));
+    EXPECT_FALSE(split_ttl_value("x 5", seconds, value));
+    EXPECT_FALSE(split_ttl_value(" 5 x", seconds, value));
+    EXPECT_FALSE(split_ttl_value(std::to_string(kMaxTtlSeconds + 1), seconds, value));
+}
+
+TEST(ProtocolTest, ReplyLengthIsLittleEndian) {
+    auto bytes = encode_reply_length(0x01020304);
+    EXPECT_EQ(bytes[0], 0x04);
+    EXPECT_EQ(bytes[3], 0x01);
+}
+
+}  // namespace database_test
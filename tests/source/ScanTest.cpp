@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pathLock.hpp"
+#include "scan.hpp"
+
+namespace database_test {
+
+class ScanTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = create_root_node();
+        create_node_by_path(root, "/Users");
+        create_leaf_by_path(root, "/Users/bob", "bob_data");
+        create_leaf_by_path(root, "/Users/kate", "kate_data");
+        create_node_by_path(root, "/Users/Login");
+        create_leaf_by_path(root, "/Users/Login/john", "1");
+        create_node_by_path(root, "/Users/Login/Empty");
+        create_node_by_path(root, "/Users/Password");
+        create_leaf_by_path(root, "/Users/Password/kate", "2");
+    }
+
+    static std::string path_of(const ScanEntry &entry) {
+        return std::string(entry.leaf ? entry.leaf->path : entry.node->path);
+    }
+
+    // Полный обход dir страницами по count записей; between вызывается между страницами.
+    template <typename Between>
+    std::vector<std::string> scan_all(const std::string &dir, size_t count, Between between) {
+        std::vector<std::string> paths;
+        std::string cursor(kScanStart);
+        std::vector<ScanEntry> page;
+        do {
+            std::string next;
+            EXPECT_TRUE(scan_subtree(find_node_by_path_linear(root, dir), cursor, count, page,
+                                     next));
+            EXPECT_LE(page.size(), count);
+            for (const auto &entry : page) {
+                paths.push_back(path_of(entry));
+            }
+            cursor = next;
+            between();
+        } while (cursor != kScanStart);
+        return paths;
+    }
+
+    std::vector<std::string> scan_all(const std::string &dir, size_t count) {
+        return scan_all(dir, count, [] {});
+    }
+
+    std::shared_ptr<Node> root;
+};
+
+TEST_F(ScanTest, PagesCoverSubtreeInPreorder) {
+    std::vector<std::string> expected = {
+        "/Users/bob",         "/Users/kate",     "/Users/Login",         "/Users/Login/john",
+        "/Users/Login/Empty", "/Users/Password", "/Users/Password/kate",
+    };
+    for (size_t count : {1, 2, 3, 7, 100}) {
+        EXPECT_EQ(scan_all("/Users", count), expected) << "count " << count;
+    }
+
+    std::vector<std::string> login = {"/Users/Login/john", "/Users/Login/Empty"};
+    EXPECT_EQ(scan_all("/Users/Login", 1), login);
+    EXPECT_EQ(scan_all("/", 100).size(), expected.size() + 1);
+    EXPECT_TRUE(scan_all("/Users/Login/Empty", 10).empty());
+}
+
+TEST_F(ScanTest, ResumesAfterDeletedCursor) {
+    std::vector<ScanEntry> page;
+    std::string next;
+    auto users = find_node_by_path_linear(root, "/Users");
+
+    // Курсор - лист bob, он удален: продолжение с kate
+    ASSERT_TRUE(scan_subtree(users, kScanStart, 1, page, next));
+    ASSERT_TRUE(delete_leaf_by_path_linear(root, "/Users/bob"));
+    ASSERT_TRUE(scan_subtree(users, next, 1, page, next));
+    EXPECT_EQ(path_of(page[0]), "/Users/kate");
+
+    // Курсор внутри /Users/Login, каталог пересоздан с тем же именем: его старое содержимое
+    // выдано, новый каталог - новая запись в конце списка
+    ASSERT_TRUE(scan_subtree(users, next, 2, page, next));
+    EXPECT_EQ(path_of(page[1]), "/Users/Login/john");
+    ASSERT_TRUE(delete_node_by_path_linear(root, "/Users/Login"));
+    create_node_by_path(root, "/Users/Login");
+    create_leaf_by_path(root, "/Users/Login/new", "3");
+
+    std::vector<std::string> rest;
+    while (next != kScanStart) {
+        ASSERT_TRUE(scan_subtree(users, next, 1, page, next));
+        for (const auto &entry : page) {
+            rest.push_back(path_of(entry));
+        }
+    }
+    std::vector<std::string> expected = {"/Users/Password", "/Users/Password/kate",
+                                         "/Users/Login", "/Users/Login/new"};
+    EXPECT_EQ(rest, expected);
+}
+
+TEST_F(ScanTest, RejectsForeignCursor) {
+    std::vector<ScanEntry> page;
+    std::string next;
+    auto users = find_node_by_path_linear(root, "/Users");
+    ASSERT_TRUE(scan_subtree(users, kScanStart, 3, page, next));
+
+    EXPECT_FALSE(scan_subtree(find_node_by_path_linear(root, "/Users/Login"), next, 3, page,
+                              next));
+    EXPECT_FALSE(scan_subtree(users, "zz", 3, page, next));
+    EXPECT_FALSE(scan_subtree(users, "4c", 3, page, next));
+}
+
+TEST_F(ScanTest, DeepTreeIsScannedIteratively) {
+    std::string deep = "/Users";
+    for (int i = 0; i < 5000; ++i) {
+        deep += "/d";
+        create_node_by_path(root, deep);
+    }
+    EXPECT_EQ(scan_all("/Users", 64).size(), 7u + 5000u);
+}
+
+// Случайные изменения между страницами: каждая запись, не удаленная за время обхода, выдается
+// ровно один раз.
+TEST_F(ScanTest, SurvivorsReturnedOnceUnderChurn) {
+    std::mt19937 random(42);
+    std::vector<std::string> dirs = {"/Users"};
+    for (int i = 0; i < 30; ++i) {
+        std::string dir = dirs[random() % dirs.size()] + "/n" + std::to_string(i);
+        create_node_by_path(root, dir);
+        dirs.push_back(dir);
+    }
+    for (int i = 0; i < 300; ++i) {
+        create_leaf_by_path(root, dirs[random() % dirs.size()] + "/l" + std::to_string(i), "v");
+    }
+
+    std::set<std::string> initial;
+    for (const auto &path : scan_all("/Users", 1000)) {
+        initial.insert(path);
+    }
+    std::set<std::string> deleted;
+    int created = 0;
+    auto churn = [&] {
+        for (int k = 0; k < 3; ++k) {
+            const std::string &dir = dirs[random() % dirs.size()];
+            std::string leaf = dir + "/l" + std::to_string(random() % 300);
+            if (random() % 2 && delete_leaf_by_path_linear(root, leaf)) {
+                deleted.insert(leaf);
+            }
+            create_leaf_by_path(root, dir + "/new" + std::to_string(created++), "v");
+        }
+        if (random() % 20 == 0) {
+            const std::string &dir = dirs[1 + random() % (dirs.size() - 1)];
+            for (const auto &path : initial) {
+                if (path == dir || path.starts_with(dir + "/")) {
+                    deleted.insert(path);
+                }
+            }
+            delete_node_by_path_linear(root, dir);
+        }
+    };
+
+    std::map<std::string, int> seen;
+    for (const auto &path : scan_all("/Users", 7, churn)) {
+        ++seen[path];
+    }
+    for (const auto &path : initial) {
+        if (!deleted.count(path)) {
+            EXPECT_EQ(seen[path], 1) << path;
+        }
+    }
+    for (const auto &[path, times] : seen) {
+        EXPECT_EQ(times, 1) << path;
+    }
+}
+
+// Страницы под S-блокировкой, пока другой поток создает и удаляет записи под X.
+TEST_F(ScanTest, ConcurrentWritersDoNotBreakScan) {
+    for (int i = 0; i < 200; ++i) {
+        create_leaf_by_path(root, "/Users/Login/stable" + std::to_string(i), "v");
+    }
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        for (int i = 0; !stop; ++i) {
+            PathLock lock(root, "/Users/Login", LockMode::Exclusive);
+            std::string path = "/Users/Login/tmp" + std::to_string(i % 50);
+            if (!delete_leaf_by_path_linear(root, path)) {
+                create_leaf_by_path(root, path, "v");
+            }
+        }
+    });
+
+    std::map<std::string, int> seen;
+    for (int round = 0; round < 20; ++round) {
+        seen.clear();
+        std::string cursor(kScanStart);
+        std::vector<ScanEntry> page;
+        do {
+            PathLock lock(root, "/Users", LockMode::Shared);
+            std::string next;
+            ASSERT_TRUE(scan_subtree(lock.node(), cursor, 5, page, next));
+            for (const auto &entry : page) {
+                ++seen[path_of(entry)];
+            }
+            cursor = next;
+        } while (cursor != kScanStart);
+        for (int i = 0; i < 200; ++i) {
+            EXPECT_EQ(seen["/Users/Login/stable" + std::to_string(i)], 1);
+        }
+    }
+    stop = true;
+    writer.join();
+}
+
+}  // namespace database_test
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include "segmentTree.hpp"
+
+namespace database_test {
+
+class SegmentTreeTest : public ::testing::Test {
+protected:
+    SegmentTree tree;
+};
+
+TEST_F(SegmentTreeTest, CreateAndFind) {
+    ASSERT_TRUE(tree.create_node("/Users"));
+    ASSERT_TRUE(tree.create_node("/Users/Login"));
+    ASSERT_TRUE(tree.create_leaf("/Users/Login/bob", "bob_data"));
+
+    EXPECT_TRUE(tree.node_exists("/"));
+    EXPECT_TRUE(tree.node_exists("/Users"));
+    EXPECT_TRUE(tree.node_exists("/Users/Login"));
+    EXPECT_FALSE(tree.node_exists("/Users/Login/bob"));
+
+    const std::string *value = tree.find_leaf("/Users/Login/bob");
+    ASSERT_NE(value, nullptr);
+    EXPECT_EQ(*value, "bob_data");
+    EXPECT_EQ(tree.find_leaf("/Users/Login"), nullptr);
+    EXPECT_EQ(tree.find_leaf("/Users/Login/kate"), nullptr);
+}
+
+TEST_F(SegmentTreeTest, RejectsInvalidAndDuplicatePaths) {
+    ASSERT_TRUE(tree.create_node("/Users"));
+    ASSERT_TRUE(tree.create_leaf("/Users/bob", "bob_data"));
+
+    EXPECT_FALSE(tree.create_node("/"));
+    EXPECT_FALSE(tree.create_node("Users"));
+    EXPECT_FALSE(tree.create_node("/Users/"));
+    EXPECT_FALSE(tree.create_node("/Users"));
+    EXPECT_FALSE(tree.create_node("/Users/bob"));
+    EXPECT_FALSE(tree.create_leaf("/Users", "data"));
+    EXPECT_FALSE(tree.create_leaf("/Missing/bob", "data"));
+    EXPECT_FALSE(tree.delete_node("/"));
+}
+
+TEST_F(SegmentTreeTest, SegmentsAreInterned) {
+    ASSERT_TRUE(tree.create_node("/a"));
+    ASSERT_TRUE(tree.create_node("/b"));
+    ASSERT_TRUE(tree.create_leaf("/a/session", "1"));
+    ASSERT_TRUE(tree.create_leaf("/b/session", "2"));
+
+    // "a", "b" и "session" - три уникальных сегмента на четыре записи
+    EXPECT_EQ(tree.segments().size(), 3u);
+
+    ASSERT_TRUE(tree.delete_leaf("/a/session"));
+    EXPECT_EQ(tree.segments().size(), 3u);
+    ASSERT_TRUE(tree.delete_leaf("/b/session"));
+    EXPECT_EQ(tree.segments().size(), 2u);
+}
+
+TEST_F(SegmentTreeTest, SingleChildChainsAreCompressed) {
+    ASSERT_TRUE(tree.create_node("/a"));
+    ASSERT_TRUE(tree.create_node("/a/b"));
+    ASSERT_TRUE(tree.create_node("/a/b/c"));
+    EXPECT_EQ(tree.node_count(), 3u);
+    EXPECT_EQ(tree.compressed_node_count(), 1u);
+
+    // Лист в середине цепочки разбивает ее на два узла
+    ASSERT_TRUE(tree.create_leaf("/a/b/x", "value"));
+    EXPECT_EQ(tree.compressed_node_count(), 2u);
+    EXPECT_TRUE(tree.node_exists("/a/b/c"));
+    EXPECT_NE(tree.find_leaf("/a/b/x"), nullptr);
+
+    // После удаления листа цепочка снова сливается
+    ASSERT_TRUE(tree.delete_leaf("/a/b/x"));
+    EXPECT_EQ(tree.compressed_node_count(), 1u);
+    EXPECT_TRUE(tree.node_exists("/a/b/c"));
+}
+
+TEST_F(SegmentTreeTest, DuplicateInsideChainKeepsCompression) {
+    ASSERT_TRUE(tree.create_node("/a"));
+    ASSERT_TRUE(tree.create_node("/a/b"));
+    ASSERT_TRUE(tree.create_node("/a/b/c"));
+
+    EXPECT_FALSE(tree.create_node("/a/b"));
+    EXPECT_FALSE(tree.create_leaf("/a/b/c", "value"));
+    EXPECT_EQ(tree.compressed_node_count(), 1u);
+    EXPECT_EQ(tree.node_count(), 3u);
+    EXPECT_TRUE(tree.node_exists("/a/b/c"));
+}
+
+TEST_F(SegmentTreeTest, DeleteNodeInsideChain) {
+    ASSERT_TRUE(tree.create_node("/a"));
+    ASSERT_TRUE(tree.create_node("/a/b"));
+    ASSERT_TRUE(tree.create_node("/a/b/c"));
+    ASSERT_TRUE(tree.create_leaf("/a/b/c/leaf", "value"));
+
+    ASSERT_TRUE(tree.delete_node("/a/b"));
+    EXPECT_TRUE(tree.node_exists("/a"));
+    EXPECT_FALSE(tree.node_exists("/a/b"));
+    EXPECT_FALSE(tree.node_exists("/a/b/c"));
+    EXPECT_EQ(tree.find_leaf("/a/b/c/leaf"), nullptr);
+    EXPECT_EQ(tree.node_count(), 1u);
+    EXPECT_EQ(tree.leaf_count(), 0u);
+    EXPECT_EQ(tree.segments().size(), 1u);
+
+    ASSERT_TRUE(tree.create_node("/a/b"));
+    EXPECT_TRUE(tree.node_exists("/a/b"));
+}
+
+TEST_F(SegmentTreeTest, DeleteSubtreeMergesParent) {
+    ASSERT_TRUE(tree.create_node("/a"));
+    ASSERT_TRUE(tree.create_node("/a/b"));
+    ASSERT_TRUE(tree.create_node("/a/c"));
+    ASSERT_TRUE(tree.create_node("/a/c/d"));
+    EXPECT_EQ(tree.compressed_node_count(), 3u);
+
+    ASSERT_TRUE(tree.delete_node("/a/b"));
+    EXPECT_EQ(tree.compressed_node_count(), 1u);
+    EXPECT_TRUE(tree.node_exists("/a/c/d"));
+    EXPECT_EQ(tree.node_count(), 3u);
+}
+
+TEST_F(SegmentTreeTest, PrintTreeRebuildsFullPaths) {
+    ASSERT_TRUE(tree.create_node("/Users"));
+    ASSERT_TRUE(tree.create_node("/Users/Login"));
+    ASSERT_TRUE(tree.create_leaf("/Users/Login/kate", "kate_data"));
+    ASSERT_TRUE(tree.create_leaf("/Users/Login/bob", "bob_data"));
+    ASSERT_TRUE(tree.create_node("/Shops"));
+
+    EXPECT_EQ(tree.print_tree_string("/"),
+              "📁 /\n"
+              "  📁 /Shops\n"
+              "  📁 /Users\n"
+              "    📁 /Users/Login\n"
+              "      🍃 /Users/Login/bob (value: 'bob_data')\n"
+              "      🍃 /Users/Login/kate (value: 'kate_data')\n");
+    EXPECT_EQ(tree.print_tree_string("/Users/Login"),
+              "📁 /Users/Login\n"
+              "  🍃 /Users/Login/bob (value: 'bob_data')\n"
+              "  🍃 /Users/Login/kate (value: 'kate_data')\n");
+    EXPECT_EQ(tree.print_tree_string("/Missing"), "");
+}
+
+}  // namespace database_test
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+#include "snapshot.hpp"
+
+namespace database_test {
+
+class SnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        // ctest запускает тесты отдельными процессами параллельно: у каждого свой файл
+        const auto *test = ::testing::UnitTest::GetInstance()->current_test_info();
+        path = ::testing::TempDir() + "snapshot_test_" + test->name() + "_" +
+               std::to_string(getpid()) + ".mcdb";
+        std::filesystem::remove(path);
+        root = create_root_node();
+        create_node_by_path(root, "/Users");
+        create_leaf_by_path(root, "/Users/bob", "bob_data");
+        create_leaf_by_path(root, "/Users/kate", std::string("bin\0ary\n", 8));
+        create_node_by_path(root, "/Users/empty");
+        create_node_by_path(root, "/Shops");
+        create_leaf_by_path(root, "/Shops/milk", "");
+        create_leaf_by_path(root, "/readme", "root leaf");
+    }
+
+    void TearDown() override { std::filesystem::remove(path); }
+
+    std::string path;
+    std::shared_ptr<Node> root;
+};
+
+TEST_F(SnapshotTest, LoadRestoresTree) {
+    ASSERT_TRUE(write_snapshot(root, path));
+
+    auto loaded = create_root_node();
+    size_t entries = 0;
+    ASSERT_TRUE(load_snapshot(loaded, path, &entries));
+    EXPECT_EQ(entries, 7u);
+    EXPECT_EQ(print_tree_string(loaded), print_tree_string(root));
+
+    // Загруженные записи доступны обычным поиском по пути
+    auto kate = find_leaf_by_path_linear(loaded, "/Users/kate");
+    ASSERT_NE(kate, nullptr);
+    EXPECT_EQ(std::string_view(kate->value), std::string_view("bin\0ary\n", 8));
+    EXPECT_NE(find_node_by_path_linear(loaded, "/Users/empty"), nullptr);
+    EXPECT_NE(create_leaf_by_path(loaded, "/Users/empty/new", "1"), nullptr);
+}
+
+TEST_F(SnapshotTest, DeepTreeDoesNotRecurse) {
+    std::string deep;
+    for (int i = 0; i < 5000; ++i) {
+        deep += "/d";
+        create_node_by_path(root, deep);
+    }
+    create_leaf_by_path(root, deep + "/bottom", "found");
+    ASSERT_TRUE(write_snapshot(root, path));
+
+    auto loaded = create_root_node();
+    ASSERT_TRUE(load_snapshot(loaded, path));
+    auto bottom = find_leaf_by_path_linear(loaded, deep + "/bottom");
+    ASSERT_NE(bottom, nullptr);
+    EXPECT_EQ(bottom->value, "found");
+}
+
+TEST_F(SnapshotTest, RejectsCorruptedImage) {
+    ASSERT_TRUE(write_snapshot(root, path));
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(kSnapshotMagic.size()) + 3);
+        file.put('X');
+    }
+    EXPECT_FALSE(load_snapshot(create_root_node(), path));
+
+    std::ofstream(path, std::ios::binary) << "not a snapshot";
+    EXPECT_FALSE(load_snapshot(create_root_node(), path));
+    EXPECT_FALSE(load_snapshot(create_root_node(), path + ".missing"));
+}
+
+TEST_F(SnapshotTest, ForkedImageIsPointInTime) {
+    std::string expected = print_tree_string(root);
+    pid_t pid = fork_snapshot(root, path);
+    ASSERT_GT(pid, 0);
+
+    // Изменения после fork() в образ не попадают
+    set_leaf_by_path(root, "/Users/bob", "changed");
+    delete_node_by_path_linear(root, "/Shops");
+    ASSERT_TRUE(wait_snapshot(pid));
+
+    auto loaded = create_root_node();
+    ASSERT_TRUE(load_snapshot(loaded, path));
+    EXPECT_EQ(print_tree_string(loaded), expected);
+}
+
+}  // namespace database_test
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pathLock.hpp"
+#include "subtreeStream.hpp"
+#include "tree.hpp"
+
+namespace database_test {
+
+// Итоги поддерева, посчитанные обходом.
+static SubtreeStats walk_stats(const Node &node) {
+    SubtreeStats stats;
+    for (const auto &child : node.childs) {
+        SubtreeStats below = walk_stats(*child);
+        stats.nodes += below.nodes + 1;
+        stats.leaves += below.leaves;
+        stats.bytes += below.bytes + child->path.size();
+    }
+    for (const Leaf *leaf = node.east.get(); leaf; leaf = leaf->east.get()) {
+        ++stats.leaves;
+        stats.bytes += leaf->path.size() + leaf->value.size();
+    }
+    return stats;
+}
+
+// Счетчики каждого каталога дерева совпадают с обходом.
+static void expect_totals_match(const std::shared_ptr<Node> &node) {
+    SubtreeStats stats = subtree_stats_of(*node);
+    SubtreeStats expected = walk_stats(*node);
+    EXPECT_EQ(stats.nodes, expected.nodes) << node->path;
+    EXPECT_EQ(stats.leaves, expected.leaves) << node->path;
+    EXPECT_EQ(stats.bytes, expected.bytes) << node->path;
+    for (const auto &child : node->childs) {
+        expect_totals_match(child);
+    }
+}
+
+class SubtreeStatsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = create_root_node();
+        create_node_by_path(root, "/Users");
+        create_node_by_path(root, "/Users/Login");
+        create_node_by_path(root, "/Shops");
+        create_leaf_by_path(root, "/Users/Login/bob", "bob_data");
+        create_leaf_by_path(root, "/Users/Login/kate", "kate_data");
+        create_leaf_by_path(root, "/Users/admin", "1");
+    }
+
+    std::shared_ptr<Node> root;
+};
+
+TEST_F(SubtreeStatsTest, CountsDescendants) {
+    auto users = find_node_by_path_linear(root, "/Users");
+    SubtreeStats stats = subtree_stats_of(*users);
+    EXPECT_EQ(stats.nodes, 1u);
+    EXPECT_EQ(stats.leaves, 3u);
+    EXPECT_EQ(stats.bytes, std::string("/Users/Login").size() +
+                               std::string("/Users/Login/bob").size() + 8 +
+                               std::string("/Users/Login/kate").size() + 9 +
+                               std::string("/Users/admin").size() + 1);
+    EXPECT_EQ(subtree_stats_of(*root).nodes, 3u);
+    expect_totals_match(root);
+}
+
+TEST_F(SubtreeStatsTest, FollowsOverwritesAndDeletes) {
+    set_leaf_by_path(root, "/Users/Login/bob", std::string(1000, 'x'));
+    set_child_leaf(find_node_by_path_linear(root, "/Users"), "/Users/admin", "");
+    set_leaf_by_path(root, "/Shops/new", "value");
+    expect_totals_match(root);
+
+    delete_leaf_by_path_linear(root, "/Users/Login/kate");
+    expect_totals_match(root);
+
+    delete_node_by_path_linear(root, "/Users/Login");
+    expect_totals_match(root);
+    EXPECT_EQ(subtree_stats_of(*find_node_by_path_linear(root, "/Users")).leaves, 1u);
+
+    delete_node_by_path_linear(root, "/Users");
+    delete_node_by_path_linear(root, "/Shops");
+    SubtreeStats empty = subtree_stats_of(*root);
+    EXPECT_EQ(empty.nodes, 0u);
+    EXPECT_EQ(empty.leaves, 0u);
+    EXPECT_EQ(empty.bytes, 0u);
+}
+
+// Поддерево, построенное отдельно, приносит свои итоги; замененный каталог их уносит.
+TEST_F(SubtreeStatsTest, FollowsAttachAndReplace) {
+    auto subtree = create_detached_node("/Users/Login");
+    auto archive = create_node(subtree, "/Users/Login/archive");
+    create_leaf(archive, "/Users/Login/archive/old", "old_data");
+    create_leaf(subtree, "/Users/Login/eve", "eve_data");
+    expect_totals_match(subtree);
+
+    ASSERT_TRUE(attach_subtree(find_node_by_path_linear(root, "/Users"), subtree));
+    expect_totals_match(root);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/Login/bob"), nullptr);
+    EXPECT_EQ(subtree_stats_of(*root).leaves, 3u);
+
+    create_leaf_by_path(root, "/Users/Login/archive/new", "new_data");
+    expect_totals_match(root);
+}
+
+// Писатели разных каталогов одновременно меняют счетчики общих предков.
+TEST_F(SubtreeStatsTest, ConcurrentWritersKeepTotals) {
+    constexpr int kThreads = 8;
+    constexpr int kLeaves = 500;
+    for (int t = 0; t < kThreads; ++t) {
+        create_node_by_path(root, "/Users/t" + std::to_string(t));
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([this, t] {
+            std::string dir = "/Users/t" + std::to_string(t);
+            for (int i = 0; i < kLeaves; ++i) {
+                std::string path = dir + "/k" + std::to_string(i);
+                PathLock lock = PathLock::parent_of(root, path, LockMode::Exclusive);
+                set_child_leaf(lock.node(), path, std::string(i % 7, 'v'));
+                if (i % 3 == 0) {
+                    delete_leaf(root, find_child_leaf(lock.node(), name_of(path)));
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    expect_totals_match(root);
+}
+
+}  // namespace database_test
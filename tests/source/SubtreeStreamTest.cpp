@@ -0,0 +1,172 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "scan.hpp"
+#include "subtreeStream.hpp"
+
+namespace database_test {
+
+class SubtreeStreamTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = create_root_node();
+        create_node_by_path(root, "/Users");
+        create_leaf_by_path(root, "/Users/bob", "bob_data");
+        create_leaf_by_path(root, "/Users/kate", std::string("a\nb\0c", 5));
+        create_node_by_path(root, "/Users/Login");
+        create_leaf_by_path(root, "/Users/Login/john", "1");
+        create_node_by_path(root, "/Users/Login/Empty");
+        create_node_by_path(root, "/Users/Password");
+        create_leaf_by_path(root, "/Users/Password/kate", "");
+        create_node_by_path(root, "/Shops");
+    }
+
+    // Поток поддерева dir, собранный из порций по count записей.
+    std::string export_all(const std::string &dir, size_t count) {
+        std::string stream;
+        std::string cursor(kScanStart);
+        do {
+            std::string next;
+            EXPECT_TRUE(export_chunk(find_node_by_path_linear(root, dir), cursor, count, stream,
+                                     next));
+            cursor = next;
+        } while (cursor != kScanStart);
+        return stream;
+    }
+
+    static std::string dump(const std::shared_ptr<Node> &node) {
+        std::string text;
+        std::string next;
+        std::vector<ScanEntry> page;
+        scan_subtree(node, kScanStart, 1000, page, next);
+        for (const auto &entry : page) {
+            text += entry.leaf ? entry.leaf->path + "=" + entry.leaf->value + ";"
+                               : entry.node->path + ";";
+        }
+        return text;
+    }
+
+    std::shared_ptr<Node> root;
+};
+
+TEST_F(SubtreeStreamTest, ExportImportRoundTrip) {
+    std::string stream = export_all("/Users", 1000);
+    EXPECT_EQ(export_all("/Users", 1), stream);
+    EXPECT_TRUE(std::string_view(stream).starts_with(kSubtreeStreamMagic));
+
+    SubtreeImporter importer("/Shops/Copy");
+    ASSERT_TRUE(importer.feed(stream));
+    EXPECT_EQ(importer.entries(), 7u);
+    auto subtree = importer.finish();
+    ASSERT_NE(subtree, nullptr);
+    ASSERT_TRUE(attach_subtree(find_node_by_path_linear(root, "/Shops"), subtree));
+
+    std::string expected = dump(find_node_by_path_linear(root, "/Users"));
+    std::string copied = dump(find_node_by_path_linear(root, "/Shops/Copy"));
+    size_t position;
+    while ((position = expected.find("/Users")) != std::string::npos) {
+        expected.replace(position, 6, "/Shops/Copy");
+    }
+    EXPECT_EQ(copied, expected);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Shops/Copy/Login/john")->value, "1");
+    EXPECT_NE(find_node_by_path_linear(root, "/Shops/Copy/Login/Empty"), nullptr);
+}
+
+TEST_F(SubtreeStreamTest, StreamMayBeSplitAnywhere) {
+    std::string stream = export_all("/", 3);
+    for (size_t piece : {1, 2, 5, 13}) {
+        SubtreeImporter importer("/Restored");
+        for (size_t i = 0; i < stream.size(); i += piece) {
+            ASSERT_TRUE(importer.feed(std::string_view(stream).substr(i, piece)));
+        }
+        auto subtree = importer.finish();
+        ASSERT_NE(subtree, nullptr) << "piece " << piece;
+        EXPECT_EQ(importer.entries(), 9u);
+        ASSERT_TRUE(attach_subtree(root, subtree));
+        EXPECT_EQ(std::string_view(find_leaf_by_path_linear(root, "/Restored/Users/kate")->value),
+                  std::string_view("a\nb\0c", 5));
+    }
+}
+
+TEST_F(SubtreeStreamTest, RejectsMalformedStreams) {
+    std::string stream = export_all("/Users", 100);
+
+    SubtreeImporter truncated("/Copy");
+    ASSERT_TRUE(truncated.feed(std::string_view(stream).substr(0, stream.size() - 1)));
+    EXPECT_EQ(truncated.finish(), nullptr);
+
+    SubtreeImporter wrong_magic("/Copy");
+    EXPECT_FALSE(wrong_magic.feed("MCDBXXXX"));
+    EXPECT_FALSE(wrong_magic.feed(stream));
+
+    // Запись глубже последнего каталога
+    std::string orphan(kSubtreeStreamMagic);
+    orphan += std::string("L\x02\x01x\x01y", 6);
+    SubtreeImporter bad_depth("/Copy");
+    EXPECT_FALSE(bad_depth.feed(orphan));
+
+    // Имя повторяется в каталоге
+    std::string duplicate(kSubtreeStreamMagic);
+    duplicate += std::string("L\x01\x01x\x00L\x01\x01x\x00", 10);
+    SubtreeImporter bad_name("/Copy");
+    EXPECT_FALSE(bad_name.feed(duplicate));
+}
+
+TEST_F(SubtreeStreamTest, AttachReplacesDirectory) {
+    std::string stream = export_all("/Users/Password", 100);
+    SubtreeImporter importer("/Users/Login");
+    ASSERT_TRUE(importer.feed(stream));
+    auto subtree = importer.finish();
+    ASSERT_NE(subtree, nullptr);
+    ASSERT_TRUE(attach_subtree(find_node_by_path_linear(root, "/Users"), subtree));
+
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/Login/john"), nullptr);
+    EXPECT_EQ(find_node_by_path_linear(root, "/Users/Login/Empty"), nullptr);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/Login/kate")->value, "");
+    EXPECT_EQ(dump(find_node_by_path_linear(root, "/Users")),
+              "/Users/bob=bob_data;/Users/kate=" + std::string("a\nb\0c", 5) +
+                  ";/Users/Password;/Users/Password/kate=;/Users/Login;/Users/Login/kate=;");
+
+    // Имя занято листом: поддерево не присоединяется
+    SubtreeImporter leaf("/Users/bob");
+    ASSERT_TRUE(leaf.feed(stream));
+    auto rejected = leaf.finish();
+    EXPECT_FALSE(attach_subtree(find_node_by_path_linear(root, "/Users"), rejected));
+    discard_detached_subtree(rejected);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/bob")->value, "bob_data");
+}
+
+// Записи, созданные после присоединения, получают seq больше записей поддерева, поэтому SCAN
+// продолжает обход с курсора внутри присоединенного каталога.
+TEST_F(SubtreeStreamTest, AttachedEntriesKeepScanOrder) {
+    auto shops = find_node_by_path_linear(root, "/Shops");
+    SubtreeImporter importer("/Shops/Big");
+    std::string stream(kSubtreeStreamMagic);
+    for (int i = 0; i < 50; ++i) {
+        std::string name = "l" + std::to_string(i);
+        stream += 'L';
+        stream += '\x01';
+        stream += static_cast<char>(name.size());
+        stream += name;
+        stream += '\x00';
+    }
+    ASSERT_TRUE(importer.feed(stream));
+    ASSERT_TRUE(attach_subtree(shops, importer.finish()));
+    auto big = find_node_by_path_linear(root, "/Shops/Big");
+    create_leaf_by_path(root, "/Shops/Big/new", "v");
+    EXPECT_GT(find_leaf_by_path_linear(root, "/Shops/Big/new")->seq,
+              find_leaf_by_path_linear(root, "/Shops/Big/l49")->seq);
+
+    std::vector<ScanEntry> page;
+    std::string next;
+    ASSERT_TRUE(scan_subtree(big, kScanStart, 50, page, next));
+    ASSERT_TRUE(delete_leaf_by_path_linear(root, "/Shops/Big/l49"));
+    ASSERT_TRUE(scan_subtree(big, next, 50, page, next));
+    ASSERT_EQ(page.size(), 1u);
+    EXPECT_EQ(page[0].leaf->path, "/Shops/Big/new");
+}
+
+}  // namespace database_test
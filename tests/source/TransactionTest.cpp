@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "expiry.hpp"
+#include "protocol.hpp"
+#include "transaction.hpp"
+
+namespace database_test {
+
+class TransactionTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        root = create_root_node();
+        create_node_by_path(root, "/Users");
+        create_leaf_by_path(root, "/Users/bob", "bob_data");
+    }
+
+    std::shared_ptr<Node> root;
+};
+
+TEST_F(TransactionTest, ChangesSeeEarlierChanges) {
+    std::vector<TreeChange> changes = {
+        {TreeChangeKind::CreateNode, "/Shops"},
+        {TreeChangeKind::CreateLeaf, "/Shops/milk"},  // Родитель создан этой же транзакцией
+        {TreeChangeKind::SetLeaf, "/Users/bob"},
+        {TreeChangeKind::DeleteLeaf, "/Users/bob"},
+        {TreeChangeKind::CreateNode, "/Users/bob"},  // Имя освобождено удалением листа
+    };
+    EXPECT_EQ(find_failing_change(root, changes), changes.size());
+
+    // Проверка ничего не меняет в дереве
+    EXPECT_EQ(find_node_by_path_linear(root, "/Shops"), nullptr);
+    EXPECT_NE(find_leaf_by_path_linear(root, "/Users/bob"), nullptr);
+}
+
+TEST_F(TransactionTest, ReportsFirstFailingChange) {
+    std::vector<TreeChange> changes = {
+        {TreeChangeKind::CreateLeaf, "/Users/kate"},
+        {TreeChangeKind::CreateLeaf, "/Users/kate"},  // Уже создан первой командой
+        {TreeChangeKind::DeleteNode, "/Missing"},
+    };
+    EXPECT_EQ(find_failing_change(root, changes), 1u);
+
+    EXPECT_EQ(find_failing_change(root, {{TreeChangeKind::SetLeaf, "/Users"}}), 0u);
+    EXPECT_EQ(find_failing_change(root, {{TreeChangeKind::DeleteNode, "/"}}), 0u);
+    EXPECT_EQ(find_failing_change(root, {{TreeChangeKind::CreateNode, "/a/b"}}), 0u);
+}
+
+TEST_F(TransactionTest, DeletedNodeHidesItsSubtree) {
+    std::vector<TreeChange> changes = {
+        {TreeChangeKind::CreateLeaf, "/Users/kate"},
+        {TreeChangeKind::DeleteNode, "/Users"},
+        {TreeChangeKind::CreateNode, "/Users"},
+        {TreeChangeKind::DeleteLeaf, "/Users/bob"},  // Лист был внутри удаленного каталога
+    };
+    EXPECT_EQ(find_failing_change(root, changes), 3u);
+
+    changes.back() = {TreeChangeKind::DeleteLeaf, "/Users/kate"};
+    EXPECT_EQ(find_failing_change(root, changes), 3u);
+
+    changes.back() = {TreeChangeKind::CreateLeaf, "/Users/bob"};
+    EXPECT_EQ(find_failing_change(root, changes), changes.size());
+}
+
+TEST_F(TransactionTest, ExpiredLeafIsAbsent) {
+    // Лист истек, но колесо TTL его еще не удалило: создание на его месте проходит, как и вне
+    // транзакции
+    find_leaf_by_path_linear(root, "/Users/bob")->expires_at = unix_time_ms() - 1;
+    EXPECT_EQ(find_failing_change(root, {{TreeChangeKind::CreateLeaf, "/Users/bob"}}), 1u);
+    EXPECT_EQ(find_failing_change(root, {{TreeChangeKind::CreateNode, "/Users/bob"}}), 1u);
+    EXPECT_EQ(find_failing_change(root, {{TreeChangeKind::DeleteLeaf, "/Users/bob"}}), 0u);
+}
+
+TEST_F(TransactionTest, MalformedTtlIsRejectedWhenQueued) {
+    // Иначе EXEC применил бы предыдущие команды и только потом ответил бы 400 на эту
+    EXPECT_FALSE(arguments_valid(Opcode::CreateLeafEx, "abc v"));
+    EXPECT_FALSE(arguments_valid(Opcode::CreateLeafEx, "0 v"));
+    EXPECT_FALSE(arguments_valid(Opcode::CreateLeafEx, std::to_string(kMaxTtlSeconds + 1)));
+    EXPECT_TRUE(arguments_valid(Opcode::CreateLeafEx, "10 v"));
+    EXPECT_TRUE(arguments_valid(Opcode::CreateLeaf, "abc v"));
+    EXPECT_TRUE(arguments_valid(Opcode::SetLeaf, ""));
+}
+
+}  // namespace database_test
@@ -0,0 +1,157 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "pathLock.hpp"
+#include "tree.hpp"
+
+namespace database_test {
+
+TEST(IntentionLockTest, CompatibilityMatrix) {
+    IntentionLock lock;
+
+    lock.lock(LockMode::IntentionExclusive);
+    EXPECT_TRUE(lock.try_lock(LockMode::IntentionShared));
+    EXPECT_TRUE(lock.try_lock(LockMode::IntentionExclusive));
+    EXPECT_FALSE(lock.try_lock(LockMode::Shared));
+    EXPECT_FALSE(lock.try_lock(LockMode::Exclusive));
+    lock.unlock(LockMode::IntentionExclusive);
+    lock.unlock(LockMode::IntentionExclusive);
+    lock.unlock(LockMode::IntentionShared);
+
+    lock.lock(LockMode::Shared);
+    EXPECT_TRUE(lock.try_lock(LockMode::Shared));
+    EXPECT_TRUE(lock.try_lock(LockMode::IntentionShared));
+    EXPECT_FALSE(lock.try_lock(LockMode::IntentionExclusive));
+    EXPECT_FALSE(lock.try_lock(LockMode::Exclusive));
+    lock.unlock(LockMode::IntentionShared);
+    lock.unlock(LockMode::Shared);
+    lock.unlock(LockMode::Shared);
+
+    lock.lock(LockMode::Exclusive);
+    EXPECT_FALSE(lock.try_lock(LockMode::IntentionShared));
+    EXPECT_FALSE(lock.try_lock(LockMode::Exclusive));
+    lock.unlock(LockMode::Exclusive);
+    EXPECT_TRUE(lock.try_lock(LockMode::Exclusive));
+    lock.unlock(LockMode::Exclusive);
+}
+
+TEST(PathLockTest, LocksAncestorsWithIntention) {
+    auto root = create_root_node();
+    auto users = create_node_by_path(root, "/Users");
+    auto login = create_node_by_path(root, "/Users/Login");
+    create_node_by_path(root, "/Shops");
+
+    {
+        PathLock lock(root, "/Users/Login", LockMode::Exclusive);
+        ASSERT_EQ(lock.node(), login);
+
+        // Предки держат IX: соседнее поддерево доступно, весь /Users - нет
+        EXPECT_FALSE(users->lock.try_lock(LockMode::Shared));
+        EXPECT_FALSE(root->lock.try_lock(LockMode::Exclusive));
+        PathLock shops(root, "/Shops", LockMode::Exclusive);
+        EXPECT_TRUE(shops.node());
+    }
+
+    EXPECT_TRUE(users->lock.try_lock(LockMode::Exclusive));
+    users->lock.unlock(LockMode::Exclusive);
+
+    EXPECT_FALSE(PathLock(root, "/Missing/x", LockMode::Shared).node());
+    EXPECT_EQ(PathLock::parent_of(root, "/Users/Login/bob", LockMode::Exclusive).node(), login);
+    EXPECT_EQ(PathLock::parent_of(root, "/Users", LockMode::Exclusive).node(), root);
+    EXPECT_FALSE(PathLock::parent_of(root, "/", LockMode::Exclusive).node());
+    // После всех разблокировок корень снова свободен
+    EXPECT_TRUE(root->lock.try_lock(LockMode::Exclusive));
+    root->lock.unlock(LockMode::Exclusive);
+}
+
+// Писатели в разных поддеревьях, удаление и пересоздание общего поддерева и читатели
+// работают одновременно. В конце дерево и индекс должны быть согласованы.
+TEST(PathLockTest, ConcurrentMutationsKeepTreeConsistent) {
+    constexpr int kWriters = 4;
+    constexpr int kIterations = 300;
+
+    auto root = create_root_node();
+    for (int w = 0; w < kWriters; ++w) {
+        create_node_by_path(root, "/w" + std::to_string(w));
+    }
+    create_node_by_path(root, "/shared");
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> failures{0};
+    std::vector<std::thread> threads;
+
+    for (int w = 0; w < kWriters; ++w) {
+        threads.emplace_back([&, w] {
+            std::string dir = "/w" + std::to_string(w);
+            for (int i = 0; i < kIterations; ++i) {
+                std::string leaf = dir + "/leaf_" + std::to_string(i % 16);
+                PathLock lock = PathLock::parent_of(root, leaf, LockMode::Exclusive);
+                bool ok = find_leaf_by_path_linear(root, leaf)
+                              ? delete_leaf_by_path_linear(root, leaf)
+                              : create_leaf_by_path(root, leaf, "v") != nullptr;
+                if (!ok) {
+                    ++failures;
+                }
+            }
+        });
+    }
+
+    // Удаляет и пересоздает поддерево /shared/sub, пока в нем могут работать другие
+    threads.emplace_back([&] {
+        for (int i = 0; i < kIterations; ++i) {
+            PathLock lock(root, "/shared", LockMode::Exclusive);
+            if (find_node_by_path_linear(root, "/shared/sub")) {
+                delete_node_by_path_linear(root, "/shared/sub");
+            } else if (create_node_by_path(root, "/shared/sub")) {
+                create_leaf_by_path(root, "/shared/sub/a", "1");
+            } else {
+                ++failures;
+            }
+        }
+    });
+
+    threads.emplace_back([&] {
+        while (!stop.load()) {
+            {
+                PathLock lock(root, "/shared/sub", LockMode::Shared);
+                if (lock.node() && !find_leaf_by_path_linear(root, "/shared/sub/a")) {
+                    ++failures;
+                }
+            }
+            PathLock whole(root, "/", LockMode::Shared);
+            print_tree_string(whole.node());
+        }
+    });
+
+    for (size_t i = 0; i + 1 < threads.size(); ++i) {
+        threads[i].join();
+    }
+    stop = true;
+    threads.back().join();
+
+    EXPECT_EQ(failures.load(), 0);
+
+    // Каждая запись в индексе достижима из дерева, и наоборот
+    size_t entries = 1 + kWriters;  // /shared и /wN, корень в индекс не входит
+    for (int w = 0; w < kWriters; ++w) {
+        auto dir = find_node_by_path_linear(root, "/w" + std::to_string(w));
+        ASSERT_TRUE(dir);
+        size_t leaves = 0;
+        for (auto leaf = dir->east; leaf; leaf = leaf->east) {
+            EXPECT_EQ(find_leaf_by_path_linear(root, std::string(leaf->path)), leaf);
+            ++leaves;
+        }
+        EXPECT_EQ(leaves, dir->leaf_by_name.size());
+        entries += leaves;
+    }
+    if (find_node_by_path_linear(root, "/shared/sub")) {
+        entries += 2;
+    }
+    EXPECT_EQ(root->index->entries.size(), entries);
+}
+
+}  // namespace database_test
@@ -36,7 +36,7 @@ TEST_F(TreeTest, ChildNodeCreation) {
     ASSERT_FALSE(users_node->parent.expired());
     EXPECT_EQ(users_node->parent.lock(), root);
     ASSERT_EQ(root->childs.size(), 1);
-    EXPECT_EQ(root->childs[0], users_node);
+    EXPECT_EQ(root->childs.front(), users_node);
 }
 
 TEST_F(TreeTest, SingleLeafCreation) {
@@ -82,4 +82,176 @@ TEST_F(TreeTest, PrintTree) {
     print_tree(root);
 }
 
+TEST_F(TreeTest, FindByPathUsesIndex) {
+    auto users_node = create_node_by_path(root, "/Users");
+    auto login_node = create_node_by_path(root, "/Users/Login");
+    auto bob_leaf = create_leaf_by_path(root, "/Users/Login/bob", "bob_data");
+
+    EXPECT_EQ(find_node_by_path_linear(root, "/"), root);
+    EXPECT_EQ(find_node_by_path_linear(root, "/Users"), users_node);
+    EXPECT_EQ(find_node_by_path_linear(root, "/Users/Login"), login_node);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/Login/bob"), bob_leaf);
+
+    // Узел и лист не подменяют друг друга при поиске
+    EXPECT_EQ(find_node_by_path_linear(root, "/Users/Login/bob"), nullptr);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/Login"), nullptr);
+
+    // Поиск ограничен поддеревом, переданным в качестве корня
+    auto shops_node = create_node_by_path(root, "/Shops");
+    EXPECT_EQ(find_node_by_path_linear(shops_node, "/Users/Login"), nullptr);
+    EXPECT_EQ(find_node_by_path_linear(users_node, "/Users/Login"), login_node);
+    EXPECT_EQ(find_leaf_by_path_linear(users_node, "/Users/Login/bob"), bob_leaf);
+}
+
+TEST_F(TreeTest, CreateByPathRejectsDuplicatesAndMissingParents) {
+    ASSERT_NE(create_node_by_path(root, "/Users"), nullptr);
+    ASSERT_NE(create_leaf_by_path(root, "/Users/bob", "bob_data"), nullptr);
+
+    EXPECT_EQ(create_node_by_path(root, "/Users"), nullptr);
+    EXPECT_EQ(create_leaf_by_path(root, "/Users", "data"), nullptr);
+    EXPECT_EQ(create_node_by_path(root, "/Users/bob"), nullptr);
+    EXPECT_EQ(create_leaf_by_path(root, "/Missing/bob", "data"), nullptr);
+}
+
+TEST_F(TreeTest, DeleteNodeRemovesDescendantsFromIndex) {
+    create_node_by_path(root, "/Users");
+    create_node_by_path(root, "/Users/Login");
+    create_leaf_by_path(root, "/Users/Login/bob", "bob_data");
+    create_leaf_by_path(root, "/Users/readme", "text");
+    create_node_by_path(root, "/Shops");
+
+    ASSERT_TRUE(delete_node_by_path_linear(root, "/Users"));
+
+    EXPECT_EQ(find_node_by_path_linear(root, "/Users"), nullptr);
+    EXPECT_EQ(find_node_by_path_linear(root, "/Users/Login"), nullptr);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/Login/bob"), nullptr);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/readme"), nullptr);
+    EXPECT_NE(find_node_by_path_linear(root, "/Shops"), nullptr);
+    EXPECT_EQ(root->index->entries.size(), 1u);
+
+    // Пути освобождены и могут быть созданы заново
+    EXPECT_NE(create_node_by_path(root, "/Users"), nullptr);
+    EXPECT_NE(create_leaf_by_path(root, "/Users/readme", "new_text"), nullptr);
+}
+
+TEST_F(TreeTest, DeleteLeafRelinksSiblings) {
+    auto users_node = create_node_by_path(root, "/Users");
+    auto bob_leaf = create_leaf_by_path(root, "/Users/bob", "bob_data");
+    auto kate_leaf = create_leaf_by_path(root, "/Users/kate", "kate_data");
+    auto mark_leaf = create_leaf_by_path(root, "/Users/mark", "mark_data");
+
+    ASSERT_TRUE(delete_leaf_by_path_linear(root, "/Users/kate"));
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/kate"), nullptr);
+    EXPECT_EQ(bob_leaf->east, mark_leaf);
+    EXPECT_EQ(mark_leaf->west, bob_leaf);
+
+    ASSERT_TRUE(delete_leaf_by_path_linear(root, "/Users/bob"));
+    EXPECT_EQ(users_node->east, mark_leaf);
+    EXPECT_EQ(mark_leaf->west, nullptr);
+    EXPECT_FALSE(delete_leaf_by_path_linear(root, "/Users/bob"));
+}
+
+TEST_F(TreeTest, LastLeafTracksTail) {
+    auto users_node = create_node_by_path(root, "/Users");
+    EXPECT_EQ(find_last_linear(users_node), nullptr);
+
+    auto bob_leaf = create_leaf_by_path(root, "/Users/bob", "bob_data");
+    auto kate_leaf = create_leaf_by_path(root, "/Users/kate", "kate_data");
+    EXPECT_EQ(find_last_linear(users_node), kate_leaf);
+
+    ASSERT_TRUE(delete_leaf_by_path_linear(root, "/Users/kate"));
+    EXPECT_EQ(find_last_linear(users_node), bob_leaf);
+
+    auto mark_leaf = create_leaf_by_path(root, "/Users/mark", "mark_data");
+    EXPECT_EQ(bob_leaf->east, mark_leaf);
+    EXPECT_EQ(find_last_linear(users_node), mark_leaf);
+
+    ASSERT_TRUE(delete_leaf_by_path_linear(root, "/Users/bob"));
+    ASSERT_TRUE(delete_leaf_by_path_linear(root, "/Users/mark"));
+    EXPECT_EQ(find_last_linear(users_node), nullptr);
+    EXPECT_EQ(users_node->east, nullptr);
+}
+
+TEST_F(TreeTest, FindChildByName) {
+    auto users_node = create_node_by_path(root, "/Users");
+    auto login_node = create_node_by_path(root, "/Users/Login");
+    auto bob_leaf = create_leaf_by_path(root, "/Users/bob", "bob_data");
+
+    EXPECT_EQ(find_child_node(root, "Users"), users_node);
+    EXPECT_EQ(find_child_node(users_node, "Login"), login_node);
+    EXPECT_EQ(find_child_leaf(users_node, "bob"), bob_leaf);
+    EXPECT_EQ(find_child_node(users_node, "bob"), nullptr);
+    EXPECT_EQ(find_child_leaf(users_node, "Login"), nullptr);
+
+    ASSERT_TRUE(delete_node_by_path_linear(root, "/Users/Login"));
+    ASSERT_TRUE(delete_leaf_by_path_linear(root, "/Users/bob"));
+    EXPECT_EQ(find_child_node(users_node, "Login"), nullptr);
+    EXPECT_EQ(find_child_leaf(users_node, "bob"), nullptr);
+    EXPECT_TRUE(users_node->childs.empty());
+}
+
+TEST_F(TreeTest, ChildOrderIsStableAfterDeletion) {
+    create_node_by_path(root, "/a");
+    create_node_by_path(root, "/b");
+    create_node_by_path(root, "/c");
+    ASSERT_TRUE(delete_node_by_path_linear(root, "/b"));
+    create_node_by_path(root, "/d");
+
+    EXPECT_EQ(print_tree_string(root), "📁 /\n  📁 /a\n  📁 /c\n  📁 /d\n");
+}
+
+TEST_F(TreeTest, SetLeafOverwritesInPlace) {
+    create_node_by_path(root, "/Users");
+    auto first = create_leaf_by_path(root, "/Users/a", "1");
+    auto bob = create_leaf_by_path(root, "/Users/bob", "a fairly long initial value");
+    auto last = create_leaf_by_path(root, "/Users/z", "26");
+    const char *buffer = bob->value.data();
+
+    bool created = true;
+    auto updated = set_leaf_by_path(root, "/Users/bob", "short", &created);
+
+    EXPECT_FALSE(created);
+    EXPECT_EQ(updated, bob);
+    EXPECT_EQ(bob->value, "short");
+    EXPECT_EQ(bob->value.data(), buffer);  // Буфер значения переиспользован
+    EXPECT_EQ(first->east, bob);
+    EXPECT_EQ(bob->east, last);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/bob")->value, "short");
+}
+
+TEST_F(TreeTest, SetLeafCreatesMissingLeaf) {
+    create_node_by_path(root, "/Users");
+
+    bool created = false;
+    auto leaf = set_leaf_by_path(root, "/Users/kate", "kate_data", &created);
+    ASSERT_NE(leaf, nullptr);
+    EXPECT_TRUE(created);
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/kate"), leaf);
+
+    // Каталог не превращается в лист, родитель должен существовать
+    EXPECT_EQ(set_leaf_by_path(root, "/Users", "x"), nullptr);
+    EXPECT_EQ(set_leaf_by_path(root, "/Missing/x", "x"), nullptr);
+}
+
+TEST_F(TreeTest, BatchHelpersWorkInFoundDirectory) {
+    auto users = create_node_by_path(root, "/Users");
+    create_node_by_path(root, "/Users/Admins");
+
+    bool created = false;
+    auto bob = set_child_leaf(users, "/Users/bob", "v1", &created);
+    ASSERT_NE(bob, nullptr);
+    EXPECT_TRUE(created);
+    EXPECT_EQ(set_child_leaf(users, "/Users/bob", "v2", &created), bob);
+    EXPECT_FALSE(created);
+    EXPECT_EQ(bob->value, "v2");
+    EXPECT_EQ(set_child_leaf(users, "/Users/Admins", "x"), nullptr);
+
+    auto kate = set_child_leaf(users, "/Users/kate", "k");
+    EXPECT_TRUE(delete_leaf(root, bob));
+    EXPECT_EQ(find_leaf_by_path_linear(root, "/Users/bob"), nullptr);
+    EXPECT_EQ(find_child_leaf(users, "bob"), nullptr);
+    EXPECT_EQ(users->east, kate);
+    EXPECT_EQ(kate->west, nullptr);
+}
+
 }  // namespace database_test